@@ -0,0 +1,731 @@
+#include "agent.h"
+
+/* All paths of change records are resolved relative to the remote workspace root */
+int workspace_root_fd = -1;
+
+AgentUpload upload = {.path = NULL, .tmp_path = NULL, .fd = -1, .base_fd = -1};
+
+const char *workspace_root_path = NULL;
+
+/*
+ * Index of the remote workspace and the ignore rules of the monitor's workspace it is built with, see 'AGENT_DIGEST'.
+ *  The index is kept across comparisons and invalidated by the records that change the remote workspace.
+ */
+IgnoreRules *digest_ignore_rules = NULL;
+WorkspaceIndex *workspace_index = NULL;
+/* Body of the 'AGENT_DIGEST_RULES' record the index is built with */
+char *digest_rules_body = NULL;
+uint32_t digest_rules_body_size = 0;
+
+/*
+ * Records must not reach outside of the workspace root, so paths have to be relative and must not contain '.' or '..'
+ *  segments. Symbolic links inside of the workspace are followed, just as rsync does when syncing into them.
+ */
+static bool
+is_valid_relative_path(const char *path)
+{
+    if (path == NULL || *path == '\0' || *path == '/') {
+        return false;
+    }
+
+    const char *segment = path;
+    while (true) {
+        const char *segment_end = strchrnul(segment, '/');
+        const size_t segment_len = segment_end - segment;
+
+        if (segment_len == 0
+            || (segment_len == 1 && segment[0] == '.')
+            || (segment_len == 2 && segment[0] == '.' && segment[1] == '.')) {
+            return false;
+        }
+
+        if (*segment_end == '\0') {
+            return true;
+        }
+        segment = segment_end + 1;
+    }
+}
+
+static bool
+validate_record_path(const char *path, char **error_msg)
+{
+    if (!is_valid_relative_path(path)) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("'%s' is not a valid path inside of the workspace", path));
+        return false;
+    }
+    return true;
+}
+
+static bool
+validate_record_end(const ByteBufferReader *reader, const AgentRecord *record, char **error_msg)
+{
+    if (reader->error || reader->offset != reader->size) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Record '%u' is malformed", record->seq));
+        return false;
+    }
+    return true;
+}
+
+static bool
+set_errno_error_msg(const char *operation, const char *path, char **error_msg)
+{
+    SET_ERROR_MSG_RAW(error_msg, format_string("Unable to %s '%s': %s", operation, path, strerror(errno)));
+    return false;
+}
+
+static void
+abort_upload(void)
+{
+    if (upload.fd != -1) {
+        close(upload.fd);
+        upload.fd = -1;
+    }
+    if (upload.base_fd != -1) {
+        close(upload.base_fd);
+        upload.base_fd = -1;
+    }
+    if (upload.tmp_path != NULL) {
+        unlinkat(workspace_root_fd, upload.tmp_path, 0);
+    }
+
+    DO_FREE(upload.path);
+    DO_FREE(upload.tmp_path);
+}
+
+/*
+ * The temporary file is hidden and placed next to the destination, so that it can be renamed into place atomically.
+ */
+static char *
+get_upload_tmp_path(const char *path)
+{
+    const char *name = strrchr(path, '/');
+    if (name == NULL) {
+        return format_string(".%s.reSync-tmp", path);
+    }
+
+    return format_string("%.*s/.%s.reSync-tmp", (int) (name - path), path, name + 1);
+}
+
+static bool
+start_upload(const char *path, char **error_msg)
+{
+    // A transfer that was not completed is superseded, e.g. because the file vanished locally while it was read
+    abort_upload();
+
+    upload.path = resync_strdup(path);
+    upload.tmp_path = get_upload_tmp_path(path);
+    upload.fd = openat(workspace_root_fd, upload.tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (upload.fd == -1) {
+        set_errno_error_msg("create a temporary file for", path, error_msg);
+        DO_FREE(upload.tmp_path);
+        abort_upload();
+        return false;
+    }
+    return true;
+}
+
+static bool
+is_upload_in_progress(const char *path, char **error_msg)
+{
+    if (upload.fd == -1 || !is_equal(upload.path, path)) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("No transfer of '%s' is in progress", path));
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Replaces the destination with the temporary file and ends the transfer.
+ */
+static bool
+finish_upload(const uint32_t mode, char **error_msg)
+{
+    bool res = true;
+    if (fchmod(upload.fd, mode & 07777) == -1) {
+        res = set_errno_error_msg("set the mode of", upload.path, error_msg);
+    } else if (close(upload.fd) == -1) {
+        upload.fd = -1;
+        res = set_errno_error_msg("write", upload.path, error_msg);
+    } else {
+        upload.fd = -1;
+        invalidate_workspace_index_resource(workspace_index, upload.path, false);
+        if (renameat(workspace_root_fd, upload.tmp_path, workspace_root_fd, upload.path) == -1) {
+            res = set_errno_error_msg("replace", upload.path, error_msg);
+        } else {
+            DO_FREE(upload.tmp_path);
+        }
+    }
+
+    abort_upload();
+    return res;
+}
+
+static bool
+apply_write_record(const AgentRecord *record, char **error_msg)
+{
+    ByteBufferReader reader = create_agent_record_reader(record);
+    const char *path = agent_record_read_string_view(&reader);
+    const uint32_t mode = agent_record_read_u32(&reader);
+    const uint8_t flags = agent_record_read_u8(&reader);
+    uint32_t data_size;
+    const void *data = agent_record_read_bytes(&reader, &data_size);
+
+    if (!validate_record_end(&reader, record, error_msg) || !validate_record_path(path, error_msg)) {
+        return false;
+    }
+
+    if (flags & AGENT_WRITE_FIRST_CHUNK) {
+        if (!start_upload(path, error_msg)) {
+            return false;
+        }
+    } else if (!is_upload_in_progress(path, error_msg)) {
+        return false;
+    }
+
+    if (data_size > 0 && !write_all(upload.fd, data, data_size)) {
+        set_errno_error_msg("write", path, error_msg);
+        abort_upload();
+        return false;
+    }
+
+    if (!(flags & AGENT_WRITE_LAST_CHUNK)) {
+        return true;
+    }
+
+    return finish_upload(mode, error_msg);
+}
+
+static bool
+write_delta_data(const void *data, const size_t size, char **error_msg)
+{
+    if (size > 0 && !write_all(upload.fd, data, size)) {
+        return set_errno_error_msg("write", upload.path, error_msg);
+    }
+
+    delta_hash_update(&upload.hash_state, data, size);
+    upload.size += size;
+    return true;
+}
+
+static bool
+copy_base_blocks(const uint32_t block_index, const uint32_t block_count, char **error_msg)
+{
+    char buffer[DELTA_MAX_LITERAL_SIZE];
+
+    uint64_t offset = (uint64_t) block_index * upload.block_size;
+    uint64_t remaining_size = (uint64_t) block_count * upload.block_size;
+
+    while (remaining_size > 0) {
+        const size_t read_size = (remaining_size < sizeof(buffer)) ? remaining_size : sizeof(buffer);
+        const ssize_t ret = pread(upload.base_fd, buffer, read_size, (off_t) offset);
+        if (ret == -1 && errno == EINTR) {
+            continue;
+        } else if (ret == -1) {
+            return set_errno_error_msg("read", upload.path, error_msg);
+        } else if (ret == 0) {
+            // The file was truncated since its signature was sent
+            SET_ERROR_MSG_RAW(error_msg, format_string("Delta of '%s' refers to blocks beyond its end", upload.path));
+            return false;
+        }
+
+        if (!write_delta_data(buffer, ret, error_msg)) {
+            return false;
+        }
+        offset += ret;
+        remaining_size -= ret;
+    }
+
+    return true;
+}
+
+static bool
+apply_delta_operations(const void *operations, const uint32_t operations_size, char **error_msg)
+{
+    ByteBufferReader reader = create_byte_buffer_reader(operations, operations_size);
+
+    while (reader.offset < reader.size) {
+        const uint8_t operation = agent_record_read_u8(&reader);
+
+        if (operation == AGENT_DELTA_COPY) {
+            const uint32_t block_index = agent_record_read_u32(&reader);
+            const uint32_t block_count = agent_record_read_u32(&reader);
+            if (!reader.error && !copy_base_blocks(block_index, block_count, error_msg)) {
+                return false;
+            }
+        } else if (operation == AGENT_DELTA_LITERAL) {
+            uint32_t data_size;
+            const void *data = agent_record_read_bytes(&reader, &data_size);
+            if (!reader.error && !write_delta_data(data, data_size, error_msg)) {
+                return false;
+            }
+        } else {
+            reader.error = true;
+        }
+
+        if (reader.error) {
+            SET_ERROR_MSG_RAW(error_msg, format_string("Delta of '%s' is malformed", upload.path));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * The file is reconstructed from the delta and the current version of the file into a temporary file, which only
+ *  replaces the current version if it matches the size and hash of the monitor's version.
+ */
+static bool
+apply_delta_record(const AgentRecord *record, char **error_msg)
+{
+    ByteBufferReader reader = create_agent_record_reader(record);
+    const char *path = agent_record_read_string_view(&reader);
+    const uint32_t mode = agent_record_read_u32(&reader);
+    const uint8_t flags = agent_record_read_u8(&reader);
+    const uint32_t block_size = agent_record_read_u32(&reader);
+    uint32_t operations_size;
+    const void *operations = agent_record_read_bytes(&reader, &operations_size);
+
+    uint64_t file_size = 0, file_hash = 0;
+    if (flags & AGENT_WRITE_LAST_CHUNK) {
+        file_size = agent_record_read_u64(&reader);
+        file_hash = agent_record_read_u64(&reader);
+    }
+
+    if (!validate_record_end(&reader, record, error_msg) || !validate_record_path(path, error_msg)) {
+        return false;
+    }
+
+    if (flags & AGENT_WRITE_FIRST_CHUNK) {
+        if (!start_upload(path, error_msg)) {
+            return false;
+        }
+
+        upload.base_fd = openat(workspace_root_fd, path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+        if (upload.base_fd == -1) {
+            set_errno_error_msg("open", path, error_msg);
+            abort_upload();
+            return false;
+        }
+
+        upload.block_size = block_size;
+        upload.size = 0;
+        delta_hash_init(&upload.hash_state);
+    } else if (!is_upload_in_progress(path, error_msg)) {
+        return false;
+    } else if (upload.base_fd == -1 || upload.block_size != block_size) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("No delta transfer of '%s' is in progress", path));
+        abort_upload();
+        return false;
+    }
+
+    if (!apply_delta_operations(operations, operations_size, error_msg)) {
+        abort_upload();
+        return false;
+    }
+
+    if (!(flags & AGENT_WRITE_LAST_CHUNK)) {
+        return true;
+    }
+
+    if (upload.size != file_size || delta_hash_digest(&upload.hash_state) != file_hash) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("File '%s' reconstructed from its delta does not match", path));
+        abort_upload();
+        return false;
+    }
+
+    return finish_upload(mode, error_msg);
+}
+
+static bool
+apply_append_record(const AgentRecord *record, char **error_msg)
+{
+    ByteBufferReader reader = create_agent_record_reader(record);
+    const char *path = agent_record_read_string_view(&reader);
+    const uint64_t offset = agent_record_read_u64(&reader);
+    uint32_t data_size;
+    const char *data = (const char *) agent_record_read_bytes(&reader, &data_size);
+
+    if (!validate_record_end(&reader, record, error_msg) || !validate_record_path(path, error_msg)) {
+        return false;
+    }
+
+    // The file is written in place, as appending to it does not change what readers of the file already saw
+    const int fd = openat(workspace_root_fd, path, O_WRONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd == -1) {
+        return set_errno_error_msg("open", path, error_msg);
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1 || !S_ISREG(file_stat.st_mode)) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("'%s' is not a regular file", path));
+        close(fd);
+        return false;
+    }
+
+    // A smaller file would end up with a hole and a larger one with stale bytes behind the appended data, i.e. the file
+    //  differs from the sender's former content and has to be transferred entirely
+    if ((uint64_t) file_stat.st_size != offset) {
+        SET_ERROR_MSG_RAW(
+                error_msg,
+                format_string(
+                        "'%s' has %llu bytes, which is not the offset %llu to append at",
+                        path,
+                        (unsigned long long) file_stat.st_size,
+                        (unsigned long long) offset
+                )
+        );
+        close(fd);
+        return false;
+    }
+
+    invalidate_workspace_index_resource(workspace_index, path, false);
+
+    uint32_t written_size = 0;
+    while (written_size < data_size) {
+        const ssize_t res = pwrite(fd, data + written_size, data_size - written_size, (off_t) (offset + written_size));
+        if (res == -1 && errno == EINTR) {
+            continue;
+        } else if (res <= 0) {
+            set_errno_error_msg("append to", path, error_msg);
+            close(fd);
+            return false;
+        }
+        written_size += (uint32_t) res;
+    }
+
+    if (close(fd) == -1) {
+        return set_errno_error_msg("append to", path, error_msg);
+    }
+    return true;
+}
+
+static bool
+apply_signature_record(const AgentRecord *record, ByteBuffer **ack_payload, char **error_msg)
+{
+    ByteBufferReader reader = create_agent_record_reader(record);
+    const char *path = agent_record_read_string_view(&reader);
+
+    if (!validate_record_end(&reader, record, error_msg) || !validate_record_path(path, error_msg)) {
+        return false;
+    }
+
+    const int fd = openat(workspace_root_fd, path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd == -1) {
+        return set_errno_error_msg("open", path, error_msg);
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1 || !S_ISREG(file_stat.st_mode)) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("'%s' is not a regular file", path));
+        close(fd);
+        return false;
+    }
+
+    FileSignature *signature = compute_file_signature(fd, file_stat.st_size, error_msg);
+    close(fd);
+    if (signature == NULL) {
+        return false;
+    }
+
+    *ack_payload = create_byte_buffer(2 * sizeof(uint32_t) + signature->block_count * (sizeof(uint32_t) + sizeof(uint64_t)));
+    append_file_signature(*ack_payload, signature);
+    destroy_file_signature(&signature);
+
+    return true;
+}
+
+static bool
+apply_digest_rules_record(const AgentRecord *record, char **error_msg)
+{
+    // The records that changed the remote workspace since the previous comparison invalidated the index already
+    if (workspace_index != NULL && record->body_size == digest_rules_body_size
+        && memcmp(record->body, digest_rules_body, digest_rules_body_size) == 0) {
+        return true;
+    }
+
+    ByteBufferReader reader = create_agent_record_reader(record);
+    const uint8_t flags = agent_record_read_u8(&reader);
+    const uint32_t patterns_count = agent_record_read_u32(&reader);
+
+    IgnoreRules *rules = create_ignore_rules();
+    for (uint32_t i = 0; i < patterns_count && !reader.error; i++) {
+        const char *pattern = agent_record_read_string_view(&reader);
+        if (pattern != NULL && !add_ignore_pattern(rules, pattern, error_msg)) {
+            destroy_ignore_rules(&rules);
+            return false;
+        }
+    }
+
+    if (!validate_record_end(&reader, record, error_msg)) {
+        destroy_ignore_rules(&rules);
+        return false;
+    }
+
+    // Other ignore rules or flags change the hashes of all directories
+    destroy_workspace_index(&workspace_index);
+    destroy_ignore_rules(&digest_ignore_rules);
+    digest_ignore_rules = rules;
+    workspace_index = create_workspace_index(workspace_root_path, digest_ignore_rules, flags);
+
+    DO_FREE(digest_rules_body);
+    digest_rules_body = (char *) do_malloc(record->body_size);
+    memcpy(digest_rules_body, record->body, record->body_size);
+    digest_rules_body_size = record->body_size;
+
+    return true;
+}
+
+static bool
+apply_digest_record(const AgentRecord *record, ByteBuffer **ack_payload, char **error_msg)
+{
+    ByteBufferReader reader = create_agent_record_reader(record);
+    const char *path = agent_record_read_string_view(&reader);
+
+    if (!validate_record_end(&reader, record, error_msg) || (path != NULL && !validate_record_path(path, error_msg))) {
+        return false;
+    }
+
+    if (workspace_index == NULL) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("No ignore rules were sent before record '%u'", record->seq));
+        return false;
+    }
+
+    DirectoryDigest *digest = get_directory_digest(workspace_index, path);
+    if (digest == NULL) {
+        return set_errno_error_msg("read the directory", (path != NULL) ? path : ".", error_msg);
+    }
+
+    *ack_payload = create_byte_buffer(sizeof(uint64_t) + sizeof(uint32_t) + digest->subdirs_count * 64);
+    append_directory_digest(*ack_payload, digest);
+    destroy_directory_digest(&digest);
+
+    // The monitor syncs a directory whose digest cannot be sent entirely instead of comparing it
+    if ((*ack_payload)->size > AGENT_MAX_RECORD_SIZE - 1024) {
+        destroy_byte_buffer(ack_payload);
+        SET_ERROR_MSG_RAW(error_msg, format_string("The digest of '%s' exceeds the record size", (path != NULL) ? path : "."));
+        return false;
+    }
+
+    return true;
+}
+
+static bool
+apply_delete_record(const AgentRecord *record, char **error_msg)
+{
+    ByteBufferReader reader = create_agent_record_reader(record);
+    const char *path = agent_record_read_string_view(&reader);
+
+    if (!validate_record_end(&reader, record, error_msg) || !validate_record_path(path, error_msg)) {
+        return false;
+    }
+
+    invalidate_workspace_index_resource(workspace_index, path, true);
+
+    // Deleting a resource that does not exist (anymore) leaves the remote workspace in the expected state
+    if (remove_tree_at(workspace_root_fd, path) == -1 && errno != ENOENT) {
+        return set_errno_error_msg("delete", path, error_msg);
+    }
+    return true;
+}
+
+static bool
+apply_mkdir_record(const AgentRecord *record, char **error_msg)
+{
+    ByteBufferReader reader = create_agent_record_reader(record);
+    const char *path = agent_record_read_string_view(&reader);
+    const uint32_t mode = agent_record_read_u32(&reader);
+
+    if (!validate_record_end(&reader, record, error_msg) || !validate_record_path(path, error_msg)) {
+        return false;
+    }
+
+    invalidate_workspace_index_resource(workspace_index, path, false);
+
+    if (mkdirat(workspace_root_fd, path, mode & 07777) == 0) {
+        return true;
+    }
+
+    struct stat dir_stat;
+    if (errno != EEXIST || fstatat(workspace_root_fd, path, &dir_stat, AT_SYMLINK_NOFOLLOW) == -1 || !S_ISDIR(dir_stat.st_mode)) {
+        return set_errno_error_msg("create the directory", path, error_msg);
+    }
+
+    if (fchmodat(workspace_root_fd, path, mode & 07777, 0) == -1) {
+        return set_errno_error_msg("set the mode of", path, error_msg);
+    }
+    return true;
+}
+
+static bool
+apply_rename_record(const AgentRecord *record, char **error_msg)
+{
+    ByteBufferReader reader = create_agent_record_reader(record);
+    const char *path = agent_record_read_string_view(&reader);
+    const char *target_path = agent_record_read_string_view(&reader);
+
+    if (!validate_record_end(&reader, record, error_msg)
+        || !validate_record_path(path, error_msg)
+        || !validate_record_path(target_path, error_msg)) {
+        return false;
+    }
+
+    invalidate_workspace_index_resource(workspace_index, path, true);
+    invalidate_workspace_index_resource(workspace_index, target_path, true);
+
+    if (renameat(workspace_root_fd, path, workspace_root_fd, target_path) == -1) {
+        return set_errno_error_msg("rename", path, error_msg);
+    }
+    return true;
+}
+
+static bool
+apply_chmod_record(const AgentRecord *record, char **error_msg)
+{
+    ByteBufferReader reader = create_agent_record_reader(record);
+    const char *path = agent_record_read_string_view(&reader);
+    const uint32_t mode = agent_record_read_u32(&reader);
+
+    if (!validate_record_end(&reader, record, error_msg) || !validate_record_path(path, error_msg)) {
+        return false;
+    }
+
+    invalidate_workspace_index_resource(workspace_index, path, false);
+
+    if (fchmodat(workspace_root_fd, path, mode & 07777, 0) == -1) {
+        return set_errno_error_msg("set the mode of", path, error_msg);
+    }
+    return true;
+}
+
+static bool
+apply_hello_record(const AgentRecord *record, char **error_msg)
+{
+    ByteBufferReader reader = create_agent_record_reader(record);
+    const uint32_t version = agent_record_read_u32(&reader);
+
+    if (!validate_record_end(&reader, record, error_msg)) {
+        return false;
+    }
+
+    if (version != AGENT_PROTOCOL_VERSION) {
+        SET_ERROR_MSG_RAW(
+                error_msg,
+                format_string("Unsupported protocol version %u (expected %u)", version, AGENT_PROTOCOL_VERSION)
+        );
+        return false;
+    }
+    return true;
+}
+
+static bool
+apply_record(const AgentRecord *record, ByteBuffer **ack_payload, char **error_msg)
+{
+    switch (record->type) {
+        case AGENT_HELLO:
+            return apply_hello_record(record, error_msg);
+        case AGENT_WRITE:
+            return apply_write_record(record, error_msg);
+        case AGENT_DELETE:
+            return apply_delete_record(record, error_msg);
+        case AGENT_MKDIR:
+            return apply_mkdir_record(record, error_msg);
+        case AGENT_RENAME:
+            return apply_rename_record(record, error_msg);
+        case AGENT_CHMOD:
+            return apply_chmod_record(record, error_msg);
+        case AGENT_SIGNATURE:
+            return apply_signature_record(record, ack_payload, error_msg);
+        case AGENT_DELTA:
+            return apply_delta_record(record, error_msg);
+        case AGENT_APPEND:
+            return apply_append_record(record, error_msg);
+        case AGENT_DIGEST_RULES:
+            return apply_digest_rules_record(record, error_msg);
+        case AGENT_DIGEST:
+            return apply_digest_record(record, ack_payload, error_msg);
+        case AGENT_ACK:
+        case OTHER_AGENT_RECORD_TYPE:
+        default:
+            SET_ERROR_MSG_RAW(error_msg, format_string("Unsupported record type '%d'", record->type));
+            return false;
+    }
+}
+
+static bool
+send_ack(const int stream_fd, const uint32_t seq, const char *error, const ByteBuffer *payload)
+{
+    ByteBuffer *ack = create_agent_record(AGENT_ACK, seq);
+    agent_record_append_u8(ack, (error == NULL) ? AGENT_ACK_OK : AGENT_ACK_ERROR);
+    agent_record_append_string(ack, error);
+    if (error == NULL && payload != NULL) {
+        byte_buffer_append(ack, payload->data, payload->size);
+    }
+
+    char *error_msg = NULL;
+    const bool res = send_agent_record(stream_fd, ack, &error_msg);
+    destroy_byte_buffer(&ack);
+
+    if (res == false) {
+        LOG_ERROR("%s", error_msg);
+        DO_FREE(error_msg);
+    }
+    return res;
+}
+
+int
+main(const int argc, const char **argv)
+{
+    if (argc != 2) {
+        fatal_custom_error("Usage: %s REMOTE_WORKSPACE_ROOT_PATH", AGENT_REMOTE_COMMAND);
+    }
+
+    // Acknowledgements are written to the original stdout, log output must not end up in the stream
+    const int stream_out_fd = dup(STDOUT_FILENO);
+    if (stream_out_fd == -1 || dup2(STDERR_FILENO, STDOUT_FILENO) == -1) {
+        fatal_error("dup");
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    // Modes of the records are applied as they are
+    umask(0);
+
+    workspace_root_path = argv[1];
+    workspace_root_fd = open(workspace_root_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (workspace_root_fd == -1) {
+        fatal_custom_error("Unable to open the remote workspace '%s': %s", argv[1], strerror(errno));
+    }
+
+    char *error_msg = NULL;
+    while (true) {
+        AgentRecord *record = receive_agent_record(STDIN_FILENO, &error_msg);
+        if (record == NULL) {
+            if (error_msg != NULL) {
+                LOG_ERROR("%s", error_msg);
+                DO_FREE(error_msg);
+            }
+            break;
+        }
+
+        ByteBuffer *ack_payload = NULL;
+        apply_record(record, &ack_payload, &error_msg);
+        const bool is_ack_sent = send_ack(stream_out_fd, record->seq, error_msg, ack_payload);
+
+        destroy_byte_buffer(&ack_payload);
+        DO_FREE(error_msg);
+        destroy_agent_record(&record);
+
+        if (!is_ack_sent) {
+            break;
+        }
+    }
+
+    abort_upload();
+    destroy_workspace_index(&workspace_index);
+    destroy_ignore_rules(&digest_ignore_rules);
+    DO_FREE(digest_rules_body);
+    close(workspace_root_fd);
+
+    return EXIT_SUCCESS;
+}
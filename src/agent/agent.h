@@ -0,0 +1,42 @@
+#ifndef RESYNC_AGENT_H
+#define RESYNC_AGENT_H
+
+#include "../util/string.h"
+#include "../util/memory.h"
+#include "../util/debug.h"
+#include "../util/error.h"
+#include "../util/byte_buffer.h"
+#include "../util/fs_util.h"
+#include "../server/agent_protocol.h"
+#include "../server/delta.h"
+#include "../server/workspace_index.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/stat.h>
+
+/*
+ * The reSync agent runs on a remote system and applies the change records that a workspace monitor streams to it
+ *  (see 'agent_protocol.h') to the remote workspace. It is started by the monitor, typically via ssh, reads records
+ *  from stdin and writes acknowledgements to stdout. The agent terminates once the monitor closes the stream.
+ */
+
+/* File that is currently transmitted in chunks, written to a temporary file next to its destination */
+typedef struct AgentUpload {
+    char *path;
+    char *tmp_path;
+    int fd;
+    /* Only used by delta transfers: the current version of the file, which copies refer to, and the size and hash of
+     *  the file reconstructed so far */
+    int base_fd;
+    uint32_t block_size;
+    uint64_t size;
+    DeltaHashState hash_state;
+} AgentUpload;
+
+#endif //RESYNC_AGENT_H
@@ -0,0 +1,136 @@
+#include "../util/checksum_kernels.h"
+#include "../util/memory.h"
+#include "../util/error.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Microbenchmark of the checksum kernels, reporting the throughput of every kernel variant supported by the CPU.
+ *  Results of the vectorized variants are checked against the scalar variant.
+ *
+ * Usage: checksum_bench [BUFFER_SIZE_MIB [ITERATIONS]]
+ */
+
+#define DEFAULT_BUFFER_SIZE_MIB 64
+#define DEFAULT_ITERATIONS 10
+
+static const size_t block_sizes[] = {1024, 8192, 65536};
+
+static double
+get_time_sec(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+static void
+fill_buffer(unsigned char *buffer, const size_t size)
+{
+    // xorshift, so that the data is not trivially compressible and runs are reproducible
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < size; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        buffer[i] = (unsigned char) state;
+    }
+}
+
+/*
+ * Folds the sums of all blocks into a single value, so that variants can be compared and the work is not optimized
+ *  away.
+ */
+static uint64_t
+run_rolling_sums(const ChecksumKernels *kernels, const unsigned char *buffer, const size_t size, const size_t block_size)
+{
+    uint64_t digest = 0;
+    for (size_t offset = 0; offset + block_size <= size; offset += block_size) {
+        uint32_t a, b;
+        kernels->rolling_sums(buffer + offset, block_size, &a, &b);
+        digest = digest * 31 + (((uint64_t) b << 32) | a);
+    }
+    return digest;
+}
+
+static uint64_t
+run_hash_stripes(const ChecksumKernels *kernels, const unsigned char *buffer, const size_t size)
+{
+    uint64_t acc[CHECKSUM_HASH_LANES] = {0};
+    uint32_t block_stripe = 0;
+    kernels->hash_stripes(acc, buffer, size / CHECKSUM_HASH_STRIPE_SIZE, &block_stripe);
+
+    uint64_t digest = 0;
+    for (int i = 0; i < CHECKSUM_HASH_LANES; i++) {
+        digest = digest * 31 + acc[i];
+    }
+    return digest;
+}
+
+static void
+report(const char *kernel, const char *variant, const size_t bytes, const double elapsed_sec)
+{
+    printf("%-16s %-8s %8.2f GB/s\n", kernel, variant, (double) bytes / elapsed_sec / 1e9);
+}
+
+int
+main(const int argc, const char **argv)
+{
+    const size_t buffer_size_mib = (argc > 1) ? strtoul(argv[1], NULL, 10) : DEFAULT_BUFFER_SIZE_MIB;
+    const int iterations = (argc > 2) ? atoi(argv[2]) : DEFAULT_ITERATIONS;
+    if (buffer_size_mib == 0 || iterations <= 0) {
+        fatal_custom_error("Usage: %s [BUFFER_SIZE_MIB [ITERATIONS]]", argv[0]);
+    }
+
+    const size_t size = buffer_size_mib * 1024 * 1024;
+    unsigned char *buffer = (unsigned char *) do_malloc(size);
+    fill_buffer(buffer, size);
+
+    size_t kernels_count;
+    const ChecksumKernels *const *kernels = get_supported_checksum_kernels(&kernels_count);
+    printf("Selected kernels: %s\n", get_checksum_kernels()->name);
+
+    bool is_consistent = true;
+
+    for (size_t i = 0; i < sizeof(block_sizes) / sizeof(block_sizes[0]); i++) {
+        const size_t block_size = block_sizes[i];
+        const uint64_t expected_digest = run_rolling_sums(kernels[0], buffer, size, block_size);
+
+        char kernel_name[32];
+        snprintf(kernel_name, sizeof(kernel_name), "rolling/%zu", block_size);
+
+        for (size_t k = 0; k < kernels_count; k++) {
+            uint64_t digest = 0;
+            const double start = get_time_sec();
+            for (int iteration = 0; iteration < iterations; iteration++) {
+                digest = run_rolling_sums(kernels[k], buffer, size, block_size);
+            }
+            report(kernel_name, kernels[k]->name, size * iterations, get_time_sec() - start);
+
+            if (digest != expected_digest) {
+                fprintf(stderr, "Rolling sums of '%s' differ from the scalar kernel\n", kernels[k]->name);
+                is_consistent = false;
+            }
+        }
+    }
+
+    const uint64_t expected_digest = run_hash_stripes(kernels[0], buffer, size);
+    for (size_t k = 0; k < kernels_count; k++) {
+        uint64_t digest = 0;
+        const double start = get_time_sec();
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            digest = run_hash_stripes(kernels[k], buffer, size);
+        }
+        report("hash_stripes", kernels[k]->name, size * iterations, get_time_sec() - start);
+
+        if (digest != expected_digest) {
+            fprintf(stderr, "Hash of '%s' differs from the scalar kernel\n", kernels[k]->name);
+            is_consistent = false;
+        }
+    }
+
+    DO_FREE(buffer);
+    return is_consistent ? EXIT_SUCCESS : EXIT_FAILURE;
+}
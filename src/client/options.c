@@ -1,5 +1,8 @@
 #include "options.h"
 
+#define MIN_PORT_NUMBER 0
+#define MAX_PORT_NUMBER 65535
+
 /*
  * Internal struct that stores the values for the given options.
  */
@@ -142,7 +145,7 @@ validate_rsync_daemon_connection_type(OptionValues *option_values)
     bool res;
 
     if (option_values->hostname == NULL) {
-        PRINT_REQUIRED_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_HOSTNAME, CONNECTION_TYPE_RSYNC_DAEMON);
+        PRINT_REQUIRED_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_HOSTNAME, connection_type_to_string(RSYNC_DAEMON));
         return false;
     }
 
@@ -166,11 +169,11 @@ validate_rsync_daemon_connection_type(OptionValues *option_values)
     }
 
     if (option_values->ssh_host_alias != NULL) {
-        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_SSH_HOST_ALIAS, CONNECTION_TYPE_RSYNC_DAEMON);
+        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_SSH_HOST_ALIAS, connection_type_to_string(RSYNC_DAEMON));
     }
 
     if (option_values->identity_file != NULL) {
-        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_IDENTITY_FILE, CONNECTION_TYPE_RSYNC_DAEMON);
+        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_IDENTITY_FILE, connection_type_to_string(RSYNC_DAEMON));
     }
 
     return true;
@@ -182,7 +185,7 @@ validate_ssh_connection_type(OptionValues *option_values)
     bool res;
 
     if (option_values->hostname == NULL) {
-        PRINT_REQUIRED_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_HOSTNAME, CONNECTION_TYPE_SSH);
+        PRINT_REQUIRED_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_HOSTNAME, connection_type_to_string(SSH));
         return false;
     }
 
@@ -206,11 +209,11 @@ validate_ssh_connection_type(OptionValues *option_values)
     }
 
     if (option_values->port != NULL) {
-        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_PORT, CONNECTION_TYPE_SSH);
+        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_PORT, connection_type_to_string(SSH));
     }
 
     if (option_values->ssh_host_alias != NULL) {
-        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_SSH_HOST_ALIAS, CONNECTION_TYPE_SSH);
+        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_SSH_HOST_ALIAS, connection_type_to_string(SSH));
     }
 
     return true;
@@ -222,7 +225,7 @@ validate_ssh_host_alias_connection_type(OptionValues *option_values)
     bool res;
 
     if (option_values->ssh_host_alias == NULL) {
-        LOG_ERROR("When using the '%s' connection type, the option '%s' must be specified!", CONNECTION_TYPE_SSH_HOST_ALIAS, OPT_USAGE_SSH_HOST_ALIAS);
+        LOG_ERROR("When using the '%s' connection type, the option '%s' must be specified!", connection_type_to_string(SSH_HOST_ALIAS), OPT_USAGE_SSH_HOST_ALIAS);
         return false;
     }
 
@@ -232,19 +235,45 @@ validate_ssh_host_alias_connection_type(OptionValues *option_values)
     }
 
     if (option_values->hostname != NULL) {
-        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_HOSTNAME, CONNECTION_TYPE_SSH_HOST_ALIAS);
+        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_HOSTNAME, connection_type_to_string(SSH_HOST_ALIAS));
+    }
+
+    if (option_values->username != NULL) {
+        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_USERNAME, connection_type_to_string(SSH_HOST_ALIAS));
+    }
+
+    if (option_values->port != NULL) {
+        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_PORT, connection_type_to_string(SSH_HOST_ALIAS));
+    }
+
+    if (option_values->identity_file != NULL) {
+        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_IDENTITY_FILE, connection_type_to_string(SSH_HOST_ALIAS));
+    }
+
+    return true;
+}
+
+static bool
+validate_local_path_connection_type(OptionValues *option_values)
+{
+    if (option_values->hostname != NULL) {
+        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_HOSTNAME, connection_type_to_string(LOCAL_PATH));
     }
 
     if (option_values->username != NULL) {
-        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_USERNAME, CONNECTION_TYPE_SSH_HOST_ALIAS);
+        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_USERNAME, connection_type_to_string(LOCAL_PATH));
     }
 
     if (option_values->port != NULL) {
-        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_PORT, CONNECTION_TYPE_SSH_HOST_ALIAS);
+        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_PORT, connection_type_to_string(LOCAL_PATH));
+    }
+
+    if (option_values->ssh_host_alias != NULL) {
+        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_SSH_HOST_ALIAS, connection_type_to_string(LOCAL_PATH));
     }
 
     if (option_values->identity_file != NULL) {
-        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_IDENTITY_FILE, CONNECTION_TYPE_SSH_HOST_ALIAS);
+        PRINT_IGNORE_OPTION_FOR_CONNECTION_TYPE(OPT_USAGE_IDENTITY_FILE, connection_type_to_string(LOCAL_PATH));
     }
 
     return true;
@@ -321,7 +350,7 @@ validate_command(const char *command)
         return false;
     }
 
-    if (string_to_resync_command_type(command) == OTHER_RESYNC_COMMAND_TYPE) {
+    if (string_to_resync_server_command_type(command) == OTHER_RESYNC_SERVER_COMMAND_TYPE) {
         LOG_ERROR("Value '%s' for option '%s' is not a valid command!", command, OPT_USAGE_COMMAND);
         return false;
     }
@@ -344,6 +373,11 @@ validate_optionValues(OptionValues *option_values)
         return false;
     }
 
+    // Removing a workspace does not concern any of its remote systems
+    if (string_to_resync_server_command_type(option_values->command) == REMOVE_WORKSPACE) {
+        return true;
+    }
+
     res = validate_remote_workspace_path(option_values->remote_ws_path);
     if (res == false) {
         return false;
@@ -364,6 +398,9 @@ validate_optionValues(OptionValues *option_values)
         case RSYNC_DAEMON:
             res = validate_rsync_daemon_connection_type(option_values);
             break;
+        case LOCAL_PATH:
+            res = validate_local_path_connection_type(option_values);
+            break;
         default:
             LOG_ERROR("Value '%s' for option '%s' is not a supported connection type!", option_values->connection_type, OPT_USAGE_CONNECTION_TYPE);
             return false;
@@ -376,52 +413,120 @@ validate_optionValues(OptionValues *option_values)
     return true;
 }
 
-static ResyncDaemonCommand *
-optionValues_to_ResyncDaemonCommand(OptionValues *option_values)
+static RemoteWorkspaceMetadata *
+optionValues_to_remoteWorkspaceMetadata(OptionValues *option_values)
 {
-    ResyncDaemonCommand *command = (ResyncDaemonCommand *) do_malloc(sizeof(ResyncDaemonCommand));
-    command->command_type = string_to_resync_command_type(option_values->command);
-
-    WorkspaceInformation *ws_info = (WorkspaceInformation *) do_malloc(sizeof(WorkspaceInformation));
-    ws_info->local_workspace_root_path = resync_strdup(option_values->local_ws_path);
-
-    RemoteWorkspaceMetadata *remote_system = (RemoteWorkspaceMetadata *) do_malloc(sizeof(RemoteWorkspaceMetadata));
+    RemoteWorkspaceMetadata *remote_system = (RemoteWorkspaceMetadata *) do_calloc(1, sizeof(RemoteWorkspaceMetadata));
     remote_system->remote_workspace_root_path = resync_strdup(option_values->remote_ws_path);
     remote_system->connection_type = string_to_connection_type(option_values->connection_type);
 
     switch (remote_system->connection_type) {
         case SSH:
-            remote_system->connection_information.sshConnectionInformation = (SshConnectionInformation *) do_malloc(
+            remote_system->connection_information.ssh_connection_information = (SshConnectionInformation *) do_calloc(
+                    1,
                     sizeof(SshConnectionInformation)
             );
-            remote_system->connection_information.sshConnectionInformation->username = resync_strdup(option_values->username);
-            remote_system->connection_information.sshConnectionInformation->hostname = resync_strdup(option_values->hostname);
-            remote_system->connection_information.sshConnectionInformation->path_to_identity_file = resync_strdup(option_values->identity_file);
+            remote_system->connection_information.ssh_connection_information->username = resync_strdup(option_values->username);
+            remote_system->connection_information.ssh_connection_information->hostname = resync_strdup(option_values->hostname);
+            remote_system->connection_information.ssh_connection_information->path_to_identity_file = resync_strdup(option_values->identity_file);
             break;
         case SSH_HOST_ALIAS:
             remote_system->connection_information.ssh_host_alias = resync_strdup(option_values->ssh_host_alias);
             break;
         case RSYNC_DAEMON:
-            remote_system->connection_information.rsyncConnectionInformation = (RsyncConnectionInformation *) do_malloc(
+            remote_system->connection_information.rsync_connection_information = (RsyncConnectionInformation *) do_calloc(
+                    1,
                     sizeof(RsyncConnectionInformation)
             );
-            remote_system->connection_information.rsyncConnectionInformation->hostname = resync_strdup(option_values->hostname);
-            remote_system->connection_information.rsyncConnectionInformation->username = resync_strdup(option_values->username);
+            remote_system->connection_information.rsync_connection_information->hostname = resync_strdup(option_values->hostname);
+            remote_system->connection_information.rsync_connection_information->username = resync_strdup(option_values->username);
             if (option_values->port != NULL) {
-                remote_system->connection_information.rsyncConnectionInformation->port = strtol(option_values->port, NULL, 10);
+                remote_system->connection_information.rsync_connection_information->port = strtol(option_values->port, NULL, 10);
             }
+            break;
+        case LOCAL_PATH:
+            break;
         default:
             LOG_ERROR("Encountered unsupported connection type '%s' while parsing user input", option_values->connection_type);
+            destroy_remoteWorkspaceMetadata(&remote_system);
             return NULL;
     }
 
-    ws_info->remote_systems = remote_system;
-    command->workspace_information = ws_info;
+    return remote_system;
+}
+
+static RemoveRemoteSystemMetadata *
+optionValues_to_removeRemoteSystemMetadata(OptionValues *option_values)
+{
+    RemoveRemoteSystemMetadata *rm_remote_system_md = (RemoveRemoteSystemMetadata *) do_calloc(
+            1,
+            sizeof(RemoveRemoteSystemMetadata)
+    );
+    rm_remote_system_md->local_workspace_root_path = resync_strdup(option_values->local_ws_path);
+    rm_remote_system_md->remote_workspace_root_path = resync_strdup(option_values->remote_ws_path);
+    rm_remote_system_md->connection_type = string_to_connection_type(option_values->connection_type);
+
+    switch (rm_remote_system_md->connection_type) {
+        case SSH:
+        case RSYNC_DAEMON:
+            rm_remote_system_md->remote_system_id_information.hostname = resync_strdup(option_values->hostname);
+            break;
+        case SSH_HOST_ALIAS:
+            rm_remote_system_md->remote_system_id_information.ssh_host_alias = resync_strdup(option_values->ssh_host_alias);
+            break;
+        case LOCAL_PATH:
+            break;
+        default:
+            LOG_ERROR("Encountered unsupported connection type '%s' while parsing user input", option_values->connection_type);
+            destroy_removeRemoteSystemMetadata(&rm_remote_system_md);
+            return NULL;
+    }
+
+    return rm_remote_system_md;
+}
+
+static ResyncServerCommand *
+optionValues_to_resyncServerCommand(OptionValues *option_values)
+{
+    ResyncServerCommand *command = (ResyncServerCommand *) do_calloc(1, sizeof(ResyncServerCommand));
+    command->command_type = string_to_resync_server_command_type(option_values->command);
+
+    switch (command->command_type) {
+        case ADD_WORKSPACE:
+        case ADD_REMOTE_SYSTEM: {
+            RemoteWorkspaceMetadata *remote_system = optionValues_to_remoteWorkspaceMetadata(option_values);
+            if (remote_system == NULL) {
+                goto error_out;
+            }
+
+            WorkspaceInformation *ws_info = (WorkspaceInformation *) do_calloc(1, sizeof(WorkspaceInformation));
+            ws_info->local_workspace_root_path = resync_strdup(option_values->local_ws_path);
+            ws_info->remote_systems = remote_system;
+            command->command_metadata.workspace_information = ws_info;
+            break;
+        }
+        case REMOVE_WORKSPACE:
+            command->command_metadata.local_workspace_root_path = resync_strdup(option_values->local_ws_path);
+            break;
+        case REMOVE_REMOTE_SYSTEM:
+            command->command_metadata.rm_remote_system_md = optionValues_to_removeRemoteSystemMetadata(option_values);
+            if (command->command_metadata.rm_remote_system_md == NULL) {
+                goto error_out;
+            }
+            break;
+        default:
+            LOG_ERROR("Encountered unsupported command '%s' while parsing user input", option_values->command);
+            goto error_out;
+    }
 
     return command;
+
+error_out:
+    DO_FREE(command);
+    return NULL;
 }
 
-ResyncDaemonCommand *
+ResyncServerCommand *
 parse_options(int argc, char **argv)
 {
     OptionValues *option_values = (OptionValues *) do_calloc(1, sizeof(OptionValues));
@@ -499,7 +604,7 @@ parse_options(int argc, char **argv)
         goto error_out;
     }
 
-    ResyncDaemonCommand *command = optionValues_to_ResyncDaemonCommand(option_values);
+    ResyncServerCommand *command = optionValues_to_resyncServerCommand(option_values);
     free_optionValues(&option_values);
 
     return command;
@@ -2,7 +2,8 @@
 #define RESYNC_OPTIONS_H
 
 #include "../util/fs_util.h"
-#include "../types.h"
+#include "../util/debug.h"
+#include "../types/mappers.h"
 
 #include <stdbool.h>
 #include <getopt.h>
@@ -63,6 +64,6 @@
 #define ALLOWED_SHORT_OPTIONS "p:h:u:c:"
 
 
-ResyncDaemonCommand *parse_options(int argc, char **argv);
+ResyncServerCommand *parse_options(int argc, char **argv);
 
 #endif //RESYNC_OPTIONS_H
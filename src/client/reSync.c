@@ -12,6 +12,7 @@ usage(void)
               "SSH --hostname HOSTNAME [--username USERNAME] [--identity-file IDENTITY_FILE_PATH]"
               " | SSH_HOST_ALIAS --ssh-host-alias ALIAS"
               " | RSYNC_DAEMON --hostname HOSTNAME [--username USERNAME] [--port PORT_NUMBER]"
+              " | LOCAL_PATH"
               "}");
 
     LOG_ERROR("\nOptions:");
@@ -55,13 +56,13 @@ send_cmd_to_daemon(char *stringified_command)
 int
 main(const int argc, char **argv)
 {
-    ResyncDaemonCommand *command = parse_options(argc, argv);
+    ResyncServerCommand *command = parse_options(argc, argv);
     if (command == NULL) {
         usage();
     }
 
     char *error_msg;
-    char *stringified_command = resync_daemon_command_to_stringified_json(command, &error_msg);
+    char *stringified_command = resyncServerCommand_to_stringified_json(command, &error_msg);
     if (stringified_command == NULL) {
         if (error_msg != NULL) {
             fatal_custom_error(error_msg);
@@ -0,0 +1,207 @@
+#include "admission.h"
+
+static uint64_t
+current_time_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000 + (uint64_t) now.tv_nsec / 1000000;
+}
+
+static RemoteHostAdmissionState *
+get_host_state(AdmissionController *controller, const char *host)
+{
+    RemoteHostAdmissionState *state;
+    HASH_FIND_STR(controller->hosts, host, state);
+    if (state == NULL) {
+        state = (RemoteHostAdmissionState *) do_calloc(1, sizeof(RemoteHostAdmissionState));
+        state->host = resync_strdup(host);
+        HASH_ADD_KEYPTR(hh, controller->hosts, state->host, strlen(state->host), state);
+    }
+
+    return state;
+}
+
+static void
+destroy_admission_request(AdmissionRequest **request)
+{
+    for (size_t i = 0; i < (*request)->remote_hosts_count; i++) {
+        DO_FREE((*request)->remote_hosts[i]);
+    }
+    DO_FREE((*request)->remote_hosts);
+    DO_FREE((*request)->ws_path);
+    DO_FREE(*request);
+}
+
+static AdmissionRequest *
+create_admission_request(const WorkspaceInformation *ws_info)
+{
+    AdmissionRequest *request = (AdmissionRequest *) do_calloc(1, sizeof(AdmissionRequest));
+    request->ws_path = resync_strdup(ws_info->local_workspace_root_path);
+    request->priority = ws_info->priority;
+
+    size_t remote_systems_count = 0;
+    RemoteWorkspaceMetadata *remote_system;
+    LL_COUNT(ws_info->remote_systems, remote_system, remote_systems_count);
+    request->remote_hosts = (char **) do_calloc(remote_systems_count + 1, sizeof(char *));
+
+    // A workspace may be synced to multiple paths on the same host, but it only occupies the host once
+    LL_FOREACH(ws_info->remote_systems, remote_system) {
+        const char *host = get_remote_system_host(remote_system);
+        if (host == NULL) {
+            continue;
+        }
+
+        bool is_duplicate = false;
+        for (size_t i = 0; i < request->remote_hosts_count && !is_duplicate; i++) {
+            is_duplicate = is_equal(request->remote_hosts[i], host);
+        }
+
+        if (!is_duplicate) {
+            request->remote_hosts[request->remote_hosts_count++] = resync_strdup(host);
+        }
+    }
+
+    return request;
+}
+
+AdmissionController *
+create_admission_controller(const int max_initial_syncs_per_host, const int stagger_interval_ms)
+{
+    AdmissionController *controller = (AdmissionController *) do_calloc(1, sizeof(AdmissionController));
+    controller->max_initial_syncs_per_host = max_initial_syncs_per_host;
+    controller->stagger_interval_ms = stagger_interval_ms;
+    return controller;
+}
+
+void
+destroy_admission_controller(AdmissionController **controller)
+{
+    if (controller == NULL || *controller == NULL) {
+        return;
+    }
+
+    AdmissionRequest *request, *tmp_request;
+    LL_FOREACH_SAFE((*controller)->requests, request, tmp_request) {
+        LL_DELETE((*controller)->requests, request);
+        destroy_admission_request(&request);
+    }
+
+    RemoteHostAdmissionState *state, *tmp_state;
+    HASH_ITER(hh, (*controller)->hosts, state, tmp_state) {
+        HASH_DEL((*controller)->hosts, state);
+        DO_FREE(state->host);
+        DO_FREE(state);
+    }
+
+    DO_FREE(*controller);
+}
+
+void
+request_initial_sync_admission(AdmissionController *controller, const WorkspaceInformation *ws_info)
+{
+    release_initial_sync_admission(controller, ws_info->local_workspace_root_path);
+
+    AdmissionRequest *request = create_admission_request(ws_info);
+
+    // Insert behind all requests with the same or a higher priority
+    AdmissionRequest *predecessor = NULL;
+    AdmissionRequest *entry;
+    LL_FOREACH(controller->requests, entry) {
+        if (entry->priority < request->priority) {
+            break;
+        }
+        predecessor = entry;
+    }
+
+    if (predecessor == NULL) {
+        LL_PREPEND(controller->requests, request);
+    } else {
+        LL_APPEND_ELEM(controller->requests, predecessor, request);
+    }
+}
+
+void
+release_initial_sync_admission(AdmissionController *controller, const char *ws_path)
+{
+    AdmissionRequest *request, *tmp;
+    LL_FOREACH_SAFE(controller->requests, request, tmp) {
+        if (!is_equal(request->ws_path, ws_path)) {
+            continue;
+        }
+
+        if (request->granted) {
+            for (size_t i = 0; i < request->remote_hosts_count; i++) {
+                get_host_state(controller, request->remote_hosts[i])->initial_syncs_in_flight--;
+            }
+        }
+
+        LL_DELETE(controller->requests, request);
+        destroy_admission_request(&request);
+        return;
+    }
+}
+
+int
+dispatch_initial_sync_admissions(AdmissionController *controller, AdmissionGrantCallback callback, void *context)
+{
+    const uint64_t now = current_time_ms();
+    int64_t next_dispatch_in_ms = -1;
+
+    RemoteHostAdmissionState *state, *tmp_state;
+    HASH_ITER(hh, controller->hosts, state, tmp_state) {
+        state->reserved = false;
+    }
+
+    AdmissionRequest *request;
+    LL_FOREACH(controller->requests, request) {
+        if (request->granted) {
+            continue;
+        }
+
+        bool is_admissible = true;
+        bool is_waiting_for_slot = false;
+        int64_t wait_ms = 0;
+
+        for (size_t i = 0; i < request->remote_hosts_count; i++) {
+            state = get_host_state(controller, request->remote_hosts[i]);
+
+            if (state->reserved || state->initial_syncs_in_flight >= controller->max_initial_syncs_per_host) {
+                is_admissible = false;
+                is_waiting_for_slot = true;
+                continue;
+            }
+
+            const uint64_t elapsed_ms = now - state->last_grant_ms;
+            if (state->last_grant_ms != 0 && elapsed_ms < (uint64_t) controller->stagger_interval_ms) {
+                is_admissible = false;
+                if ((int64_t) (controller->stagger_interval_ms - elapsed_ms) > wait_ms) {
+                    wait_ms = (int64_t) (controller->stagger_interval_ms - elapsed_ms);
+                }
+            }
+        }
+
+        if (!is_admissible) {
+            // Workspaces with a lower priority must not overtake this one on any of its hosts
+            for (size_t i = 0; i < request->remote_hosts_count; i++) {
+                get_host_state(controller, request->remote_hosts[i])->reserved = true;
+            }
+
+            if (!is_waiting_for_slot && (next_dispatch_in_ms == -1 || wait_ms < next_dispatch_in_ms)) {
+                next_dispatch_in_ms = wait_ms;
+            }
+            continue;
+        }
+
+        request->granted = true;
+        for (size_t i = 0; i < request->remote_hosts_count; i++) {
+            state = get_host_state(controller, request->remote_hosts[i]);
+            state->initial_syncs_in_flight++;
+            state->last_grant_ms = now;
+        }
+
+        callback(request->ws_path, context);
+    }
+
+    return (int) next_dispatch_in_ms;
+}
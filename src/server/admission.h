@@ -0,0 +1,72 @@
+#ifndef RESYNC_ADMISSION_H
+#define RESYNC_ADMISSION_H
+
+#include "../util/string.h"
+#include "../util/memory.h"
+#include "../util/error.h"
+#include "../types/types.h"
+#include "../../lib/ulist.h"
+#include "../../lib/utash.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+/*
+ * Admission control for the initial sync of freshly started workspace monitors. Instead of syncing right away, a
+ *  monitor waits until the daemon admits it, so that starting many workspaces does not hit the same remote hosts all
+ *  at once. Per remote host, only a limited number of initial syncs run concurrently and consecutive ones are started
+ *  with a minimum delay. Waiting workspaces are admitted in the order of their priority.
+ */
+
+typedef struct AdmissionRequest {
+    char *ws_path;
+    int priority;
+    char **remote_hosts;
+    size_t remote_hosts_count;
+    bool granted;
+    struct AdmissionRequest *next;
+} AdmissionRequest;
+
+typedef struct RemoteHostAdmissionState {
+    char *host;
+    int initial_syncs_in_flight;
+    uint64_t last_grant_ms;
+    /* Set while dispatching, if a waiting workspace with a higher priority syncs to this host */
+    bool reserved;
+    UT_hash_handle hh;
+} RemoteHostAdmissionState;
+
+typedef struct AdmissionController {
+    int max_initial_syncs_per_host;
+    int stagger_interval_ms;
+    /* Ordered by descending priority, requests with the same priority are kept in the order of their arrival */
+    AdmissionRequest *requests;
+    RemoteHostAdmissionState *hosts;
+} AdmissionController;
+
+typedef void (*AdmissionGrantCallback)(const char *ws_path, void *context);
+
+AdmissionController *create_admission_controller(const int max_initial_syncs_per_host, const int stagger_interval_ms);
+
+void destroy_admission_controller(AdmissionController **controller);
+
+/**
+ * Enqueues the initial sync of the workspace. A pending or granted request for the same workspace is replaced.
+ */
+void request_initial_sync_admission(AdmissionController *controller, const WorkspaceInformation *ws_info);
+
+/**
+ * Removes the workspace's request, either because its initial sync finished or because its monitor is gone.
+ */
+void release_initial_sync_admission(AdmissionController *controller, const char *ws_path);
+
+/**
+ * Admits all waiting workspaces whose initial sync can start now and invokes the callback for each of them.
+ *
+ * @return the number of milliseconds until another waiting workspace can be admitted without any initial sync
+ *  finishing in the meantime, or -1 if there is no such workspace
+ */
+int dispatch_initial_sync_admissions(AdmissionController *controller, AdmissionGrantCallback callback, void *context);
+
+#endif //RESYNC_ADMISSION_H
@@ -0,0 +1,736 @@
+#include "agent_connection.h"
+
+AgentConnection *
+create_agent_connection(RemoteWorkspaceMetadata *remote_system)
+{
+    AgentConnection *connection = (AgentConnection *) do_calloc(1, sizeof(AgentConnection));
+    connection->remote_system = remote_system;
+    connection->pid = -1;
+    connection->fd = -1;
+    return connection;
+}
+
+static void
+add_fallback_directory(AgentConnection *connection, const char *directory)
+{
+    AgentFallbackDirectory *entry;
+    LL_FOREACH(connection->fallback_directories, entry) {
+        if (is_equal(entry->path_relative_to_ws_root, directory)) {
+            return;
+        }
+    }
+
+    entry = (AgentFallbackDirectory *) do_calloc(1, sizeof(AgentFallbackDirectory));
+    entry->path_relative_to_ws_root = resync_strdup(directory);
+    LL_APPEND(connection->fallback_directories, entry);
+}
+
+static void
+destroy_pending_record(AgentConnection *connection, PendingAgentRecord *record)
+{
+    LL_DELETE(connection->pending_records, record);
+    connection->pending_records_count--;
+    DO_FREE(record->fallback_directory);
+    DO_FREE(record);
+}
+
+static void
+disconnect_agent(AgentConnection *connection)
+{
+    if (connection->fd != -1) {
+        close(connection->fd);
+        connection->fd = -1;
+    }
+
+    if (connection->pid != -1) {
+        kill(connection->pid, SIGTERM);
+        waitpid(connection->pid, NULL, 0);
+        connection->pid = -1;
+    }
+}
+
+void
+destroy_agent_connection(AgentConnection **connection)
+{
+    if (connection == NULL || *connection == NULL) {
+        return;
+    }
+
+    disconnect_agent(*connection);
+
+    while ((*connection)->pending_records != NULL) {
+        destroy_pending_record(*connection, (*connection)->pending_records);
+    }
+
+    AgentFallbackDirectory *entry, *tmp;
+    LL_FOREACH_SAFE((*connection)->fallback_directories, entry, tmp) {
+        LL_DELETE((*connection)->fallback_directories, entry);
+        DO_FREE(entry->path_relative_to_ws_root);
+        DO_FREE(entry);
+    }
+
+    DO_FREE(*connection);
+}
+
+/*
+ * Closes the broken connection and schedules the reconnect. The state of the remote workspace is unknown for all
+ *  records in flight, so their directories have to be synced with rsync.
+ */
+static void
+handle_agent_failure(AgentConnection *connection)
+{
+    disconnect_agent(connection);
+
+    while (connection->pending_records != NULL) {
+        add_fallback_directory(connection, connection->pending_records->fallback_directory);
+        destroy_pending_record(connection, connection->pending_records);
+    }
+
+    int backoff_sec = AGENT_INITIAL_RECONNECT_BACKOFF_SEC;
+    for (int i = 0; i < connection->consecutive_failures && backoff_sec < AGENT_MAX_RECONNECT_BACKOFF_SEC; i++) {
+        backoff_sec *= 2;
+    }
+    if (backoff_sec > AGENT_MAX_RECONNECT_BACKOFF_SEC) {
+        backoff_sec = AGENT_MAX_RECONNECT_BACKOFF_SEC;
+    }
+
+    connection->consecutive_failures++;
+    connection->reconnect_at = time(NULL) + backoff_sec;
+
+    LOG_ERROR(
+            "Connection to the agent of remote workspace '%s' on '%s' broke, reconnecting in %d s",
+            connection->remote_system->remote_workspace_root_path,
+            get_remote_system_host(connection->remote_system),
+            backoff_sec
+    );
+}
+
+/*
+ * Reads the acknowledgement of the oldest record in flight.
+ *
+ * @return false if the connection broke
+ */
+static bool
+receive_agent_ack(AgentConnection *connection)
+{
+    char *error_msg = NULL;
+
+    AgentRecord *ack = receive_agent_record(connection->fd, &error_msg);
+    if (ack == NULL) {
+        LOG_ERROR("Agent closed the stream: %s", (error_msg != NULL) ? error_msg : "End of stream");
+        DO_FREE(error_msg);
+        handle_agent_failure(connection);
+        return false;
+    }
+
+    PendingAgentRecord *record = connection->pending_records;
+
+    ByteBufferReader reader = create_agent_record_reader(ack);
+    const uint8_t status = agent_record_read_u8(&reader);
+    const char *ack_error_msg = agent_record_read_string_view(&reader);
+
+    if (ack->type != AGENT_ACK || reader.error || record == NULL || ack->seq != record->seq) {
+        LOG_ERROR("Agent sent an unexpected record of type '%d' with sequence number '%u'", ack->type, ack->seq);
+        destroy_agent_record(&ack);
+        handle_agent_failure(connection);
+        return false;
+    }
+
+    if (status != AGENT_ACK_OK) {
+        LOG_ERROR("Agent failed to apply a change: %s", (ack_error_msg != NULL) ? ack_error_msg : "Unknown error");
+        add_fallback_directory(connection, record->fallback_directory);
+    } else {
+        connection->consecutive_failures = 0;
+    }
+
+    destroy_pending_record(connection, record);
+    destroy_agent_record(&ack);
+    return true;
+}
+
+/*
+ * @return false if the connection broke
+ */
+static bool
+send_pending_record(AgentConnection *connection, ByteBuffer *record, const uint32_t seq, const char *fallback_directory)
+{
+    while (connection->pending_records_count >= AGENT_MAX_IN_FLIGHT_RECORDS) {
+        if (!receive_agent_ack(connection)) {
+            add_fallback_directory(connection, fallback_directory);
+            return false;
+        }
+    }
+
+    char *error_msg = NULL;
+    if (!send_agent_record(connection->fd, record, &error_msg)) {
+        LOG_ERROR("%s", error_msg);
+        DO_FREE(error_msg);
+        add_fallback_directory(connection, fallback_directory);
+        handle_agent_failure(connection);
+        return false;
+    }
+
+    PendingAgentRecord *pending_record = (PendingAgentRecord *) do_calloc(1, sizeof(PendingAgentRecord));
+    pending_record->seq = seq;
+    pending_record->fallback_directory = resync_strdup(fallback_directory);
+    LL_APPEND(connection->pending_records, pending_record);
+    connection->pending_records_count++;
+
+    return true;
+}
+
+static bool
+spawn_agent(AgentConnection *connection)
+{
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) == -1) {
+        LOG_ERROR("Unable to create the agent stream: %s", strerror(errno));
+        return false;
+    }
+
+    char *quoted_root_path = quote_shell_argument(connection->remote_system->remote_workspace_root_path);
+    char *remote_command = format_string("%s %s", AGENT_REMOTE_COMMAND, quoted_root_path);
+    char **args = construct_ssh_remote_command_arguments(connection->remote_system, remote_command);
+    DO_FREE(remote_command);
+    DO_FREE(quoted_root_path);
+
+    const pid_t pid = fork();
+    if (pid == 0) {
+        if (dup2(sockets[1], STDIN_FILENO) == -1 || dup2(sockets[1], STDOUT_FILENO) == -1) {
+            fatal_error("dup2");
+        }
+        signal(SIGPIPE, SIG_DFL);
+
+        execvp("ssh", args);
+        fatal_error("execvp");
+    }
+
+    for (char **arg = args; *arg != NULL; arg++) {
+        DO_FREE(*arg);
+    }
+    DO_FREE(args);
+    close(sockets[1]);
+
+    if (pid == -1) {
+        LOG_ERROR("Unable to start the agent: %s", strerror(errno));
+        close(sockets[0]);
+        return false;
+    }
+
+    connection->pid = pid;
+    connection->fd = sockets[0];
+    return true;
+}
+
+static bool
+connect_agent(AgentConnection *connection)
+{
+    if (!spawn_agent(connection)) {
+        return false;
+    }
+
+    connection->next_seq = 0;
+    const uint32_t seq = connection->next_seq++;
+
+    ByteBuffer *hello = create_agent_record(AGENT_HELLO, seq);
+    agent_record_append_u32(hello, AGENT_PROTOCOL_VERSION);
+
+    char *error_msg = NULL;
+    const bool is_sent = send_agent_record(connection->fd, hello, &error_msg);
+    destroy_byte_buffer(&hello);
+
+    AgentRecord *ack = is_sent ? receive_agent_record(connection->fd, &error_msg) : NULL;
+    if (ack == NULL) {
+        LOG_ERROR("Unable to connect to the agent: %s", (error_msg != NULL) ? error_msg : "Agent terminated");
+        DO_FREE(error_msg);
+        disconnect_agent(connection);
+        return false;
+    }
+
+    ByteBufferReader reader = create_agent_record_reader(ack);
+    const uint8_t status = agent_record_read_u8(&reader);
+    const char *ack_error_msg = agent_record_read_string_view(&reader);
+
+    const bool res = ack->type == AGENT_ACK && ack->seq == seq && !reader.error && status == AGENT_ACK_OK;
+    if (res == false) {
+        LOG_ERROR("Agent rejected the connection: %s", (ack_error_msg != NULL) ? ack_error_msg : "Invalid acknowledgement");
+        disconnect_agent(connection);
+    }
+
+    destroy_agent_record(&ack);
+    return res;
+}
+
+bool
+ensure_agent_connected(AgentConnection *connection)
+{
+    if (connection->fd != -1) {
+        return true;
+    }
+
+    if (time(NULL) < connection->reconnect_at) {
+        return false;
+    }
+
+    if (!connect_agent(connection)) {
+        handle_agent_failure(connection);
+        return false;
+    }
+
+    LOG(
+            "Connected to the agent of remote workspace '%s' on '%s'",
+            connection->remote_system->remote_workspace_root_path,
+            get_remote_system_host(connection->remote_system)
+    );
+    return true;
+}
+
+/*
+ * Requests the signature of the remote version of the file. Other records in flight are awaited first, as the
+ *  acknowledgement carrying the signature is read directly.
+ *
+ * @return the signature, or NULL if the file does not exist remotely or the connection broke
+ */
+static FileSignature *
+request_agent_signature(AgentConnection *connection, const char *relative_path, const char *fallback_directory)
+{
+    await_agent_acks(connection);
+    if (connection->fd == -1) {
+        add_fallback_directory(connection, fallback_directory);
+        return NULL;
+    }
+
+    const uint32_t seq = connection->next_seq++;
+    ByteBuffer *request = create_agent_record(AGENT_SIGNATURE, seq);
+    agent_record_append_string(request, relative_path);
+
+    char *error_msg = NULL;
+    const bool is_sent = send_agent_record(connection->fd, request, &error_msg);
+    destroy_byte_buffer(&request);
+
+    AgentRecord *ack = is_sent ? receive_agent_record(connection->fd, &error_msg) : NULL;
+    if (ack == NULL) {
+        LOG_ERROR("Unable to request the signature of '%s': %s", relative_path, (error_msg != NULL) ? error_msg : "Agent terminated");
+        DO_FREE(error_msg);
+        add_fallback_directory(connection, fallback_directory);
+        handle_agent_failure(connection);
+        return NULL;
+    }
+
+    ByteBufferReader reader = create_agent_record_reader(ack);
+    const uint8_t status = agent_record_read_u8(&reader);
+    agent_record_read_string_view(&reader);
+
+    if (ack->type != AGENT_ACK || ack->seq != seq || reader.error) {
+        LOG_ERROR("Agent sent an unexpected record of type '%d' with sequence number '%u'", ack->type, ack->seq);
+        destroy_agent_record(&ack);
+        add_fallback_directory(connection, fallback_directory);
+        handle_agent_failure(connection);
+        return NULL;
+    }
+
+    // Typically the file does not exist remotely yet, in which case it is transmitted entirely
+    FileSignature *signature = (status == AGENT_ACK_OK) ? read_file_signature(&reader) : NULL;
+    if (signature != NULL && reader.offset != reader.size) {
+        destroy_file_signature(&signature);
+    }
+
+    destroy_agent_record(&ack);
+    return signature;
+}
+
+/* Splits the delta into 'AGENT_DELTA' records */
+typedef struct AgentDeltaStream {
+    AgentConnection *connection;
+    const char *relative_path;
+    const char *fallback_directory;
+    mode_t mode;
+    uint32_t block_size;
+    uint8_t flags;
+    ByteBuffer *operations;
+    uint64_t literal_size;
+} AgentDeltaStream;
+
+static bool
+send_agent_delta_record(AgentDeltaStream *stream, const uint64_t file_size, const uint64_t file_hash)
+{
+    const uint32_t seq = stream->connection->next_seq++;
+    ByteBuffer *record = create_agent_record(AGENT_DELTA, seq);
+    agent_record_append_string(record, stream->relative_path);
+    agent_record_append_u32(record, stream->mode & 07777);
+    agent_record_append_u8(record, stream->flags);
+    agent_record_append_u32(record, stream->block_size);
+    agent_record_append_bytes(record, stream->operations->data, stream->operations->size);
+    if (stream->flags & AGENT_WRITE_LAST_CHUNK) {
+        agent_record_append_u64(record, file_size);
+        agent_record_append_u64(record, file_hash);
+    }
+
+    const bool res = send_pending_record(stream->connection, record, seq, stream->fallback_directory);
+    destroy_byte_buffer(&record);
+
+    stream->flags &= ~AGENT_WRITE_FIRST_CHUNK;
+    stream->operations->size = 0;
+    return res;
+}
+
+/*
+ * Sends the operations buffered so far once the next operation would exceed the size of a chunk.
+ */
+static bool
+reserve_agent_delta_operation(AgentDeltaStream *stream, const size_t operation_size)
+{
+    if (stream->operations->size + operation_size <= AGENT_WRITE_CHUNK_SIZE) {
+        return true;
+    }
+    return send_agent_delta_record(stream, 0, 0);
+}
+
+static bool
+emit_agent_delta_copy(void *ctx, const uint32_t block_index, const uint32_t block_count)
+{
+    AgentDeltaStream *stream = (AgentDeltaStream *) ctx;
+    if (!reserve_agent_delta_operation(stream, sizeof(uint8_t) + 2 * sizeof(uint32_t))) {
+        return false;
+    }
+
+    agent_record_append_u8(stream->operations, AGENT_DELTA_COPY);
+    agent_record_append_u32(stream->operations, block_index);
+    agent_record_append_u32(stream->operations, block_count);
+    return true;
+}
+
+static bool
+emit_agent_delta_literal(void *ctx, const char *data, const uint32_t size)
+{
+    AgentDeltaStream *stream = (AgentDeltaStream *) ctx;
+    if (!reserve_agent_delta_operation(stream, sizeof(uint8_t) + sizeof(uint32_t) + size)) {
+        return false;
+    }
+
+    agent_record_append_u8(stream->operations, AGENT_DELTA_LITERAL);
+    agent_record_append_bytes(stream->operations, data, size);
+    stream->literal_size += size;
+    return true;
+}
+
+static void
+send_agent_file_delta(AgentConnection *connection, const int fd, const mode_t mode, const FileSignature *signature,
+                      const char *relative_path, const char *fallback_directory)
+{
+    AgentDeltaStream stream = {
+            .connection = connection,
+            .relative_path = relative_path,
+            .fallback_directory = fallback_directory,
+            .mode = mode,
+            .block_size = signature->block_size,
+            .flags = AGENT_WRITE_FIRST_CHUNK,
+            .operations = create_byte_buffer(AGENT_WRITE_CHUNK_SIZE),
+            .literal_size = 0
+    };
+    const DeltaEmitter emitter = {
+            .copy = emit_agent_delta_copy,
+            .literal = emit_agent_delta_literal,
+            .ctx = &stream
+    };
+
+    uint64_t file_size, file_hash;
+    char *error_msg = NULL;
+
+    if (!generate_delta(fd, signature, &emitter, &file_size, &file_hash, &error_msg)) {
+        // Records that were not sent are covered by the fallback of the broken connection. If the file could not be
+        //  read, the incomplete transfer is discarded by the agent once the next one starts.
+        if (connection->fd != -1) {
+            LOG_ERROR("Unable to stream the delta of '%s': %s", relative_path, error_msg);
+            add_fallback_directory(connection, fallback_directory);
+        }
+        DO_FREE(error_msg);
+    } else {
+        stream.flags |= AGENT_WRITE_LAST_CHUNK;
+        if (send_agent_delta_record(&stream, file_size, file_hash)) {
+            LOG(
+                    "Streamed delta of '%s' with %llu of %llu bytes of literal data",
+                    relative_path,
+                    (unsigned long long) stream.literal_size,
+                    (unsigned long long) file_size
+            );
+        }
+    }
+
+    destroy_byte_buffer(&stream.operations);
+}
+
+void
+send_agent_file(AgentConnection *connection, const char *local_path, const char *relative_path,
+                const char *fallback_directory)
+{
+    if (connection->fd == -1) {
+        add_fallback_directory(connection, fallback_directory);
+        return;
+    }
+
+    const int fd = open(local_path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd == -1) {
+        // A file that was deleted in the meantime is deleted remotely by the corresponding event
+        if (errno != ENOENT) {
+            add_fallback_directory(connection, fallback_directory);
+        }
+        return;
+    }
+
+    // Only the content of regular files can be streamed, rsync takes care of everything else
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1 || !S_ISREG(file_stat.st_mode)) {
+        add_fallback_directory(connection, fallback_directory);
+        close(fd);
+        return;
+    }
+
+    if ((uint64_t) file_stat.st_size >= AGENT_DELTA_MIN_FILE_SIZE) {
+        FileSignature *signature = request_agent_signature(connection, relative_path, fallback_directory);
+        const bool is_delta_sent = (signature != NULL);
+        if (is_delta_sent) {
+            send_agent_file_delta(connection, fd, file_stat.st_mode, signature, relative_path, fallback_directory);
+            destroy_file_signature(&signature);
+        }
+
+        if (is_delta_sent || connection->fd == -1) {
+            close(fd);
+            return;
+        }
+    }
+
+    char *chunk = (char *) do_malloc(AGENT_WRITE_CHUNK_SIZE);
+    uint8_t flags = AGENT_WRITE_FIRST_CHUNK;
+
+    while (connection->fd != -1) {
+        const ssize_t chunk_size = read(fd, chunk, AGENT_WRITE_CHUNK_SIZE);
+        if (chunk_size == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // The incomplete transfer is discarded by the agent once the next one starts
+            add_fallback_directory(connection, fallback_directory);
+            break;
+        }
+
+        // A file that is still growing is transmitted up to the point where a read first comes up short, the
+        //  remaining content is transmitted when the writer closes the file
+        if (chunk_size < (ssize_t) AGENT_WRITE_CHUNK_SIZE) {
+            flags |= AGENT_WRITE_LAST_CHUNK;
+        }
+
+        const uint32_t seq = connection->next_seq++;
+        ByteBuffer *record = create_agent_record(AGENT_WRITE, seq);
+        agent_record_append_string(record, relative_path);
+        agent_record_append_u32(record, file_stat.st_mode & 07777);
+        agent_record_append_u8(record, flags);
+        agent_record_append_bytes(record, chunk, (uint32_t) chunk_size);
+
+        const bool is_sent = send_pending_record(connection, record, seq, fallback_directory);
+        destroy_byte_buffer(&record);
+
+        if (!is_sent || (flags & AGENT_WRITE_LAST_CHUNK)) {
+            break;
+        }
+        flags = 0;
+    }
+
+    DO_FREE(chunk);
+    close(fd);
+}
+
+void
+send_agent_appended_data(AgentConnection *connection, const char *local_path, const char *relative_path,
+                         const uint64_t offset, const char *fallback_directory)
+{
+    if (connection->fd == -1) {
+        add_fallback_directory(connection, fallback_directory);
+        return;
+    }
+
+    const int fd = open(local_path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd == -1) {
+        if (errno != ENOENT) {
+            add_fallback_directory(connection, fallback_directory);
+        }
+        return;
+    }
+
+    char *chunk = (char *) do_malloc(AGENT_WRITE_CHUNK_SIZE);
+    uint64_t chunk_offset = offset;
+
+    // Just like files that are written entirely, data is transmitted up to the point where a read first comes up short
+    while (connection->fd != -1) {
+        const ssize_t chunk_size = pread(fd, chunk, AGENT_WRITE_CHUNK_SIZE, (off_t) chunk_offset);
+        if (chunk_size == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            add_fallback_directory(connection, fallback_directory);
+            break;
+        } else if (chunk_size == 0) {
+            break;
+        }
+
+        const uint32_t seq = connection->next_seq++;
+        ByteBuffer *record = create_agent_record(AGENT_APPEND, seq);
+        agent_record_append_string(record, relative_path);
+        agent_record_append_u64(record, chunk_offset);
+        agent_record_append_bytes(record, chunk, (uint32_t) chunk_size);
+
+        const bool is_sent = send_pending_record(connection, record, seq, fallback_directory);
+        destroy_byte_buffer(&record);
+
+        if (!is_sent || chunk_size < (ssize_t) AGENT_WRITE_CHUNK_SIZE) {
+            break;
+        }
+        chunk_offset += (uint64_t) chunk_size;
+    }
+
+    DO_FREE(chunk);
+    close(fd);
+}
+
+void
+send_agent_change(AgentConnection *connection, const AgentRecordType type, const char *relative_path,
+                  const char *relative_target_path, const mode_t mode, const char *fallback_directory)
+{
+    if (connection->fd == -1) {
+        add_fallback_directory(connection, fallback_directory);
+        return;
+    }
+
+    const uint32_t seq = connection->next_seq++;
+    ByteBuffer *record = create_agent_record(type, seq);
+    agent_record_append_string(record, relative_path);
+
+    switch (type) {
+        case AGENT_MKDIR:
+        case AGENT_CHMOD:
+            agent_record_append_u32(record, mode & 07777);
+            break;
+        case AGENT_RENAME:
+            agent_record_append_string(record, relative_target_path);
+            break;
+        case AGENT_DELETE:
+        default:
+            break;
+    }
+
+    send_pending_record(connection, record, seq, fallback_directory);
+    destroy_byte_buffer(&record);
+}
+
+void
+await_agent_acks(AgentConnection *connection)
+{
+    while (connection->pending_records != NULL && receive_agent_ack(connection)) {
+        ;
+    }
+}
+
+/*
+ * Sends a request whose acknowledgement is read directly, once all records in flight are acknowledged.
+ *
+ * @param reader set to a reader of the acknowledgement that is positioned after its error message
+ * @return the acknowledgement, which has to be freed by the caller, or NULL if the connection broke
+ */
+static AgentRecord *
+exchange_agent_request(AgentConnection *connection, ByteBuffer *request, const uint32_t seq, const char *description,
+                       ByteBufferReader *reader, uint8_t *status)
+{
+    char *error_msg = NULL;
+    const bool is_sent = send_agent_record(connection->fd, request, &error_msg);
+
+    AgentRecord *ack = is_sent ? receive_agent_record(connection->fd, &error_msg) : NULL;
+    if (ack == NULL) {
+        LOG_ERROR("Unable to request %s: %s", description, (error_msg != NULL) ? error_msg : "Agent terminated");
+        DO_FREE(error_msg);
+        handle_agent_failure(connection);
+        return NULL;
+    }
+
+    *reader = create_agent_record_reader(ack);
+    *status = agent_record_read_u8(reader);
+    const char *ack_error_msg = agent_record_read_string_view(reader);
+
+    if (ack->type != AGENT_ACK || ack->seq != seq || reader->error) {
+        LOG_ERROR("Agent sent an unexpected record of type '%d' with sequence number '%u'", ack->type, ack->seq);
+        destroy_agent_record(&ack);
+        handle_agent_failure(connection);
+        return NULL;
+    }
+
+    if (*status != AGENT_ACK_OK) {
+        LOG_ERROR("Agent failed to provide %s: %s", description, (ack_error_msg != NULL) ? ack_error_msg : "Unknown error");
+    }
+    return ack;
+}
+
+bool
+send_agent_digest_rules(AgentConnection *connection, const IgnoreRules *ignore_rules, const uint8_t flags)
+{
+    await_agent_acks(connection);
+    if (connection->fd == -1) {
+        return false;
+    }
+
+    const uint32_t seq = connection->next_seq++;
+    ByteBuffer *request = create_agent_record(AGENT_DIGEST_RULES, seq);
+    agent_record_append_u8(request, flags);
+    agent_record_append_u32(request, (ignore_rules != NULL) ? (uint32_t) ignore_rules->rules_count : 0);
+    for (ssize_t i = 0; ignore_rules != NULL && i < ignore_rules->rules_count; i++) {
+        agent_record_append_string(request, ignore_rules->rules[i].line);
+    }
+
+    ByteBufferReader reader;
+    uint8_t status;
+    AgentRecord *ack = exchange_agent_request(connection, request, seq, "the index of the workspace", &reader, &status);
+    destroy_byte_buffer(&request);
+
+    const bool is_applied = (ack != NULL && status == AGENT_ACK_OK);
+    destroy_agent_record(&ack);
+    return is_applied;
+}
+
+DirectoryDigest *
+request_agent_digest(AgentConnection *connection, const char *relative_path)
+{
+    await_agent_acks(connection);
+    if (connection->fd == -1) {
+        return NULL;
+    }
+
+    const uint32_t seq = connection->next_seq++;
+    ByteBuffer *request = create_agent_record(AGENT_DIGEST, seq);
+    agent_record_append_string(request, relative_path);
+
+    char *description = format_string("the digest of '%s'", (relative_path != NULL) ? relative_path : ".");
+    ByteBufferReader reader;
+    uint8_t status;
+    AgentRecord *ack = exchange_agent_request(connection, request, seq, description, &reader, &status);
+    destroy_byte_buffer(&request);
+    DO_FREE(description);
+
+    if (ack == NULL || status != AGENT_ACK_OK) {
+        destroy_agent_record(&ack);
+        return NULL;
+    }
+
+    DirectoryDigest *digest = read_directory_digest(&reader);
+    if (digest != NULL && reader.offset != reader.size) {
+        destroy_directory_digest(&digest);
+    }
+
+    destroy_agent_record(&ack);
+    return digest;
+}
+
+AgentFallbackDirectory *
+take_agent_fallback_directories(AgentConnection *connection)
+{
+    AgentFallbackDirectory *fallback_directories = connection->fallback_directories;
+    connection->fallback_directories = NULL;
+    return fallback_directories;
+}
@@ -0,0 +1,138 @@
+#ifndef RESYNC_AGENT_CONNECTION_H
+#define RESYNC_AGENT_CONNECTION_H
+
+#include "../util/string.h"
+#include "../util/memory.h"
+#include "../util/error.h"
+#include "../util/debug.h"
+#include "../util/ignore_rules.h"
+#include "../types/types.h"
+#include "../../lib/ulist.h"
+#include "agent_protocol.h"
+#include "delta.h"
+#include "ssh_control.h"
+#include "workspace_index.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+
+/*
+ * Connection of a workspace monitor to the reSync agent of a remote system that uses the agent transport. The agent
+ *  is started through an ssh session, which is multiplexed over the daemon's master connection, and keeps running for
+ *  the lifetime of the connection.
+ *
+ * Change records are pipelined, i.e. the monitor does not wait for the acknowledgement of a record before sending the
+ *  next one. Directories whose records the agent failed to apply, or whose records were in flight when the connection
+ *  broke, are collected as fallback directories, which have to be synced with rsync instead. A broken connection is
+ *  reestablished with an exponential backoff.
+ */
+
+/* Number of records that may be sent without having been acknowledged */
+#define AGENT_MAX_IN_FLIGHT_RECORDS 256
+
+#define AGENT_INITIAL_RECONNECT_BACKOFF_SEC 1
+#define AGENT_MAX_RECONNECT_BACKOFF_SEC 60
+
+typedef struct AgentFallbackDirectory {
+    /* NULL for the workspace root */
+    char *path_relative_to_ws_root;
+    struct AgentFallbackDirectory *next;
+} AgentFallbackDirectory;
+
+typedef struct PendingAgentRecord {
+    uint32_t seq;
+    /* Directory to sync with rsync if the record is not applied */
+    char *fallback_directory;
+    struct PendingAgentRecord *next;
+} PendingAgentRecord;
+
+typedef struct AgentConnection {
+    RemoteWorkspaceMetadata *remote_system;
+    /* PID of the 'ssh' process running the agent and the monitor's end of its stdio, or -1 if not connected */
+    pid_t pid;
+    int fd;
+    uint32_t next_seq;
+    /* Records in the order they were sent, which is the order they are acknowledged in */
+    PendingAgentRecord *pending_records;
+    size_t pending_records_count;
+    AgentFallbackDirectory *fallback_directories;
+    int consecutive_failures;
+    time_t reconnect_at;
+    struct AgentConnection *next;
+} AgentConnection;
+
+/**
+ * Creates a connection that is established by the first call of 'ensure_agent_connected'. The remote system has to
+ *  outlive the connection.
+ */
+AgentConnection *create_agent_connection(RemoteWorkspaceMetadata *remote_system);
+
+/**
+ * Closes the connection without waiting for outstanding acknowledgements.
+ */
+void destroy_agent_connection(AgentConnection **connection);
+
+/**
+ * Connects to the agent unless the connection is already established or a reconnect is not due yet.
+ *
+ * @return true if the connection is established
+ */
+bool ensure_agent_connected(AgentConnection *connection);
+
+/**
+ * Streams the current content of the local file to the agent, which replaces the file at the relative path with it.
+ *  Files of at least 'AGENT_DELTA_MIN_FILE_SIZE' bytes that already exist remotely are transmitted as delta to their
+ *  remote version.
+ */
+void send_agent_file(AgentConnection *connection, const char *local_path, const char *relative_path,
+                     const char *fallback_directory);
+
+/**
+ * Streams the data of the local file from the offset on to the agent, which appends it to the remote file. The remote
+ *  file has to have the content of the local file up to the offset, otherwise the fallback directory is collected.
+ */
+void send_agent_appended_data(AgentConnection *connection, const char *local_path, const char *relative_path,
+                              const uint64_t offset, const char *fallback_directory);
+
+/**
+ * Sends a change record of type 'AGENT_DELETE', 'AGENT_MKDIR', 'AGENT_RENAME' or 'AGENT_CHMOD'. The target path is
+ *  only used by renames, the mode only by the creation of directories and mode changes.
+ */
+void send_agent_change(AgentConnection *connection, const AgentRecordType type, const char *relative_path,
+                       const char *relative_target_path, const mode_t mode, const char *fallback_directory);
+
+/**
+ * Blocks until all records that were sent are acknowledged or the connection broke.
+ */
+void await_agent_acks(AgentConnection *connection);
+
+/**
+ * Resets the index of the remote workspace, which the agent builds with the given ignore rules and index flags from
+ *  now on. Records in flight are awaited first.
+ *
+ * @return false if the agent rejected the rules or the connection broke
+ */
+bool send_agent_digest_rules(AgentConnection *connection, const IgnoreRules *ignore_rules, const uint8_t flags);
+
+/**
+ * Requests the digest of a directory of the remote workspace (see 'send_agent_digest_rules').
+ *
+ * @param relative_path NULL for the workspace root
+ * @return the digest, or NULL if the agent was unable to provide it, e.g. as the directory does not exist remotely, or
+ *  the connection broke
+ */
+DirectoryDigest *request_agent_digest(AgentConnection *connection, const char *relative_path);
+
+/**
+ * @return the collected fallback directories, which are owned by the caller from now on
+ */
+AgentFallbackDirectory *take_agent_fallback_directories(AgentConnection *connection);
+
+#endif //RESYNC_AGENT_CONNECTION_H
@@ -0,0 +1,189 @@
+#include "agent_protocol.h"
+
+#define AGENT_RECORD_HEADER_SIZE (sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint32_t))
+#define AGENT_NULL_STRING_LENGTH UINT32_MAX
+
+ByteBuffer *
+create_agent_record(const AgentRecordType type, const uint32_t seq)
+{
+    ByteBuffer *record = create_byte_buffer(128);
+
+    // The size is filled in once the record is sent
+    byte_buffer_append_u32(record, 0);
+    byte_buffer_append_u8(record, (uint8_t) type);
+    agent_record_append_u32(record, seq);
+
+    return record;
+}
+
+void
+agent_record_append_u8(ByteBuffer *record, const uint8_t value)
+{
+    byte_buffer_append_u8(record, value);
+}
+
+void
+agent_record_append_u32(ByteBuffer *record, const uint32_t value)
+{
+    byte_buffer_append_u32(record, htobe32(value));
+}
+
+void
+agent_record_append_u64(ByteBuffer *record, const uint64_t value)
+{
+    byte_buffer_append_u64(record, htobe64(value));
+}
+
+void
+agent_record_append_string(ByteBuffer *record, const char *string)
+{
+    if (string == NULL) {
+        agent_record_append_u32(record, AGENT_NULL_STRING_LENGTH);
+        return;
+    }
+
+    const uint32_t length = strlen(string);
+    agent_record_append_u32(record, length);
+    byte_buffer_append(record, string, length + 1);
+}
+
+void
+agent_record_append_bytes(ByteBuffer *record, const void *data, const uint32_t size)
+{
+    agent_record_append_u32(record, size);
+    byte_buffer_append(record, data, size);
+}
+
+bool
+send_agent_record(const int fd, ByteBuffer *record, char **error_msg)
+{
+    const uint32_t record_size = record->size - sizeof(uint32_t);
+    if (record_size > AGENT_MAX_RECORD_SIZE) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Agent record of '%u' bytes exceeds the maximum record size", record_size));
+        return false;
+    }
+
+    const uint32_t encoded_record_size = htobe32(record_size);
+    memcpy(record->data, &encoded_record_size, sizeof(encoded_record_size));
+
+    if (!write_all(fd, record->data, record->size)) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to send agent record: %s", strerror(errno)));
+        return false;
+    }
+
+    return true;
+}
+
+AgentRecord *
+receive_agent_record(const int fd, char **error_msg)
+{
+    char header[AGENT_RECORD_HEADER_SIZE];
+
+    const int ret = read_all(fd, header, sizeof(header));
+    if (ret == 0) {
+        return NULL;
+    } else if (ret < 0) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to receive agent record header: %s", strerror(errno)));
+        return NULL;
+    }
+
+    ByteBufferReader reader = create_byte_buffer_reader(header, sizeof(header));
+    const uint32_t record_size = agent_record_read_u32(&reader);
+    const uint8_t type = byte_buffer_read_u8(&reader);
+    const uint32_t seq = agent_record_read_u32(&reader);
+
+    if (record_size < AGENT_RECORD_HEADER_SIZE - sizeof(uint32_t) || record_size > AGENT_MAX_RECORD_SIZE) {
+        SET_ERROR_MSG_RAW(
+                error_msg,
+                format_string("Received agent record header announces an invalid record size of '%u' bytes", record_size)
+        );
+        return NULL;
+    }
+
+    AgentRecord *record = (AgentRecord *) do_calloc(1, sizeof(AgentRecord));
+    record->type = (AgentRecordType) type;
+    record->seq = seq;
+    record->body_size = record_size - (AGENT_RECORD_HEADER_SIZE - sizeof(uint32_t));
+    record->body = (char *) do_malloc(record->body_size + 1);
+
+    if (record->body_size > 0 && read_all(fd, record->body, record->body_size) != 1) {
+        SET_ERROR_MSG(error_msg, "Stream was closed before the entire agent record was received");
+        destroy_agent_record(&record);
+        return NULL;
+    }
+
+    return record;
+}
+
+void
+destroy_agent_record(AgentRecord **record)
+{
+    if (record == NULL || *record == NULL) {
+        return;
+    }
+
+    DO_FREE((*record)->body);
+    DO_FREE(*record);
+}
+
+ByteBufferReader
+create_agent_record_reader(const AgentRecord *record)
+{
+    return create_byte_buffer_reader(record->body, record->body_size);
+}
+
+uint8_t
+agent_record_read_u8(ByteBufferReader *reader)
+{
+    return byte_buffer_read_u8(reader);
+}
+
+uint32_t
+agent_record_read_u32(ByteBufferReader *reader)
+{
+    return be32toh(byte_buffer_read_u32(reader));
+}
+
+uint64_t
+agent_record_read_u64(ByteBufferReader *reader)
+{
+    return be64toh(byte_buffer_read_u64(reader));
+}
+
+const char *
+agent_record_read_string_view(ByteBufferReader *reader)
+{
+    const uint32_t length = agent_record_read_u32(reader);
+    if (reader->error || length == AGENT_NULL_STRING_LENGTH) {
+        return NULL;
+    }
+
+    const char *string = (const char *) byte_buffer_read(reader, (size_t) length + 1);
+    if (string == NULL) {
+        return NULL;
+    }
+
+    // Embedded NULL bytes would make the agent operate on a different path than the one that was sent
+    if (string[length] != '\0' || strlen(string) != length) {
+        reader->error = true;
+        return NULL;
+    }
+
+    return string;
+}
+
+const void *
+agent_record_read_bytes(ByteBufferReader *reader, uint32_t *size)
+{
+    *size = agent_record_read_u32(reader);
+    if (reader->error) {
+        *size = 0;
+        return NULL;
+    }
+
+    const void *data = byte_buffer_read(reader, *size);
+    if (data == NULL) {
+        *size = 0;
+    }
+    return data;
+}
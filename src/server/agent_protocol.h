@@ -0,0 +1,138 @@
+#ifndef RESYNC_AGENT_PROTOCOL_H
+#define RESYNC_AGENT_PROTOCOL_H
+
+#include "../util/string.h"
+#include "../util/memory.h"
+#include "../util/error.h"
+#include "../util/byte_buffer.h"
+#include "../socket.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <endian.h>
+
+/*
+ * Streaming change protocol spoken between a workspace monitor and the reSync agent running on a remote system (see
+ *  'agent/agent.h'). The monitor keeps one bidirectional stream to the agent open, e.g. the stdio of an ssh session,
+ *  and pipelines change records over it. The agent applies the records in order and acknowledges every record with an
+ *  'AGENT_ACK' record carrying the same sequence number.
+ *
+ * As monitor and agent run on different hosts, all integers are transmitted in network byte order. Every record is
+ *  framed by its size, followed by its type, its sequence number and its body. Strings are length prefixed and NULL
+ *  terminated, paths are always relative to the remote workspace root.
+ */
+
+#define AGENT_PROTOCOL_VERSION 5
+
+/* Name of the agent executable, which has to be found in the PATH of the remote user */
+#define AGENT_REMOTE_COMMAND "reSync-agent"
+
+/* Files are transmitted in chunks of at most this size, so that records stay small */
+#define AGENT_WRITE_CHUNK_SIZE ((uint32_t) (256 * 1024))
+/* Upper bound for the size of a single record, to guard against corrupted frames */
+#define AGENT_MAX_RECORD_SIZE ((uint32_t) (AGENT_WRITE_CHUNK_SIZE + 64 * 1024))
+
+/* Files smaller than this are always transmitted entirely, as their delta would not save a round trip */
+#define AGENT_DELTA_MIN_FILE_SIZE ((uint64_t) (64 * 1024))
+
+/* Flags of an 'AGENT_WRITE' or 'AGENT_DELTA' record */
+#define AGENT_WRITE_FIRST_CHUNK 0x1
+#define AGENT_WRITE_LAST_CHUNK 0x2
+
+typedef enum AgentRecordType {
+    OTHER_AGENT_RECORD_TYPE,
+    /* monitor -> agent: u32 protocol version */
+    AGENT_HELLO,
+    /* monitor -> agent: path, u32 mode, u8 flags, data. A file is replaced atomically once its last chunk arrived. */
+    AGENT_WRITE,
+    /* monitor -> agent: path. Directories are deleted along with their content. */
+    AGENT_DELETE,
+    /* monitor -> agent: path, u32 mode */
+    AGENT_MKDIR,
+    /* monitor -> agent: source path, target path */
+    AGENT_RENAME,
+    /* monitor -> agent: path, u32 mode */
+    AGENT_CHMOD,
+    /* monitor -> agent: path. The acknowledgement carries the signature of the file (see 'delta.h'). */
+    AGENT_SIGNATURE,
+    /* monitor -> agent: path, u32 mode, u8 flags, u32 block size, delta operations. The last chunk is followed by the
+     *  u64 size and the u64 hash of the file, which the agent verifies before it replaces the file. */
+    AGENT_DELTA,
+    /* agent -> monitor: u8 status, error message (NULL on success), record specific payload */
+    AGENT_ACK,
+    /* monitor -> agent: path, u64 offset, data. The data is appended to the existing file, whose size has to be the
+     *  offset. Otherwise the file differs from the monitor's former version of it and has to be transmitted entirely. */
+    AGENT_APPEND,
+    /* monitor -> agent: u8 index flags, u32 number of patterns, ignore patterns. Sent before every comparison, resets
+     *  the index of the remote workspace if the flags or ignore rules of the monitor's workspace changed (see
+     *  'workspace_index.h'). */
+    AGENT_DIGEST_RULES,
+    /* monitor -> agent: path (NULL for the workspace root). The acknowledgement carries the digest of the directory. */
+    AGENT_DIGEST
+} AgentRecordType;
+
+/* Operations of an 'AGENT_DELTA' record, each prefixed by its u8 type */
+typedef enum AgentDeltaOperation {
+    /* u32 index of the first block, u32 number of blocks */
+    AGENT_DELTA_COPY = 1,
+    /* data */
+    AGENT_DELTA_LITERAL = 2
+} AgentDeltaOperation;
+
+typedef enum AgentAckStatus {
+    AGENT_ACK_OK,
+    AGENT_ACK_ERROR
+} AgentAckStatus;
+
+typedef struct AgentRecord {
+    AgentRecordType type;
+    uint32_t seq;
+    /* Use the 'agent_record_read_*' functions to decode the body */
+    char *body;
+    uint32_t body_size;
+} AgentRecord;
+
+/**
+ * Starts a record whose body is appended with the 'agent_record_append_*' functions.
+ */
+ByteBuffer *create_agent_record(const AgentRecordType type, const uint32_t seq);
+
+void agent_record_append_u8(ByteBuffer *record, const uint8_t value);
+
+void agent_record_append_u32(ByteBuffer *record, const uint32_t value);
+
+void agent_record_append_u64(ByteBuffer *record, const uint64_t value);
+
+void agent_record_append_string(ByteBuffer *record, const char *string);
+
+void agent_record_append_bytes(ByteBuffer *record, const void *data, const uint32_t size);
+
+bool send_agent_record(const int fd, ByteBuffer *record, char **error_msg);
+
+/**
+ * Blocks until a complete record was received.
+ *
+ * @return the received record, or NULL if the peer closed the stream or an error occurred. In the latter case the
+ *  error message is set.
+ */
+AgentRecord *receive_agent_record(const int fd, char **error_msg);
+
+void destroy_agent_record(AgentRecord **record);
+
+ByteBufferReader create_agent_record_reader(const AgentRecord *record);
+
+uint8_t agent_record_read_u8(ByteBufferReader *reader);
+
+uint32_t agent_record_read_u32(ByteBufferReader *reader);
+
+uint64_t agent_record_read_u64(ByteBufferReader *reader);
+
+/**
+ * @return view of the string inside of the record, or NULL if a NULL string was sent or the record is malformed (in
+ *  which case the reader's error flag is set)
+ */
+const char *agent_record_read_string_view(ByteBufferReader *reader);
+
+const void *agent_record_read_bytes(ByteBufferReader *reader, uint32_t *size);
+
+#endif //RESYNC_AGENT_PROTOCOL_H
@@ -0,0 +1,179 @@
+#include "append_stream.h"
+
+/*
+ * @return the hash of the data of the file right before the offset, or false if it could not be read
+ */
+static bool
+hash_tail(const int fd, const uint64_t offset, uint64_t *hash)
+{
+    // The monitor is single-threaded, so the buffer is shared by all calls
+    static char buffer[APPEND_STREAM_TAIL_SIZE];
+
+    const uint64_t tail_start = (offset > APPEND_STREAM_TAIL_SIZE) ? offset - APPEND_STREAM_TAIL_SIZE : 0;
+    const size_t tail_size = (size_t) (offset - tail_start);
+
+    size_t bytes_read = 0;
+    while (bytes_read < tail_size) {
+        const ssize_t res = pread(fd, buffer + bytes_read, tail_size - bytes_read, (off_t) (tail_start + bytes_read));
+        if (res == -1 && errno == EINTR) {
+            continue;
+        } else if (res <= 0) {
+            return false;
+        }
+        bytes_read += (size_t) res;
+    }
+
+    *hash = delta_hash(buffer, tail_size);
+    return true;
+}
+
+static void
+destroy_append_stream_entry(AppendStreams *streams, AppendStreamEntry *entry)
+{
+    HASH_DELETE(hh, streams->entries, entry);
+    DO_FREE(entry->key);
+    DO_FREE(entry);
+}
+
+AppendStreams *
+create_append_streams(const IgnorePatternList *patterns, char **error_msg)
+{
+    if (patterns == NULL) {
+        return NULL;
+    }
+
+    AppendStreams *streams = (AppendStreams *) do_calloc(1, sizeof(AppendStreams));
+    streams->rules = create_ignore_rules();
+
+    const IgnorePatternList *pattern;
+    LL_FOREACH(patterns, pattern) {
+        if (!add_ignore_pattern(streams->rules, pattern->pattern, error_msg)) {
+            destroy_append_streams(&streams);
+            return NULL;
+        }
+    }
+
+    return streams;
+}
+
+void
+destroy_append_streams(AppendStreams **streams)
+{
+    if (streams == NULL || *streams == NULL) {
+        return;
+    }
+
+    AppendStreamEntry *entry, *tmp;
+    HASH_ITER(hh, (*streams)->entries, entry, tmp) {
+        destroy_append_stream_entry(*streams, entry);
+    }
+
+    destroy_ignore_rules(&(*streams)->rules);
+    DO_FREE(*streams);
+}
+
+bool
+is_append_stream(const AppendStreams *streams, const char *relative_path)
+{
+    if (streams == NULL) {
+        return false;
+    }
+
+    // The path is split in place, as the check must not allocate for every write of a stream
+    const char *name = strrchr(relative_path, '/');
+    if (name == NULL) {
+        return is_ignored(streams->rules, NULL, relative_path, false);
+    }
+
+    char relative_directory_path[PATH_MAX];
+    const size_t relative_directory_path_len = (size_t) (name - relative_path);
+    if (relative_directory_path_len >= sizeof(relative_directory_path)) {
+        return false;
+    }
+
+    memcpy(relative_directory_path, relative_path, relative_directory_path_len);
+    relative_directory_path[relative_directory_path_len] = '\0';
+
+    return is_ignored(streams->rules, relative_directory_path, name + 1, false);
+}
+
+uint64_t
+get_shipped_offset(AppendStreams *streams, const char *relative_path, const char *absolute_path,
+                   AppendStreamFingerprint *fingerprint)
+{
+    *fingerprint = (AppendStreamFingerprint) {.inode = 0, .size = 0, .tail_hash = 0};
+
+    const int fd = open(absolute_path, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd == -1) {
+        return 0;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1 || !S_ISREG(file_stat.st_mode)
+        || !hash_tail(fd, (uint64_t) file_stat.st_size, &fingerprint->tail_hash)) {
+        close(fd);
+        return 0;
+    }
+    fingerprint->inode = (uint64_t) file_stat.st_ino;
+    fingerprint->size = (uint64_t) file_stat.st_size;
+
+    AppendStreamEntry *entry;
+    HASH_FIND_STR(streams->entries, relative_path, entry);
+
+    // Rotated logs are replaced by a new file, truncated ones shrink
+    const AppendStreamFingerprint *shipped = (entry != NULL) ? &entry->fingerprint : NULL;
+    if (shipped == NULL || shipped->inode != fingerprint->inode || shipped->size > fingerprint->size) {
+        close(fd);
+        return 0;
+    }
+
+    uint64_t tail_hash = fingerprint->tail_hash;
+    const bool is_tail_hashed = shipped->size == fingerprint->size || hash_tail(fd, shipped->size, &tail_hash);
+    close(fd);
+
+    return (is_tail_hashed && tail_hash == shipped->tail_hash) ? shipped->size : 0;
+}
+
+void
+record_shipped_offset(AppendStreams *streams, const char *relative_path, const AppendStreamFingerprint *fingerprint)
+{
+    AppendStreamEntry *entry;
+    HASH_FIND_STR(streams->entries, relative_path, entry);
+    if (entry != NULL) {
+        destroy_append_stream_entry(streams, entry);
+    }
+
+    if (fingerprint->inode == 0) {
+        return;
+    }
+
+    entry = (AppendStreamEntry *) do_calloc(1, sizeof(AppendStreamEntry));
+    entry->key = resync_strdup(relative_path);
+    entry->fingerprint = *fingerprint;
+    HASH_ADD_KEYPTR(hh, streams->entries, entry->key, strlen(entry->key), entry);
+
+    if (HASH_COUNT(streams->entries) > APPEND_STREAM_MAX_ENTRIES) {
+        destroy_append_stream_entry(streams, streams->entries);
+    }
+}
+
+void
+forget_shipped_offsets(AppendStreams *streams, const char *relative_path, const bool is_directory)
+{
+    AppendStreamEntry *entry, *tmp;
+    HASH_FIND_STR(streams->entries, relative_path, entry);
+    if (entry != NULL) {
+        destroy_append_stream_entry(streams, entry);
+    }
+
+    if (!is_directory || streams->entries == NULL) {
+        return;
+    }
+
+    const size_t relative_path_len = strlen(relative_path);
+    HASH_ITER(hh, streams->entries, entry, tmp) {
+        if (strncmp(entry->key, relative_path, relative_path_len) == 0 && entry->key[relative_path_len] == '/') {
+            destroy_append_stream_entry(streams, entry);
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef RESYNC_APPEND_STREAM_H
+#define RESYNC_APPEND_STREAM_H
+
+#include "../util/string.h"
+#include "../util/memory.h"
+#include "../util/error.h"
+#include "../util/ignore_rules.h"
+#include "../types/types.h"
+#include "../../lib/ulist.h"
+#include "../../lib/utash.h"
+#include "delta.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/*
+ * Files that the workspace configuration declares to be only ever appended to, e.g. logs, are streamed: the monitor
+ *  tracks the size of such a file up to which the remote systems received it (its shipped offset), so that only the
+ *  data after it is transferred, at a cost that is proportional to the appended data instead of the size of the file.
+ *
+ * A file no longer continues its stream if it was truncated, replaced, e.g. when a log is rotated, or rewritten. The
+ *  latter is detected by a hash of the data right before the shipped offset, which is cheap to check but only guards
+ *  against files whose end changed. Such files, and files without a shipped offset, are transferred entirely. Shipped
+ *  offsets are not persisted, the first write of every file after the monitor started transfers it entirely as well.
+ */
+
+/* Data right before the shipped offset that is hashed */
+#define APPEND_STREAM_TAIL_SIZE ((uint64_t) 4096)
+/* Bounds the number of tracked files, the least recently shipped ones are forgotten */
+#define APPEND_STREAM_MAX_ENTRIES 4096
+
+typedef struct AppendStreamFingerprint {
+    uint64_t inode;
+    uint64_t size;
+    /* Hash of the data right before the end of the file */
+    uint64_t tail_hash;
+} AppendStreamFingerprint;
+
+typedef struct AppendStreamEntry {
+    /* Path relative to the workspace root */
+    char *key;
+    /* Fingerprint of the file when it was last shipped, its size is the shipped offset */
+    AppendStreamFingerprint fingerprint;
+    UT_hash_handle hh;
+} AppendStreamEntry;
+
+typedef struct AppendStreams {
+    /* Rules whose excluded files are streamed */
+    IgnoreRules *rules;
+    /* Ordered from the least to the most recently shipped file */
+    AppendStreamEntry *entries;
+} AppendStreams;
+
+/**
+ * @return the streams of the files that the patterns select, or NULL if there are no patterns
+ */
+AppendStreams *create_append_streams(const IgnorePatternList *patterns, char **error_msg);
+
+void destroy_append_streams(AppendStreams **streams);
+
+/**
+ * @param relative_path path of a file relative to the workspace root
+ */
+bool is_append_stream(const AppendStreams *streams, const char *relative_path);
+
+/**
+ * Determines the data of the written file that was not shipped yet.
+ *
+ * @param fingerprint receives the fingerprint of the file, which has to be passed to 'record_shipped_offset' once the
+ *  write was synced
+ * @return the shipped offset, i.e. the offset of the first byte to transfer, or 0 if the file has to be transferred
+ *  entirely. If it equals the size of the fingerprint, nothing was appended.
+ */
+uint64_t get_shipped_offset(AppendStreams *streams, const char *relative_path, const char *absolute_path,
+                            AppendStreamFingerprint *fingerprint);
+
+/**
+ * Records that the file was synced up to the size of the fingerprint at least. Files that could not be fingerprinted
+ *  are forgotten.
+ */
+void record_shipped_offset(AppendStreams *streams, const char *relative_path, const AppendStreamFingerprint *fingerprint);
+
+/**
+ * Forgets the shipped offset of the resource, and of all resources below it if it is a directory.
+ */
+void forget_shipped_offsets(AppendStreams *streams, const char *relative_path, const bool is_directory);
+
+#endif //RESYNC_APPEND_STREAM_H
@@ -0,0 +1,295 @@
+#include "bootstrap.h"
+
+/*
+ * Exits with a non-zero status unless the workspace root is missing or an empty directory and tar is available, and
+ *  reports whether the compressor is available as well
+ */
+#define BOOTSTRAP_PROBE_COMMAND_FMT                                                  \
+    "if [ -e %1$s ] && [ -n \"$(ls -A %1$s 2>/dev/null || echo x)\" ]; then exit 1; fi; " \
+    "command -v tar >/dev/null || exit 1; "                                          \
+    "command -v " BOOTSTRAP_COMPRESSOR " >/dev/null && echo " BOOTSTRAP_COMPRESSOR "; exit 0"
+
+static bool
+is_local_directory_empty(const char *path)
+{
+    DIR *dirp = opendir(path);
+    if (dirp == NULL) {
+        return errno == ENOENT;
+    }
+
+    bool is_empty = true;
+    struct dirent *dent;
+    while (is_empty && (dent = readdir(dirp)) != NULL) {
+        is_empty = strcmp(dent->d_name, ".") == 0 || strcmp(dent->d_name, "..") == 0;
+    }
+
+    closedir(dirp);
+    return is_empty;
+}
+
+static bool
+is_local_command_available(const char *command)
+{
+    const char *path = getenv("PATH");
+    if (path == NULL) {
+        return false;
+    }
+
+    char *directories = resync_strdup(path);
+    char *save_ptr = NULL;
+    bool is_available = false;
+
+    for (char *directory = strtok_r(directories, ":", &save_ptr); directory != NULL && !is_available;
+         directory = strtok_r(NULL, ":", &save_ptr)) {
+        char *command_path = concat_paths(directory, command);
+        is_available = access(command_path, X_OK) == 0;
+        DO_FREE(command_path);
+    }
+
+    DO_FREE(directories);
+    return is_available;
+}
+
+/*
+ * @param output set to the standard output of the command, which is truncated to its first bytes
+ * @return whether the command exited successfully
+ */
+static bool
+run_probe(char **args, char *output, const size_t output_size)
+{
+    int pipe_fds[2];
+    if (pipe2(pipe_fds, O_CLOEXEC) == -1) {
+        fatal_error("pipe2");
+    }
+
+    const pid_t pid = fork();
+    if (pid < 0) {
+        fatal_error("fork");
+    } else if (pid == 0) {
+        dup2(pipe_fds[1], STDOUT_FILENO);
+        execvp(args[0], args);
+        fatal_error("execvp");
+    }
+    close(pipe_fds[1]);
+
+    size_t size = 0;
+    while (size + 1 < output_size) {
+        const ssize_t ret = read(pipe_fds[0], output + size, output_size - size - 1);
+        if (ret == -1 && errno == EINTR) {
+            continue;
+        } else if (ret <= 0) {
+            break;
+        }
+        size += (size_t) ret;
+    }
+    output[size] = '\0';
+    close(pipe_fds[0]);
+
+    int status;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+static char *
+join_shell_arguments(char **args)
+{
+    char *command = NULL;
+    for (char **arg = args; *arg != NULL; arg++) {
+        char *quoted_arg = quote_shell_argument(*arg);
+        char *extended_command = (command == NULL) ? resync_strdup(quoted_arg) : format_string("%s %s", command, quoted_arg);
+
+        DO_FREE(quoted_arg);
+        DO_FREE(command);
+        command = extended_command;
+    }
+
+    return command;
+}
+
+/*
+ * Joins the stages into a pipeline that fails if any of its stages fails, not only its last one, as 'set -o pipefail'
+ *  is not supported by every sh. A failing stage reports itself on descriptor 3, whose output is collected by a command
+ *  substitution while the pipeline writes to the original standard output (descriptor 4). The stages do not inherit
+ *  either descriptor, so that a process they leave behind, e.g. an ssh master connection, does not hold them open.
+ */
+static char *
+join_pipeline_stages(char **stages)
+{
+    char *pipeline = NULL;
+    for (char **stage = stages; *stage != NULL; stage++) {
+        char *checked_stage = format_string("{ %s 3>&- 4>&- || echo %ld >&3; }", *stage, (long) (stage - stages));
+        char *extended_pipeline = (pipeline == NULL) ? resync_strdup(checked_stage) : format_string("%s | %s", pipeline, checked_stage);
+
+        DO_FREE(checked_stage);
+        DO_FREE(pipeline);
+        pipeline = extended_pipeline;
+    }
+
+    char *command = format_string("exec 4>&1; failed=$( { %s; } 3>&1 >&4 4>&- ); [ -z \"$failed\" ]", pipeline);
+    DO_FREE(pipeline);
+    return command;
+}
+
+static void
+free_arguments(char **args)
+{
+    for (char **arg = args; *arg != NULL; arg++) {
+        DO_FREE(*arg);
+    }
+    DO_FREE(args);
+}
+
+static bool
+is_excluded_partition(const SyncPartitionList *partitions, const char *relative_path)
+{
+    const SyncPartitionList *partition;
+    LL_FOREACH(partitions, partition) {
+        if (is_equal(partition->path_relative_to_ws_root, relative_path)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Lists the entries below the directory, separated by NUL characters, as rsync would transfer them: ignored resources
+ *  are skipped and symbolic links are not followed.
+ */
+static void
+write_bootstrap_entries(FILE *list, const char *absolute_workspace_root_path, const char *relative_directory_path,
+                        const IgnoreRules *ignore_rules, const SyncPartitionList *excluded_partitions)
+{
+    char *absolute_directory_path = concat_paths(absolute_workspace_root_path, relative_directory_path);
+
+    // A directory that was removed in the meantime is removed on the remote system by the sync of its event
+    DIR *dirp = opendir(absolute_directory_path);
+    if (dirp == NULL) {
+        DO_FREE(absolute_directory_path);
+        return;
+    }
+
+    struct dirent *dent;
+    while ((dent = readdir(dirp)) != NULL) {
+        if (strcmp(dent->d_name, ".") == 0 || strcmp(dent->d_name, "..") == 0) {
+            continue;
+        }
+
+        struct stat entry_stat;
+        if (fstatat(dirfd(dirp), dent->d_name, &entry_stat, AT_SYMLINK_NOFOLLOW) == -1) {
+            continue;
+        }
+
+        const bool is_directory = S_ISDIR(entry_stat.st_mode);
+        if (is_ignored(ignore_rules, relative_directory_path, dent->d_name, is_directory)) {
+            continue;
+        }
+
+        char *relative_path = concat_paths(relative_directory_path, dent->d_name);
+        if (!is_directory || !is_excluded_partition(excluded_partitions, relative_path)) {
+            fputs(relative_path, list);
+            fputc('\0', list);
+
+            if (is_directory) {
+                write_bootstrap_entries(list, absolute_workspace_root_path, relative_path, ignore_rules, excluded_partitions);
+            }
+        }
+        DO_FREE(relative_path);
+    }
+
+    closedir(dirp);
+    DO_FREE(absolute_directory_path);
+}
+
+bool
+is_bootstrap_target(const RemoteWorkspaceMetadata *remote_system, bool *is_compressed)
+{
+    *is_compressed = false;
+
+    // A local mirror is not reached over a link, compressing its archives would only cost processing time
+    if (remote_system->connection_type == LOCAL_PATH) {
+        return is_local_directory_empty(remote_system->remote_workspace_root_path);
+    }
+
+    if (!is_ssh_remote_system(remote_system)) {
+        return false;
+    }
+
+    char *quoted_root_path = quote_shell_argument(remote_system->remote_workspace_root_path);
+    char *probe_command = format_string(BOOTSTRAP_PROBE_COMMAND_FMT, quoted_root_path);
+    char **args = construct_ssh_remote_command_arguments(remote_system, probe_command);
+    DO_FREE(probe_command);
+    DO_FREE(quoted_root_path);
+
+    char output[64];
+    const bool is_empty = run_probe(args, output, sizeof(output));
+    free_arguments(args);
+
+    *is_compressed = is_empty
+            && get_transfer_profile(remote_system)->is_compressed
+            && strstr(output, BOOTSTRAP_COMPRESSOR) != NULL
+            && is_local_command_available(BOOTSTRAP_COMPRESSOR);
+    return is_empty;
+}
+
+char **
+construct_bootstrap_command(const WorkspaceInformation *ws_info, const RemoteWorkspaceMetadata *remote_system,
+                            const IgnoreRules *ignore_rules, const char *relative_path,
+                            const SyncPartitionList *excluded_partitions, const bool is_compressed, int *input_fd)
+{
+    // The list is buffered in an anonymous file, as the commands of all subtrees are started before any of them reads it
+    FILE *list = tmpfile();
+    if (list == NULL) {
+        fatal_error("tmpfile");
+    }
+
+    if (relative_path != NULL) {
+        fputs(relative_path, list);
+        fputc('\0', list);
+    }
+    write_bootstrap_entries(list, ws_info->local_workspace_root_path, relative_path, ignore_rules, excluded_partitions);
+
+    if (fflush(list) != 0 || (*input_fd = fcntl(fileno(list), F_DUPFD_CLOEXEC, 0)) == -1) {
+        fatal_error("tmpfile");
+    }
+    fclose(list);
+    lseek(*input_fd, 0, SEEK_SET);
+
+    // Entries are listed relative to the workspace root, so that every archive is extracted at the remote root
+    char *quoted_local_root_path = quote_shell_argument(ws_info->local_workspace_root_path);
+    char *quoted_remote_root_path = quote_shell_argument(remote_system->remote_workspace_root_path);
+    char *archive_command = format_string("tar -C %s --null --no-recursion -T - -cf -", quoted_local_root_path);
+    char *extract_command = format_string(
+            "mkdir -p %1$s && cd %1$s && %2$star -xpf -",
+            quoted_remote_root_path,
+            is_compressed ? BOOTSTRAP_COMPRESSOR " -dc | " : ""
+    );
+
+    // A truncated archive lets the extracting tar fail as well, so the stages on the remote system are not checked
+    //  individually
+    char **stages = (char **) do_calloc(4, sizeof(char *));
+    stages[0] = archive_command;
+    if (remote_system->connection_type == LOCAL_PATH) {
+        stages[1] = format_string("(%s)", extract_command);
+    } else {
+        char **ssh_args = construct_ssh_remote_command_arguments(remote_system, extract_command);
+        size_t index = 1;
+        if (is_compressed) {
+            stages[index++] = resync_strdup(BOOTSTRAP_COMPRESSOR " " BOOTSTRAP_COMPRESSION_ARGS " -c");
+        }
+        stages[index] = join_shell_arguments(ssh_args);
+        free_arguments(ssh_args);
+    }
+    char *pipeline = join_pipeline_stages(stages);
+
+    free_arguments(stages);
+    DO_FREE(quoted_local_root_path);
+    DO_FREE(quoted_remote_root_path);
+    DO_FREE(extract_command);
+
+    char **args = (char **) do_calloc(4, sizeof(char *));
+    args[0] = resync_strdup("sh");
+    args[1] = resync_strdup("-c");
+    args[2] = pipeline;
+    return args;
+}
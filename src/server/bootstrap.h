@@ -0,0 +1,60 @@
+#ifndef RESYNC_BOOTSTRAP_H
+#define RESYNC_BOOTSTRAP_H
+
+#include "../util/string.h"
+#include "../util/memory.h"
+#include "../util/error.h"
+#include "../util/debug.h"
+#include "../util/fs_util.h"
+#include "../util/ignore_rules.h"
+#include "../types/types.h"
+#include "../../lib/ulist.h"
+#include "ssh_control.h"
+#include "transfer_tuning.h"
+#include "sync_partitions.h"
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+/*
+ * A remote system whose workspace root is empty or does not exist yet is bootstrapped: the workspace is streamed to it
+ *  as tar archives instead of being synced by rsync, whose per-file exchanges and delta computation are pure overhead
+ *  for a remote system that has none of the files. The archives are compressed with zstd if the link is compressed and
+ *  both ends provide it. Later syncs use rsync as before.
+ *
+ * The entries to archive are listed by walking the workspace with the ignore rules, so that ignored resources are not
+ *  transferred, and passed to tar on its standard input. Remote systems that are reached via an rsync daemon cannot run
+ *  tar and are never bootstrapped.
+ */
+
+#define BOOTSTRAP_COMPRESSOR "zstd"
+/* Level 1 keeps up with fast links while still shrinking source trees considerably */
+#define BOOTSTRAP_COMPRESSION_ARGS "-1 -T0"
+
+/**
+ * Checks whether the remote system can be bootstrapped, i.e. whether its workspace root is empty.
+ *
+ * @param is_compressed set to whether the archives sent to the remote system are compressed
+ */
+bool is_bootstrap_target(const RemoteWorkspaceMetadata *remote_system, bool *is_compressed);
+
+/**
+ * Constructs the command that streams a subtree of the workspace to the remote system.
+ *
+ * @param relative_path subtree to stream, NULL for the entire workspace
+ * @param excluded_partitions partitions that are streamed by commands of their own and are skipped
+ * @param input_fd set to the descriptor of the list of entries, which the command has to read on its standard input
+ * @return the arguments of the command
+ */
+char **construct_bootstrap_command(const WorkspaceInformation *ws_info, const RemoteWorkspaceMetadata *remote_system,
+                                   const IgnoreRules *ignore_rules, const char *relative_path,
+                                   const SyncPartitionList *excluded_partitions, bool is_compressed, int *input_fd);
+
+#endif //RESYNC_BOOTSTRAP_H
@@ -4,6 +4,29 @@
 
 #define CONFIG_READ_CHUNK_SIZE ((ssize_t)(2048 * sizeof(char)))
 
+/*
+ * Index of the local root paths of all workspaces managed by reSync. Maps a workspace root path to the index of the
+ *  workspaces' entry in the configuration file's array of workspaces.
+ */
+static PathTrie *managed_workspaces_index = NULL;
+
+/*
+ * @return the absolute path of the configuration file, which is resolved on the first access, i.e. before the daemon
+ *  changes its working directory to '/'
+ */
+static const char *
+get_configuration_file_path(void)
+{
+    static char *config_file_path = NULL;
+
+    if (config_file_path == NULL) {
+        config_file_path = realpath(DEFAULT_RESYNC_CONFIG_FILE_PATH, NULL);
+    }
+
+    // A configuration file that does not exist is reported when it is opened
+    return (config_file_path != NULL) ? config_file_path : DEFAULT_RESYNC_CONFIG_FILE_PATH;
+}
+
 static bool
 write_to_configuration_file_from_buffer(const char *config_file_buffer, char **error_msg)
 {
@@ -12,7 +35,7 @@ write_to_configuration_file_from_buffer(const char *config_file_buffer, char **e
         return false;
     }
 
-    int config_file_fd = open(DEFAULT_RESYNC_CONFIG_FILE_PATH, O_WRONLY | O_TRUNC);
+    int config_file_fd = open(get_configuration_file_path(), O_WRONLY | O_TRUNC);
     if (config_file_fd == -1) {
         SET_ERROR_MSG_RAW(
                 error_msg,
@@ -74,7 +97,7 @@ is_config_file_empty(const char *config_file_buffer)
 static bool
 read_configuration_file_into_buffer(char **buf, char **error_msg)
 {
-    int config_file_fd = open(DEFAULT_RESYNC_CONFIG_FILE_PATH, O_RDONLY);
+    int config_file_fd = open(get_configuration_file_path(), O_RDONLY);
     if (config_file_fd == -1) {
         SET_ERROR_MSG_RAW(
                 error_msg,
@@ -150,6 +173,55 @@ get_json_array_from_config_file_buffer(const char *config_file_buffer, char **er
     return json_config_file_array;
 }
 
+static bool
+build_managed_workspaces_index(const cJSON *config_entries_array, char **error_msg)
+{
+    destroy_path_trie(&managed_workspaces_index);
+    managed_workspaces_index = create_path_trie();
+
+    intptr_t loop_index = 0;
+    cJSON *config_array_entry;
+    cJSON_ArrayForEach(config_array_entry, config_entries_array) {
+        const char *ws_path = cjson_to_local_workspace_root_path(config_array_entry);
+        if (ws_path == NULL) {
+            SET_ERROR_MSG_RAW(
+                    error_msg,
+                    format_string("Configuration file entry at index '%ld' does not specify a local workspace root path", loop_index)
+            );
+            destroy_path_trie(&managed_workspaces_index);
+            return false;
+        }
+
+        path_trie_insert(managed_workspaces_index, ws_path, (void *) loop_index);
+        loop_index++;
+    }
+
+    return true;
+}
+
+static bool
+ensure_managed_workspaces_index(const cJSON *config_entries_array, char **error_msg)
+{
+    // The daemon is the only writer of the configuration file and updates the index along with every entry it adds or
+    //  removes, so the index only has to be built on the first access
+    if (managed_workspaces_index != NULL) {
+        return true;
+    }
+
+    return build_managed_workspaces_index(config_entries_array, error_msg);
+}
+
+static void
+shift_index_after_removal(void **value, void *context)
+{
+    const intptr_t removed_index = *((intptr_t *) context);
+    const intptr_t index = (intptr_t) *value;
+
+    if (index > removed_index) {
+        *value = (void *) (index - 1);
+    }
+}
+
 /*
  * 1: Config file contains the workspace
  * 0: The config file does not contain an entry for the workspace
@@ -167,23 +239,14 @@ config_file_contains_workspace(cJSON *config_entries_array, const WorkspaceInfor
         return -1;
     }
 
-    cJSON *config_array_entry;
-    cJSON_ArrayForEach(config_array_entry, config_entries_array) {
-        WorkspaceInformation *ws_info_entry = cjson_to_workspaceInformation(config_array_entry, error_msg);
-        if (ws_info_entry == NULL) {
-            SET_ERROR_MSG_WITH_CAUSE(error_msg, "An error occurred while checking if the workspace is already managed by reSync", error_msg);
-            return -1;
-        }
-
-        if (strncmp(ws_info->local_workspace_root_path, ws_info_entry->local_workspace_root_path, strlen(ws_info->local_workspace_root_path)) == 0
-            || strncmp(ws_info_entry->local_workspace_root_path, ws_info->local_workspace_root_path, strlen(ws_info_entry->local_workspace_root_path)) == 0) {
-            // If a subdirectory or a parent directory is already managed by reSync, the requested workspace cannot also
-            //  be managed by it.
-            return 1;
-        }
+    if (!ensure_managed_workspaces_index(config_entries_array, error_msg)) {
+        SET_ERROR_MSG_WITH_CAUSE(error_msg, "An error occurred while checking if the workspace is already managed by reSync", error_msg);
+        return -1;
     }
 
-    return 0;
+    // If a subdirectory or a parent directory is already managed by reSync, the requested workspace cannot also be
+    //  managed by it.
+    return path_trie_overlaps(managed_workspaces_index, ws_info->local_workspace_root_path) ? 1 : 0;
 }
 
 /*
@@ -203,66 +266,28 @@ get_index_of_exact_match_workspace(cJSON *config_entries_array, const char *path
         return -2;
     }
 
-    int loop_index = 0;
-    cJSON *config_array_entry;
-    cJSON_ArrayForEach(config_array_entry, config_entries_array) {
-
-        WorkspaceInformation *ws_info_entry = cjson_to_workspaceInformation(config_array_entry, error_msg);
-        if (ws_info_entry == NULL) {
-            SET_ERROR_MSG_WITH_CAUSE(error_msg, "An error occurred while searching the workspaces contained in the configuration file", error_msg);
-            return -2;
-        }
-
-        if (is_equal(ws_info_entry->local_workspace_root_path, path)) {
-            return loop_index;
-        }
-
-        loop_index++;
-    }
-
-    return -1;
-}
-
-static bool
-matches_ssh_remote_system(const SshConnectionInformation *connection_info, const RemoveRemoteSystemMetadata *rm_rsys_data)
-{
-    if (rm_rsys_data->connection_type != SSH) {
-        return false;
-    }
-
-    if (!is_equal(connection_info->hostname,rm_rsys_data->remote_system_id_information.hostname)) {
-        return false;
-    }
-
-    return true;
-}
-
-static bool
-matches_ssh_host_alias_remote_system(const char *ssh_host_alias, const RemoveRemoteSystemMetadata *rm_rsys_data)
-{
-    if (rm_rsys_data->connection_type != SSH_HOST_ALIAS) {
-        return false;
+    if (!ensure_managed_workspaces_index(config_entries_array, error_msg)) {
+        SET_ERROR_MSG_WITH_CAUSE(error_msg, "An error occurred while searching the workspaces contained in the configuration file", error_msg);
+        return -2;
     }
 
-    if (!is_equal(ssh_host_alias, rm_rsys_data->remote_system_id_information.ssh_host_alias)) {
-        return false;
+    void *value;
+    if (!path_trie_lookup(managed_workspaces_index, path, &value)) {
+        return -1;
     }
 
-    return true;
-}
-
-static bool
-matches_rsync_remote_system(const RsyncConnectionInformation *connection_info, const RemoveRemoteSystemMetadata *rm_rsys_data)
-{
-    if (rm_rsys_data->connection_type != RSYNC_DAEMON) {
-        return false;
-    }
+    const int index = (int) (intptr_t) value;
+    if (!is_equal(cjson_to_local_workspace_root_path(cJSON_GetArrayItem(config_entries_array, index)), path)) {
+        // The entries of the configuration file were reordered behind our back, rebuild the index once.
+        if (!build_managed_workspaces_index(config_entries_array, error_msg)) {
+            SET_ERROR_MSG_WITH_CAUSE(error_msg, "An error occurred while searching the workspaces contained in the configuration file", error_msg);
+            return -2;
+        }
 
-    if (!is_equal(connection_info->hostname, rm_rsys_data->remote_system_id_information.hostname)) {
-        return false;
+        return path_trie_lookup(managed_workspaces_index, path, &value) ? (int) (intptr_t) value : -1;
     }
 
-    return true;
+    return index;
 }
 
 /*
@@ -295,34 +320,21 @@ get_index_of_remote_system_based_on_identifying_information(const cJSON *remote_
             return -2;
         }
 
-        if (!is_equal(remote_system->remote_workspace_root_path, rm_rsys_data->remote_workspace_root_path)) {
-            loop_index++;
-            continue;
+        if (remote_system->connection_type == OTHER_CONNECTION_TYPE) {
+            SET_ERROR_MSG_RAW(
+                    error_msg,
+                    format_string(
+                            "Encountered unsupported connection type while searching the remote systems of "
+                            "workspace '%s'",
+                            rm_rsys_data->local_workspace_root_path
+                    )
+            );
+            destroy_remoteWorkspaceMetadata(&remote_system);
+            return -2;
         }
 
-        bool res_connection_info_matches = false;
-        switch (remote_system->connection_type) {
-            case SSH:
-                res_connection_info_matches = matches_ssh_remote_system(remote_system->connection_information.ssh_connection_information, rm_rsys_data);
-                break;
-            case SSH_HOST_ALIAS:
-                res_connection_info_matches = matches_ssh_host_alias_remote_system(remote_system->connection_information.ssh_host_alias, rm_rsys_data);
-                break;
-            case RSYNC_DAEMON:
-                res_connection_info_matches = matches_rsync_remote_system(remote_system->connection_information.rsync_connection_information, rm_rsys_data);
-                break;
-            case OTHER_CONNECTION_TYPE:
-            default:
-                SET_ERROR_MSG_RAW(
-                        error_msg,
-                        format_string(
-                                "Encountered unsupported connection type while searching the remote systems of "
-                                "workspace '%s'",
-                                rm_rsys_data->local_workspace_root_path
-                        )
-                );
-                return -2;
-        }
+        bool res_connection_info_matches = is_remote_system_identified_by(remote_system, rm_rsys_data);
+        destroy_remoteWorkspaceMetadata(&remote_system);
 
         if (res_connection_info_matches == true) {
             return loop_index;
@@ -388,6 +400,12 @@ add_workspace_to_configuration_file(const WorkspaceInformation *ws_info, ConfigF
         goto error_out_ext;
     }
 
+    path_trie_insert(
+            managed_workspaces_index,
+            ws_info->local_workspace_root_path,
+            (void *) (intptr_t) (cJSON_GetArraySize(json_config_file_entry_array) - 1)
+    );
+
     ConfigFileEntryData *config_entry = (ConfigFileEntryData *) do_calloc(1, sizeof(ConfigFileEntryData));
     config_entry->workspace_information = ws_info;
     config_entry->stringified_json_workspace_information = cJSON_Print(json_ws_info);
@@ -448,6 +466,10 @@ remove_workspace_from_configuration_file(const char *workspace_root_path, char *
         goto error_out;
     }
 
+    intptr_t removed_index = index;
+    path_trie_remove(managed_workspaces_index, workspace_root_path, NULL);
+    path_trie_foreach_value(managed_workspaces_index, shift_index_after_removal, &removed_index);
+
     cJSON_Delete(json_config_file_entry_array);
     DO_FREE(config_file_buffer);
     return true;
@@ -527,13 +549,22 @@ add_remote_system_to_workspace_config_entry(const WorkspaceInformation *ws_info,
 
     cJSON_AddItemToArray(remote_systems_array, remote_system_to_add);
 
+    // The updated entry is validated before it is written, which rejects e.g. a remote system whose relay parent is not
+    //  a remote system of the workspace
+    WorkspaceInformation *updated_ws_info = cjson_to_workspaceInformation(json_ws_info_entry, error_msg);
+    if (updated_ws_info == NULL) {
+        SET_ERROR_MSG_WITH_CAUSE(error_msg, "Unable to add remote system to workspaces config file entry", error_msg);
+        goto error_out;
+    }
+
     if (write_to_configuration_file_from_buffer(cJSON_Print(json_config_file_entry_array), error_msg) == false) {
         SET_ERROR_MSG_WITH_CAUSE(error_msg, "Unable to add remote system to workspaces config file entry", error_msg);
+        destroy_workspaceInformation(&updated_ws_info);
         goto error_out;
     }
 
     ConfigFileEntryData *updated_config_entry = (ConfigFileEntryData *) do_calloc(1, sizeof(ConfigFileEntryData));
-    updated_config_entry->workspace_information = ws_info;
+    updated_config_entry->workspace_information = updated_ws_info;
     updated_config_entry->stringified_json_workspace_information = cJSON_Print(json_ws_info_entry);
     *config_entry_data = updated_config_entry;
 
@@ -619,13 +650,21 @@ remove_remote_system_from_workspace_config_entry(const RemoveRemoteSystemMetadat
 
     cJSON_DeleteItemFromArray(remote_systems_array, remote_system_index);
 
+    // A relay cannot be removed while other remote systems are synced through it, as they would not be synced anymore
+    WorkspaceInformation *updated_ws_info = cjson_to_workspaceInformation(json_ws_info_entry, error_msg);
+    if (updated_ws_info == NULL) {
+        SET_ERROR_MSG_WITH_CAUSE(error_msg, "Unable to remove remote system from workspaces config file entry", error_msg);
+        goto error_out;
+    }
+
     if (write_to_configuration_file_from_buffer(cJSON_Print(json_config_file_entry_array), error_msg) == false) {
         SET_ERROR_MSG_WITH_CAUSE(error_msg, "Unable to remove remote system from workspaces config file entry", error_msg);
+        destroy_workspaceInformation(&updated_ws_info);
         goto error_out;
     }
 
     ConfigFileEntryData *updated_ws_entry = (ConfigFileEntryData *) do_calloc(1, sizeof(ConfigFileEntryData));
-    updated_ws_entry->workspace_information = cjson_to_workspaceInformation(json_ws_info_entry, error_msg);
+    updated_ws_entry->workspace_information = updated_ws_info;
     updated_ws_entry->stringified_json_workspace_information = cJSON_Print(json_ws_info_entry);
     *config_entry_data = updated_ws_entry;
 
@@ -657,6 +696,11 @@ parse_configuration_file(ConfigFileEntryData **config_file_entries, char **error
         goto error_out;
     }
 
+    if (!build_managed_workspaces_index(json_config_file_entry_array, error_msg)) {
+        SET_ERROR_MSG_WITH_CAUSE(error_msg, "Unable to parse reSync configuration file", error_msg);
+        goto error_out;
+    }
+
     cJSON *config_array_entry;
     cJSON_ArrayForEach(config_array_entry, json_config_file_entry_array) {
         WorkspaceInformation *ws_info = cjson_to_workspaceInformation(config_array_entry, error_msg);
@@ -680,15 +724,19 @@ parse_configuration_file(ConfigFileEntryData **config_file_entries, char **error
 error_out:
 
     cJSON_Delete(json_config_file_entry_array);
+    destroy_config_file_entries(&config_file_entry_list_head);
+    DO_FREE(config_file_buffer);
+    return false;
+}
 
+void
+destroy_config_file_entries(ConfigFileEntryData **config_file_entries)
+{
     ConfigFileEntryData *entry, *temp;
-    LL_FOREACH_SAFE(config_file_entry_list_head, entry, temp) {
-        LL_DELETE(config_file_entry_list_head, entry);
+    LL_FOREACH_SAFE(*config_file_entries, entry, temp) {
+        LL_DELETE(*config_file_entries, entry);
         destroy_workspaceInformation((WorkspaceInformation **) &(entry->workspace_information));
         DO_FREE(entry->stringified_json_workspace_information);
         DO_FREE(entry);
     }
-
-    DO_FREE(config_file_buffer);
-    return false;
 }
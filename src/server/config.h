@@ -3,10 +3,12 @@
 
 #include "../types/types.h"
 #include "../types/mappers.h"
+#include "../util/path_trie.h"
 #include "../../lib/ulist.h"
 #include "../../lib/json/cJSON.h"
 
 #include <fcntl.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <stdbool.h>
 
@@ -24,6 +26,8 @@ typedef struct ConfigFileEntryData {
  */
 bool parse_configuration_file(ConfigFileEntryData **config_file_entries, char **error_msg);
 
+void destroy_config_file_entries(ConfigFileEntryData **config_file_entries);
+
 bool add_workspace_to_configuration_file(const WorkspaceInformation *ws_info, ConfigFileEntryData **config_entry_data, char **error_msg);
 
 bool remove_workspace_from_configuration_file(const char *workspace_root_path, char **error_msg);
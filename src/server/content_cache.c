@@ -0,0 +1,381 @@
+#include "content_cache.h"
+
+/*
+ * The cache file of a workspace is named after the hash of the workspace's path, like its sync state.
+ */
+static char *
+get_content_cache_file_path(const char *ws_path)
+{
+    return format_string(
+            "%s/%016llx.contents",
+            DEFAULT_RESYNC_SYNC_STATE_DIRECTORY,
+            (unsigned long long) hash_string(ws_path)
+    );
+}
+
+static void
+set_fingerprint_metadata(ContentFingerprint *fingerprint, const struct stat *file_stat)
+{
+    fingerprint->inode = (uint64_t) file_stat->st_ino;
+    fingerprint->size = (uint64_t) file_stat->st_size;
+    fingerprint->mtime_sec = (int64_t) file_stat->st_mtim.tv_sec;
+    fingerprint->mtime_nsec = (uint32_t) file_stat->st_mtim.tv_nsec;
+}
+
+static bool
+is_metadata_equal(const ContentFingerprint *fingerprint, const ContentFingerprint *other_fingerprint)
+{
+    return fingerprint->inode == other_fingerprint->inode
+           && fingerprint->size == other_fingerprint->size
+           && fingerprint->mtime_sec == other_fingerprint->mtime_sec
+           && fingerprint->mtime_nsec == other_fingerprint->mtime_nsec;
+}
+
+static bool
+hash_file_content(const int fd, uint64_t *hash)
+{
+    // The monitor is single-threaded, so the buffer is shared by all calls
+    static unsigned char buffer[CONTENT_CACHE_READ_SIZE];
+
+    DeltaHashState state;
+    delta_hash_init(&state);
+
+    ssize_t bytes_read;
+    while ((bytes_read = read(fd, buffer, sizeof(buffer))) != 0) {
+        if (bytes_read == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        delta_hash_update(&state, buffer, (size_t) bytes_read);
+    }
+
+    *hash = delta_hash_digest(&state);
+    return true;
+}
+
+static void
+destroy_content_cache_entry(ContentCache *cache, ContentCacheEntry *entry)
+{
+    HASH_DELETE(hh, cache->entries, entry);
+    DO_FREE(entry->key);
+    DO_FREE(entry);
+}
+
+/*
+ * Moves the entry to the end of the cache, which holds the most recently synced files.
+ */
+static void
+touch_content_cache_entry(ContentCache *cache, ContentCacheEntry *entry)
+{
+    HASH_DELETE(hh, cache->entries, entry);
+    HASH_ADD_KEYPTR(hh, cache->entries, entry->key, strlen(entry->key), entry);
+}
+
+static void
+add_content_cache_entry(ContentCache *cache, const char *relative_path, const ContentFingerprint *fingerprint)
+{
+    ContentCacheEntry *entry = (ContentCacheEntry *) do_calloc(1, sizeof(ContentCacheEntry));
+    entry->key = resync_strdup(relative_path);
+    entry->fingerprint = *fingerprint;
+    HASH_ADD_KEYPTR(hh, cache->entries, entry->key, strlen(entry->key), entry);
+
+    if (HASH_COUNT(cache->entries) > CONTENT_CACHE_MAX_ENTRIES) {
+        destroy_content_cache_entry(cache, cache->entries);
+    }
+}
+
+ContentCache *
+create_content_cache(void)
+{
+    return (ContentCache *) do_calloc(1, sizeof(ContentCache));
+}
+
+void
+clear_content_cache(ContentCache *cache)
+{
+    ContentCacheEntry *entry, *tmp;
+    HASH_ITER(hh, cache->entries, entry, tmp) {
+        destroy_content_cache_entry(cache, entry);
+    }
+
+    cache->is_modified = true;
+}
+
+void
+destroy_content_cache(ContentCache **cache)
+{
+    if (cache == NULL || *cache == NULL) {
+        return;
+    }
+
+    clear_content_cache(*cache);
+    DO_FREE(*cache);
+}
+
+bool
+is_content_unchanged(ContentCache *cache, const char *relative_path, const char *absolute_path,
+                     ContentFingerprint *fingerprint)
+{
+    fingerprint->is_hashed = false;
+
+    const int fd = open(absolute_path, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd == -1) {
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1 || !S_ISREG(file_stat.st_mode)) {
+        close(fd);
+        return false;
+    }
+    set_fingerprint_metadata(fingerprint, &file_stat);
+
+    ContentCacheEntry *entry;
+    HASH_FIND_STR(cache->entries, relative_path, entry);
+
+    // The file was closed without being written to
+    if (entry != NULL && is_metadata_equal(&entry->fingerprint, fingerprint)) {
+        close(fd);
+        fingerprint->hash = entry->fingerprint.hash;
+        fingerprint->is_hashed = true;
+        return true;
+    }
+
+    if (fingerprint->size > CONTENT_CACHE_MAX_FILE_SIZE) {
+        close(fd);
+        return false;
+    }
+
+    // Even if the content changed, it is hashed to be cached once it is synced
+    const bool is_hashed = hash_file_content(fd, &fingerprint->hash);
+    close(fd);
+    if (!is_hashed) {
+        return false;
+    }
+    fingerprint->is_hashed = true;
+
+    if (entry == NULL
+        || entry->fingerprint.inode != fingerprint->inode
+        || entry->fingerprint.size != fingerprint->size
+        || entry->fingerprint.hash != fingerprint->hash) {
+        return false;
+    }
+
+    // Only the modification time changed, which is remembered to not hash the file again on its next write
+    entry->fingerprint = *fingerprint;
+    touch_content_cache_entry(cache, entry);
+    cache->is_modified = true;
+    return true;
+}
+
+void
+record_synced_content(ContentCache *cache, const char *relative_path, const char *absolute_path,
+                      const ContentFingerprint *fingerprint)
+{
+    ContentCacheEntry *entry;
+    HASH_FIND_STR(cache->entries, relative_path, entry);
+    if (entry != NULL) {
+        destroy_content_cache_entry(cache, entry);
+        cache->is_modified = true;
+    }
+
+    if (!fingerprint->is_hashed) {
+        return;
+    }
+
+    // If the file was written while it was hashed or synced, its next write event follows and is synced
+    struct stat file_stat;
+    ContentFingerprint current_fingerprint;
+    if (stat(absolute_path, &file_stat) == -1) {
+        return;
+    }
+    set_fingerprint_metadata(&current_fingerprint, &file_stat);
+    if (!is_metadata_equal(fingerprint, &current_fingerprint)) {
+        return;
+    }
+
+    add_content_cache_entry(cache, relative_path, fingerprint);
+    cache->is_modified = true;
+}
+
+void
+invalidate_cached_content(ContentCache *cache, const char *relative_path, const bool is_directory)
+{
+    ContentCacheEntry *entry, *tmp;
+    HASH_FIND_STR(cache->entries, relative_path, entry);
+    if (entry != NULL) {
+        destroy_content_cache_entry(cache, entry);
+        cache->is_modified = true;
+    }
+
+    if (!is_directory || cache->entries == NULL) {
+        return;
+    }
+
+    const size_t relative_path_len = strlen(relative_path);
+    HASH_ITER(hh, cache->entries, entry, tmp) {
+        if (strncmp(entry->key, relative_path, relative_path_len) == 0 && entry->key[relative_path_len] == '/') {
+            destroy_content_cache_entry(cache, entry);
+            cache->is_modified = true;
+        }
+    }
+}
+
+static ContentCache *
+decode_content_cache(const char *data, const size_t size, const char *ws_path, char **error_msg)
+{
+    ByteBufferReader reader = create_byte_buffer_reader(data, size);
+
+    const uint32_t magic = byte_buffer_read_u32(&reader);
+    const uint32_t version = byte_buffer_read_u32(&reader);
+    if (reader.error || magic != CONTENT_CACHE_MAGIC || version != CONTENT_CACHE_VERSION) {
+        SET_ERROR_MSG(error_msg, "Unsupported content cache format");
+        return NULL;
+    }
+
+    // Guards against hash collisions of the cache file names
+    const char *persisted_ws_path = byte_buffer_read_string_view(&reader);
+    if (reader.error || !is_equal(persisted_ws_path, ws_path)) {
+        SET_ERROR_MSG(error_msg, "Content cache belongs to a different workspace");
+        return NULL;
+    }
+
+    ContentCache *cache = create_content_cache();
+
+    const uint32_t entries_count = byte_buffer_read_u32(&reader);
+    for (uint32_t i = 0; i < entries_count && !reader.error; i++) {
+        const char *relative_path = byte_buffer_read_string_view(&reader);
+        ContentFingerprint fingerprint = {.is_hashed = true};
+        fingerprint.inode = byte_buffer_read_u64(&reader);
+        fingerprint.size = byte_buffer_read_u64(&reader);
+        fingerprint.mtime_sec = (int64_t) byte_buffer_read_u64(&reader);
+        fingerprint.mtime_nsec = byte_buffer_read_u32(&reader);
+        fingerprint.hash = byte_buffer_read_u64(&reader);
+        if (relative_path == NULL || reader.error) {
+            reader.error = true;
+            break;
+        }
+
+        char *absolute_path = concat_paths(ws_path, relative_path);
+        struct stat file_stat;
+        ContentFingerprint current_fingerprint;
+        const bool is_stat = stat(absolute_path, &file_stat) == 0;
+        DO_FREE(absolute_path);
+
+        if (!is_stat) {
+            continue;
+        }
+        set_fingerprint_metadata(&current_fingerprint, &file_stat);
+        if (is_metadata_equal(&fingerprint, &current_fingerprint)) {
+            add_content_cache_entry(cache, relative_path, &fingerprint);
+        }
+    }
+
+    if (reader.error || reader.offset != reader.size) {
+        SET_ERROR_MSG(error_msg, "Content cache is malformed");
+        destroy_content_cache(&cache);
+        return NULL;
+    }
+
+    cache->is_modified = false;
+    return cache;
+}
+
+ContentCache *
+load_content_cache(const WorkspaceInformation *ws_info, char **error_msg)
+{
+    char *path = get_content_cache_file_path(ws_info->local_workspace_root_path);
+
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    DO_FREE(path);
+    if (fd == -1) {
+        if (errno != ENOENT) {
+            SET_ERROR_MSG_RAW(error_msg, format_string("Unable to open the content cache: %s", strerror(errno)));
+        }
+        return NULL;
+    }
+
+    struct stat cache_stat;
+    if (fstat(fd, &cache_stat) == -1) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to stat the content cache: %s", strerror(errno)));
+        close(fd);
+        return NULL;
+    }
+
+    char *data = (char *) do_malloc(cache_stat.st_size + 1);
+    const int read_result = read_all(fd, data, cache_stat.st_size);
+    close(fd);
+
+    if (read_result != 1) {
+        SET_ERROR_MSG(error_msg, "Unable to read the content cache");
+        DO_FREE(data);
+        return NULL;
+    }
+
+    ContentCache *cache = decode_content_cache(data, cache_stat.st_size, ws_info->local_workspace_root_path, error_msg);
+    DO_FREE(data);
+    return cache;
+}
+
+bool
+store_content_cache(ContentCache *cache, const WorkspaceInformation *ws_info, char **error_msg)
+{
+    if (!cache->is_modified) {
+        return true;
+    }
+
+    const uint32_t entries_count = HASH_COUNT(cache->entries);
+
+    ByteBuffer *buffer = create_byte_buffer(64 + (size_t) entries_count * 64);
+    byte_buffer_append_u32(buffer, CONTENT_CACHE_MAGIC);
+    byte_buffer_append_u32(buffer, CONTENT_CACHE_VERSION);
+    byte_buffer_append_string(buffer, ws_info->local_workspace_root_path);
+    byte_buffer_append_u32(buffer, entries_count);
+
+    // Stored from the least to the most recently synced file, so that the order survives loading the cache
+    ContentCacheEntry *entry, *tmp;
+    HASH_ITER(hh, cache->entries, entry, tmp) {
+        byte_buffer_append_string(buffer, entry->key);
+        byte_buffer_append_u64(buffer, entry->fingerprint.inode);
+        byte_buffer_append_u64(buffer, entry->fingerprint.size);
+        byte_buffer_append_u64(buffer, (uint64_t) entry->fingerprint.mtime_sec);
+        byte_buffer_append_u32(buffer, entry->fingerprint.mtime_nsec);
+        byte_buffer_append_u64(buffer, entry->fingerprint.hash);
+    }
+
+    if (mkdir(DEFAULT_RESYNC_SYNC_STATE_DIRECTORY, 0700) == -1 && errno != EEXIST) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to create the sync state directory: %s", strerror(errno)));
+        destroy_byte_buffer(&buffer);
+        return false;
+    }
+
+    char *path = get_content_cache_file_path(ws_info->local_workspace_root_path);
+    char *tmp_path = format_string("%s.tmp", path);
+
+    // Like the sync state, the cache only has to survive the monitor, so it is not flushed to disk
+    bool res = false;
+    const int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd == -1 || !write_all(fd, buffer->data, buffer->size)) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to write the content cache: %s", strerror(errno)));
+    } else if (rename(tmp_path, path) == -1) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to replace the content cache: %s", strerror(errno)));
+    } else {
+        cache->is_modified = false;
+        res = true;
+    }
+
+    if (fd != -1) {
+        close(fd);
+    }
+    if (res == false) {
+        unlink(tmp_path);
+    }
+
+    DO_FREE(tmp_path);
+    DO_FREE(path);
+    destroy_byte_buffer(&buffer);
+    return res;
+}
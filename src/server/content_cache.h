@@ -0,0 +1,105 @@
+#ifndef RESYNC_CONTENT_CACHE_H
+#define RESYNC_CONTENT_CACHE_H
+
+#include "../util/string.h"
+#include "../util/memory.h"
+#include "../util/error.h"
+#include "../util/byte_buffer.h"
+#include "../util/fs_util.h"
+#include "../types/types.h"
+#include "../socket.h"
+#include "../../lib/utash.h"
+#include "sync_state.h"
+#include "delta.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/*
+ * Content of the files that were last synced, so that writes that do not change the content of a file, e.g. of code
+ *  generators or build tools that rewrite all of their output, are not synced. A file is identified by its path and
+ *  inode, its content by its size, its modification time and a hash. If only the modification time changed, the file
+ *  is hashed to decide whether its content changed as well. Skipped writes leave the modification time of the remote
+ *  file behind, which is brought up to date by the next sync of its directory.
+ *
+ * The cache only stays accurate if every change of a cached file either passes 'is_content_unchanged' or invalidates
+ *  the file. The least recently synced files are evicted to bound the size of the cache, files that are larger than
+ *  CONTENT_CACHE_MAX_FILE_SIZE are not cached at all, as hashing them costs more than a no-op sync.
+ */
+
+#define CONTENT_CACHE_MAX_ENTRIES 65536
+#define CONTENT_CACHE_MAX_FILE_SIZE ((uint64_t) (16 * 1024 * 1024))
+#define CONTENT_CACHE_READ_SIZE ((size_t) (64 * 1024))
+
+#define CONTENT_CACHE_MAGIC 0x53524343
+#define CONTENT_CACHE_VERSION 1
+
+typedef struct ContentFingerprint {
+    uint64_t inode;
+    uint64_t size;
+    int64_t mtime_sec;
+    uint32_t mtime_nsec;
+    uint64_t hash;
+    /* Whether the content was hashed, i.e. whether the file can be cached */
+    bool is_hashed;
+} ContentFingerprint;
+
+typedef struct ContentCacheEntry {
+    /* Path relative to the workspace root */
+    char *key;
+    ContentFingerprint fingerprint;
+    UT_hash_handle hh;
+} ContentCacheEntry;
+
+typedef struct ContentCache {
+    /* Ordered from the least to the most recently synced file */
+    ContentCacheEntry *entries;
+    /* Whether the cache changed since it was loaded or stored */
+    bool is_modified;
+} ContentCache;
+
+ContentCache *create_content_cache(void);
+
+void destroy_content_cache(ContentCache **cache);
+
+/**
+ * Checks whether the written file still has the content it had when it was last synced.
+ *
+ * @param fingerprint receives the fingerprint of the current content, which has to be passed to 'record_synced_content'
+ *  once the write was synced
+ * @return true if the content did not change, i.e. the write does not have to be synced
+ */
+bool is_content_unchanged(ContentCache *cache, const char *relative_path, const char *absolute_path,
+                          ContentFingerprint *fingerprint);
+
+/**
+ * Caches the content of the synced file, unless it changed again since it was fingerprinted, as it is not known which
+ *  content the remote systems received in that case.
+ */
+void record_synced_content(ContentCache *cache, const char *relative_path, const char *absolute_path,
+                           const ContentFingerprint *fingerprint);
+
+/**
+ * Removes the resource from the cache, and all resources below it if it is a directory.
+ */
+void invalidate_cached_content(ContentCache *cache, const char *relative_path, const bool is_directory);
+
+void clear_content_cache(ContentCache *cache);
+
+/**
+ * Loads the persisted cache of the workspace. Files whose inode, size or modification time no longer match are dropped,
+ *  as they changed while the cache was not maintained.
+ *
+ * @return the loaded cache, or NULL if none was persisted or it cannot be used
+ */
+ContentCache *load_content_cache(const WorkspaceInformation *ws_info, char **error_msg);
+
+/**
+ * Atomically replaces the persisted cache of the workspace, if the cache changed since it was loaded or stored.
+ */
+bool store_content_cache(ContentCache *cache, const WorkspaceInformation *ws_info, char **error_msg);
+
+#endif //RESYNC_CONTENT_CACHE_H
@@ -0,0 +1,479 @@
+#include "delta.h"
+
+#define PRIME64_1 CHECKSUM_PRIME64_1
+#define PRIME64_2 CHECKSUM_PRIME64_2
+#define PRIME64_3 CHECKSUM_PRIME64_3
+#define PRIME64_4 CHECKSUM_PRIME64_4
+#define PRIME64_5 CHECKSUM_PRIME64_5
+#define STRIPE_SIZE CHECKSUM_HASH_STRIPE_SIZE
+
+#define ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+static uint64_t
+read_u64_le(const unsigned char *ptr)
+{
+    uint64_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return le64toh(value);
+}
+
+static uint32_t
+read_u32_le(const unsigned char *ptr)
+{
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return le32toh(value);
+}
+
+static uint64_t
+hash_round(uint64_t acc, const uint64_t input)
+{
+    acc += input * PRIME64_2;
+    acc = ROTL64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static uint64_t
+hash_merge_round(uint64_t acc, const uint64_t value)
+{
+    acc ^= hash_round(0, value);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+void
+delta_hash_init(DeltaHashState *state)
+{
+    memset(state, 0, sizeof(DeltaHashState));
+    state->acc[0] = CHECKSUM_PRIME32_3;
+    state->acc[1] = PRIME64_1;
+    state->acc[2] = PRIME64_2;
+    state->acc[3] = PRIME64_3;
+    state->acc[4] = PRIME64_4;
+    state->acc[5] = CHECKSUM_PRIME32_2;
+    state->acc[6] = PRIME64_5;
+    state->acc[7] = CHECKSUM_PRIME32_1;
+}
+
+void
+delta_hash_update(DeltaHashState *state, const void *data, size_t size)
+{
+    const ChecksumKernels *kernels = get_checksum_kernels();
+    const unsigned char *ptr = (const unsigned char *) data;
+    state->total_len += size;
+
+    if (state->buffered > 0) {
+        const size_t fill = (size < STRIPE_SIZE - state->buffered) ? size : STRIPE_SIZE - state->buffered;
+        memcpy(state->buffer + state->buffered, ptr, fill);
+        state->buffered += fill;
+        ptr += fill;
+        size -= fill;
+
+        if (state->buffered < STRIPE_SIZE) {
+            return;
+        }
+        kernels->hash_stripes(state->acc, state->buffer, 1, &state->block_stripe);
+        state->buffered = 0;
+    }
+
+    const size_t stripe_count = size / STRIPE_SIZE;
+    kernels->hash_stripes(state->acc, ptr, stripe_count, &state->block_stripe);
+    ptr += stripe_count * STRIPE_SIZE;
+    size -= stripe_count * STRIPE_SIZE;
+
+    memcpy(state->buffer, ptr, size);
+    state->buffered = size;
+}
+
+uint64_t
+delta_hash_digest(const DeltaHashState *state)
+{
+    // The accumulators and the remaining bytes are folded into the hash like the accumulators and the tail of XXH64
+    uint64_t hash = state->total_len * PRIME64_1;
+    for (int i = 0; i < CHECKSUM_HASH_LANES; i++) {
+        hash = hash_merge_round(hash, state->acc[i]);
+    }
+
+    const unsigned char *ptr = state->buffer;
+    uint32_t remaining = state->buffered;
+    for (; remaining >= 8; ptr += 8, remaining -= 8) {
+        hash ^= hash_round(0, read_u64_le(ptr));
+        hash = ROTL64(hash, 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (remaining >= 4) {
+        hash ^= (uint64_t) read_u32_le(ptr) * PRIME64_1;
+        hash = ROTL64(hash, 23) * PRIME64_2 + PRIME64_3;
+        ptr += 4;
+        remaining -= 4;
+    }
+    for (; remaining > 0; ptr++, remaining--) {
+        hash ^= (*ptr) * PRIME64_5;
+        hash = ROTL64(hash, 11) * PRIME64_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+uint64_t
+delta_hash(const void *data, const size_t size)
+{
+    DeltaHashState state;
+    delta_hash_init(&state);
+    delta_hash_update(&state, data, size);
+    return delta_hash_digest(&state);
+}
+
+void
+rolling_checksum_init(RollingChecksum *checksum, const unsigned char *data, const uint32_t block_size)
+{
+    checksum->block_size = block_size;
+    get_checksum_kernels()->rolling_sums(data, block_size, &checksum->a, &checksum->b);
+}
+
+void
+rolling_checksum_roll(RollingChecksum *checksum, const unsigned char out, const unsigned char in)
+{
+    checksum->a += in - out;
+    checksum->b += checksum->a - checksum->block_size * out;
+}
+
+uint32_t
+rolling_checksum_value(const RollingChecksum *checksum)
+{
+    return (checksum->a & 0xffff) | (checksum->b << 16);
+}
+
+uint32_t
+get_delta_block_size(const uint64_t file_size)
+{
+    // Roughly the square root of the file size balances the size of the signature against the granularity of matches
+    uint64_t block_size = DELTA_MIN_BLOCK_SIZE;
+    while (block_size * block_size < file_size) {
+        block_size *= 2;
+    }
+
+    while (file_size / block_size >= DELTA_MAX_BLOCK_COUNT) {
+        block_size *= 2;
+    }
+
+    return (block_size > UINT32_MAX / 2) ? UINT32_MAX / 2 : (uint32_t) block_size;
+}
+
+static void
+index_file_signature(FileSignature *signature)
+{
+    uint32_t bucket_count = 16;
+    while (bucket_count < signature->block_count * 2) {
+        bucket_count *= 2;
+    }
+
+    signature->bucket_mask = bucket_count - 1;
+    signature->buckets = (int32_t *) do_malloc(bucket_count * sizeof(int32_t));
+    signature->chain = (int32_t *) do_malloc((signature->block_count + 1) * sizeof(int32_t));
+    memset(signature->buckets, 0xff, bucket_count * sizeof(int32_t));
+
+    // Inserted in reverse, so that every chain lists its blocks in ascending order, which makes consecutive copies
+    //  of unchanged regions likely
+    for (uint32_t i = signature->block_count; i-- > 0;) {
+        const uint32_t bucket = signature->blocks[i].weak & signature->bucket_mask;
+        signature->chain[i] = signature->buckets[bucket];
+        signature->buckets[bucket] = (int32_t) i;
+    }
+}
+
+FileSignature *
+compute_file_signature(const int fd, const uint64_t file_size, char **error_msg)
+{
+    FileSignature *signature = (FileSignature *) do_calloc(1, sizeof(FileSignature));
+    signature->block_size = get_delta_block_size(file_size);
+    signature->block_count = file_size / signature->block_size;
+    signature->blocks = (BlockSignature *) do_calloc(signature->block_count + 1, sizeof(BlockSignature));
+
+    unsigned char *block = (unsigned char *) do_malloc(signature->block_size);
+    for (uint32_t i = 0; i < signature->block_count; i++) {
+        if (read_all(fd, block, signature->block_size) != 1) {
+            SET_ERROR_MSG(error_msg, "File was truncated while its signature was computed");
+            DO_FREE(block);
+            destroy_file_signature(&signature);
+            return NULL;
+        }
+
+        RollingChecksum checksum;
+        rolling_checksum_init(&checksum, block, signature->block_size);
+        signature->blocks[i].weak = rolling_checksum_value(&checksum);
+        signature->blocks[i].strong = delta_hash(block, signature->block_size);
+    }
+
+    DO_FREE(block);
+    index_file_signature(signature);
+    return signature;
+}
+
+void
+append_file_signature(ByteBuffer *buffer, const FileSignature *signature)
+{
+    byte_buffer_append_u32(buffer, htobe32(signature->block_size));
+    byte_buffer_append_u32(buffer, htobe32(signature->block_count));
+
+    for (uint32_t i = 0; i < signature->block_count; i++) {
+        byte_buffer_append_u32(buffer, htobe32(signature->blocks[i].weak));
+        byte_buffer_append_u64(buffer, htobe64(signature->blocks[i].strong));
+    }
+}
+
+FileSignature *
+read_file_signature(ByteBufferReader *reader)
+{
+    const uint32_t block_size = be32toh(byte_buffer_read_u32(reader));
+    const uint32_t block_count = be32toh(byte_buffer_read_u32(reader));
+    if (reader->error || block_size == 0 || block_count > DELTA_MAX_BLOCK_COUNT) {
+        reader->error = true;
+        return NULL;
+    }
+
+    FileSignature *signature = (FileSignature *) do_calloc(1, sizeof(FileSignature));
+    signature->block_size = block_size;
+    signature->block_count = block_count;
+    signature->blocks = (BlockSignature *) do_calloc(block_count + 1, sizeof(BlockSignature));
+
+    for (uint32_t i = 0; i < block_count; i++) {
+        signature->blocks[i].weak = be32toh(byte_buffer_read_u32(reader));
+        signature->blocks[i].strong = be64toh(byte_buffer_read_u64(reader));
+    }
+
+    if (reader->error) {
+        destroy_file_signature(&signature);
+        return NULL;
+    }
+
+    index_file_signature(signature);
+    return signature;
+}
+
+void
+destroy_file_signature(FileSignature **signature)
+{
+    if (signature == NULL || *signature == NULL) {
+        return;
+    }
+
+    DO_FREE((*signature)->blocks);
+    DO_FREE((*signature)->buckets);
+    DO_FREE((*signature)->chain);
+    DO_FREE(*signature);
+}
+
+/*
+ * @return index of the base block with the same content as the window, or -1 if there is none
+ */
+static int32_t
+find_matching_block(const FileSignature *signature, const uint32_t weak, const unsigned char *window)
+{
+    bool is_strong_computed = false;
+    uint64_t strong = 0;
+
+    for (int32_t i = signature->buckets[weak & signature->bucket_mask]; i != -1; i = signature->chain[i]) {
+        if (signature->blocks[i].weak != weak) {
+            continue;
+        }
+
+        // The strong hash is only computed for windows whose weak checksum matches any block
+        if (!is_strong_computed) {
+            strong = delta_hash(window, signature->block_size);
+            is_strong_computed = true;
+        }
+        if (signature->blocks[i].strong == strong) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * Accumulates copies of consecutive base blocks into a single copy.
+ */
+typedef struct DeltaCopyRun {
+    uint32_t block_index;
+    uint32_t block_count;
+} DeltaCopyRun;
+
+static bool
+flush_copy_run(const DeltaEmitter *emitter, DeltaCopyRun *run)
+{
+    if (run->block_count == 0) {
+        return true;
+    }
+
+    const bool res = emitter->copy(emitter->ctx, run->block_index, run->block_count);
+    run->block_count = 0;
+    return res;
+}
+
+static bool
+emit_literal(const DeltaEmitter *emitter, DeltaCopyRun *run, const unsigned char *data, size_t size)
+{
+    if (size == 0) {
+        return true;
+    }
+
+    if (!flush_copy_run(emitter, run)) {
+        return false;
+    }
+
+    for (size_t offset = 0; offset < size; offset += DELTA_MAX_LITERAL_SIZE) {
+        const size_t literal_size = (size - offset < DELTA_MAX_LITERAL_SIZE) ? size - offset : DELTA_MAX_LITERAL_SIZE;
+        if (!emitter->literal(emitter->ctx, (const char *) data + offset, (uint32_t) literal_size)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool
+emit_copy(const DeltaEmitter *emitter, DeltaCopyRun *run, const uint32_t block_index)
+{
+    if (run->block_count > 0 && run->block_index + run->block_count == block_index) {
+        run->block_count++;
+        return true;
+    }
+
+    if (!flush_copy_run(emitter, run)) {
+        return false;
+    }
+
+    run->block_index = block_index;
+    run->block_count = 1;
+    return true;
+}
+
+bool
+generate_delta(const int fd, const FileSignature *signature, const DeltaEmitter *emitter, uint64_t *file_size,
+               uint64_t *file_hash, char **error_msg)
+{
+    const uint32_t block_size = signature->block_size;
+    const size_t capacity = DELTA_READ_AHEAD_SIZE + block_size;
+    unsigned char *buffer = (unsigned char *) do_malloc(capacity);
+
+    // The window spans [pos, pos + block_size), data in [literal_start, pos) was not emitted yet
+    size_t len = 0, pos = 0, literal_start = 0;
+    bool is_eof = false, is_checksum_valid = false;
+    bool res = true;
+
+    RollingChecksum checksum;
+    DeltaCopyRun run = {.block_index = 0, .block_count = 0};
+
+    DeltaHashState hash_state;
+    delta_hash_init(&hash_state);
+    *file_size = 0;
+
+    while (res) {
+        if (len - pos < block_size && !is_eof) {
+            // Data before the window is no longer needed once it is emitted, so the buffer is refilled behind it
+            if (!emit_literal(emitter, &run, buffer + literal_start, pos - literal_start)) {
+                res = false;
+                break;
+            }
+
+            memmove(buffer, buffer + pos, len - pos);
+            len -= pos;
+            pos = 0;
+            literal_start = 0;
+
+            while (len < capacity && !is_eof) {
+                const ssize_t read_size = read(fd, buffer + len, capacity - len);
+                if (read_size == -1 && errno == EINTR) {
+                    continue;
+                } else if (read_size == -1) {
+                    SET_ERROR_MSG_RAW(error_msg, format_string("Unable to read the file: %s", strerror(errno)));
+                    res = false;
+                    break;
+                }
+
+                is_eof = (read_size == 0);
+                delta_hash_update(&hash_state, buffer + len, read_size);
+                len += read_size;
+                *file_size += read_size;
+            }
+            continue;
+        }
+
+        if (len - pos < block_size || signature->block_count == 0) {
+            break;
+        }
+
+        if (!is_checksum_valid) {
+            rolling_checksum_init(&checksum, buffer + pos, block_size);
+            is_checksum_valid = true;
+        }
+
+        const int32_t block_index = find_matching_block(signature, rolling_checksum_value(&checksum), buffer + pos);
+        if (block_index != -1) {
+            if (!emit_literal(emitter, &run, buffer + literal_start, pos - literal_start)
+                || !emit_copy(emitter, &run, (uint32_t) block_index)) {
+                res = false;
+                break;
+            }
+
+            pos += block_size;
+            literal_start = pos;
+            is_checksum_valid = false;
+            continue;
+        }
+
+        if (pos + block_size < len) {
+            rolling_checksum_roll(&checksum, buffer[pos], buffer[pos + block_size]);
+        } else {
+            is_checksum_valid = false;
+        }
+        pos++;
+
+        if (pos - literal_start >= DELTA_MAX_LITERAL_SIZE) {
+            if (!emit_literal(emitter, &run, buffer + literal_start, pos - literal_start)) {
+                res = false;
+                break;
+            }
+            literal_start = pos;
+        }
+    }
+
+    // Without any base block, the entire file is literal data, which still has to be read
+    while (res && !is_eof) {
+        if (!emit_literal(emitter, &run, buffer + literal_start, len - literal_start)) {
+            res = false;
+            break;
+        }
+
+        literal_start = 0;
+        const ssize_t read_size = read(fd, buffer, capacity);
+        if (read_size == -1 && errno == EINTR) {
+            len = 0;
+            continue;
+        } else if (read_size == -1) {
+            SET_ERROR_MSG_RAW(error_msg, format_string("Unable to read the file: %s", strerror(errno)));
+            res = false;
+            break;
+        }
+
+        is_eof = (read_size == 0);
+        delta_hash_update(&hash_state, buffer, read_size);
+        len = read_size;
+        *file_size += read_size;
+    }
+
+    if (res) {
+        res = emit_literal(emitter, &run, buffer + literal_start, len - literal_start) && flush_copy_run(emitter, &run);
+    }
+    if (res == false && error_msg != NULL && *error_msg == NULL) {
+        SET_ERROR_MSG(error_msg, "Unable to emit the delta");
+    }
+
+    *file_hash = delta_hash_digest(&hash_state);
+    DO_FREE(buffer);
+    return res;
+}
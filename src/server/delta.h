@@ -0,0 +1,130 @@
+#ifndef RESYNC_DELTA_H
+#define RESYNC_DELTA_H
+
+#include "../util/string.h"
+#include "../util/memory.h"
+#include "../util/error.h"
+#include "../util/byte_buffer.h"
+#include "../util/checksum_kernels.h"
+#include "../socket.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <endian.h>
+
+/*
+ * Delta encoding of files, in the way rsync does it. The receiver of a file splits its current version (the base) into
+ *  blocks of a fixed size and sends a signature consisting of a weak, rolling checksum and a strong hash per block.
+ *  The sender slides a window over its version of the file, looks the weak checksum of every window position up in
+ *  the signature, confirms candidates with the strong hash and encodes the file as a sequence of copies of base blocks
+ *  and literal data. A hash of the entire file allows the receiver to verify the reconstructed file.
+ */
+
+#define DELTA_MIN_BLOCK_SIZE ((uint32_t) 1024)
+/* Bounds the size of a signature, larger files use larger blocks */
+#define DELTA_MAX_BLOCK_COUNT ((uint32_t) 16384)
+/* Literal data is emitted in pieces of at most this size */
+#define DELTA_MAX_LITERAL_SIZE ((uint32_t) (64 * 1024))
+/* Amount of data the sender reads ahead of the window */
+#define DELTA_READ_AHEAD_SIZE ((size_t) (1024 * 1024))
+
+typedef struct DeltaHashState {
+    uint64_t acc[CHECKSUM_HASH_LANES];
+    uint64_t total_len;
+    unsigned char buffer[CHECKSUM_HASH_STRIPE_SIZE];
+    uint32_t buffered;
+    /* Number of stripes consumed since the accumulators were last scrambled */
+    uint32_t block_stripe;
+} DeltaHashState;
+
+typedef struct RollingChecksum {
+    uint32_t a;
+    uint32_t b;
+    uint32_t block_size;
+} RollingChecksum;
+
+typedef struct BlockSignature {
+    uint32_t weak;
+    uint64_t strong;
+} BlockSignature;
+
+/*
+ * Signature of the full blocks of a base file. A short last block is not part of the signature, its data is always
+ *  transmitted as literal.
+ */
+typedef struct FileSignature {
+    uint32_t block_size;
+    uint32_t block_count;
+    BlockSignature *blocks;
+    /* Lookup of blocks by their weak checksum: heads of the bucket chains and the next block of every chain, or -1 */
+    int32_t *buckets;
+    int32_t *chain;
+    uint32_t bucket_mask;
+} FileSignature;
+
+/*
+ * Receives the encoded delta. Copies refer to a run of consecutive base blocks.
+ */
+typedef struct DeltaEmitter {
+    bool (*copy)(void *ctx, const uint32_t block_index, const uint32_t block_count);
+    bool (*literal)(void *ctx, const char *data, const uint32_t size);
+    void *ctx;
+} DeltaEmitter;
+
+/*
+ * 64 bit hash used as strong block hash and as file hash (XXH64)
+ */
+void delta_hash_init(DeltaHashState *state);
+
+void delta_hash_update(DeltaHashState *state, const void *data, size_t size);
+
+uint64_t delta_hash_digest(const DeltaHashState *state);
+
+uint64_t delta_hash(const void *data, const size_t size);
+
+void rolling_checksum_init(RollingChecksum *checksum, const unsigned char *data, const uint32_t block_size);
+
+/**
+ * Moves the window by one byte.
+ */
+void rolling_checksum_roll(RollingChecksum *checksum, const unsigned char out, const unsigned char in);
+
+uint32_t rolling_checksum_value(const RollingChecksum *checksum);
+
+/**
+ * @return the block size for a base file of the given size
+ */
+uint32_t get_delta_block_size(const uint64_t file_size);
+
+/**
+ * Computes the signature of the file, reading it from its current offset on.
+ *
+ * @return the signature, or NULL if the file could not be read (the error message is set)
+ */
+FileSignature *compute_file_signature(const int fd, const uint64_t file_size, char **error_msg);
+
+/**
+ * Appends the signature with all integers in network byte order, as it is exchanged between hosts.
+ */
+void append_file_signature(ByteBuffer *buffer, const FileSignature *signature);
+
+/**
+ * Reads a signature that was written by 'append_file_signature'.
+ *
+ * @return the signature, or NULL if it is malformed
+ */
+FileSignature *read_file_signature(ByteBufferReader *reader);
+
+void destroy_file_signature(FileSignature **signature);
+
+/**
+ * Encodes the file, read from its current offset on, as delta to the base described by the signature.
+ *
+ * @return true on success. On error, e.g. if the file could not be read or the emitter failed, false is returned and
+ *  the error message is set.
+ */
+bool generate_delta(const int fd, const FileSignature *signature, const DeltaEmitter *emitter, uint64_t *file_size,
+                    uint64_t *file_hash, char **error_msg);
+
+#endif //RESYNC_DELTA_H
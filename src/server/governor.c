@@ -0,0 +1,187 @@
+#include "governor.h"
+
+static SyncLease *
+create_sync_lease(const char *host)
+{
+    SyncLease *lease = (SyncLease *) do_calloc(1, sizeof(SyncLease));
+    lease->host = resync_strdup(host);
+    return lease;
+}
+
+static void
+destroy_sync_leases(SyncLease **leases)
+{
+    SyncLease *lease, *tmp;
+    LL_FOREACH_SAFE(*leases, lease, tmp) {
+        LL_DELETE(*leases, lease);
+        DO_FREE(lease->host);
+        DO_FREE(lease);
+    }
+}
+
+static SyncGovernorHost *
+get_host(SyncGovernor *governor, const char *host)
+{
+    SyncGovernorHost *entry;
+    HASH_FIND_STR(governor->hosts, host, entry);
+    if (entry == NULL) {
+        entry = (SyncGovernorHost *) do_calloc(1, sizeof(SyncGovernorHost));
+        entry->host = resync_strdup(host);
+        HASH_ADD_KEYPTR(hh, governor->hosts, entry->host, strlen(entry->host), entry);
+    }
+
+    return entry;
+}
+
+static SyncGovernorWorkspace *
+find_workspace(SyncGovernor *governor, const char *ws_path)
+{
+    SyncGovernorWorkspace *workspace;
+    HASH_FIND_STR(governor->workspaces, ws_path, workspace);
+    return workspace;
+}
+
+static void
+destroy_workspace(SyncGovernor *governor, SyncGovernorWorkspace *workspace)
+{
+    HASH_DEL(governor->workspaces, workspace);
+    destroy_sync_leases(&(workspace->pending_leases));
+    destroy_sync_leases(&(workspace->granted_leases));
+    DO_FREE(workspace->ws_path);
+    DO_FREE(workspace);
+}
+
+static bool
+is_grantable(const SyncGovernor *governor, SyncGovernorHost *host)
+{
+    return governor->leases_in_flight < governor->max_leases && host->leases_in_flight < governor->max_leases_per_host;
+}
+
+SyncGovernor *
+create_sync_governor(const int max_leases, const int max_leases_per_host)
+{
+    SyncGovernor *governor = (SyncGovernor *) do_calloc(1, sizeof(SyncGovernor));
+    governor->max_leases = max_leases;
+    governor->max_leases_per_host = max_leases_per_host;
+    return governor;
+}
+
+void
+destroy_sync_governor(SyncGovernor **governor)
+{
+    if (governor == NULL || *governor == NULL) {
+        return;
+    }
+
+    SyncGovernorWorkspace *workspace, *tmp_workspace;
+    HASH_ITER(hh, (*governor)->workspaces, workspace, tmp_workspace) {
+        destroy_workspace(*governor, workspace);
+    }
+
+    SyncGovernorHost *host, *tmp_host;
+    HASH_ITER(hh, (*governor)->hosts, host, tmp_host) {
+        HASH_DEL((*governor)->hosts, host);
+        DO_FREE(host->host);
+        DO_FREE(host);
+    }
+
+    DO_FREE(*governor);
+}
+
+void
+request_sync_lease(SyncGovernor *governor, const char *ws_path, const int weight, const char *host)
+{
+    SyncGovernorWorkspace *workspace = find_workspace(governor, ws_path);
+    if (workspace == NULL) {
+        workspace = (SyncGovernorWorkspace *) do_calloc(1, sizeof(SyncGovernorWorkspace));
+        workspace->ws_path = resync_strdup(ws_path);
+        workspace->virtual_time = governor->virtual_time;
+        HASH_ADD_KEYPTR(hh, governor->workspaces, workspace->ws_path, strlen(workspace->ws_path), workspace);
+    } else if (workspace->pending_leases == NULL && workspace->virtual_time < governor->virtual_time) {
+        // A workspace that did not compete for a while must not have accumulated credit in the meantime
+        workspace->virtual_time = governor->virtual_time;
+    }
+
+    workspace->weight = (weight > 0) ? weight : 1;
+    LL_APPEND(workspace->pending_leases, create_sync_lease(host));
+}
+
+void
+release_sync_lease(SyncGovernor *governor, const char *ws_path, const char *host)
+{
+    SyncGovernorWorkspace *workspace = find_workspace(governor, ws_path);
+    if (workspace == NULL) {
+        return;
+    }
+
+    SyncLease *lease;
+    LL_FOREACH(workspace->granted_leases, lease) {
+        if (is_equal(lease->host, host)) {
+            break;
+        }
+    }
+
+    if (lease == NULL) {
+        return;
+    }
+
+    LL_DELETE(workspace->granted_leases, lease);
+    get_host(governor, lease->host)->leases_in_flight--;
+    governor->leases_in_flight--;
+    DO_FREE(lease->host);
+    DO_FREE(lease);
+}
+
+void
+release_all_sync_leases(SyncGovernor *governor, const char *ws_path)
+{
+    SyncGovernorWorkspace *workspace = find_workspace(governor, ws_path);
+    if (workspace == NULL) {
+        return;
+    }
+
+    SyncLease *lease;
+    LL_FOREACH(workspace->granted_leases, lease) {
+        get_host(governor, lease->host)->leases_in_flight--;
+        governor->leases_in_flight--;
+    }
+
+    destroy_workspace(governor, workspace);
+}
+
+void
+dispatch_sync_leases(SyncGovernor *governor, SyncLeaseGrantCallback callback, void *context)
+{
+    while (governor->leases_in_flight < governor->max_leases) {
+        // Serve the workspace with the smallest virtual time whose oldest request can be granted. The oldest request
+        //  of a workspace is served first, even if a later one targets a less busy host.
+        SyncGovernorWorkspace *next = NULL;
+        SyncGovernorWorkspace *workspace, *tmp;
+        HASH_ITER(hh, governor->workspaces, workspace, tmp) {
+            if (workspace->pending_leases == NULL
+                || !is_grantable(governor, get_host(governor, workspace->pending_leases->host))) {
+                continue;
+            }
+
+            if (next == NULL || workspace->virtual_time < next->virtual_time) {
+                next = workspace;
+            }
+        }
+
+        if (next == NULL) {
+            return;
+        }
+
+        SyncLease *lease = next->pending_leases;
+        LL_DELETE(next->pending_leases, lease);
+        LL_APPEND(next->granted_leases, lease);
+
+        get_host(governor, lease->host)->leases_in_flight++;
+        governor->leases_in_flight++;
+
+        governor->virtual_time = next->virtual_time;
+        next->virtual_time += 1.0 / next->weight;
+
+        callback(next->ws_path, lease->host, context);
+    }
+}
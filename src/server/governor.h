@@ -0,0 +1,74 @@
+#ifndef RESYNC_GOVERNOR_H
+#define RESYNC_GOVERNOR_H
+
+#include "../util/string.h"
+#include "../util/memory.h"
+#include "../util/error.h"
+#include "../../lib/ulist.h"
+#include "../../lib/utash.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Daemon-wide limit for the number of concurrently running syncs. Before a workspace monitor syncs with a remote
+ *  system, it requests a lease for the remote system's host over its control channel and returns the lease once the
+ *  sync finished. Leases are handed out as long as neither the global nor the per host limit is reached.
+ *
+ * Waiting workspaces are served by weighted fair queuing: every workspace has a virtual clock that advances by
+ *  1 / weight whenever it is granted a lease, and the waiting workspace with the smallest virtual clock is served
+ *  first. Thus, a workspace with weight 2 is granted twice as many leases as one with weight 1 while both compete.
+ */
+
+typedef struct SyncLease {
+    char *host;
+    struct SyncLease *next;
+} SyncLease;
+
+typedef struct SyncGovernorWorkspace {
+    char *ws_path;
+    int weight;
+    double virtual_time;
+    /* Requested leases in the order of their arrival */
+    SyncLease *pending_leases;
+    SyncLease *granted_leases;
+    UT_hash_handle hh;
+} SyncGovernorWorkspace;
+
+typedef struct SyncGovernorHost {
+    char *host;
+    int leases_in_flight;
+    UT_hash_handle hh;
+} SyncGovernorHost;
+
+typedef struct SyncGovernor {
+    int max_leases;
+    int max_leases_per_host;
+    int leases_in_flight;
+    /* Virtual time of the most recent grant, workspaces that compete again continue from there at the earliest */
+    double virtual_time;
+    SyncGovernorWorkspace *workspaces;
+    SyncGovernorHost *hosts;
+} SyncGovernor;
+
+typedef void (*SyncLeaseGrantCallback)(const char *ws_path, const char *host, void *context);
+
+SyncGovernor *create_sync_governor(const int max_leases, const int max_leases_per_host);
+
+void destroy_sync_governor(SyncGovernor **governor);
+
+void request_sync_lease(SyncGovernor *governor, const char *ws_path, const int weight, const char *host);
+
+void release_sync_lease(SyncGovernor *governor, const char *ws_path, const char *host);
+
+/**
+ * Drops all requested and granted leases of the workspace, e.g. because its monitor terminated.
+ */
+void release_all_sync_leases(SyncGovernor *governor, const char *ws_path);
+
+/**
+ * Grants as many of the requested leases as the limits allow and invokes the callback for each of them.
+ */
+void dispatch_sync_leases(SyncGovernor *governor, SyncLeaseGrantCallback callback, void *context);
+
+#endif //RESYNC_GOVERNOR_H
@@ -0,0 +1,245 @@
+#include "bulk_mode.h"
+
+static int event_threshold = BULK_MODE_DEFAULT_EVENT_THRESHOLD;
+
+/* Watch of the lock file's directory, or -1 if the workspace has none */
+static int lock_watch_fd = -1;
+static bool is_lock_held = false;
+
+/* Events of the current and of the previous rate window, which estimate the event rate of the last window */
+static uint64_t rate_window_start_ms = 0;
+static uint64_t rate_window_events = 0;
+static uint64_t previous_rate_window_events = 0;
+
+static bool is_active = false;
+static uint64_t bulk_operation_start_ms = 0;
+static uint64_t last_event_ms = 0;
+
+static DirtySubtreeList *dirty_subtrees = NULL;
+static uint32_t dirty_subtrees_count = 0;
+
+static uint64_t
+now_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000 + (uint64_t) now.tv_nsec / 1000000;
+}
+
+static void
+enter_bulk_mode(const char *reason)
+{
+    last_event_ms = now_ms();
+    if (is_active) {
+        return;
+    }
+
+    is_active = true;
+    bulk_operation_start_ms = last_event_ms;
+    LOG("Detected a bulk operation (%s), deferring changes until it is over", reason);
+}
+
+/*
+ * @param subtree_path NULL for the workspace root
+ */
+static bool
+is_within_subtree(const char *relative_path, const char *subtree_path)
+{
+    if (subtree_path == NULL) {
+        return true;
+    } else if (relative_path == NULL) {
+        return false;
+    }
+
+    const size_t subtree_path_len = strlen(subtree_path);
+    return strncmp(relative_path, subtree_path, subtree_path_len) == 0
+           && (relative_path[subtree_path_len] == '\0' || relative_path[subtree_path_len] == '/');
+}
+
+static void
+add_dirty_subtree(char *relative_directory_path)
+{
+    DirtySubtreeList *entry = (DirtySubtreeList *) do_calloc(1, sizeof(DirtySubtreeList));
+    entry->path_relative_to_ws_root = relative_directory_path;
+    LL_APPEND(dirty_subtrees, entry);
+    dirty_subtrees_count++;
+}
+
+static void
+clear_dirty_subtrees(void)
+{
+    DirtySubtreeList *entry, *tmp;
+    LL_FOREACH_SAFE(dirty_subtrees, entry, tmp) {
+        LL_DELETE(dirty_subtrees, entry);
+        DO_FREE(entry->path_relative_to_ws_root);
+        DO_FREE(entry);
+    }
+    dirty_subtrees_count = 0;
+}
+
+/*
+ * Replaces the dirty subtrees with the innermost directory that contains all of them.
+ */
+static void
+merge_dirty_subtrees(void)
+{
+    char *common_directory = (dirty_subtrees->path_relative_to_ws_root == NULL)
+            ? NULL
+            : resync_strdup(dirty_subtrees->path_relative_to_ws_root);
+
+    DirtySubtreeList *entry;
+    LL_FOREACH(dirty_subtrees->next, entry) {
+        if (common_directory == NULL) {
+            break;
+        }
+
+        char *merged_directory = get_common_directory(common_directory, entry->path_relative_to_ws_root);
+        DO_FREE(common_directory);
+        common_directory = merged_directory;
+    }
+
+    clear_dirty_subtrees();
+    add_dirty_subtree(common_directory);
+}
+
+void
+configure_bulk_mode(const int threshold)
+{
+    event_threshold = (threshold > 0) ? threshold : BULK_MODE_DEFAULT_EVENT_THRESHOLD;
+}
+
+void
+watch_bulk_operation_lock(const int inotify_fd, const char *ws_root_path)
+{
+    char *lock_directory_path = concat_paths(ws_root_path, BULK_OPERATION_LOCK_DIRECTORY);
+
+    // The directory may already be watched like any other directory, whose events must not change
+    lock_watch_fd = inotify_add_watch(
+            inotify_fd,
+            lock_directory_path,
+            BULK_OPERATION_LOCK_EVENT_MASK | IN_MASK_ADD | IN_ONLYDIR
+    );
+    DO_FREE(lock_directory_path);
+}
+
+void
+handle_bulk_operation_lock_event(const struct inotify_event *event)
+{
+    if (lock_watch_fd == -1 || event->wd != lock_watch_fd || event->len == 0
+        || strcmp(event->name, BULK_OPERATION_LOCK_FILE_NAME) != 0) {
+        return;
+    }
+
+    if (event->mask & IN_CREATE) {
+        is_lock_held = true;
+        enter_bulk_mode("lock file '" BULK_OPERATION_LOCK_DIRECTORY "/" BULK_OPERATION_LOCK_FILE_NAME "' was created");
+    } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+        // Git renames the lock file to the index once it is done
+        is_lock_held = false;
+        last_event_ms = now_ms();
+    }
+}
+
+void
+count_events_for_bulk_mode(const uint32_t read_events_count, const uint32_t queued_events_count)
+{
+    const uint64_t now = now_ms();
+    if (now - rate_window_start_ms >= 2 * BULK_MODE_RATE_WINDOW_MS) {
+        previous_rate_window_events = 0;
+        rate_window_events = 0;
+        rate_window_start_ms = now;
+    } else if (now - rate_window_start_ms >= BULK_MODE_RATE_WINDOW_MS) {
+        previous_rate_window_events = rate_window_events;
+        rate_window_events = 0;
+        rate_window_start_ms += BULK_MODE_RATE_WINDOW_MS;
+    }
+    rate_window_events += read_events_count;
+
+    if (is_active) {
+        last_event_ms = now;
+        return;
+    }
+
+    // The events of the previous window are weighted by how much of it overlaps with the last window
+    const uint64_t elapsed_ms = now - rate_window_start_ms;
+    const uint64_t estimated_events = rate_window_events + queued_events_count
+            + previous_rate_window_events * (BULK_MODE_RATE_WINDOW_MS - elapsed_ms) / BULK_MODE_RATE_WINDOW_MS;
+
+    if (estimated_events > (uint64_t) event_threshold) {
+        enter_bulk_mode("event rate exceeded the threshold");
+    }
+}
+
+bool
+is_bulk_mode_active(void)
+{
+    return is_active;
+}
+
+void
+mark_dirty_subtree(const char *relative_directory_path)
+{
+    DirtySubtreeList *entry, *tmp;
+    LL_FOREACH(dirty_subtrees, entry) {
+        if (is_within_subtree(relative_directory_path, entry->path_relative_to_ws_root)) {
+            return;
+        }
+    }
+
+    LL_FOREACH_SAFE(dirty_subtrees, entry, tmp) {
+        if (is_within_subtree(entry->path_relative_to_ws_root, relative_directory_path)) {
+            LL_DELETE(dirty_subtrees, entry);
+            DO_FREE(entry->path_relative_to_ws_root);
+            DO_FREE(entry);
+            dirty_subtrees_count--;
+        }
+    }
+
+    add_dirty_subtree((relative_directory_path == NULL) ? NULL : resync_strdup(relative_directory_path));
+    if (dirty_subtrees_count > BULK_MODE_MAX_DIRTY_SUBTREES) {
+        merge_dirty_subtrees();
+    }
+}
+
+int
+get_bulk_mode_timeout_ms(void)
+{
+    if (!is_active) {
+        return -1;
+    }
+
+    const uint64_t quiescence_ms = is_lock_held ? BULK_MODE_LOCKED_QUIESCENCE_MS : BULK_MODE_QUIESCENCE_MS;
+    uint64_t deadline_ms = last_event_ms + quiescence_ms;
+    if (deadline_ms > bulk_operation_start_ms + BULK_MODE_MAX_DURATION_MS) {
+        deadline_ms = bulk_operation_start_ms + BULK_MODE_MAX_DURATION_MS;
+    }
+
+    const uint64_t now = now_ms();
+    return (deadline_ms > now) ? (int) (deadline_ms - now) : 0;
+}
+
+bool
+is_bulk_operation_over(void)
+{
+    return is_active && get_bulk_mode_timeout_ms() == 0;
+}
+
+void
+leave_bulk_mode(WorkspaceInformation *ws_info)
+{
+    // Changes that agents did not apply yet must not race with the syncs of the subtrees
+    flush_synchronized_changes(ws_info);
+
+    LOG("Bulk operation is over, syncing %u changed subtree(s)", dirty_subtrees_count);
+
+    DirtySubtreeList *entry;
+    LL_FOREACH(dirty_subtrees, entry) {
+        synchronize_workspace(ws_info, entry->path_relative_to_ws_root);
+    }
+    clear_dirty_subtrees();
+
+    // The events of the operation must not start another one right away
+    previous_rate_window_events = 0;
+    rate_window_events = 0;
+    is_active = false;
+}
@@ -0,0 +1,92 @@
+#ifndef RESYNC_BULK_MODE_H
+#define RESYNC_BULK_MODE_H
+
+#include "../../util/string.h"
+#include "../../util/memory.h"
+#include "../../util/debug.h"
+#include "../../util/fs_util.h"
+#include "../../types/types.h"
+#include "../../../lib/ulist.h"
+#include "../sync.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <sys/inotify.h>
+
+/*
+ * Bulk operations, e.g. checkouts, package installations or extracting archives, change thousands of resources across
+ *  the workspace within seconds. Syncing their changes one by one would sync the same directories over and over. While
+ *  a bulk operation is in progress, the monitor only records the subtrees that changed and syncs them once the
+ *  operation is over, i.e. once no event arrived for a while.
+ *
+ * A bulk operation is detected by the rate of the events or by the lock file that git holds while it changes the
+ *  working tree. The lock file extends the period without events that ends the operation, as git may pause while it
+ *  holds the lock, e.g. while it fetches objects.
+ */
+
+/* Events per second from which changes are considered to be part of a bulk operation */
+#define BULK_MODE_DEFAULT_EVENT_THRESHOLD 500
+#define BULK_MODE_RATE_WINDOW_MS 1000
+/* Period without events after which a bulk operation is over, depending on whether its lock file is held */
+#define BULK_MODE_QUIESCENCE_MS 1000
+#define BULK_MODE_LOCKED_QUIESCENCE_MS 5000
+/* Bounds how long changes are deferred if events keep arriving */
+#define BULK_MODE_MAX_DURATION_MS 30000
+/* Dirty subtrees that are recorded before they are merged into their common directory */
+#define BULK_MODE_MAX_DIRTY_SUBTREES 8
+
+#define BULK_OPERATION_LOCK_DIRECTORY ".git"
+#define BULK_OPERATION_LOCK_FILE_NAME "index.lock"
+#define BULK_OPERATION_LOCK_EVENT_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM)
+
+typedef struct DirtySubtreeList {
+    /* NULL for the workspace root */
+    char *path_relative_to_ws_root;
+    struct DirtySubtreeList *next;
+} DirtySubtreeList;
+
+/**
+ * @param threshold events per second from which a bulk operation is detected, 0 for the default
+ */
+void configure_bulk_mode(const int threshold);
+
+/**
+ * Watches the directory of the bulk operation lock file, if the workspace has one. The directory is watched even if it
+ *  is ignored, its events are then handled by 'handle_bulk_operation_lock_event' only. Has to be called again whenever
+ *  the watches of the workspace were registered anew.
+ */
+void watch_bulk_operation_lock(const int inotify_fd, const char *ws_root_path);
+
+/**
+ * Tracks whether the bulk operation lock file is held, which starts a bulk operation.
+ */
+void handle_bulk_operation_lock_event(const struct inotify_event *event);
+
+/**
+ * Counts the events that were read, which starts a bulk operation if the event rate exceeds the threshold. As events
+ *  are read more slowly than they arrive while the monitor is syncing, the events that are still queued count as well.
+ */
+void count_events_for_bulk_mode(const uint32_t read_events_count, const uint32_t queued_events_count);
+
+bool is_bulk_mode_active(void);
+
+void mark_dirty_subtree(const char *relative_directory_path);
+
+/**
+ * @return the time until the bulk operation may be over, or -1 if there is none
+ */
+int get_bulk_mode_timeout_ms(void);
+
+/**
+ * @return true if a bulk operation is in progress and no event arrived for the quiescence period, or the operation
+ *  took too long to defer its changes any further
+ */
+bool is_bulk_operation_over(void);
+
+/**
+ * Syncs the dirty subtrees with all remote systems and returns to syncing changes one by one.
+ */
+void leave_bulk_mode(WorkspaceInformation *ws_info);
+
+#endif //RESYNC_BULK_MODE_H
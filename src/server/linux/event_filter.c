@@ -0,0 +1,159 @@
+#include "event_filter.h"
+
+/*
+ * Name of a discardable file, given by a prefix and a suffix that are both optional. A rule without a suffix whose
+ *  prefix is the entire name matches that name only.
+ */
+typedef struct EventNameRule {
+    const char *prefix;
+    size_t prefix_len;
+    const char *suffix;
+    size_t suffix_len;
+    bool is_exact;
+    EventFilterReason reason;
+} EventNameRule;
+
+#define PREFIX_RULE(prefix, reason) {prefix, sizeof(prefix) - 1, "", 0, false, reason}
+#define SUFFIX_RULE(suffix, reason) {"", 0, suffix, sizeof(suffix) - 1, false, reason}
+#define AFFIX_RULE(prefix, suffix, reason) {prefix, sizeof(prefix) - 1, suffix, sizeof(suffix) - 1, false, reason}
+#define EXACT_RULE(name, reason) {name, sizeof(name) - 1, "", 0, true, reason}
+
+static const EventNameRule event_name_rules[] = {
+        AFFIX_RULE(".", ".swp", EVENT_FILTER_SWAP_FILE),
+        AFFIX_RULE(".", ".swo", EVENT_FILTER_SWAP_FILE),
+        AFFIX_RULE(".", ".swn", EVENT_FILTER_SWAP_FILE),
+        AFFIX_RULE(".", ".swx", EVENT_FILTER_SWAP_FILE),
+        SUFFIX_RULE(".kate-swp", EVENT_FILTER_SWAP_FILE),
+        SUFFIX_RULE("~", EVENT_FILTER_BACKUP_FILE),
+        EXACT_RULE("4913", EVENT_FILTER_WRITE_PROBE),
+        PREFIX_RULE(".#", EVENT_FILTER_EDITOR_LOCK_FILE),
+        AFFIX_RULE("#", "#", EVENT_FILTER_EDITOR_LOCK_FILE),
+        SUFFIX_RULE("___jb_tmp___", EVENT_FILTER_ATOMIC_SAVE_FILE),
+        SUFFIX_RULE("___jb_old___", EVENT_FILTER_ATOMIC_SAVE_FILE),
+        PREFIX_RULE(".goutputstream-", EVENT_FILTER_ATOMIC_SAVE_FILE)
+};
+
+#define EVENT_NAME_RULES_COUNT (sizeof(event_name_rules) / sizeof(event_name_rules[0]))
+
+static const char *event_filter_reason_names[EVENT_FILTER_REASONS_COUNT] = {
+        [EVENT_FILTER_PASSED] = "passed",
+        [EVENT_FILTER_FILE_CREATED] = "file creations",
+        [EVENT_FILTER_SWAP_FILE] = "swap files",
+        [EVENT_FILTER_BACKUP_FILE] = "backup files",
+        [EVENT_FILTER_WRITE_PROBE] = "write probes",
+        [EVENT_FILTER_EDITOR_LOCK_FILE] = "editor lock files",
+        [EVENT_FILTER_ATOMIC_SAVE_FILE] = "atomic save files"
+};
+
+/*
+ * Characters that the name rules start or end with. Most names neither start nor end with any of them, so that they
+ *  pass without comparing them to any rule.
+ */
+static bool is_rule_first_char[UCHAR_MAX + 1];
+static bool is_rule_last_char[UCHAR_MAX + 1];
+static bool is_event_filter_compiled = false;
+
+static uint64_t filtered_events_counts[EVENT_FILTER_REASONS_COUNT];
+static uint64_t reported_events_counts[EVENT_FILTER_REASONS_COUNT];
+
+static void
+compile_event_filter(void)
+{
+    for (size_t i = 0; i < EVENT_NAME_RULES_COUNT; i++) {
+        const EventNameRule *rule = &event_name_rules[i];
+        if (rule->prefix_len > 0) {
+            is_rule_first_char[(unsigned char) rule->prefix[0]] = true;
+        }
+        if (rule->is_exact) {
+            is_rule_last_char[(unsigned char) rule->prefix[rule->prefix_len - 1]] = true;
+        } else if (rule->suffix_len > 0) {
+            is_rule_last_char[(unsigned char) rule->suffix[rule->suffix_len - 1]] = true;
+        }
+    }
+
+    is_event_filter_compiled = true;
+}
+
+static bool
+match_event_name_rule(const EventNameRule *rule, const char *name, const size_t name_len)
+{
+    if (rule->is_exact) {
+        return name_len == rule->prefix_len && memcmp(name, rule->prefix, name_len) == 0;
+    }
+
+    // The prefix and the suffix must not overlap, e.g. '#' is not an auto-save file of emacs
+    return name_len > rule->prefix_len + rule->suffix_len
+           && memcmp(name, rule->prefix, rule->prefix_len) == 0
+           && memcmp(name + name_len - rule->suffix_len, rule->suffix, rule->suffix_len) == 0;
+}
+
+static EventFilterReason
+classify_event(const uint32_t mask, const char *name)
+{
+    if (name == NULL || (mask & IN_ISDIR)) {
+        return EVENT_FILTER_PASSED;
+    }
+
+    if (mask & IN_CREATE) {
+        return EVENT_FILTER_FILE_CREATED;
+    }
+
+    const size_t name_len = strlen(name);
+    if (name_len == 0
+        || (!is_rule_first_char[(unsigned char) name[0]] && !is_rule_last_char[(unsigned char) name[name_len - 1]])) {
+        return EVENT_FILTER_PASSED;
+    }
+
+    for (size_t i = 0; i < EVENT_NAME_RULES_COUNT; i++) {
+        if (match_event_name_rule(&event_name_rules[i], name, name_len)) {
+            return event_name_rules[i].reason;
+        }
+    }
+
+    return EVENT_FILTER_PASSED;
+}
+
+EventFilterReason
+filter_event(const uint32_t mask, const char *name)
+{
+    if (!is_event_filter_compiled) {
+        compile_event_filter();
+    }
+
+    const EventFilterReason reason = classify_event(mask, name);
+    if (reason != EVENT_FILTER_PASSED) {
+        filtered_events_counts[reason]++;
+    }
+
+    return reason;
+}
+
+void
+report_filtered_events(void)
+{
+    if (memcmp(filtered_events_counts, reported_events_counts, sizeof(filtered_events_counts)) == 0) {
+        return;
+    }
+
+    char *report = NULL;
+    for (int reason = EVENT_FILTER_PASSED + 1; reason < EVENT_FILTER_REASONS_COUNT; reason++) {
+        if (filtered_events_counts[reason] == reported_events_counts[reason]) {
+            continue;
+        }
+
+        char *extended_report = format_string(
+                "%s%s%s: %llu",
+                (report == NULL) ? "" : report,
+                (report == NULL) ? "" : ", ",
+                event_filter_reason_names[reason],
+                (unsigned long long) (filtered_events_counts[reason] - reported_events_counts[reason])
+        );
+        DO_FREE(report);
+        report = extended_report;
+    }
+
+    LOG("Discarded events since the previous report: %s", report);
+    DO_FREE(report);
+
+    memcpy(reported_events_counts, filtered_events_counts, sizeof(filtered_events_counts));
+}
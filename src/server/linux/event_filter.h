@@ -0,0 +1,49 @@
+#ifndef RESYNC_EVENT_FILTER_H
+#define RESYNC_EVENT_FILTER_H
+
+#include "../../util/string.h"
+#include "../../util/debug.h"
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/inotify.h>
+
+/*
+ * First stage of handling an inotify event, which discards events that are irrelevant judging by their mask and the
+ *  name of the resource alone, i.e. without any allocation or system call. Editors produce several of them for every
+ *  save, e.g. vim writes a '4913' probe, renames the file to a '~' backup and maintains a '.swp' swap file. Such files
+ *  are still synced along with their directory if they exist at that time, only their events are not acted upon.
+ */
+
+typedef enum EventFilterReason {
+    EVENT_FILTER_PASSED,
+    /* Files are synced once they are closed after writing, which 'IN_CLOSE_WRITE' reports */
+    EVENT_FILTER_FILE_CREATED,
+    /* Swap files of vim ('.name.swp', ...) and kate ('name.kate-swp') */
+    EVENT_FILTER_SWAP_FILE,
+    /* Backups that editors keep while writing, e.g. 'name~' */
+    EVENT_FILTER_BACKUP_FILE,
+    /* File that vim creates and deletes to probe whether a directory is writable */
+    EVENT_FILTER_WRITE_PROBE,
+    /* Lock ('.#name') and auto-save ('#name#') files of emacs */
+    EVENT_FILTER_EDITOR_LOCK_FILE,
+    /* Temporary files of atomic saves that are renamed to the saved file, e.g. by JetBrains IDEs or gedit */
+    EVENT_FILTER_ATOMIC_SAVE_FILE,
+    EVENT_FILTER_REASONS_COUNT
+} EventFilterReason;
+
+/**
+ * Classifies the event and counts it if it is discarded.
+ *
+ * @param name name of the resource, NULL for events of the watched directory itself
+ * @return EVENT_FILTER_PASSED if the event has to be handled, the reason for discarding it otherwise
+ */
+EventFilterReason filter_event(const uint32_t mask, const char *name);
+
+/**
+ * Logs how many events were discarded for each reason since the previous report, if any.
+ */
+void report_filtered_events(void);
+
+#endif //RESYNC_EVENT_FILTER_H
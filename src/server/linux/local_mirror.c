@@ -0,0 +1,241 @@
+#include "local_mirror.h"
+
+/* Buffer size of the copy through user space, which is only used if the kernel cannot copy between the files */
+#define LOCAL_MIRROR_BUFFER_SIZE ((size_t) (1024 * 1024))
+
+static bool
+set_errno_error_msg(const char *operation, const char *path, char **error_msg)
+{
+    SET_ERROR_MSG_RAW(error_msg, format_string("Unable to %s '%s': %s", operation, path, strerror(errno)));
+    return false;
+}
+
+/*
+ * The temporary file is hidden and placed next to the target, so that it can be renamed into place atomically.
+ */
+static char *
+get_mirror_tmp_path(const char *target_path)
+{
+    const char *name = strrchr(target_path, '/');
+    if (name == NULL) {
+        return format_string(".%s.reSync-tmp", target_path);
+    }
+
+    return format_string("%.*s/.%s.reSync-tmp", (int) (name - target_path), target_path, name + 1);
+}
+
+static bool
+copy_file_content_through_buffer(const int source_fd, const int target_fd)
+{
+    char *buffer = (char *) do_malloc(LOCAL_MIRROR_BUFFER_SIZE);
+
+    bool res = true;
+    while (res) {
+        const ssize_t read_size = read(source_fd, buffer, LOCAL_MIRROR_BUFFER_SIZE);
+        if (read_size == -1 && errno == EINTR) {
+            continue;
+        } else if (read_size <= 0) {
+            res = (read_size == 0);
+            break;
+        }
+
+        res = write_all(target_fd, buffer, read_size);
+    }
+
+    DO_FREE(buffer);
+    return res;
+}
+
+/*
+ * Copies the content from the current offset of the source file on to the current offset of the target file inside of
+ *  the kernel, which file systems may still accelerate, e.g. by server side copies.
+ *
+ * @return false on error (errno is set accordingly)
+ */
+static bool
+copy_file_range_content(const int source_fd, const int target_fd)
+{
+    bool is_copied = false;
+    while (true) {
+        const ssize_t copied_size = copy_file_range(source_fd, NULL, target_fd, NULL, LOCAL_MIRROR_COPY_CHUNK_SIZE, 0);
+        if (copied_size > 0) {
+            is_copied = true;
+            continue;
+        } else if (copied_size == 0) {
+            return true;
+        } else if (errno == EINTR) {
+            continue;
+        }
+
+        // Older kernels cannot copy across file systems and some file systems do not support the call at all, in
+        //  which case the offsets of both files are unchanged and the content is copied through user space instead
+        if (!is_copied && (errno == EXDEV || errno == EOPNOTSUPP || errno == ENOSYS || errno == EINVAL)) {
+            return copy_file_content_through_buffer(source_fd, target_fd);
+        }
+        return false;
+    }
+}
+
+/*
+ * Copies the content from the current offset of the source file on. The copy is reflinked if the file system
+ *  supports it, e.g. btrfs or XFS, so that source and target share their extents until either of them is modified.
+ *
+ * @return false on error (errno is set accordingly)
+ */
+static bool
+copy_file_content(const int source_fd, const int target_fd)
+{
+    if (ioctl(target_fd, FICLONE, source_fd) == 0) {
+        return true;
+    }
+
+    return copy_file_range_content(source_fd, target_fd);
+}
+
+bool
+mirror_local_file(const char *source_path, const char *target_path, char **error_msg)
+{
+    const int source_fd = open(source_path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (source_fd == -1) {
+        if (errno == ENOENT) {
+            return true;
+        }
+        // Symbolic links are left to rsync
+        return (errno == ELOOP) ? false : set_errno_error_msg("open", source_path, error_msg);
+    }
+
+    // Special files are left to rsync as well
+    struct stat source_stat;
+    if (fstat(source_fd, &source_stat) == -1 || !S_ISREG(source_stat.st_mode)) {
+        close(source_fd);
+        return false;
+    }
+
+    char *tmp_path = get_mirror_tmp_path(target_path);
+    const int target_fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (target_fd == -1) {
+        // The directory does not exist in the mirror (yet), which is resolved by syncing it
+        if (errno != ENOENT) {
+            set_errno_error_msg("create a temporary file for", target_path, error_msg);
+        }
+        close(source_fd);
+        DO_FREE(tmp_path);
+        return false;
+    }
+
+    // The times are preserved just as by 'rsync -a', so that rsync still considers the file as up to date
+    const struct timespec times[2] = {source_stat.st_atim, source_stat.st_mtim};
+
+    bool res = true;
+    if (!copy_file_content(source_fd, target_fd)) {
+        res = set_errno_error_msg("copy", source_path, error_msg);
+    } else if (fchmod(target_fd, source_stat.st_mode & 07777) == -1 || futimens(target_fd, times) == -1) {
+        res = set_errno_error_msg("set the attributes of", target_path, error_msg);
+    }
+
+    close(source_fd);
+    if (close(target_fd) == -1 && res) {
+        res = set_errno_error_msg("write", target_path, error_msg);
+    }
+
+    if (res && rename(tmp_path, target_path) == -1) {
+        res = set_errno_error_msg("replace", target_path, error_msg);
+    }
+    if (res == false) {
+        unlink(tmp_path);
+    }
+
+    DO_FREE(tmp_path);
+    return res;
+}
+
+bool
+mirror_local_appended_data(const char *source_path, const char *target_path, const uint64_t offset, char **error_msg)
+{
+    const int source_fd = open(source_path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (source_fd == -1) {
+        if (errno == ENOENT) {
+            return true;
+        }
+        return (errno == ELOOP) ? false : set_errno_error_msg("open", source_path, error_msg);
+    }
+
+    // A target that does not exist or does not end at the offset is replaced by rsync instead. Data of a larger target
+    //  would remain behind the appended data.
+    const int target_fd = open(target_path, O_WRONLY | O_NOFOLLOW | O_CLOEXEC);
+    struct stat source_stat, target_stat;
+    if (target_fd == -1 || fstat(source_fd, &source_stat) == -1 || fstat(target_fd, &target_stat) == -1
+        || !S_ISREG(source_stat.st_mode) || !S_ISREG(target_stat.st_mode) || (uint64_t) target_stat.st_size != offset) {
+        close(source_fd);
+        if (target_fd != -1) {
+            close(target_fd);
+        }
+        return false;
+    }
+
+    const struct timespec times[2] = {source_stat.st_atim, source_stat.st_mtim};
+
+    bool res = true;
+    if (lseek(source_fd, (off_t) offset, SEEK_SET) == -1 || lseek(target_fd, (off_t) offset, SEEK_SET) == -1
+        || !copy_file_range_content(source_fd, target_fd)) {
+        res = set_errno_error_msg("append to", target_path, error_msg);
+    } else if (futimens(target_fd, times) == -1) {
+        res = set_errno_error_msg("set the attributes of", target_path, error_msg);
+    }
+
+    close(source_fd);
+    if (close(target_fd) == -1 && res) {
+        res = set_errno_error_msg("write", target_path, error_msg);
+    }
+    return res;
+}
+
+bool
+mirror_local_directory(const char *target_path, const mode_t mode, char **error_msg)
+{
+    struct stat target_stat;
+    if (mkdir(target_path, 0700) == -1
+        && (errno != EEXIST || lstat(target_path, &target_stat) == -1 || !S_ISDIR(target_stat.st_mode))) {
+        // The parent directory does not exist in the mirror (yet), which is resolved by syncing it
+        return (errno == ENOENT) ? false : set_errno_error_msg("create the directory", target_path, error_msg);
+    }
+
+    // Unlike 'mkdir', the mode is not subject to the umask
+    return mirror_local_mode(target_path, mode, error_msg);
+}
+
+bool
+mirror_local_deletion(const char *target_path, char **error_msg)
+{
+    if (remove_tree_at(AT_FDCWD, target_path) == -1 && errno != ENOENT) {
+        return set_errno_error_msg("delete", target_path, error_msg);
+    }
+    return true;
+}
+
+bool
+mirror_local_move(const char *source_path, const char *target_path, char **error_msg)
+{
+    if (renameat2(AT_FDCWD, source_path, AT_FDCWD, target_path, 0) == 0) {
+        return true;
+    } else if (errno != ENOTEMPTY && errno != EEXIST) {
+        // A source that does not exist in the mirror is resolved by syncing the directories
+        return (errno == ENOENT) ? false : set_errno_error_msg("move", source_path, error_msg);
+    }
+
+    // A directory replaces a non-empty one, which the mirror still contains although it was replaced locally. Both
+    //  are exchanged atomically, so the target path never vanishes, and the replaced directory is deleted afterwards.
+    if (renameat2(AT_FDCWD, source_path, AT_FDCWD, target_path, RENAME_EXCHANGE) == -1) {
+        return set_errno_error_msg("move", source_path, error_msg);
+    }
+    return mirror_local_deletion(source_path, error_msg);
+}
+
+bool
+mirror_local_mode(const char *target_path, const mode_t mode, char **error_msg)
+{
+    if (chmod(target_path, mode & 07777) == -1) {
+        return (errno == ENOENT) ? false : set_errno_error_msg("set the mode of", target_path, error_msg);
+    }
+    return true;
+}
@@ -0,0 +1,63 @@
+#ifndef RESYNC_LOCAL_MIRROR_H
+#define RESYNC_LOCAL_MIRROR_H
+
+#include "../../util/string.h"
+#include "../../util/memory.h"
+#include "../../util/error.h"
+#include "../../util/fs_util.h"
+#include "../../socket.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+
+/*
+ * Applies changes of a workspace to a mirror on the same host, i.e. a remote system with the 'LOCAL_PATH' connection
+ *  type. Content is copied inside of the kernel: files are reflinked if the file system supports it and copied with
+ *  'copy_file_range' otherwise, so the data never passes through user space, let alone a compressor.
+ *
+ * All functions return false if the change could not be applied (the error message is set if the cause is worth
+ *  reporting), in which case the caller falls back to syncing the directory with rsync.
+ */
+
+/* Files are copied with 'copy_file_range' in pieces of at most this size */
+#define LOCAL_MIRROR_COPY_CHUNK_SIZE ((size_t) (64 * 1024 * 1024))
+
+/**
+ * Replaces the target file with a copy of the source file. A source file that no longer exists is skipped, as its
+ *  deletion is mirrored by the corresponding change.
+ */
+bool mirror_local_file(const char *source_path, const char *target_path, char **error_msg);
+
+/**
+ * Copies the data of the source file from the offset on to the target file, which has to have the content of the
+ *  source file up to the offset and end there. The target is written in place, as appending to it does not change what
+ *  readers of the target already saw.
+ */
+bool mirror_local_appended_data(const char *source_path, const char *target_path, const uint64_t offset,
+                                char **error_msg);
+
+/**
+ * Creates the target directory, or sets its mode if it already exists.
+ */
+bool mirror_local_directory(const char *target_path, const mode_t mode, char **error_msg);
+
+/**
+ * Deletes the target, including its content if it is a directory.
+ */
+bool mirror_local_deletion(const char *target_path, char **error_msg);
+
+/**
+ * Moves the resource inside of the mirror, replacing whatever exists at the target path.
+ */
+bool mirror_local_move(const char *source_path, const char *target_path, char **error_msg);
+
+bool mirror_local_mode(const char *target_path, const mode_t mode, char **error_msg);
+
+#endif //RESYNC_LOCAL_MIRROR_H
@@ -4,9 +4,36 @@ volatile sig_atomic_t terminate_process = 0;
 
 WorkspaceInformation *workspace_information = NULL;
 
+/* Resources that are neither watched nor synced */
+IgnoreRules *ignore_rules = NULL;
+
+/* Content of the files that were synced, to skip writes that did not change it */
+ContentCache *content_cache = NULL;
+
+/* Hashes of the workspace that it is compared with its remote systems by, NULL if drift checks are disabled */
+WorkspaceIndex *workspace_index = NULL;
+
+/* Shipped offsets of the files that are only ever appended to, NULL if the workspace declares no such files */
+AppendStreams *append_streams = NULL;
+
 WatchMetadata *absolute_path_to_metadata = NULL;
 WatchMetadata *watch_descriptor_to_metadata = NULL;
 
+/* Daemon's end of the control channel, or -1 if the daemon closed it */
+int daemon_control_fd = -1;
+
+MonitorControlMessage *deferred_control_messages = NULL;
+
+/* Point in time at which the sync state was last persisted */
+time_t sync_state_persisted_at = 0;
+
+PendingMove pending_move = {
+        .cookie = 0,
+        .path_relative_to_ws_root = NULL,
+        .directory_path_relative_to_ws_root = NULL,
+        .is_write_deferred = false
+};
+
 static WatchDescriptorList *
 create_watch_descriptor_list_entry(const int watch_descriptor)
 {
@@ -52,18 +79,28 @@ get_metadata_required(WatchMetadata *table, void *key, const ssize_t size, char
     return entry;
 }
 
-static int
-register_watches(const int inotify_fd, const char *absolute_workspace_root_path, const char *path_relative_to_ws_root)
+static void
+add_watch_descriptor_to_parent(const char *absolute_directory_path, const int watch_fd)
 {
-    char *absolute_directory_path = concat_paths(absolute_workspace_root_path, path_relative_to_ws_root);
-
-    const int watch_fd = inotify_add_watch(inotify_fd, absolute_directory_path, WATCH_EVENT_MASK | MISC_EVENT_MASK);
-    if (watch_fd == -1) {
-        fatal_error("inotify_add_watch");
+    char *absolute_path_to_parent = get_path_to_parent_directory(absolute_directory_path);
+    if (absolute_path_to_parent == NULL) {
+        return;
     }
 
-    LOG("Registering directory: '%s' with descriptor '%d'", absolute_directory_path, watch_fd);
+    WatchMetadata *parent_watch_metadata_abs_path = GET_METADATA_BY_STR_REQUIRED(absolute_path_to_parent);
+    WatchMetadata *parent_watch_metadata_descriptor = GET_METADATA_BY_INT_REQUIRED(&parent_watch_metadata_abs_path->watch_fd);
+
+    WatchDescriptorList *abs_path_entry = create_watch_descriptor_list_entry(watch_fd);
+    LL_APPEND(parent_watch_metadata_abs_path->watch_descriptors_of_direct_subdirs, abs_path_entry);
+    WatchDescriptorList *descriptor_entry = create_watch_descriptor_list_entry(watch_fd);
+    LL_APPEND(parent_watch_metadata_descriptor->watch_descriptors_of_direct_subdirs, descriptor_entry);
+
+    DO_FREE(absolute_path_to_parent);
+}
 
+static void
+add_watch_metadata(const int watch_fd, const char *absolute_directory_path, const char *path_relative_to_ws_root)
+{
     WatchMetadata *val_descriptor_to_metadata = create_watch_metadata(
             watch_fd,
             absolute_directory_path,
@@ -77,40 +114,75 @@ register_watches(const int inotify_fd, const char *absolute_workspace_root_path,
             path_relative_to_ws_root
     );
     HASH_ADD_STR(absolute_path_to_metadata, absolute_directory_path, val_path_to_metadata);
+}
+
+/*
+ * Registers the directory and all of its subdirectories with the inotify instance. If 'scan' is given, the directories
+ *  that changed since 'scan->changed_since' are collected along the way.
+ */
+static int
+register_watches(const int inotify_fd, const char *absolute_workspace_root_path, const char *path_relative_to_ws_root,
+                 ChangeScan *scan, SyncSubtree *subtree)
+{
+    char *absolute_directory_path = concat_paths(absolute_workspace_root_path, path_relative_to_ws_root);
+
+    const int watch_fd = inotify_add_watch(inotify_fd, absolute_directory_path, WATCH_EVENT_MASK | MISC_EVENT_MASK);
+    if (watch_fd == -1) {
+        fatal_error("inotify_add_watch");
+    }
+
+    LOG("Registering directory: '%s' with descriptor '%d'", absolute_directory_path, watch_fd);
+
+    add_watch_metadata(watch_fd, absolute_directory_path, path_relative_to_ws_root);
 
     // Register all subdirectories of the current directory with the inotify instance.
     const DirectoryPath *path = create_directory_path(absolute_workspace_root_path, path_relative_to_ws_root);
-    DirectoryPathList *subdir_list = get_paths_of_subdirectories(path);
+    time_t latest_change;
+    uint64_t entries_count;
+    DirectoryPathList *subdir_list = get_paths_of_subdirectories(
+            path,
+            ignore_rules,
+            (scan != NULL) ? &latest_change : NULL,
+            (subtree != NULL) ? &entries_count : NULL
+    );
+
+    // The directory's watch was added before its entries were looked at, so a change is either seen here or reported
+    //  by an event
+    ChangeScan *subdir_scan = scan;
+    if (scan != NULL && latest_change >= scan->changed_since) {
+        ChangedDirectoryList *changed_directory = (ChangedDirectoryList *) do_malloc(sizeof(ChangedDirectoryList));
+        changed_directory->path_relative_to_ws_root = resync_strdup(path_relative_to_ws_root);
+        LL_APPEND(scan->changed_directories, changed_directory);
+        subdir_scan = NULL;
+    }
+
+    // The size of the subtree is counted along, see 'sync_partitions.h'
+    if (subtree != NULL) {
+        subtree->entries_count = entries_count;
+    }
 
     DirectoryPathList *entry;
     LL_FOREACH(subdir_list, entry) {
+        SyncSubtree *subdir_subtree = (subtree != NULL) ? create_sync_subtree(entry->path->subdir_path_relative_to_ws_root) : NULL;
         register_watches(
                 inotify_fd,
                 entry->path->workspace_root_path,
-                entry->path->subdir_path_relative_to_ws_root
+                entry->path->subdir_path_relative_to_ws_root,
+                subdir_scan,
+                subdir_subtree
         );
+
+        if (subdir_subtree != NULL) {
+            subtree->entries_count += subdir_subtree->entries_count;
+            LL_PREPEND(subtree->subtrees, subdir_subtree);
+        }
     }
 
     // Add watch descriptor to parent's list of subdir watch descriptors.
     if (strlen(absolute_directory_path) > strlen(absolute_workspace_root_path)) {
-        char *absolute_path_to_parent = get_path_to_parent_directory(absolute_directory_path);
-        if (absolute_path_to_parent == NULL) {
-            goto skip_adding_descriptor_to_parent;
-        }
-
-        WatchMetadata *parent_watch_metadata_abs_path = GET_METADATA_BY_STR_REQUIRED(absolute_path_to_parent);
-        WatchMetadata *parent_watch_metadata_descriptor = GET_METADATA_BY_INT_REQUIRED(&parent_watch_metadata_abs_path->watch_fd);
-
-        WatchDescriptorList *abs_path_entry = create_watch_descriptor_list_entry(watch_fd);
-        LL_APPEND(parent_watch_metadata_abs_path->watch_descriptors_of_direct_subdirs, abs_path_entry);
-        WatchDescriptorList *descriptor_entry = create_watch_descriptor_list_entry(watch_fd);
-        LL_APPEND(parent_watch_metadata_descriptor->watch_descriptors_of_direct_subdirs, descriptor_entry);
-
-        DO_FREE(absolute_path_to_parent);
+        add_watch_descriptor_to_parent(absolute_directory_path, watch_fd);
     }
 
-skip_adding_descriptor_to_parent:
-
     DO_FREE(absolute_directory_path);
     DO_FREE(path);
 
@@ -124,6 +196,31 @@ skip_adding_descriptor_to_parent:
     return watch_fd;
 }
 
+/*
+ * Counts the entries of the directory and of all of its subdirectories into the subtree, like 'register_watches' does
+ *  for the initial sync, but without registering any watches.
+ */
+static void
+scan_sync_subtree(const char *absolute_workspace_root_path, const char *path_relative_to_ws_root, SyncSubtree *subtree)
+{
+    const DirectoryPath *path = create_directory_path(absolute_workspace_root_path, path_relative_to_ws_root);
+    DirectoryPathList *subdir_list = get_paths_of_subdirectories(path, ignore_rules, NULL, &subtree->entries_count);
+
+    DirectoryPathList *entry, *tmp;
+    LL_FOREACH_SAFE(subdir_list, entry, tmp) {
+        SyncSubtree *subdir_subtree = create_sync_subtree(entry->path->subdir_path_relative_to_ws_root);
+        scan_sync_subtree(entry->path->workspace_root_path, entry->path->subdir_path_relative_to_ws_root, subdir_subtree);
+        subtree->entries_count += subdir_subtree->entries_count;
+        LL_PREPEND(subtree->subtrees, subdir_subtree);
+
+        LL_DELETE(subdir_list, entry);
+        destroy_directory_path(&(entry->path));
+        DO_FREE(entry);
+    }
+
+    DO_FREE(path);
+}
+
 static void
 remove_watches(const int inotify_fd, const int watch_descriptor)
 {
@@ -198,20 +295,247 @@ skip_removal_from_parent:
     destroy_watch_metadata(&watch_metadata);
 }
 
+static void
+clear_pending_move(void)
+{
+    DO_FREE(pending_move.path_relative_to_ws_root);
+    DO_FREE(pending_move.directory_path_relative_to_ws_root);
+    pending_move.is_write_deferred = false;
+}
+
+/*
+ * Syncs the change, unless a bulk operation is in progress, during which only the directories of the change are
+ *  recorded to be synced once it is over.
+ */
+static void
+propagate_change(const WorkspaceChange *change)
+{
+    if (!is_bulk_mode_active()) {
+        synchronize_change(workspace_information, change);
+        return;
+    }
+
+    mark_dirty_subtree(change->relative_directory_path);
+    if (change->type == RESOURCE_MOVED) {
+        mark_dirty_subtree(change->relative_source_directory_path);
+    }
+}
+
+/*
+ * Transfers the data that was appended to the streamed file since it was last synced, see 'append_stream.h'.
+ */
+static void
+synchronize_streamed_file(const char *relative_path, const char *relative_directory_path)
+{
+    char *absolute_path = concat_paths(workspace_information->local_workspace_root_path, relative_path);
+
+    AppendStreamFingerprint fingerprint;
+    const uint64_t shipped_offset = get_shipped_offset(append_streams, relative_path, absolute_path, &fingerprint);
+    DO_FREE(absolute_path);
+
+    // The file was closed without being appended to
+    if (shipped_offset > 0 && shipped_offset == fingerprint.size) {
+        return;
+    }
+
+    const WorkspaceChange change = {
+            .type = FILE_WRITTEN,
+            .relative_path = relative_path,
+            .relative_directory_path = relative_directory_path,
+            .append_offset = shipped_offset
+    };
+    propagate_change(&change);
+
+    record_shipped_offset(append_streams, relative_path, &fingerprint);
+}
+
+/*
+ * Syncs the written file, unless its content did not change since it was last synced.
+ */
+static void
+synchronize_written_file(const char *relative_path, const char *relative_directory_path)
+{
+    // Streamed files are not hashed, as the cost of their syncs must not depend on their size
+    if (is_append_stream(append_streams, relative_path)) {
+        synchronize_streamed_file(relative_path, relative_directory_path);
+        return;
+    }
+
+    char *absolute_path = concat_paths(workspace_information->local_workspace_root_path, relative_path);
+
+    // Writes are not hashed during bulk operations, which drops the written files from the content cache
+    ContentFingerprint fingerprint = {.size = 0, .is_hashed = false};
+    if (!is_bulk_mode_active() && is_content_unchanged(content_cache, relative_path, absolute_path, &fingerprint)) {
+        DO_FREE(absolute_path);
+        return;
+    }
+
+    const WorkspaceChange change = {
+            .type = FILE_WRITTEN,
+            .relative_path = relative_path,
+            .relative_directory_path = relative_directory_path,
+            .is_appended = workspace_information->is_append_transfer_enabled
+                    && is_file_appended(relative_path, fingerprint.size)
+    };
+    propagate_change(&change);
+
+    record_synced_content(content_cache, relative_path, absolute_path, &fingerprint);
+    record_synced_file_size(relative_path, fingerprint.size);
+    DO_FREE(absolute_path);
+}
+
+/*
+ * Syncs the directory including its content, unless a bulk operation is in progress, see 'propagate_change'.
+ */
+static void
+propagate_subtree(const char *relative_directory_path)
+{
+    if (is_bulk_mode_active()) {
+        mark_dirty_subtree(relative_directory_path);
+        return;
+    }
+
+    flush_synchronized_changes(workspace_information);
+    synchronize_workspace(workspace_information, relative_directory_path);
+}
+
+static void
+flush_pending_move(void)
+{
+    if (pending_move.path_relative_to_ws_root == NULL) {
+        return;
+    }
+
+    const WorkspaceChange change = {
+            .type = RESOURCE_DELETED,
+            .relative_path = pending_move.path_relative_to_ws_root,
+            .relative_directory_path = pending_move.directory_path_relative_to_ws_root
+    };
+    propagate_change(&change);
+
+    clear_pending_move();
+}
+
+static void
+add_config_ignore_patterns(IgnoreRules *rules)
+{
+    char *error_msg = NULL;
+
+    IgnorePatternList *pattern;
+    LL_FOREACH(workspace_information->ignore_patterns, pattern) {
+        // The patterns were already validated along with the configuration
+        if (!add_ignore_pattern(rules, pattern->pattern, &error_msg)) {
+            fatal_custom_error("%s", error_msg);
+        }
+    }
+}
+
+/*
+ * Compiles the ignore patterns of the workspace configuration and of the ignore file at the workspace root.
+ *
+ * @return NULL if the ignore file is malformed, which is reported
+ */
+static IgnoreRules *
+compile_ignore_rules(const bool is_ignore_file_included)
+{
+    char *error_msg = NULL;
+    char *ignore_file_path = concat_paths(workspace_information->local_workspace_root_path, IGNORE_FILE_NAME);
+
+    IgnoreRules *rules = create_ignore_rules();
+    add_config_ignore_patterns(rules);
+
+    if (is_ignore_file_included && !add_ignore_file(rules, ignore_file_path, &error_msg)) {
+        LOG_ERROR("Invalid ignore file of workspace '%s': %s", workspace_information->local_workspace_root_path, error_msg);
+        DO_FREE(error_msg);
+        destroy_ignore_rules(&rules);
+    }
+
+    DO_FREE(ignore_file_path);
+    return rules;
+}
+
+/*
+ * Applies the changed ignore file. All watches are registered anew, so that directories that are no longer ignored are
+ *  watched and newly ignored ones no longer are, and the workspace is synced entirely to transfer what is no longer
+ *  ignored. Events that are still queued for the previous watches are dropped, as the sync covers them.
+ */
+static void
+reload_ignore_rules(const int inotify_fd)
+{
+    // A typo must not suddenly sync everything the ignore file excluded, so the previous rules are kept until it is fixed
+    IgnoreRules *rules = compile_ignore_rules(true);
+    if (rules == NULL) {
+        return;
+    }
+
+    destroy_ignore_rules(&ignore_rules);
+    ignore_rules = rules;
+    set_sync_ignore_rules(ignore_rules);
+    if (workspace_index != NULL) {
+        reset_workspace_index(workspace_index, ignore_rules);
+    }
+
+    // Files that were ignored may have changed without invalidating their cached content
+    clear_content_cache(content_cache);
+
+    LOG("Reloading the ignore rules of workspace '%s'", workspace_information->local_workspace_root_path);
+
+    // Changes that agents did not apply yet must not race with the sync of the workspace
+    flush_synchronized_changes(workspace_information);
+
+    const WatchMetadata *root_metadata = GET_METADATA_BY_STR_REQUIRED(workspace_information->local_workspace_root_path);
+    remove_watches(inotify_fd, root_metadata->watch_fd);
+    register_watches(inotify_fd, workspace_information->local_workspace_root_path, NULL, NULL, NULL);
+    watch_bulk_operation_lock(inotify_fd, workspace_information->local_workspace_root_path);
+
+    synchronize_workspace(workspace_information, NULL);
+}
+
 static void
 handle_inotify_event(const int inotify_fd, const struct inotify_event *event)
 {
-    if (event->mask & IN_IGNORED) {
+    // Mode changes of watched directories are also reported to their parent directory, which is why the event
+    //  reported to the directory itself is not needed
+    if ((event->mask & IN_IGNORED) || ((event->mask & IN_ATTRIB) && event->len == 0)) {
         return;
     }
 
+    // The lock file may be in an ignored directory, whose events are discarded
+    handle_bulk_operation_lock_event(event);
+
+    // Irrelevant events and those of ignored resources are discarded before anything is allocated or any system call is
+    //  made, as they may make up most of the events, e.g. of editors saving files or of build output. The directory of
+    //  a resource is watched, so it is not ignored itself.
+    const EventFilterReason filter_reason = filter_event(event->mask, (event->len > 0) ? event->name : NULL);
     WatchMetadata *watch_metadata = GET_METADATA_BY_INT_OPTIONAL(&event->wd);
+    const bool is_discarded = filter_reason != EVENT_FILTER_PASSED || (watch_metadata != NULL && event->len > 0
+            && is_ignored(ignore_rules, watch_metadata->path_relative_to_ws_root, event->name, event->mask & IN_ISDIR));
+
+    // A resource that is moved to a discarded name, e.g. to an editor backup, is gone for the remote systems
+    if (pending_move.path_relative_to_ws_root != NULL
+        && !((event->mask & IN_MOVED_TO) && event->cookie == pending_move.cookie && !is_discarded)) {
+        flush_pending_move();
+    }
+
     if (watch_metadata == NULL) {
         // If we don't store metadata for this watch descriptor (anymore), chances are that this is an old event that is
         //  still enqueued, but we stopped listening for events for this watch.
         return;
+    } else if (is_discarded) {
+        return;
+    }
+
+    invalidate_workspace_index(workspace_index, watch_metadata->path_relative_to_ws_root);
+
+    // Reported for every single write, which is why it is handled before anything is allocated
+    if (event->mask & IN_MODIFY) {
+        note_file_modification(watch_metadata->path_relative_to_ws_root, event->name);
+        return;
     }
 
+    const bool is_ignore_file = watch_metadata->path_relative_to_ws_root == NULL && event->len > 0
+            && strcmp(event->name, IGNORE_FILE_NAME) == 0;
+
     char *absolute_directory_path = concat_paths(workspace_information->local_workspace_root_path, watch_metadata->path_relative_to_ws_root);
     char *resource_absolute_path = concat_paths(absolute_directory_path, event->name);
     char *resource_relative_path = concat_paths(watch_metadata->path_relative_to_ws_root, event->name);
@@ -228,19 +552,35 @@ handle_inotify_event(const int inotify_fd, const struct inotify_event *event)
         return;
     }
 
-    if ((event->mask & IN_CREATE) || (event->mask & IN_MOVED_TO)) {
+    // Whatever is at the path now was not written through it, so its content is not known to be synced
+    uint32_t deferred_writes_count = 0;
+    if ((event->mask & IN_DELETE) || (event->mask & IN_MOVE)) {
+        invalidate_cached_content(content_cache, resource_relative_path, event->mask & IN_ISDIR);
+        if (append_streams != NULL) {
+            forget_shipped_offsets(append_streams, resource_relative_path, event->mask & IN_ISDIR);
+        }
+        deferred_writes_count = forget_file_writes(resource_relative_path, event->mask & IN_ISDIR);
+    }
 
-        struct stat dirstat;
-        if (stat(resource_absolute_path, &dirstat) < 0) {
+    struct stat resource_stat;
+    if ((event->mask & IN_CREATE) || (event->mask & IN_MOVED_TO) || (event->mask & IN_ATTRIB)
+        || (event->mask & IN_CLOSE_WRITE)) {
+
+        if (stat(resource_absolute_path, &resource_stat) < 0) {
             // This can happen for e.g. swap files, e.g. when using 'vim'.
             goto out;
         }
+    }
 
-        if (S_ISDIR(dirstat.st_mode)) {
+    if ((event->mask & IN_CREATE) || (event->mask & IN_MOVED_TO)) {
+
+        if (S_ISDIR(resource_stat.st_mode)) {
             register_watches(
                     inotify_fd,
                     workspace_information->local_workspace_root_path,
-                    resource_relative_path
+                    resource_relative_path,
+                    NULL,
+                    NULL
             );
         } else {
             if (event->mask & IN_CREATE) {
@@ -260,59 +600,792 @@ handle_inotify_event(const int inotify_fd, const struct inotify_event *event)
         remove_watches(inotify_fd, moved_or_deleted_dir_metadata->watch_fd);
     }
 
-    synchronize_workspace(workspace_information, watch_metadata->path_relative_to_ws_root);
+    WorkspaceChange change = {
+            .type = OTHER_WORKSPACE_CHANGE_TYPE,
+            .relative_path = resource_relative_path,
+            .relative_directory_path = watch_metadata->path_relative_to_ws_root
+    };
+
+    if (event->mask & IN_MOVED_FROM) {
+        // Whether the resource was moved within the workspace or out of it is only known once the next event is read
+        pending_move.cookie = event->cookie;
+        pending_move.path_relative_to_ws_root = resync_strdup(resource_relative_path);
+        pending_move.directory_path_relative_to_ws_root = resync_strdup(watch_metadata->path_relative_to_ws_root);
+        pending_move.is_write_deferred = deferred_writes_count > 0;
+        goto out;
+    } else if ((event->mask & IN_MOVED_TO) && pending_move.path_relative_to_ws_root != NULL) {
+        change.type = RESOURCE_MOVED;
+        change.relative_source_path = pending_move.path_relative_to_ws_root;
+        change.relative_source_directory_path = pending_move.directory_path_relative_to_ws_root;
+        change.mode = resource_stat.st_mode & 07777;
+    } else if ((event->mask & IN_CREATE) || (event->mask & IN_MOVED_TO)) {
+        change.type = S_ISDIR(resource_stat.st_mode) ? DIRECTORY_CREATED : FILE_WRITTEN;
+        change.mode = resource_stat.st_mode & 07777;
+    } else if (event->mask & IN_CLOSE_WRITE) {
+        // Files that are still being written are synced once they settle
+        if (is_bulk_mode_active()
+            || !defer_written_file(resource_relative_path, watch_metadata->path_relative_to_ws_root, resource_stat.st_size)) {
+            synchronize_written_file(resource_relative_path, watch_metadata->path_relative_to_ws_root);
+        }
+        goto out;
+    } else if (event->mask & IN_DELETE) {
+        change.type = RESOURCE_DELETED;
+    } else if (event->mask & IN_ATTRIB) {
+        change.type = MODE_CHANGED;
+        change.mode = resource_stat.st_mode & 07777;
+    } else {
+        goto out;
+    }
+
+    propagate_change(&change);
+
+    if (change.type == RESOURCE_MOVED) {
+        // The moved resource is renamed on the remote systems, which did not receive the writes that were deferred
+        if (pending_move.is_write_deferred && S_ISDIR(resource_stat.st_mode)) {
+            propagate_subtree(resource_relative_path);
+        } else if (pending_move.is_write_deferred) {
+            synchronize_written_file(resource_relative_path, watch_metadata->path_relative_to_ws_root);
+        }
+        clear_pending_move();
+    }
 
 out:
+    if (is_ignore_file && (event->mask & IGNORE_FILE_EVENT_MASK)) {
+        reload_ignore_rules(inotify_fd);
+    }
+
     DO_FREE(resource_absolute_path);
     DO_FREE(resource_relative_path);
     DO_FREE(absolute_directory_path);
 }
 
+static ByteBuffer *
+serialize_watch_tables(void)
+{
+    ByteBuffer *buffer = create_byte_buffer(HASH_COUNT(watch_descriptor_to_metadata) * 64);
+    byte_buffer_append_u32(buffer, WATCH_STATE_SNAPSHOT_VERSION);
+    byte_buffer_append_u32(buffer, HASH_COUNT(watch_descriptor_to_metadata));
+
+    WatchMetadata *entry, *tmp;
+    HASH_ITER(hh, watch_descriptor_to_metadata, entry, tmp) {
+        byte_buffer_append_i32(buffer, entry->watch_fd);
+        byte_buffer_append_string(buffer, entry->path_relative_to_ws_root);
+    }
+
+    return buffer;
+}
+
 static void
-listen_for_inotify_events(const int inotify_fd)
+restore_watch_tables(const char *snapshot, const size_t snapshot_size)
+{
+    ByteBufferReader reader = create_byte_buffer_reader(snapshot, snapshot_size);
+
+    const uint32_t version = byte_buffer_read_u32(&reader);
+    if (version != WATCH_STATE_SNAPSHOT_VERSION) {
+        fatal_custom_error("Unsupported watch state snapshot version '%u'", version);
+    }
+
+    const uint32_t watch_count = byte_buffer_read_u32(&reader);
+    for (uint32_t i = 0; i < watch_count && !reader.error; i++) {
+        const int watch_fd = byte_buffer_read_i32(&reader);
+        char *path_relative_to_ws_root = byte_buffer_read_string(&reader);
+        if (reader.error) {
+            break;
+        }
+
+        char *absolute_directory_path = concat_paths(workspace_information->local_workspace_root_path, path_relative_to_ws_root);
+        add_watch_metadata(watch_fd, absolute_directory_path, path_relative_to_ws_root);
+
+        DO_FREE(absolute_directory_path);
+        DO_FREE(path_relative_to_ws_root);
+    }
+
+    if (reader.error) {
+        fatal_custom_error("Watch state snapshot for workspace '%s' is truncated", workspace_information->local_workspace_root_path);
+    }
+
+    // All directories are known now, so the parent -> subdirectories relations can be restored without any fs access.
+    WatchMetadata *entry, *tmp;
+    HASH_ITER(hh, watch_descriptor_to_metadata, entry, tmp) {
+        if (entry->path_relative_to_ws_root != NULL) {
+            add_watch_descriptor_to_parent(entry->absolute_directory_path, entry->watch_fd);
+        }
+    }
+
+    LOG("Restored %u watches of workspace '%s' from a handoff", watch_count, workspace_information->local_workspace_root_path);
+}
+
+static void
+read_watch_state_snapshot(const int snapshot_fd)
+{
+    struct stat statbuf;
+    if (fstat(snapshot_fd, &statbuf) == -1) {
+        fatal_error("fstat");
+    }
+
+    char *snapshot = (char *) do_malloc(statbuf.st_size);
+    if (lseek(snapshot_fd, 0, SEEK_SET) == -1 || read_all(snapshot_fd, snapshot, statbuf.st_size) != 1) {
+        fatal_custom_error("Unable to read the watch state snapshot: %s", strerror(errno));
+    }
+
+    restore_watch_tables(snapshot, statbuf.st_size);
+
+    DO_FREE(snapshot);
+    close(snapshot_fd);
+}
+
+static void
+persist_content_cache(void)
+{
+    // The cache is only loaded after the initial sync
+    if (content_cache == NULL) {
+        return;
+    }
+
+    char *error_msg = NULL;
+    if (!store_content_cache(content_cache, workspace_information, &error_msg)) {
+        LOG_ERROR("Unable to persist the content cache: %s", error_msg);
+        DO_FREE(error_msg);
+    }
+}
+
+static void
+handle_handoff_request(const int inotify_fd, const int control_fd)
+{
+    // The changes of a bulk operation that is in progress would be lost, as only the watch tables are handed over
+    if (is_bulk_mode_active()) {
+        leave_bulk_mode(workspace_information);
+    }
+
+    // Neither are the writes whose sync is deferred until their file settles
+    synchronize_settled_files(synchronize_written_file, true);
+
+    // The successor process loads the content cache, as it cannot be handed over along with the watch tables
+    persist_content_cache();
+
+    // Events that are not read yet stay queued in the inotify instance and are processed by the successor process
+    char *error_msg = NULL;
+    ByteBuffer *snapshot = serialize_watch_tables();
+
+    bool res = send_monitor_control_message(control_fd, MONITOR_HANDOFF_STATE, snapshot->data, snapshot->size, &error_msg);
+    destroy_byte_buffer(&snapshot);
+
+    if (res == false) {
+        LOG_ERROR("Unable to hand over the watch state: %s", error_msg);
+        DO_FREE(error_msg);
+        return;
+    }
+
+    // The daemon restarts the monitor from scratch if the handoff fails. Once the watch state went out, the monitor
+    //  cannot tell whether the daemon still waits for the inotify instance, so it must not keep running either.
+    if (!send_file_descriptor(control_fd, inotify_fd)) {
+        LOG_ERROR("Unable to hand over the inotify instance: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    LOG("Handed over the watch state of workspace '%s'", workspace_information->local_workspace_root_path);
+    exit(EXIT_SUCCESS);
+}
+
+static void
+handle_add_remote_system_message(const MonitorControlMessage *message)
+{
+    char *error_msg = NULL;
+
+    RemoteWorkspaceMetadata *remote_system_view = binary_to_remoteWorkspaceMetadata(
+            message->payload,
+            message->payload_size,
+            &error_msg
+    );
+
+    if (remote_system_view == NULL) {
+        LOG_ERROR("Unable to add remote system to workspace '%s': %s", workspace_information->local_workspace_root_path, error_msg);
+        DO_FREE(error_msg);
+        return;
+    }
+
+    // The view points into the message, which is destroyed once it is handled, but the remote system is kept
+    RemoteWorkspaceMetadata *remote_system = copy_remoteWorkspaceMetadata(remote_system_view);
+    destroy_remoteWorkspaceMetadata(&remote_system_view);
+
+    LL_APPEND(workspace_information->remote_systems, remote_system);
+
+    // Only the newly added remote system has to catch up with the current state of the workspace, all other remote
+    //  systems are already in sync. It is synced like in the initial sync, i.e. bootstrapped if its workspace is empty
+    //  and synced in partitions if the workspace is large. The sizes of the subtrees that were counted when the
+    //  watches were registered are outdated by now, so the workspace is scanned again.
+    SyncPartitionList *partitions = NULL;
+    const uint32_t streams_count = get_sync_streams_count();
+    if (remote_system->relay_parent == NULL) {
+        SyncSubtree *root_subtree = create_sync_subtree(NULL);
+        scan_sync_subtree(workspace_information->local_workspace_root_path, NULL, root_subtree);
+        partitions = create_sync_partitions(root_subtree, streams_count);
+        destroy_sync_subtree(&root_subtree);
+    }
+
+    synchronize_entire_workspace(workspace_information, remote_system, partitions, streams_count);
+    destroy_sync_partitions(&partitions);
+}
+
+static void
+handle_remove_remote_system_message(const MonitorControlMessage *message)
+{
+    char *error_msg = NULL;
+
+    RemoveRemoteSystemMetadata *rm_rsys = binary_to_removeRemoteSystemMetadata(
+            message->payload,
+            message->payload_size,
+            &error_msg
+    );
+
+    if (rm_rsys == NULL) {
+        LOG_ERROR("Unable to remove remote system from workspace '%s': %s", workspace_information->local_workspace_root_path, error_msg);
+        DO_FREE(error_msg);
+        return;
+    }
+
+    RemoteWorkspaceMetadata *entry, *tmp;
+    LL_FOREACH_SAFE(workspace_information->remote_systems, entry, tmp) {
+        if (is_remote_system_identified_by(entry, rm_rsys)) {
+            LL_DELETE(workspace_information->remote_systems, entry);
+            release_remote_system_transport(entry);
+            destroy_remoteWorkspaceMetadata(&entry);
+            break;
+        }
+    }
+
+    destroy_removeRemoteSystemMetadata(&rm_rsys);
+}
+
+static void
+dispatch_control_message(const int inotify_fd, const int control_fd, MonitorControlMessage *message)
+{
+    bool is_handoff_requested = false;
+
+    switch (message->type) {
+        case MONITOR_ADD_REMOTE_SYSTEM:
+            handle_add_remote_system_message(message);
+            break;
+        case MONITOR_REMOVE_REMOTE_SYSTEM:
+            handle_remove_remote_system_message(message);
+            break;
+        case MONITOR_HANDOFF_REQUEST:
+            is_handoff_requested = true;
+            break;
+        case OTHER_MONITOR_CONTROL_MESSAGE_TYPE:
+        default:
+            LOG_ERROR("Received unsupported control message of type '%d'", message->type);
+            break;
+    }
+
+    destroy_monitor_control_message(&message);
+
+    // A successful handoff terminates the monitor
+    if (is_handoff_requested) {
+        handle_handoff_request(inotify_fd, control_fd);
+    }
+}
+
+/*
+ * Returns false if the control channel was closed by the daemon, true otherwise.
+ */
+static bool
+handle_control_message(const int inotify_fd, const int control_fd)
+{
+    char *error_msg = NULL;
+
+    MonitorControlMessage *message = receive_monitor_control_message(control_fd, &error_msg);
+    if (message == NULL) {
+        if (error_msg != NULL) {
+            LOG_ERROR("%s", error_msg);
+            DO_FREE(error_msg);
+        }
+        return false;
+    }
+
+    dispatch_control_message(inotify_fd, control_fd, message);
+    return true;
+}
+
+/*
+ * Blocks until the daemon admits the initial sync of the workspace. Control messages that arrive in the meantime are
+ *  deferred until the monitor listens for events.
+ *
+ * @return false if the control channel was closed, i.e. there is no daemon to admit the initial sync
+ */
+static bool
+wait_for_initial_sync_admission(const int control_fd)
+{
+    char *error_msg = NULL;
+
+    while (true) {
+        MonitorControlMessage *message = receive_monitor_control_message(control_fd, &error_msg);
+        if (message == NULL) {
+            LOG_ERROR("No admission for the initial sync received: %s", error_msg == NULL ? "Control channel closed" : error_msg);
+            DO_FREE(error_msg);
+            daemon_control_fd = -1;
+            return false;
+        }
+
+        if (message->type == MONITOR_INITIAL_SYNC_GRANT) {
+            destroy_monitor_control_message(&message);
+            return true;
+        }
+
+        LL_APPEND(deferred_control_messages, message);
+    }
+}
+
+/*
+ * Blocks until the daemon grants a lease to sync with the host. Control messages that arrive in the meantime are
+ *  deferred until the current event is handled. Without a daemon, syncs are not limited.
+ */
+static void
+acquire_sync_lease(const char *host)
+{
+    if (daemon_control_fd == -1) {
+        return;
+    }
+
+    char *error_msg = NULL;
+    if (!send_monitor_control_message(daemon_control_fd, MONITOR_SYNC_LEASE_REQUEST, host, strlen(host), &error_msg)) {
+        LOG_ERROR("Unable to request a sync lease for host '%s': %s", host, error_msg);
+        DO_FREE(error_msg);
+        return;
+    }
+
+    while (true) {
+        MonitorControlMessage *message = receive_monitor_control_message(daemon_control_fd, &error_msg);
+        if (message == NULL) {
+            LOG_ERROR("No sync lease for host '%s' received: %s", host, error_msg == NULL ? "Control channel closed" : error_msg);
+            DO_FREE(error_msg);
+            daemon_control_fd = -1;
+            return;
+        }
+
+        if (message->type == MONITOR_SYNC_LEASE_GRANT) {
+            destroy_monitor_control_message(&message);
+            return;
+        }
+
+        LL_APPEND(deferred_control_messages, message);
+    }
+}
+
+static void
+release_sync_lease(const char *host)
+{
+    if (daemon_control_fd == -1) {
+        return;
+    }
+
+    char *error_msg = NULL;
+    if (!send_monitor_control_message(daemon_control_fd, MONITOR_SYNC_LEASE_RELEASE, host, strlen(host), &error_msg)) {
+        LOG_ERROR("Unable to release the sync lease for host '%s': %s", host, error_msg);
+        DO_FREE(error_msg);
+    }
+}
+
+static void
+handle_deferred_control_messages(const int inotify_fd, const int control_fd)
+{
+    // Handling a message may defer further messages, e.g. while waiting for a sync lease
+    while (deferred_control_messages != NULL) {
+        MonitorControlMessage *message = deferred_control_messages;
+        LL_DELETE(deferred_control_messages, message);
+        dispatch_control_message(inotify_fd, control_fd, message);
+    }
+}
+
+static void
+persist_sync_state(const time_t synced_until)
+{
+    persist_content_cache();
+
+    char *error_msg = NULL;
+    if (!store_sync_state(workspace_information, synced_until, &error_msg)) {
+        LOG_ERROR("Unable to persist the sync state: %s", error_msg);
+        DO_FREE(error_msg);
+        return;
+    }
+
+    sync_state_persisted_at = time(NULL);
+}
+
+/*
+ * @return the point in time up to which all changes were synced, which lies before the oldest write whose sync is
+ *  deferred until its file settles
+ */
+static time_t
+get_synced_until(const time_t poll_start)
+{
+    const time_t oldest_deferred_write_time = get_oldest_deferred_write_time();
+    return (oldest_deferred_write_time != 0 && oldest_deferred_write_time < poll_start)
+           ? oldest_deferred_write_time
+           : poll_start;
+}
+
+/*
+ * A relay has to be fully synced if any remote system behind it was not, as they are synced along with it.
+ */
+static bool
+is_relay_tree_synced(const SyncState *sync_state, const RemoteWorkspaceMetadata *relay)
+{
+    RemoteWorkspaceMetadata *remote_system;
+    LL_FOREACH(workspace_information->remote_systems, remote_system) {
+        if ((remote_system == relay || get_relay_parent(workspace_information, remote_system) == relay)
+            && !is_remote_system_synced(sync_state, remote_system)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Registers all directories of the workspace and syncs what changed while the workspace was not monitored. If a sync
+ *  state was persisted by a previous monitor, only directories that changed since then are synced with the remote
+ *  systems it had fully synced. Otherwise, the entire workspace is synced.
+ */
+static void
+perform_initial_sync(const int inotify_fd, const int control_fd)
+{
+    char *error_msg = NULL;
+    const time_t scan_start = time(NULL);
+
+    SyncState *sync_state = load_sync_state(workspace_information, &error_msg);
+    if (error_msg != NULL) {
+        LOG_ERROR("Ignoring the persisted sync state: %s", error_msg);
+        DO_FREE(error_msg);
+    }
+
+    ChangeScan scan = {.changed_directories = NULL};
+    if (sync_state != NULL) {
+        scan.changed_since = sync_state->synced_until - SYNC_STATE_CLOCK_SLACK_SEC;
+    }
+
+    // Register all directories contained in this workspace with the previously created inotify instance before the
+    //  initial sync, so that no change is lost while waiting for the admission of the initial sync.
+    SyncSubtree *root_subtree = create_sync_subtree(NULL);
+    register_watches(
+            inotify_fd,
+            workspace_information->local_workspace_root_path,
+            NULL,
+            (sync_state != NULL) ? &scan : NULL,
+            root_subtree
+    );
+
+    // Only computed once a remote system has to be synced entirely
+    SyncPartitionList *partitions = NULL;
+    bool is_partitioned = false;
+    const uint32_t streams_count = get_sync_streams_count();
+
+    // The daemon staggers the initial syncs of all workspaces to not overload the remote systems.
+    const bool is_admitted = wait_for_initial_sync_admission(control_fd);
+
+    RemoteWorkspaceMetadata *remote_system;
+    LL_FOREACH(workspace_information->remote_systems, remote_system) {
+        // Remote systems behind a relay are synced along with it
+        if (remote_system->relay_parent != NULL) {
+            continue;
+        }
+
+        if (sync_state == NULL || !is_relay_tree_synced(sync_state, remote_system)) {
+            if (!is_partitioned) {
+                partitions = create_sync_partitions(root_subtree, streams_count);
+                is_partitioned = true;
+            }
+            synchronize_entire_workspace(workspace_information, remote_system, partitions, streams_count);
+            continue;
+        }
+
+        ChangedDirectoryList *changed_directory;
+        LL_FOREACH(scan.changed_directories, changed_directory) {
+            synchronize_with_remote_system(workspace_information, remote_system, changed_directory->path_relative_to_ws_root);
+        }
+    }
+
+    persist_sync_state(scan_start);
+
+    ChangedDirectoryList *changed_directory, *tmp;
+    LL_FOREACH_SAFE(scan.changed_directories, changed_directory, tmp) {
+        LL_DELETE(scan.changed_directories, changed_directory);
+        DO_FREE(changed_directory->path_relative_to_ws_root);
+        DO_FREE(changed_directory);
+    }
+    destroy_sync_state(&sync_state);
+    destroy_sync_partitions(&partitions);
+    destroy_sync_subtree(&root_subtree);
+
+    if (is_admitted && !send_monitor_control_message(control_fd, MONITOR_INITIAL_SYNC_DONE, NULL, 0, &error_msg)) {
+        LOG_ERROR("Unable to report the finished initial sync: %s", error_msg);
+        DO_FREE(error_msg);
+    }
+}
+
+/*
+ * @return true if the event queue was drained, i.e. all events that were queued before the call were handled
+ */
+static bool
+read_inotify_events(const int inotify_fd)
 {
     char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
     const struct inotify_event *event;
     ssize_t len;
 
+    len = read(inotify_fd, buf, sizeof(buf));
+    if (len == -1 && errno != EAGAIN && errno != EINTR) {
+        fatal_error("read");
+    }
+
+    // A single file that is written to reports 'IN_MODIFY' for every write, which does not make it a bulk operation
+    uint32_t events_count = 0;
+    uint32_t counted_events_count = 0;
+    for (char *ptr = buf; ptr < buf + len; ptr += sizeof(struct inotify_event) + event->len) {
+        event = (const struct inotify_event *) ptr;
+        events_count++;
+        counted_events_count += !(event->mask & IN_MODIFY);
+    }
+
+    // Events keep arriving while the monitor syncs, the ones that are still queued are estimated from their size
+    int queued_size = 0;
+    if (counted_events_count > 0 && ioctl(inotify_fd, FIONREAD, &queued_size) == -1) {
+        queued_size = 0;
+    }
+    count_events_for_bulk_mode(
+            counted_events_count,
+            (counted_events_count > 0) ? (uint32_t) ((uint64_t) queued_size * counted_events_count / (uint64_t) len) : 0
+    );
+
+    for (char *ptr = buf; ptr < buf + len; ptr += sizeof(struct inotify_event) + event->len) {
+        event = (const struct inotify_event *) ptr;
+
+        handle_inotify_event(inotify_fd, event);
+    }
+
+    // Moves are not paired across reads, a move whose events are split is propagated as deletion and creation
+    flush_pending_move();
+    flush_synchronized_changes(workspace_information);
+
+    return len < (ssize_t) sizeof(buf);
+}
+
+static void
+listen_for_events(const int inotify_fd, const int control_fd)
+{
+    struct pollfd poll_fds[POLL_FDS_COUNT];
+    poll_fds[POLL_INDEX_INOTIFY].fd = inotify_fd;
+    poll_fds[POLL_INDEX_INOTIFY].events = POLLIN;
+    poll_fds[POLL_INDEX_CONTROL].fd = control_fd;
+    poll_fds[POLL_INDEX_CONTROL].events = POLLIN;
+
+    bool is_sync_state_outdated = false;
+    time_t drift_check_at = time(NULL) + workspace_information->drift_check_interval;
+
     while (!terminate_process) {
-        len = read(inotify_fd, buf, sizeof(buf));
-        if (len == -1 && errno != EAGAIN) {
-            fatal_error("read");
+        // Handle the control messages that arrived while the monitor was not listening, e.g. while it was syncing
+        handle_deferred_control_messages(inotify_fd, control_fd);
+
+        if (is_bulk_operation_over()) {
+            leave_bulk_mode(workspace_information);
         }
 
-        if (len <= 0)
-            break;
+        if (synchronize_settled_files(synchronize_written_file, false) > 0) {
+            is_sync_state_outdated = true;
+        }
 
-        for (char *ptr = buf; ptr < buf + len; ptr += sizeof(struct inotify_event) + event->len) {
-            event = (const struct inotify_event *) ptr;
+        // Files that are still being written would be reported as drift
+        if (workspace_index != NULL && time(NULL) >= drift_check_at && !is_bulk_mode_active()
+            && get_write_settle_timeout_ms() == -1) {
+            check_remote_systems_for_drift(workspace_information, workspace_index);
+            drift_check_at = time(NULL) + workspace_information->drift_check_interval;
+        }
+
+        // All changes that happened before polling are handled by the time the event queue is drained, unless they
+        //  are deferred by a bulk operation or until their file settles. Once the monitor is idle for a while, the sync
+        //  state is brought up to date.
+        const time_t poll_start = time(NULL);
+        int poll_timeout_ms = is_sync_state_outdated ? SYNC_STATE_PERSIST_INTERVAL_SEC * 1000 : -1;
+        bool is_persist_timeout = is_sync_state_outdated;
+        if (is_bulk_mode_active()) {
+            poll_timeout_ms = get_bulk_mode_timeout_ms();
+            is_persist_timeout = false;
+        } else {
+            const int write_settle_timeout_ms = get_write_settle_timeout_ms();
+            if (write_settle_timeout_ms != -1 && (poll_timeout_ms == -1 || write_settle_timeout_ms < poll_timeout_ms)) {
+                poll_timeout_ms = write_settle_timeout_ms;
+                is_persist_timeout = false;
+            }
+
+            const time_t drift_check_delay_sec = (drift_check_at > poll_start) ? drift_check_at - poll_start : 0;
+            const int drift_check_timeout_ms = (drift_check_delay_sec < INT_MAX / 1000)
+                    ? (int) drift_check_delay_sec * 1000 : INT_MAX;
+            if (workspace_index != NULL && write_settle_timeout_ms == -1
+                && (poll_timeout_ms == -1 || drift_check_timeout_ms < poll_timeout_ms)) {
+                poll_timeout_ms = drift_check_timeout_ms;
+                is_persist_timeout = false;
+            }
+        }
+
+        const int poll_result = poll(poll_fds, POLL_FDS_COUNT, poll_timeout_ms);
+        if (poll_result == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fatal_error("poll");
+        }
+
+        if (poll_result == 0) {
+            if (!is_persist_timeout) {
+                continue;
+            }
+
+            report_filtered_events();
+            persist_sync_state(get_synced_until(poll_start));
+            is_sync_state_outdated = false;
+            continue;
+        }
+        is_sync_state_outdated = true;
 
-            handle_inotify_event(inotify_fd, event);
+        if (poll_fds[POLL_INDEX_CONTROL].revents & (POLLIN | POLLHUP | POLLERR)) {
+            if (!handle_control_message(inotify_fd, poll_fds[POLL_INDEX_CONTROL].fd)) {
+                // Without the daemon, the workspace is still kept in sync, but its remote systems can no longer change
+                LOG_ERROR("Control channel to the reSync daemon was closed");
+                close(poll_fds[POLL_INDEX_CONTROL].fd);
+                poll_fds[POLL_INDEX_CONTROL].fd = -1;
+                daemon_control_fd = -1;
+            }
+        }
+
+        if (poll_fds[POLL_INDEX_INOTIFY].revents & POLLIN) {
+            const bool is_drained = read_inotify_events(inotify_fd);
+            if (is_drained && !is_bulk_mode_active()
+                && poll_start - sync_state_persisted_at >= SYNC_STATE_PERSIST_INTERVAL_SEC) {
+                persist_sync_state(get_synced_until(poll_start));
+            }
         }
     }
 }
 
+static int
+parse_fd_argument(const char *arg)
+{
+    char *endptr;
+    const long fd = strtol(arg, &endptr, 10);
+    if (endptr == arg || *endptr != '\0' || fd < 0 || fd > INT_MAX) {
+        fatal_custom_error("'%s' is not a valid file descriptor", arg);
+    }
+
+    return (int) fd;
+}
+
+/*
+ * Maps the binary encoded workspace information passed by the daemon. The mapping is kept for the lifetime of the
+ *  process, as the decoded workspace information points into it.
+ */
+static WorkspaceInformation *
+read_workspace_information(const int ws_info_fd)
+{
+    struct stat ws_info_stat;
+    if (fstat(ws_info_fd, &ws_info_stat) == -1) {
+        fatal_error("fstat");
+    }
+
+    if (ws_info_stat.st_size == 0) {
+        fatal_custom_error("The passed workspace information is empty");
+    }
+
+    const char *data = (const char *) mmap(NULL, ws_info_stat.st_size, PROT_READ, MAP_PRIVATE, ws_info_fd, 0);
+    if (data == MAP_FAILED) {
+        fatal_error("mmap");
+    }
+    close(ws_info_fd);
+
+    char *error_msg = NULL;
+    WorkspaceInformation *ws_info = binary_to_workspaceInformation(data, ws_info_stat.st_size, &error_msg);
+    if (ws_info == NULL) {
+        fatal_custom_error("Unable to decode the workspace information: %s", error_msg);
+    }
+
+    return ws_info;
+}
+
 int
 main(const int argc, const char **argv)
 {
-    if (argc != 2) {
-        fatal_custom_error("Usage: ./workspace JSON_STRINGIFIED_CONFIG_FILE_ENTRY");
+    if (argc != 3 && argc != 5) {
+        fatal_custom_error(
+                "Usage: ./workspace WORKSPACE_INFORMATION_FD CONTROL_SOCKET_FD [INOTIFY_FD WATCH_STATE_SNAPSHOT_FD]"
+        );
     }
 
-    workspace_information = stringified_json_to_workspace_information(argv[1]);
+    // A daemon that closed the control channel must not terminate the monitor when it writes to the channel
+    signal(SIGPIPE, SIG_IGN);
 
-    // To account for possible changes that happened while 'reSync' was not running, we initially sync the entire workspace.
-    synchronize_workspace(workspace_information, NULL);
+    workspace_information = read_workspace_information(parse_fd_argument(argv[1]));
+
+    // The workspace is still synced if its ignore file is malformed, only without the patterns of the file
+    ignore_rules = compile_ignore_rules(true);
+    if (ignore_rules == NULL) {
+        ignore_rules = compile_ignore_rules(false);
+    }
+    set_sync_ignore_rules(ignore_rules);
 
-    const int inotify_fd = inotify_init();
-    if (inotify_fd == -1) {
-        fatal_error("inotify_init");
+    char *error_msg = NULL;
+    append_streams = create_append_streams(workspace_information->append_stream_patterns, &error_msg);
+    if (error_msg != NULL) {
+        LOG_ERROR("Syncing the files of the append stream patterns entirely: %s", error_msg);
+        DO_FREE(error_msg);
     }
 
-    // Register all directories contained in this workspace with the previously created inotify instance
-    register_watches(inotify_fd, workspace_information->local_workspace_root_path, NULL);
+    const int control_fd = parse_fd_argument(argv[2]);
+    daemon_control_fd = control_fd;
+
+    // Every sync with a remote system has to be admitted by the daemon-wide sync governor
+    const SyncLeaseHandlers lease_handlers = {.acquire = acquire_sync_lease, .release = release_sync_lease};
+    set_sync_lease_handlers(&lease_handlers);
+
+    int inotify_fd;
+    if (argc == 5) {
+        // The predecessor handed over its inotify instance and watch tables. No event was lost in the meantime, so
+        //  neither the directory tree has to be walked again nor the workspace has to be synced entirely.
+        inotify_fd = parse_fd_argument(argv[3]);
+        read_watch_state_snapshot(parse_fd_argument(argv[4]));
+    } else {
+        inotify_fd = inotify_init();
+        if (inotify_fd == -1) {
+            fatal_error("inotify_init");
+        }
+
+        // To account for possible changes that happened while the workspace was not monitored, e.g. because 'reSync'
+        //  was not running or the previous monitor crashed
+        perform_initial_sync(inotify_fd, control_fd);
+    }
+
+    configure_bulk_mode(workspace_information->bulk_event_threshold);
+    watch_bulk_operation_lock(inotify_fd, workspace_information->local_workspace_root_path);
+
+    // Loaded once all directories are watched, so that the files that change after their cached content was checked
+    //  against them are reported
+    content_cache = load_content_cache(workspace_information, &error_msg);
+    if (error_msg != NULL) {
+        LOG_ERROR("Ignoring the persisted content cache: %s", error_msg);
+        DO_FREE(error_msg);
+    }
+    if (content_cache == NULL) {
+        content_cache = create_content_cache();
+    }
+
+    // Directories are hashed by the first comparison, from then on only those that changed are hashed again
+    if (workspace_information->drift_check_interval > 0) {
+        workspace_index = create_workspace_index(
+                workspace_information->local_workspace_root_path,
+                ignore_rules,
+                workspace_information->is_drift_check_content_hashed ? WORKSPACE_INDEX_CONTENT_HASHED : 0
+        );
+    }
 
-    listen_for_inotify_events(inotify_fd);
+    listen_for_events(inotify_fd, control_fd);
 
     close(inotify_fd);
 
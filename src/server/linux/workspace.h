@@ -6,23 +6,52 @@
 #include "../../util/debug.h"
 #include "../../util/error.h"
 #include "../../util/fs_util.h"
+#include "../../util/byte_buffer.h"
 #include "../../../lib/ulist.h"
 #include "../../../lib/utash.h"
-#include "../../types.h"
+#include "../../types/types.h"
+#include "../../types/mappers.h"
+#include "../monitor_ipc.h"
 #include "../sync.h"
+#include "../sync_state.h"
+#include "../content_cache.h"
+#include "../append_stream.h"
+#include "../workspace_index.h"
+#include "event_filter.h"
+#include "bulk_mode.h"
+#include "write_settle.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <dirent.h>
 #include <errno.h>
+#include <limits.h>
+#include <signal.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <poll.h>
 
-#define WATCH_EVENT_MASK (IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_MOVE | IN_MOVE_SELF)
+#define WATCH_EVENT_MASK (IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_MOVE | IN_MOVE_SELF | IN_ATTRIB)
 #define MISC_EVENT_MASK (IN_ONLYDIR)
 
+/* Events of the ignore file at the workspace root that change the ignore rules */
+#define IGNORE_FILE_EVENT_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM)
+
+#define WATCH_STATE_SNAPSHOT_VERSION 1
+
+/* Minimum interval between two updates of the persisted sync state */
+#define SYNC_STATE_PERSIST_INTERVAL_SEC 5
+/* Tolerance for file systems whose timestamps are coarser than the clock */
+#define SYNC_STATE_CLOCK_SLACK_SEC 2
+
+#define POLL_INDEX_INOTIFY 0
+#define POLL_INDEX_CONTROL 1
+#define POLL_FDS_COUNT 2
+
 #define GET_METADATA_BY_INT_OPTIONAL(x) get_metadata_optional(watch_descriptor_to_metadata, (void *) (x), sizeof(int))
 #define GET_METADATA_BY_INT_REQUIRED(x) get_metadata_required( \
     watch_descriptor_to_metadata,                              \
@@ -52,4 +81,30 @@ typedef struct WatchMetadata {
     UT_hash_handle hh;
 } WatchMetadata;
 
+/*
+ * Directories that changed since the persisted sync state, collected while registering the watches of a restarted
+ *  monitor. Subdirectories of a changed directory are not collected, as they are synced along with it.
+ */
+typedef struct ChangedDirectoryList {
+    char *path_relative_to_ws_root;
+    struct ChangedDirectoryList *next;
+} ChangedDirectoryList;
+
+typedef struct ChangeScan {
+    time_t changed_since;
+    ChangedDirectoryList *changed_directories;
+} ChangeScan;
+
+/*
+ * Source of a move whose 'IN_MOVED_TO' event was not handled yet. If the event does not directly follow, the resource
+ *  was moved out of the workspace.
+ */
+typedef struct PendingMove {
+    uint32_t cookie;
+    char *path_relative_to_ws_root;
+    char *directory_path_relative_to_ws_root;
+    /* Whether the sync of a write to the resource, or to a file below it, was deferred (see 'write_settle.h') */
+    bool is_write_deferred;
+} PendingMove;
+
 #endif //RESYNC_WORKSPACE_H
@@ -0,0 +1,235 @@
+#include "write_settle.h"
+
+static FileWriteActivity *file_writes = NULL;
+
+static uint64_t
+now_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000 + (uint64_t) now.tv_nsec / 1000000;
+}
+
+static void
+destroy_file_write_activity(FileWriteActivity *activity)
+{
+    HASH_DELETE(hh, file_writes, activity);
+    DO_FREE(activity->key);
+    DO_FREE(activity->relative_directory_path);
+    DO_FREE(activity);
+}
+
+/*
+ * @return the activity of the new file, or NULL if too many files are tracked
+ */
+static FileWriteActivity *
+create_file_write_activity(const char *relative_path, const char *relative_directory_path, const uint64_t now)
+{
+    if (HASH_COUNT(file_writes) >= WRITE_SETTLE_MAX_TRACKED_FILES) {
+        // Synced files whose rate window is over only tell whether they are appended to
+        FileWriteActivity *activity, *tmp;
+        HASH_ITER(hh, file_writes, activity, tmp) {
+            if (activity->deferred_since_ms == 0 && now - activity->last_write_ms >= WRITE_SETTLE_RATE_WINDOW_MS) {
+                destroy_file_write_activity(activity);
+            }
+        }
+
+        if (HASH_COUNT(file_writes) >= WRITE_SETTLE_MAX_TRACKED_FILES) {
+            return NULL;
+        }
+    }
+
+    FileWriteActivity *activity = (FileWriteActivity *) do_calloc(1, sizeof(FileWriteActivity));
+    activity->key = resync_strdup(relative_path);
+    activity->relative_directory_path = (relative_directory_path == NULL) ? NULL : resync_strdup(relative_directory_path);
+    activity->rate_window_start_ms = now;
+    HASH_ADD_KEYPTR(hh, file_writes, activity->key, strlen(activity->key), activity);
+
+    return activity;
+}
+
+static void
+mark_file_write_deferred(FileWriteActivity *activity, const uint64_t now)
+{
+    if (activity->deferred_since_ms == 0) {
+        activity->deferred_since_ms = now;
+        activity->deferred_since = time(NULL);
+    }
+}
+
+void
+note_file_modification(const char *relative_directory_path, const char *name)
+{
+    char relative_path[PATH_MAX];
+    const int relative_path_len = (relative_directory_path == NULL)
+            ? snprintf(relative_path, sizeof(relative_path), "%s", name)
+            : snprintf(relative_path, sizeof(relative_path), "%s/%s", relative_directory_path, name);
+    if (relative_path_len < 0 || (size_t) relative_path_len >= sizeof(relative_path)) {
+        return;
+    }
+
+    const uint64_t now = now_ms();
+
+    FileWriteActivity *activity;
+    HASH_FIND(hh, file_writes, relative_path, (size_t) relative_path_len, activity);
+    if (activity == NULL) {
+        activity = create_file_write_activity(relative_path, relative_directory_path, now);
+        if (activity == NULL) {
+            return;
+        }
+    }
+
+    activity->last_write_ms = now;
+    mark_file_write_deferred(activity, now);
+}
+
+bool
+defer_written_file(const char *relative_path, const char *relative_directory_path, const uint64_t size)
+{
+    const uint64_t now = now_ms();
+
+    FileWriteActivity *activity;
+    HASH_FIND_STR(file_writes, relative_path, activity);
+    if (activity == NULL) {
+        activity = create_file_write_activity(relative_path, relative_directory_path, now);
+        if (activity == NULL) {
+            return false;
+        }
+    }
+
+    activity->last_write_ms = now;
+    if (now - activity->rate_window_start_ms >= WRITE_SETTLE_RATE_WINDOW_MS) {
+        activity->rate_window_start_ms = now;
+        activity->rate_window_writes = 0;
+    }
+    activity->rate_window_writes++;
+
+    const bool is_hot = size >= WRITE_SETTLE_LARGE_FILE_SIZE
+            || activity->rate_window_writes >= WRITE_SETTLE_HOT_WRITES_COUNT;
+    if (!is_hot) {
+        activity->deferred_since_ms = 0;
+        return false;
+    }
+
+    mark_file_write_deferred(activity, now);
+    if (now - activity->deferred_since_ms >= WRITE_SETTLE_MAX_STALENESS_MS) {
+        activity->deferred_since_ms = 0;
+        return false;
+    }
+
+    return true;
+}
+
+uint32_t
+synchronize_settled_files(const SettledFileHandler handler, const bool is_forced)
+{
+    const uint64_t now = now_ms();
+    uint32_t synced_files_count = 0;
+
+    FileWriteActivity *activity, *tmp;
+    HASH_ITER(hh, file_writes, activity, tmp) {
+        if (activity->deferred_since_ms == 0) {
+            if (now - activity->last_write_ms >= WRITE_SETTLE_EXPIRY_MS) {
+                destroy_file_write_activity(activity);
+            }
+            continue;
+        }
+
+        if (is_forced
+            || now - activity->last_write_ms >= WRITE_SETTLE_QUIET_MS
+            || now - activity->deferred_since_ms >= WRITE_SETTLE_MAX_STALENESS_MS) {
+            activity->deferred_since_ms = 0;
+            handler(activity->key, activity->relative_directory_path);
+            synced_files_count++;
+        }
+    }
+
+    return synced_files_count;
+}
+
+int
+get_write_settle_timeout_ms(void)
+{
+    const uint64_t now = now_ms();
+    int timeout_ms = -1;
+
+    FileWriteActivity *activity;
+    for (activity = file_writes; activity != NULL; activity = activity->hh.next) {
+        if (activity->deferred_since_ms == 0) {
+            continue;
+        }
+
+        uint64_t deadline_ms = activity->last_write_ms + WRITE_SETTLE_QUIET_MS;
+        if (deadline_ms > activity->deferred_since_ms + WRITE_SETTLE_MAX_STALENESS_MS) {
+            deadline_ms = activity->deferred_since_ms + WRITE_SETTLE_MAX_STALENESS_MS;
+        }
+
+        const int file_timeout_ms = (deadline_ms > now) ? (int) (deadline_ms - now) : 0;
+        if (timeout_ms == -1 || file_timeout_ms < timeout_ms) {
+            timeout_ms = file_timeout_ms;
+        }
+    }
+
+    return timeout_ms;
+}
+
+time_t
+get_oldest_deferred_write_time(void)
+{
+    time_t oldest = 0;
+
+    FileWriteActivity *activity;
+    for (activity = file_writes; activity != NULL; activity = activity->hh.next) {
+        if (activity->deferred_since_ms != 0 && (oldest == 0 || activity->deferred_since < oldest)) {
+            oldest = activity->deferred_since;
+        }
+    }
+
+    return oldest;
+}
+
+bool
+is_file_appended(const char *relative_path, const uint64_t size)
+{
+    FileWriteActivity *activity;
+    HASH_FIND_STR(file_writes, relative_path, activity);
+
+    return activity != NULL && activity->synced_size > 0 && size > activity->synced_size;
+}
+
+void
+record_synced_file_size(const char *relative_path, const uint64_t size)
+{
+    FileWriteActivity *activity;
+    HASH_FIND_STR(file_writes, relative_path, activity);
+    if (activity != NULL) {
+        activity->synced_size = size;
+    }
+}
+
+uint32_t
+forget_file_writes(const char *relative_path, const bool is_directory)
+{
+    uint32_t deferred_writes_count = 0;
+
+    FileWriteActivity *activity, *tmp;
+    HASH_FIND_STR(file_writes, relative_path, activity);
+    if (activity != NULL) {
+        deferred_writes_count += (activity->deferred_since_ms != 0);
+        destroy_file_write_activity(activity);
+    }
+
+    if (!is_directory || file_writes == NULL) {
+        return deferred_writes_count;
+    }
+
+    const size_t relative_path_len = strlen(relative_path);
+    HASH_ITER(hh, file_writes, activity, tmp) {
+        if (strncmp(activity->key, relative_path, relative_path_len) == 0 && activity->key[relative_path_len] == '/') {
+            deferred_writes_count += (activity->deferred_since_ms != 0);
+            destroy_file_write_activity(activity);
+        }
+    }
+
+    return deferred_writes_count;
+}
@@ -0,0 +1,99 @@
+#ifndef RESYNC_WRITE_SETTLE_H
+#define RESYNC_WRITE_SETTLE_H
+
+#include "../../util/string.h"
+#include "../../util/memory.h"
+#include "../../../lib/utash.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <time.h>
+
+/*
+ * Write activity of the files of the workspace. Files that are still being written, e.g. large files that are written
+ *  in many open/write/close cycles or logs that are appended to, would be synced again for every write, each time
+ *  transferring a larger part of them. Instead, the sync of a hot file is deferred until it settles, i.e. until it is
+ *  no longer written to for a while, or until it was deferred for too long. A file is hot if it is large or if it was
+ *  closed after writing several times within a short period. Files that are written to without being closed, which
+ *  'IN_MODIFY' reports, are synced once they settle as well.
+ */
+
+/* Files from this size on are hot on every write */
+#define WRITE_SETTLE_LARGE_FILE_SIZE ((uint64_t) (64 * 1024 * 1024))
+/* Number of writes within the rate window that make a file hot */
+#define WRITE_SETTLE_HOT_WRITES_COUNT 3
+#define WRITE_SETTLE_RATE_WINDOW_MS 2000
+/* Period without writes after which a file settled */
+#define WRITE_SETTLE_QUIET_MS 2000
+/* Bounds how long the sync of a file that is written to continuously is deferred */
+#define WRITE_SETTLE_MAX_STALENESS_MS 30000
+/* Period after which the activity of a synced file is forgotten */
+#define WRITE_SETTLE_EXPIRY_MS 60000
+/* Bounds the number of tracked files, files that are not tracked are synced on every write */
+#define WRITE_SETTLE_MAX_TRACKED_FILES 4096
+
+typedef struct FileWriteActivity {
+    /* Path relative to the workspace root */
+    char *key;
+    char *relative_directory_path;
+    uint64_t last_write_ms;
+    /* Start of the rate window and the writes within it */
+    uint64_t rate_window_start_ms;
+    uint32_t rate_window_writes;
+    /* Time of the oldest write that was not synced yet, 0 if the file is synced */
+    uint64_t deferred_since_ms;
+    time_t deferred_since;
+    /* Size of the file when it was last synced, 0 if unknown */
+    uint64_t synced_size;
+    UT_hash_handle hh;
+} FileWriteActivity;
+
+typedef void (*SettledFileHandler)(const char *relative_path, const char *relative_directory_path);
+
+/**
+ * Records a write to the file that did not close it ('IN_MODIFY'). Nothing is allocated for files that are tracked
+ *  already, as such events are reported for every single write.
+ */
+void note_file_modification(const char *relative_directory_path, const char *name);
+
+/**
+ * Records that the file was closed after writing.
+ *
+ * @return true if the file is hot and its sync is deferred until it settles, false if it has to be synced now
+ */
+bool defer_written_file(const char *relative_path, const char *relative_directory_path, const uint64_t size);
+
+/**
+ * Syncs the deferred files that settled or were deferred for too long with the handler.
+ *
+ * @param is_forced whether all deferred files are synced, regardless of whether they settled
+ * @return the number of synced files
+ */
+uint32_t synchronize_settled_files(const SettledFileHandler handler, const bool is_forced);
+
+/**
+ * @return the time until the next deferred file may settle, or -1 if no sync is deferred
+ */
+int get_write_settle_timeout_ms(void);
+
+/**
+ * @return the time of the oldest write whose sync is deferred, 0 if there is none
+ */
+time_t get_oldest_deferred_write_time(void);
+
+/**
+ * @return true if the file only grew since it was last synced
+ */
+bool is_file_appended(const char *relative_path, const uint64_t size);
+
+void record_synced_file_size(const char *relative_path, const uint64_t size);
+
+/**
+ * Forgets the activity of the resource, and of all resources below it if it is a directory.
+ *
+ * @return the number of files whose deferred sync was dropped
+ */
+uint32_t forget_file_writes(const char *relative_path, const bool is_directory);
+
+#endif //RESYNC_WRITE_SETTLE_H
@@ -0,0 +1,70 @@
+#include "monitor_ipc.h"
+
+bool
+send_monitor_control_message(const int fd, const MonitorControlMessageType type, const char *payload,
+                             const uint32_t payload_size, char **error_msg)
+{
+    if (payload_size > MONITOR_CONTROL_MAX_PAYLOAD_SIZE) {
+        SET_ERROR_MSG_RAW(
+                error_msg,
+                format_string("Control message payload of '%u' bytes exceeds the maximum payload size", payload_size)
+        );
+        return false;
+    }
+
+    MonitorControlMessageHeader header = {.type = type, .payload_size = payload_size};
+
+    if (!write_all(fd, &header, sizeof(header)) || (payload_size > 0 && !write_all(fd, payload, payload_size))) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to send control message: %s", strerror(errno)));
+        return false;
+    }
+
+    return true;
+}
+
+MonitorControlMessage *
+receive_monitor_control_message(const int fd, char **error_msg)
+{
+    MonitorControlMessageHeader header;
+
+    int ret = read_all(fd, &header, sizeof(header));
+    if (ret == 0) {
+        return NULL;
+    } else if (ret < 0) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to receive control message header: %s", strerror(errno)));
+        return NULL;
+    }
+
+    if (header.payload_size > MONITOR_CONTROL_MAX_PAYLOAD_SIZE) {
+        SET_ERROR_MSG_RAW(
+                error_msg,
+                format_string("Received control message header announces an invalid payload size of '%u' bytes", header.payload_size)
+        );
+        return NULL;
+    }
+
+    MonitorControlMessage *message = (MonitorControlMessage *) do_calloc(1, sizeof(MonitorControlMessage));
+    message->type = (MonitorControlMessageType) header.type;
+    message->payload_size = header.payload_size;
+
+    // Payloads are always NULL terminated, so that textual payloads can be used as strings directly
+    message->payload = (char *) do_calloc(1, header.payload_size + 1);
+    if (header.payload_size > 0 && read_all(fd, message->payload, header.payload_size) != 1) {
+        SET_ERROR_MSG(error_msg, "Control channel was closed before the entire control message payload was received");
+        destroy_monitor_control_message(&message);
+        return NULL;
+    }
+
+    return message;
+}
+
+void
+destroy_monitor_control_message(MonitorControlMessage **message)
+{
+    if (message == NULL || *message == NULL) {
+        return;
+    }
+
+    DO_FREE((*message)->payload);
+    DO_FREE(*message);
+}
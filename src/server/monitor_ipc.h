@@ -0,0 +1,69 @@
+#ifndef RESYNC_MONITOR_IPC_H
+#define RESYNC_MONITOR_IPC_H
+
+#include "../util/string.h"
+#include "../util/memory.h"
+#include "../util/error.h"
+#include "../socket.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Control channel between the reSync daemon and the fs monitoring & syncing process of a workspace. The daemon creates
+ *  a connected pair of unix stream sockets for every workspace monitor, keeps one end and passes the other one to the
+ *  monitor process. Messages are framed by a fixed size header, followed by 'payload_size' bytes of payload.
+ */
+
+/* Upper bound for the payload of a single control message, to guard against corrupted headers */
+#define MONITOR_CONTROL_MAX_PAYLOAD_SIZE ((uint32_t) (64 * 1024 * 1024))
+
+typedef enum MonitorControlMessageType {
+    OTHER_MONITOR_CONTROL_MESSAGE_TYPE,
+    /* daemon -> monitor: Start synchronizing the workspace with an additional remote system */
+    MONITOR_ADD_REMOTE_SYSTEM,
+    /* daemon -> monitor: Stop synchronizing the workspace with a remote system */
+    MONITOR_REMOVE_REMOTE_SYSTEM,
+    /* daemon -> monitor: Hand the watch state over to a successor process and terminate */
+    MONITOR_HANDOFF_REQUEST,
+    /* monitor -> daemon: Serialized watch tables, directly followed by the inotify instance's fd (SCM_RIGHTS) */
+    MONITOR_HANDOFF_STATE,
+    /* daemon -> monitor: The freshly started monitor may now perform the initial sync of the workspace */
+    MONITOR_INITIAL_SYNC_GRANT,
+    /* monitor -> daemon: The initial sync of the workspace finished */
+    MONITOR_INITIAL_SYNC_DONE,
+    /* monitor -> daemon: Request a lease to sync with the remote host in the payload, see 'governor.h' */
+    MONITOR_SYNC_LEASE_REQUEST,
+    /* daemon -> monitor: The requested lease for the remote host in the payload is granted */
+    MONITOR_SYNC_LEASE_GRANT,
+    /* monitor -> daemon: Return the lease for the remote host in the payload */
+    MONITOR_SYNC_LEASE_RELEASE
+} MonitorControlMessageType;
+
+typedef struct MonitorControlMessageHeader {
+    uint32_t type;
+    uint32_t payload_size;
+} MonitorControlMessageHeader;
+
+typedef struct MonitorControlMessage {
+    MonitorControlMessageType type;
+    uint32_t payload_size;
+    char *payload;
+    /* Allows queueing messages that cannot be handled yet */
+    struct MonitorControlMessage *next;
+} MonitorControlMessage;
+
+bool send_monitor_control_message(const int fd, const MonitorControlMessageType type, const char *payload,
+                                  const uint32_t payload_size, char **error_msg);
+
+/**
+ * Blocks until a complete control message was received.
+ *
+ * @return the received message, or NULL if the peer closed the channel or an error occurred. In the latter case the
+ *  error message is set.
+ */
+MonitorControlMessage *receive_monitor_control_message(const int fd, char **error_msg);
+
+void destroy_monitor_control_message(MonitorControlMessage **message);
+
+#endif //RESYNC_MONITOR_IPC_H
@@ -0,0 +1,127 @@
+#include "options.h"
+
+#include <errno.h>
+#include <limits.h>
+
+/*
+ * Utility macros when parsing the given options
+ */
+#define HANDLE_MAX_OCCURRENCE(x,y,z) do { \
+    if (x > y) {                           \
+        LOG_ERROR("Option '%s' must be specified at most %d time(s)!", z, y); \
+        return false;                      \
+        }                                  \
+    } while (0)
+
+/*
+ * The long options accepted by the daemon.
+ */
+static struct option long_options[] = {
+        {OPT_LONG_NAME_STARTUP_CONCURRENCY, required_argument, NULL, OPT_LONG_VAL_STARTUP_CONCURRENCY},
+        {OPT_LONG_NAME_INITIAL_SYNCS_PER_HOST, required_argument, NULL, OPT_LONG_VAL_INITIAL_SYNCS_PER_HOST},
+        {OPT_LONG_NAME_INITIAL_SYNC_STAGGER, required_argument, NULL, OPT_LONG_VAL_INITIAL_SYNC_STAGGER},
+        {OPT_LONG_NAME_MAX_CONCURRENT_SYNCS, required_argument, NULL, OPT_LONG_VAL_MAX_CONCURRENT_SYNCS},
+        {OPT_LONG_NAME_MAX_SYNCS_PER_HOST, required_argument, NULL, OPT_LONG_VAL_MAX_SYNCS_PER_HOST},
+        {OPT_LONG_NAME_RESTART_BACKOFF, required_argument, NULL, OPT_LONG_VAL_RESTART_BACKOFF},
+        {OPT_LONG_NAME_MAX_RESTART_BACKOFF, required_argument, NULL, OPT_LONG_VAL_MAX_RESTART_BACKOFF},
+        {NULL, 0, NULL, 0}
+};
+
+static bool
+parse_int_option(const char *value, const char *option_usage, const int min_value, int *result)
+{
+    char *endptr;
+    errno = 0;
+    const long parsed_value = strtol(value, &endptr, 10);
+
+    if (errno != 0 || endptr == value || *endptr != '\0' || parsed_value < min_value || parsed_value > INT_MAX) {
+        LOG_ERROR("The value for option '%s' must be an integer >= %d!", option_usage, min_value);
+        return false;
+    }
+
+    *result = (int) parsed_value;
+    return true;
+}
+
+bool
+parse_daemon_options(int argc, char **argv, DaemonOptions *options)
+{
+    options->startup_concurrency = DEFAULT_STARTUP_CONCURRENCY;
+    options->initial_syncs_per_host = DEFAULT_INITIAL_SYNCS_PER_HOST;
+    options->initial_sync_stagger_ms = DEFAULT_INITIAL_SYNC_STAGGER_MS;
+    options->max_concurrent_syncs = DEFAULT_MAX_CONCURRENT_SYNCS;
+    options->max_syncs_per_host = DEFAULT_MAX_SYNCS_PER_HOST;
+    options->restart_backoff_ms = DEFAULT_RESTART_BACKOFF_MS;
+    options->max_restart_backoff_ms = DEFAULT_MAX_RESTART_BACKOFF_MS;
+
+    int c;
+    int option_index = 0;
+
+    int opt_counter_startup_concurrency = 0;
+    int opt_counter_initial_syncs_per_host = 0;
+    int opt_counter_initial_sync_stagger = 0;
+    int opt_counter_max_concurrent_syncs = 0;
+    int opt_counter_max_syncs_per_host = 0;
+    int opt_counter_restart_backoff = 0;
+    int opt_counter_max_restart_backoff = 0;
+
+    while ((c = getopt_long(argc, argv, ALLOWED_SHORT_OPTIONS, long_options, &option_index)) != -1) {
+
+        switch (c) {
+            case OPT_LONG_VAL_STARTUP_CONCURRENCY:
+                HANDLE_MAX_OCCURRENCE(++opt_counter_startup_concurrency, 1, OPT_USAGE_STARTUP_CONCURRENCY);
+                if (!parse_int_option(optarg, OPT_USAGE_STARTUP_CONCURRENCY, 1, &(options->startup_concurrency))) {
+                    return false;
+                }
+                break;
+            case OPT_LONG_VAL_INITIAL_SYNCS_PER_HOST:
+                HANDLE_MAX_OCCURRENCE(++opt_counter_initial_syncs_per_host, 1, OPT_USAGE_INITIAL_SYNCS_PER_HOST);
+                if (!parse_int_option(optarg, OPT_USAGE_INITIAL_SYNCS_PER_HOST, 1, &(options->initial_syncs_per_host))) {
+                    return false;
+                }
+                break;
+            case OPT_LONG_VAL_INITIAL_SYNC_STAGGER:
+                HANDLE_MAX_OCCURRENCE(++opt_counter_initial_sync_stagger, 1, OPT_USAGE_INITIAL_SYNC_STAGGER);
+                if (!parse_int_option(optarg, OPT_USAGE_INITIAL_SYNC_STAGGER, 0, &(options->initial_sync_stagger_ms))) {
+                    return false;
+                }
+                break;
+            case OPT_LONG_VAL_MAX_CONCURRENT_SYNCS:
+                HANDLE_MAX_OCCURRENCE(++opt_counter_max_concurrent_syncs, 1, OPT_USAGE_MAX_CONCURRENT_SYNCS);
+                if (!parse_int_option(optarg, OPT_USAGE_MAX_CONCURRENT_SYNCS, 1, &(options->max_concurrent_syncs))) {
+                    return false;
+                }
+                break;
+            case OPT_LONG_VAL_MAX_SYNCS_PER_HOST:
+                HANDLE_MAX_OCCURRENCE(++opt_counter_max_syncs_per_host, 1, OPT_USAGE_MAX_SYNCS_PER_HOST);
+                if (!parse_int_option(optarg, OPT_USAGE_MAX_SYNCS_PER_HOST, 1, &(options->max_syncs_per_host))) {
+                    return false;
+                }
+                break;
+            case OPT_LONG_VAL_RESTART_BACKOFF:
+                HANDLE_MAX_OCCURRENCE(++opt_counter_restart_backoff, 1, OPT_USAGE_RESTART_BACKOFF);
+                if (!parse_int_option(optarg, OPT_USAGE_RESTART_BACKOFF, 0, &(options->restart_backoff_ms))) {
+                    return false;
+                }
+                break;
+            case OPT_LONG_VAL_MAX_RESTART_BACKOFF:
+                HANDLE_MAX_OCCURRENCE(++opt_counter_max_restart_backoff, 1, OPT_USAGE_MAX_RESTART_BACKOFF);
+                if (!parse_int_option(optarg, OPT_USAGE_MAX_RESTART_BACKOFF, 0, &(options->max_restart_backoff_ms))) {
+                    return false;
+                }
+                break;
+            case '?':
+                return false;
+            default:
+                LOG_ERROR("Encountered an unknown error while parsing the options");
+                return false;
+        }
+    }
+
+    if (optind != argc) {
+        LOG_ERROR("The daemon does not accept positional arguments!");
+        return false;
+    }
+
+    return true;
+}
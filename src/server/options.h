@@ -0,0 +1,76 @@
+#ifndef RESYNC_DAEMON_OPTIONS_H
+#define RESYNC_DAEMON_OPTIONS_H
+
+#include "../util/string.h"
+#include "../util/debug.h"
+
+#include <stdbool.h>
+#include <getopt.h>
+
+/*
+ * Short and long form options recognized by the daemon with their description.
+ */
+
+#define OPT_LONG_NAME_STARTUP_CONCURRENCY "startup-concurrency"
+#define OPT_LONG_VAL_STARTUP_CONCURRENCY 1
+#define OPT_USAGE_STARTUP_CONCURRENCY (format_string("--%s", OPT_LONG_NAME_STARTUP_CONCURRENCY))
+#define OPT_DESCRIPTION_STARTUP_CONCURRENCY "Number of workspace monitors that are spawned concurrently on startup"
+
+#define OPT_LONG_NAME_INITIAL_SYNCS_PER_HOST "initial-syncs-per-host"
+#define OPT_LONG_VAL_INITIAL_SYNCS_PER_HOST 2
+#define OPT_USAGE_INITIAL_SYNCS_PER_HOST (format_string("--%s", OPT_LONG_NAME_INITIAL_SYNCS_PER_HOST))
+#define OPT_DESCRIPTION_INITIAL_SYNCS_PER_HOST "Maximum number of concurrent initial workspace syncs to the same remote host"
+
+#define OPT_LONG_NAME_INITIAL_SYNC_STAGGER "initial-sync-stagger-ms"
+#define OPT_LONG_VAL_INITIAL_SYNC_STAGGER 3
+#define OPT_USAGE_INITIAL_SYNC_STAGGER (format_string("--%s", OPT_LONG_NAME_INITIAL_SYNC_STAGGER))
+#define OPT_DESCRIPTION_INITIAL_SYNC_STAGGER "Minimum delay in milliseconds between two initial syncs to the same remote host"
+
+#define OPT_LONG_NAME_MAX_CONCURRENT_SYNCS "max-concurrent-syncs"
+#define OPT_LONG_VAL_MAX_CONCURRENT_SYNCS 4
+#define OPT_USAGE_MAX_CONCURRENT_SYNCS (format_string("--%s", OPT_LONG_NAME_MAX_CONCURRENT_SYNCS))
+#define OPT_DESCRIPTION_MAX_CONCURRENT_SYNCS "Maximum number of syncs that run concurrently across all workspaces"
+
+#define OPT_LONG_NAME_MAX_SYNCS_PER_HOST "max-syncs-per-host"
+#define OPT_LONG_VAL_MAX_SYNCS_PER_HOST 5
+#define OPT_USAGE_MAX_SYNCS_PER_HOST (format_string("--%s", OPT_LONG_NAME_MAX_SYNCS_PER_HOST))
+#define OPT_DESCRIPTION_MAX_SYNCS_PER_HOST "Maximum number of syncs to the same remote host that run concurrently"
+
+#define OPT_LONG_NAME_RESTART_BACKOFF "restart-backoff-ms"
+#define OPT_LONG_VAL_RESTART_BACKOFF 6
+#define OPT_USAGE_RESTART_BACKOFF (format_string("--%s", OPT_LONG_NAME_RESTART_BACKOFF))
+#define OPT_DESCRIPTION_RESTART_BACKOFF "Delay in milliseconds before a crashed workspace monitor is restarted"
+
+#define OPT_LONG_NAME_MAX_RESTART_BACKOFF "max-restart-backoff-ms"
+#define OPT_LONG_VAL_MAX_RESTART_BACKOFF 7
+#define OPT_USAGE_MAX_RESTART_BACKOFF (format_string("--%s", OPT_LONG_NAME_MAX_RESTART_BACKOFF))
+#define OPT_DESCRIPTION_MAX_RESTART_BACKOFF "Maximum delay in milliseconds before a repeatedly crashing workspace monitor is restarted"
+
+#define ALLOWED_SHORT_OPTIONS ""
+
+#define DEFAULT_STARTUP_CONCURRENCY 8
+#define DEFAULT_INITIAL_SYNCS_PER_HOST 2
+#define DEFAULT_INITIAL_SYNC_STAGGER_MS 250
+#define DEFAULT_MAX_CONCURRENT_SYNCS 16
+#define DEFAULT_MAX_SYNCS_PER_HOST 4
+#define DEFAULT_RESTART_BACKOFF_MS 1000
+#define DEFAULT_MAX_RESTART_BACKOFF_MS (5 * 60 * 1000)
+
+typedef struct DaemonOptions {
+    int startup_concurrency;
+    int initial_syncs_per_host;
+    int initial_sync_stagger_ms;
+    int max_concurrent_syncs;
+    int max_syncs_per_host;
+    int restart_backoff_ms;
+    int max_restart_backoff_ms;
+} DaemonOptions;
+
+/**
+ * Parses the daemon's command line options. Options that are not specified keep their default value.
+ *
+ * @return false if invalid options were specified
+ */
+bool parse_daemon_options(int argc, char **argv, DaemonOptions *options);
+
+#endif //RESYNC_DAEMON_OPTIONS_H
@@ -1,5 +1,11 @@
-#include "../util/debug.h"
 #include "config.h"
+#include "../util/debug.h"
+#include "monitor_ipc.h"
+#include "admission.h"
+#include "governor.h"
+#include "supervisor.h"
+#include "ssh_pool.h"
+#include "options.h"
 #include "../socket.h"
 #include "../types/types.h"
 #include "../types/mappers.h"
@@ -11,7 +17,11 @@
 #include <signal.h>
 #include <errno.h>
 #include <syslog.h>
+#include <fcntl.h>
 #include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <poll.h>
 
 #define COMMAND_BUFFER_CHUNK_SIZE ((ssize_t)(2048 * sizeof(char)))
 
@@ -20,30 +30,189 @@
 
 #define WORKSPACE_MONITOR_EXECUTABLE "./linux/ws"
 
+/* Time a spawned workspace monitor has to pass its pidfd before its start is considered failed */
+#define MONITOR_START_TIMEOUT_SEC 10
+
+/* Time a workspace monitor has to finish its current sync and hand over its watch state before it is terminated */
+#define HANDOFF_TIMEOUT_SEC 60
+
 typedef struct WorkspaceProcessInfo {
     const char *ws_path;
     pid_t process_pid;
+    /* Daemon's end of the control channel to the workspace's fs monitoring & syncing process, or -1 once it closed */
+    int control_fd;
+    /* Becomes readable once the monitor terminated, or -1 if the kernel does not support pidfds */
+    int pidfd;
+    /* The monitor waits for or performs its initial sync, see 'admission.h' */
+    bool initial_sync_pending;
+    /* Weight of the workspace when competing for sync leases, see 'governor.h' */
+    int sync_weight;
     UT_hash_handle hh;
 } WorkspaceProcessInfo;
 
+/*
+ * A workspace monitor whose intermediate process was forked, but whose PID was not collected yet.
+ */
+typedef struct PendingMonitorStart {
+    const ConfigFileEntryData *config_entry_info;
+    pid_t intermediate_pid;
+    int pid_pipe_fd;
+    int control_fd;
+    bool needs_initial_sync;
+} PendingMonitorStart;
+
+/*
+ * Watch state of a terminated workspace monitor that is handed over to its successor.
+ */
+typedef struct WatchStateHandoff {
+    int inotify_fd;
+    int snapshot_fd;
+} WatchStateHandoff;
+
 WorkspaceProcessInfo *ws_to_process_map = NULL;
 
+DaemonOptions daemon_options;
+
+AdmissionController *admission_controller = NULL;
+
+SyncGovernor *sync_governor = NULL;
+
+MonitorSupervisor *monitor_supervisor = NULL;
+
+SshPool *ssh_pool = NULL;
+
+/* Absolute path of the workspace monitor executable, as the daemon changes its working directory to '/' */
+char *workspace_monitor_path = NULL;
+
 volatile sig_atomic_t terminate_daemon = 0;
 
+volatile sig_atomic_t reload_workspace_monitors = 0;
+
+static void
+handle_termination_signal(int signal_number)
+{
+    terminate_daemon = 1;
+}
+
+static void
+handle_reload_signal(int signal_number)
+{
+    reload_workspace_monitors = 1;
+}
+
+static void
+handle_child_termination_signal(int signal_number)
+{
+    // Only interrupts the event loop, so that terminated ssh master connections are reconnected right away
+}
+
 static void
 install_signal_handlers(void)
 {
-    // TODO:
-    //  Handle e.g. process termination or when child process terminates
+    // No SA_RESTART, so that the event loop is interrupted and notices the termination request
+    struct sigaction termination_action;
+    memset(&termination_action, 0, sizeof(termination_action));
+    termination_action.sa_handler = handle_termination_signal;
+    sigemptyset(&termination_action.sa_mask);
+    sigaction(SIGTERM, &termination_action, NULL);
+    sigaction(SIGINT, &termination_action, NULL);
+
+    // Replaces the running workspace monitors, e.g. once their executable was upgraded, without losing any events
+    struct sigaction reload_action;
+    memset(&reload_action, 0, sizeof(reload_action));
+    reload_action.sa_handler = handle_reload_signal;
+    sigemptyset(&reload_action.sa_mask);
+    sigaction(SIGHUP, &reload_action, NULL);
+
+    // Writing to the control channel of a workspace monitor that terminated must not terminate the daemon
+    signal(SIGPIPE, SIG_IGN);
+
+    // Workspace monitors are grandchildren that are supervised through pidfds instead. The children are the ssh
+    //  master connections and the intermediate processes of a monitor start, which are reaped right after they
+    //  terminated. Blocking calls other than 'poll' are restarted after the handler ran.
+    struct sigaction child_termination_action;
+    memset(&child_termination_action, 0, sizeof(child_termination_action));
+    child_termination_action.sa_handler = handle_child_termination_signal;
+    child_termination_action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    sigemptyset(&child_termination_action.sa_mask);
+    sigaction(SIGCHLD, &child_termination_action, NULL);
+}
+
+/*
+ * Stores the binary encoded workspace information in a sealed anonymous in-memory file, which is inherited by the
+ *  workspace monitor. Unlike a command line argument, its size is not limited by ARG_MAX.
+ */
+static int
+create_workspace_information_fd(const WorkspaceInformation *ws_info, char **error_msg)
+{
+    ByteBuffer *buffer = workspaceInformation_to_binary(ws_info, error_msg);
+    if (buffer == NULL) {
+        return -1;
+    }
+
+    const int fd = memfd_create("reSync-workspace-information", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd == -1 || !write_all(fd, buffer->data, buffer->size)) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to store the workspace information: %s", strerror(errno)));
+        if (fd != -1) {
+            close(fd);
+        }
+        destroy_byte_buffer(&buffer);
+        return -1;
+    }
+
+    destroy_byte_buffer(&buffer);
+
+    // The monitor maps the file and decodes views into it, so its content must not change afterwards
+    fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+
+    return fd;
 }
 
 static bool
-start_workspace_monitor(const ConfigFileEntryData *config_entry_info, char **error_msg)
+spawn_workspace_monitor(const ConfigFileEntryData *config_entry_info, const WatchStateHandoff *handoff,
+                        PendingMonitorStart *pending_start, char **error_msg)
 {
     int pipe_fd[2];
+    int control_fds[2];
     pid_t intermediate_pid, grandchild_pid;
 
-    if (pipe(pipe_fd) == -1) {
+    const int ws_info_fd = create_workspace_information_fd(config_entry_info->workspace_information, error_msg);
+    if (ws_info_fd == -1) {
+        SET_ERROR_MSG_WITH_CAUSE_RAW(
+                error_msg,
+                format_string(
+                        "Passing the workspace information to the fs monitoring & syncing process for workspace '%s' "
+                        "failed",
+                        config_entry_info->workspace_information->local_workspace_root_path
+                ),
+                error_msg
+        );
+        return false;
+    }
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, control_fds) == -1) {
+        close(ws_info_fd);
+        SET_ERROR_MSG_RAW(
+                error_msg,
+                format_string(
+                        "Creating the control channel while trying to create the fs monitoring & syncing process for "
+                        "workspace '%s' failed: %s",
+                        config_entry_info->workspace_information->local_workspace_root_path,
+                        strerror(errno)
+                )
+        );
+        return false;
+    }
+
+    // The daemon's end of the control channel must not be inherited by any other process, as otherwise the monitor
+    //  would not notice when the daemon closes the channel.
+    fcntl(control_fds[0], F_SETFD, FD_CLOEXEC);
+
+    // Monitors are spawned concurrently, so the pipe must not leak into the monitors of other workspaces either
+    if (pipe2(pipe_fd, O_CLOEXEC) == -1) {
+        close(ws_info_fd);
+        close(control_fds[0]);
+        close(control_fds[1]);
         SET_ERROR_MSG_RAW(
                 error_msg,
                 format_string(
@@ -58,6 +227,11 @@ start_workspace_monitor(const ConfigFileEntryData *config_entry_info, char **err
 
     intermediate_pid = fork();
     if (intermediate_pid < 0) {
+        close(ws_info_fd);
+        close(control_fds[0]);
+        close(control_fds[1]);
+        close(pipe_fd[0]);
+        close(pipe_fd[1]);
         SET_ERROR_MSG_RAW(
                 error_msg,
                 format_string(
@@ -90,50 +264,193 @@ start_workspace_monitor(const ConfigFileEntryData *config_entry_info, char **err
 
         /* Grandchild process */
         close(pipe_fd[1]);
-        execlp(
-                WORKSPACE_MONITOR_EXECUTABLE,
-                WORKSPACE_MONITOR_EXECUTABLE,
-                config_entry_info->stringified_json_workspace_information,
-                (char *) NULL
-        );
+        close(control_fds[0]);
+
+        // The daemon supervises the monitor through a pidfd, which only the monitor itself can open without racing
+        //  against the reuse of its PID. It precedes all control messages. Without pidfd support, the byte that
+        //  carries the descriptor is sent on its own.
+        const int pidfd = (int) syscall(SYS_pidfd_open, getpid(), 0);
+        if (pidfd == -1) {
+            const char no_pidfd = 0;
+            write(control_fds[1], &no_pidfd, sizeof(no_pidfd));
+        } else {
+            send_file_descriptor(control_fds[1], pidfd);
+            close(pidfd);
+        }
+
+        // The workspace information is close-on-exec in the daemon, but must be inherited by the monitor
+        fcntl(ws_info_fd, F_SETFD, 0);
+
+        char *ws_info_fd_arg = format_string("%d", ws_info_fd);
+        char *control_fd_arg = format_string("%d", control_fds[1]);
+        if (handoff == NULL) {
+            execl(
+                    workspace_monitor_path,
+                    WORKSPACE_MONITOR_EXECUTABLE,
+                    ws_info_fd_arg,
+                    control_fd_arg,
+                    (char *) NULL
+            );
+        } else {
+            // The handed over descriptors are close-on-exec in the daemon, but must be inherited by the successor
+            fcntl(handoff->inotify_fd, F_SETFD, 0);
+            fcntl(handoff->snapshot_fd, F_SETFD, 0);
+
+            execl(
+                    workspace_monitor_path,
+                    WORKSPACE_MONITOR_EXECUTABLE,
+                    ws_info_fd_arg,
+                    control_fd_arg,
+                    format_string("%d", handoff->inotify_fd),
+                    format_string("%d", handoff->snapshot_fd),
+                    (char *) NULL
+            );
+        }
 
         LOG_ERROR(
-                "'execlp' failed for workspace '%s': %s\n",
+                "'execl' failed for workspace '%s': %s\n",
                 config_entry_info->workspace_information->local_workspace_root_path,
                 strerror(errno)
         );
-        fatal_error("execlp");
+        fatal_error("execl");
     }
 
+    close(ws_info_fd);
     close(pipe_fd[1]);
-    read(pipe_fd[0], &grandchild_pid, sizeof(grandchild_pid));
-    close(pipe_fd[0]);
+    close(control_fds[1]);
+
+    pending_start->config_entry_info = config_entry_info;
+    pending_start->intermediate_pid = intermediate_pid;
+    pending_start->pid_pipe_fd = pipe_fd[0];
+    pending_start->control_fd = control_fds[0];
+    pending_start->needs_initial_sync = (handoff == NULL);
+    return true;
+}
+
+/*
+ * Waits until the fd is readable or closed, which is not cut short by signals.
+ *
+ * @return false if that did not happen within the timeout
+ */
+static bool
+wait_until_readable(const int fd, const int timeout_sec)
+{
+    const time_t deadline = time(NULL) + timeout_sec;
+    struct pollfd poll_fd = {.fd = fd, .events = POLLIN};
+
+    while (true) {
+        const int remaining_ms = (int) (deadline - time(NULL)) * 1000;
+        if (remaining_ms <= 0) {
+            return false;
+        }
+
+        const int res = poll(&poll_fd, 1, remaining_ms);
+        if (res > 0) {
+            return true;
+        } else if (res == -1 && errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+static bool
+complete_workspace_monitor_start(PendingMonitorStart *pending_start, char **error_msg)
+{
+    const WorkspaceInformation *ws_info = pending_start->config_entry_info->workspace_information;
+    pid_t grandchild_pid;
+
+    const bool received_pid = read_all(pending_start->pid_pipe_fd, &grandchild_pid, sizeof(grandchild_pid)) == 1;
+    close(pending_start->pid_pipe_fd);
 
     // Wait for the intermediate child process to terminate and, if successful, store the grandchild PID
     int status;
-    waitpid(intermediate_pid, &status, 0);
+    waitpid(pending_start->intermediate_pid, &status, 0);
 
-    if (!WIFEXITED(status)) {
+    if (!WIFEXITED(status) || !received_pid) {
+        close(pending_start->control_fd);
         SET_ERROR_MSG_RAW(
                 error_msg,
                 format_string(
                         "Creating the fs monitoring & syncing process for workspace '%s' failed: %s",
-                        config_entry_info->workspace_information->local_workspace_root_path,
+                        ws_info->local_workspace_root_path,
                         strerror(errno)
                 )
         );
         return false;
     }
 
-    char *ws_path = resync_strdup(config_entry_info->workspace_information->local_workspace_root_path);
+    // The monitor passes its pidfd right after it was forked, so a monitor that does not is stuck and replaced
+    if (!wait_until_readable(pending_start->control_fd, MONITOR_START_TIMEOUT_SEC)) {
+        kill(grandchild_pid, SIGKILL);
+        close(pending_start->control_fd);
+        SET_ERROR_MSG_RAW(
+                error_msg,
+                format_string(
+                        "The fs monitoring & syncing process for workspace '%s' did not start in time",
+                        ws_info->local_workspace_root_path
+                )
+        );
+        return false;
+    }
+
+    char *ws_path = resync_strdup(ws_info->local_workspace_root_path);
     WorkspaceProcessInfo *new_entry = (WorkspaceProcessInfo *) do_calloc(1, sizeof(WorkspaceProcessInfo));
     new_entry->ws_path = ws_path;
     new_entry->process_pid = grandchild_pid;
+    new_entry->control_fd = pending_start->control_fd;
+    // If the monitor terminated before it passed its pidfd, its closed control channel is noticed instead
+    new_entry->pidfd = receive_file_descriptor(pending_start->control_fd);
+    new_entry->initial_sync_pending = pending_start->needs_initial_sync;
+    new_entry->sync_weight = ws_info->sync_weight;
 
     HASH_ADD_STR(ws_to_process_map, ws_path, new_entry);
+    record_monitor_start(monitor_supervisor, ws_path);
+    register_ssh_pool_workspace(ssh_pool, ws_info);
+
+    if (pending_start->needs_initial_sync) {
+        request_initial_sync_admission(admission_controller, ws_info);
+    }
+
     return true;
 }
 
+static bool
+start_workspace_monitor(const ConfigFileEntryData *config_entry_info, const WatchStateHandoff *handoff, char **error_msg)
+{
+    PendingMonitorStart pending_start;
+    if (!spawn_workspace_monitor(config_entry_info, handoff, &pending_start, error_msg)) {
+        return false;
+    }
+
+    return complete_workspace_monitor_start(&pending_start, error_msg);
+}
+
+/*
+ * Schedules the restart of a workspace monitor that could not be started, like that of a crashed one.
+ */
+static void
+schedule_failed_monitor_restart(const char *ws_path, const char *error_msg)
+{
+    const int restart_delay_ms = record_monitor_crash(monitor_supervisor, ws_path);
+    LOG_ERROR("Unable to start the monitor of workspace '%s', retrying in %d ms: %s", ws_path, restart_delay_ms, error_msg);
+}
+
+static void
+remove_workspace_process_info(WorkspaceProcessInfo *process_information)
+{
+    HASH_DEL(ws_to_process_map, process_information);
+    release_initial_sync_admission(admission_controller, process_information->ws_path);
+    release_all_sync_leases(sync_governor, process_information->ws_path);
+    if (process_information->control_fd != -1) {
+        close(process_information->control_fd);
+    }
+    if (process_information->pidfd != -1) {
+        close(process_information->pidfd);
+    }
+    DO_FREE(process_information->ws_path);
+    DO_FREE(process_information);
+}
+
 static bool
 terminate_fs_monitoring_process(const char *ws_path, char **error_msg)
 {
@@ -147,7 +464,8 @@ terminate_fs_monitoring_process(const char *ws_path, char **error_msg)
         return false;
     }
 
-    if (kill(process_information->process_pid, SIGTERM) == -1) {
+    // A monitor that already terminated, but whose termination was not handled yet, is removed nonetheless
+    if (kill(process_information->process_pid, SIGTERM) == -1 && errno != ESRCH) {
         SET_ERROR_MSG_RAW(
                 error_msg,
                 format_string(
@@ -160,11 +478,380 @@ terminate_fs_monitoring_process(const char *ws_path, char **error_msg)
         return false;
     }
 
-    HASH_DEL(ws_to_process_map, process_information);
+    remove_workspace_process_info(process_information);
 
     return true;
 }
 
+/*
+ * Handles a message that a workspace monitor sent on its own initiative.
+ */
+static void
+handle_monitor_message(WorkspaceProcessInfo *process_information, MonitorControlMessage *message)
+{
+    switch (message->type) {
+        case MONITOR_INITIAL_SYNC_DONE:
+            process_information->initial_sync_pending = false;
+            release_initial_sync_admission(admission_controller, process_information->ws_path);
+            break;
+        case MONITOR_SYNC_LEASE_REQUEST:
+            request_sync_lease(sync_governor, process_information->ws_path, process_information->sync_weight, message->payload);
+            break;
+        case MONITOR_SYNC_LEASE_RELEASE:
+            release_sync_lease(sync_governor, process_information->ws_path, message->payload);
+            break;
+        case OTHER_MONITOR_CONTROL_MESSAGE_TYPE:
+        default:
+            LOG_ERROR(
+                    "Received unexpected control message of type '%d' from the monitor of workspace '%s'",
+                    message->type,
+                    process_information->ws_path
+            );
+            break;
+    }
+
+    destroy_monitor_control_message(&message);
+}
+
+/*
+ * Handles the unexpected termination of a workspace monitor by scheduling its restart.
+ */
+static void
+handle_workspace_monitor_exit(WorkspaceProcessInfo *process_information)
+{
+    char *ws_path = resync_strdup(process_information->ws_path);
+    remove_workspace_process_info(process_information);
+
+    const int restart_delay_ms = record_monitor_crash(monitor_supervisor, ws_path);
+    LOG_ERROR("Monitor of workspace '%s' terminated unexpectedly, restarting it in %d ms", ws_path, restart_delay_ms);
+
+    DO_FREE(ws_path);
+}
+
+static void
+handle_workspace_monitor_readable(WorkspaceProcessInfo *process_information)
+{
+    char *error_msg = NULL;
+
+    MonitorControlMessage *message = receive_monitor_control_message(process_information->control_fd, &error_msg);
+    if (message == NULL) {
+        LOG_ERROR(
+                "Lost the control channel to the monitor of workspace '%s': %s",
+                process_information->ws_path,
+                error_msg == NULL ? "Monitor terminated" : error_msg
+        );
+        DO_FREE(error_msg);
+
+        if (process_information->pidfd == -1) {
+            handle_workspace_monitor_exit(process_information);
+            return;
+        }
+
+        // The termination of the monitor itself is noticed through its pidfd
+        close(process_information->control_fd);
+        process_information->control_fd = -1;
+        return;
+    }
+
+    handle_monitor_message(process_information, message);
+}
+
+/*
+ * Handles a readable pollfd of a workspace monitor, which is either its control channel or its pidfd.
+ */
+static void
+handle_workspace_monitor_poll_event(WorkspaceProcessInfo *process_information, const struct pollfd *poll_fd)
+{
+    if (!(poll_fd->revents & (POLLIN | POLLHUP | POLLERR))) {
+        return;
+    }
+
+    if (poll_fd->fd == process_information->pidfd) {
+        handle_workspace_monitor_exit(process_information);
+    } else {
+        handle_workspace_monitor_readable(process_information);
+    }
+}
+
+static void
+restart_crashed_workspace_monitor(const char *ws_path, void *context)
+{
+    char *error_msg = NULL;
+
+    WorkspaceProcessInfo *process_information;
+    HASH_FIND_STR(ws_to_process_map, ws_path, process_information);
+    if (process_information != NULL) {
+        // The monitor was started again in the meantime, e.g. because a remote system was added
+        record_monitor_start(monitor_supervisor, ws_path);
+        return;
+    }
+
+    // The configuration file reflects all changes of the workspace since its monitor was started
+    ConfigFileEntryData *config_file_entries = NULL;
+    if (!parse_configuration_file(&config_file_entries, &error_msg)) {
+        const int restart_delay_ms = record_monitor_crash(monitor_supervisor, ws_path);
+        LOG_ERROR("Unable to restart the monitor of workspace '%s', retrying in %d ms: %s", ws_path, restart_delay_ms, error_msg);
+        DO_FREE(error_msg);
+        return;
+    }
+
+    ConfigFileEntryData *entry;
+    LL_FOREACH(config_file_entries, entry) {
+        if (is_equal(entry->workspace_information->local_workspace_root_path, ws_path)) {
+            break;
+        }
+    }
+
+    if (entry == NULL) {
+        LOG("Workspace '%s' is no longer managed by reSync, not restarting its monitor", ws_path);
+        forget_supervised_monitor(monitor_supervisor, ws_path);
+    } else if (!start_workspace_monitor(entry, NULL, &error_msg)) {
+        schedule_failed_monitor_restart(ws_path, error_msg);
+        DO_FREE(error_msg);
+    }
+
+    destroy_config_file_entries(&config_file_entries);
+}
+
+static void
+grant_sync_lease(const char *ws_path, const char *host, void *context)
+{
+    char *error_msg = NULL;
+
+    WorkspaceProcessInfo *process_information;
+    HASH_FIND_STR(ws_to_process_map, ws_path, process_information);
+    if (process_information == NULL) {
+        return;
+    }
+
+    // If the monitor is gone, the closed control channel is noticed by the event loop, which releases the lease
+    if (!send_monitor_control_message(process_information->control_fd, MONITOR_SYNC_LEASE_GRANT, host, strlen(host), &error_msg)) {
+        LOG_ERROR("Unable to grant a sync lease for host '%s' to workspace '%s': %s", host, ws_path, error_msg);
+        DO_FREE(error_msg);
+    }
+}
+
+static void
+grant_initial_sync(const char *ws_path, void *context)
+{
+    char *error_msg = NULL;
+
+    WorkspaceProcessInfo *process_information;
+    HASH_FIND_STR(ws_to_process_map, ws_path, process_information);
+    if (process_information == NULL) {
+        return;
+    }
+
+    // If the monitor is gone, the closed control channel is noticed by the event loop, which releases the admission
+    if (!send_monitor_control_message(process_information->control_fd, MONITOR_INITIAL_SYNC_GRANT, NULL, 0, &error_msg)) {
+        LOG_ERROR("Unable to admit the initial sync of workspace '%s': %s", ws_path, error_msg);
+        DO_FREE(error_msg);
+    }
+}
+
+/*
+ * Hands out initial sync admissions and sync leases that became available.
+ *
+ * @return the timeout in milliseconds after which this function has to be called again, or -1 if it only has to be
+ *  called again after a message of a workspace monitor was handled
+ */
+static int
+dispatch_grants(void)
+{
+    dispatch_sync_leases(sync_governor, grant_sync_lease, NULL);
+    return dispatch_initial_sync_admissions(admission_controller, grant_initial_sync, NULL);
+}
+
+/*
+ * Collects the control channels and pidfds of all workspace monitors for polling. The first entry is reserved for
+ *  'first_fd'. The control channel of a monitor precedes its pidfd, so that its last messages are handled before its
+ *  termination.
+ *
+ * @return the number of collected file descriptors, including 'first_fd'
+ */
+static unsigned int
+collect_poll_fds(const int first_fd, struct pollfd **poll_fds, WorkspaceProcessInfo ***polled_monitors)
+{
+    const unsigned int monitors_count = HASH_COUNT(ws_to_process_map);
+    *poll_fds = (struct pollfd *) do_calloc(2 * monitors_count + 1, sizeof(struct pollfd));
+    *polled_monitors = (WorkspaceProcessInfo **) do_calloc(2 * monitors_count + 1, sizeof(WorkspaceProcessInfo *));
+
+    (*poll_fds)[0].fd = first_fd;
+    (*poll_fds)[0].events = POLLIN;
+
+    unsigned int index = 1;
+    WorkspaceProcessInfo *entry, *tmp;
+    HASH_ITER(hh, ws_to_process_map, entry, tmp) {
+        (*poll_fds)[index].fd = entry->control_fd;
+        (*poll_fds)[index].events = POLLIN;
+        (*polled_monitors)[index] = entry;
+        index++;
+
+        if (entry->pidfd != -1) {
+            (*poll_fds)[index].fd = entry->pidfd;
+            (*poll_fds)[index].events = POLLIN;
+            (*polled_monitors)[index] = entry;
+            index++;
+        }
+    }
+
+    return index;
+}
+
+/*
+ * Waits until the monitor sends a message of the given type. Messages of all monitors are handled in the meantime, as
+ *  the monitor might first have to finish a sync, which in turn waits for a lease held by another monitor.
+ */
+static MonitorControlMessage *
+wait_for_monitor_message(WorkspaceProcessInfo *process_information, const MonitorControlMessageType type,
+                         const int timeout_sec, char **error_msg)
+{
+    const time_t deadline = time(NULL) + timeout_sec;
+    const int control_fd = process_information->control_fd;
+
+    while (true) {
+        const int remaining_ms = (int) (deadline - time(NULL)) * 1000;
+        if (remaining_ms <= 0) {
+            SET_ERROR_MSG(error_msg, "Workspace monitor did not reply in time");
+            return NULL;
+        }
+
+        int poll_timeout_ms = dispatch_grants();
+        if (poll_timeout_ms == -1 || poll_timeout_ms > remaining_ms) {
+            poll_timeout_ms = remaining_ms;
+        }
+
+        struct pollfd *poll_fds;
+        WorkspaceProcessInfo **polled_monitors;
+        const unsigned int poll_fds_count = collect_poll_fds(-1, &poll_fds, &polled_monitors);
+
+        if (poll(poll_fds, poll_fds_count, poll_timeout_ms) == -1 && errno != EINTR) {
+            SET_ERROR_MSG_RAW(error_msg, format_string("Waiting for the workspace monitor failed: %s", strerror(errno)));
+            DO_FREE(poll_fds);
+            DO_FREE(polled_monitors);
+            return NULL;
+        }
+
+        MonitorControlMessage *reply = NULL;
+        bool is_channel_closed = false;
+
+        for (unsigned int index = 1; index < poll_fds_count; index++) {
+            if (polled_monitors[index] != process_information) {
+                handle_workspace_monitor_poll_event(polled_monitors[index], &poll_fds[index]);
+                continue;
+            }
+
+            // The termination of the monitor itself is noticed through its closed control channel and left to the caller
+            if (poll_fds[index].fd != control_fd || !(poll_fds[index].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+
+            MonitorControlMessage *message = receive_monitor_control_message(control_fd, error_msg);
+            if (message == NULL) {
+                is_channel_closed = true;
+            } else if (message->type == type) {
+                reply = message;
+            } else {
+                handle_monitor_message(process_information, message);
+            }
+        }
+
+        DO_FREE(poll_fds);
+        DO_FREE(polled_monitors);
+
+        if (reply != NULL) {
+            return reply;
+        }
+
+        if (is_channel_closed) {
+            if (error_msg != NULL && *error_msg == NULL) {
+                SET_ERROR_MSG(error_msg, "Workspace monitor closed the control channel");
+            }
+            return NULL;
+        }
+    }
+}
+
+/*
+ * Asks the workspace's monitor to hand over its inotify instance and watch tables. On success, the monitor terminates
+ *  by itself and is no longer tracked by the daemon.
+ */
+static bool
+request_watch_state_handoff(const char *ws_path, WatchStateHandoff *handoff, char **error_msg)
+{
+    WorkspaceProcessInfo *process_information;
+    HASH_FIND_STR(ws_to_process_map, ws_path, process_information);
+    if (process_information == NULL) {
+        SET_ERROR_MSG(error_msg, "There is currently no process running that monitors and synchronizes the workspace");
+        return false;
+    }
+
+    // A monitor that did not finish its initial sync yet handles the request only afterwards, which in turn may depend
+    //  on the daemon admitting the initial sync. Restarting it from scratch does not lose anything in that case.
+    if (process_information->initial_sync_pending) {
+        SET_ERROR_MSG(error_msg, "The workspace monitor did not finish its initial sync yet");
+        return false;
+    }
+
+    const int control_fd = process_information->control_fd;
+
+    if (!send_monitor_control_message(control_fd, MONITOR_HANDOFF_REQUEST, NULL, 0, error_msg)) {
+        return false;
+    }
+
+    MonitorControlMessage *message = wait_for_monitor_message(
+            process_information,
+            MONITOR_HANDOFF_STATE,
+            HANDOFF_TIMEOUT_SEC,
+            error_msg
+    );
+
+    if (message == NULL) {
+        return false;
+    }
+
+    // The inotify instance directly follows the watch state
+    set_socket_timeout(control_fd, DEFAULT_RCV_TIMEOUT_SEC, DEFAULT_RCV_TIMEOUT_USEC);
+
+    handoff->inotify_fd = receive_file_descriptor(control_fd);
+    if (handoff->inotify_fd == -1) {
+        SET_ERROR_MSG(error_msg, "Workspace monitor did not pass its inotify instance");
+        destroy_monitor_control_message(&message);
+        set_socket_timeout(control_fd, 0, 0);
+        return false;
+    }
+
+    // The snapshot is passed as an anonymous in-memory file, so that its size is not limited by pipe buffers or ARG_MAX
+    handoff->snapshot_fd = memfd_create("reSync-watch-state", MFD_CLOEXEC);
+    if (handoff->snapshot_fd == -1 || !write_all(handoff->snapshot_fd, message->payload, message->payload_size)) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to store the handed over watch state: %s", strerror(errno)));
+        if (handoff->snapshot_fd != -1) {
+            close(handoff->snapshot_fd);
+        }
+        close(handoff->inotify_fd);
+        destroy_monitor_control_message(&message);
+        set_socket_timeout(control_fd, 0, 0);
+        return false;
+    }
+
+    destroy_monitor_control_message(&message);
+    remove_workspace_process_info(process_information);
+    return true;
+}
+
+static bool
+send_to_workspace_monitor(const char *ws_path, const MonitorControlMessageType type, const ByteBuffer *payload, char **error_msg)
+{
+    WorkspaceProcessInfo *process_information;
+    HASH_FIND_STR(ws_to_process_map, ws_path, process_information);
+    if (process_information == NULL) {
+        SET_ERROR_MSG(error_msg, "There is currently no process running that monitors and synchronizes the workspace");
+        return false;
+    }
+
+    return send_monitor_control_message(process_information->control_fd, type, payload->data, payload->size, error_msg);
+}
+
 static bool
 terminate_all_workspace_processes(char **error_msg)
 {
@@ -182,17 +869,25 @@ terminate_all_workspace_processes(char **error_msg)
     return res;
 }
 
+/*
+ * Terminates the workspace's monitor, if there is one, and starts a new one that walks the directory tree again.
+ */
 static bool
-restart_workspace_process(const ConfigFileEntryData *entry, char **error_msg)
+restart_workspace_process_from_scratch(const ConfigFileEntryData *entry, char **error_msg)
 {
     bool res;
 
-    res = terminate_fs_monitoring_process(entry->workspace_information->local_workspace_root_path, error_msg);
-    if (res == false) {
-        return false;
+    // The monitor may have crashed and be waiting for its restart, which is then performed right away
+    WorkspaceProcessInfo *process_information;
+    HASH_FIND_STR(ws_to_process_map, entry->workspace_information->local_workspace_root_path, process_information);
+    if (process_information != NULL) {
+        res = terminate_fs_monitoring_process(entry->workspace_information->local_workspace_root_path, error_msg);
+        if (res == false) {
+            return false;
+        }
     }
 
-    res = start_workspace_monitor(entry, error_msg);
+    res = start_workspace_monitor(entry, NULL, error_msg);
     if (res == false) {
         return false;
     }
@@ -200,24 +895,131 @@ restart_workspace_process(const ConfigFileEntryData *entry, char **error_msg)
     return true;
 }
 
+/*
+ * Replaces the workspace's running monitor by one that takes over its watch state, so that neither the directory tree
+ *  has to be walked again nor any event that happens during the restart gets lost. Falls back to restarting the
+ *  monitor from scratch.
+ */
 static bool
-start_workspace_monitors(ConfigFileEntryData *workspace_config_entries)
+restart_workspace_process(const ConfigFileEntryData *entry, char **error_msg)
 {
     bool res;
+    char *handoff_error_msg = NULL;
+    WatchStateHandoff handoff;
+
+    res = request_watch_state_handoff(entry->workspace_information->local_workspace_root_path, &handoff, &handoff_error_msg);
+    if (res == true) {
+        res = start_workspace_monitor(entry, &handoff, error_msg);
+        close(handoff.inotify_fd);
+        close(handoff.snapshot_fd);
+        return res;
+    }
+
+    LOG_ERROR("Watch state handoff failed, restarting the workspace monitor from scratch: %s", handoff_error_msg);
+    DO_FREE(handoff_error_msg);
+
+    return restart_workspace_process_from_scratch(entry, error_msg);
+}
+
+/*
+ * Restarts all running workspace monitors with the current configuration, see 'restart_workspace_process'. Monitors
+ *  that are waiting for their restart after a crash are left to the supervisor.
+ */
+static void
+reload_all_workspace_monitors(void)
+{
+    char *error_msg = NULL;
+    ConfigFileEntryData *config_file_entries = NULL;
+
+    if (!parse_configuration_file(&config_file_entries, &error_msg)) {
+        LOG_ERROR("Unable to reload the workspace monitors: %s", error_msg);
+        DO_FREE(error_msg);
+        return;
+    }
+
+    ConfigFileEntryData *entry;
+    LL_FOREACH(config_file_entries, entry) {
+        const char *ws_path = entry->workspace_information->local_workspace_root_path;
+
+        WorkspaceProcessInfo *process_information;
+        HASH_FIND_STR(ws_to_process_map, ws_path, process_information);
+        if (process_information == NULL) {
+            continue;
+        }
+
+        LOG("Reloading the monitor of workspace '%s'", ws_path);
+        if (!restart_workspace_process(entry, &error_msg)) {
+            schedule_failed_monitor_restart(ws_path, error_msg);
+            DO_FREE(error_msg);
+        }
+    }
+
+    destroy_config_file_entries(&config_file_entries);
+}
+
+/*
+ * Completes the start of a spawned workspace monitor, or schedules its restart if it failed.
+ */
+static bool
+collect_pending_monitor_start(PendingMonitorStart *pending_start)
+{
+    char *error_msg = NULL;
+
+    if (complete_workspace_monitor_start(pending_start, &error_msg)) {
+        return true;
+    }
+
+    schedule_failed_monitor_restart(
+            pending_start->config_entry_info->workspace_information->local_workspace_root_path,
+            error_msg
+    );
+    DO_FREE(error_msg);
+    return false;
+}
+
+static bool
+start_workspace_monitors(ConfigFileEntryData *workspace_config_entries)
+{
     char *error_msg = NULL;
     int successful_starts_counter = 0;
 
+    // Up to 'startup_concurrency' monitors are spawned before the PID of the oldest spawned monitor is collected
+    const int window_size = daemon_options.startup_concurrency;
+    PendingMonitorStart *pending_starts = (PendingMonitorStart *) do_calloc(window_size, sizeof(PendingMonitorStart));
+    int oldest_pending_index = 0;
+    int pending_counter = 0;
+
     ConfigFileEntryData *entry;
     LL_FOREACH(workspace_config_entries, entry) {
-        res = start_workspace_monitor(entry, &error_msg);
-        if (res == false) {
-            LOG_ERROR("%s\n", error_msg);
+        if (pending_counter == window_size) {
+            if (collect_pending_monitor_start(&pending_starts[oldest_pending_index])) {
+                successful_starts_counter++;
+            }
+
+            oldest_pending_index = (oldest_pending_index + 1) % window_size;
+            pending_counter--;
+        }
+
+        PendingMonitorStart *slot = &pending_starts[(oldest_pending_index + pending_counter) % window_size];
+        if (!spawn_workspace_monitor(entry, NULL, slot, &error_msg)) {
+            schedule_failed_monitor_restart(entry->workspace_information->local_workspace_root_path, error_msg);
+            DO_FREE(error_msg);
             continue;
         }
 
-        successful_starts_counter++;
+        pending_counter++;
+    }
+
+    for (; pending_counter > 0; pending_counter--) {
+        if (collect_pending_monitor_start(&pending_starts[oldest_pending_index])) {
+            successful_starts_counter++;
+        }
+
+        oldest_pending_index = (oldest_pending_index + 1) % window_size;
     }
 
+    DO_FREE(pending_starts);
+
     if (workspace_config_entries != NULL && successful_starts_counter == 0) {
         return false;
     }
@@ -246,11 +1048,13 @@ handle_add_workspace_request(const ResyncServerCommand *command, char **error_ms
         return false;
     }
 
-    result = start_workspace_monitor(config_entry, error_msg);
+    result = start_workspace_monitor(config_entry, NULL, error_msg);
     if (result == false) {
+        schedule_failed_monitor_restart(config_entry->workspace_information->local_workspace_root_path, *error_msg);
         SET_ERROR_MSG_WITH_CAUSE(
                 error_msg,
-                "Workspace was added to the config file, but starting a fs monitoring & syncing process failed",
+                "Workspace was added to the config file, but starting a fs monitoring & syncing process failed, it is "
+                "retried in the background",
                 error_msg
         );
         return false;
@@ -264,7 +1068,7 @@ handle_add_remote_system_request(const ResyncServerCommand *command, char **erro
 {
     /*
      * Adds a new remote system definition to a workspaces' entry in the reSync configuration file and subsequently
-     *  restarts the workspaces' fs monitoring process to also propagate changes to the newly added remote system.
+     *  tells the workspaces' fs monitoring process to also propagate changes to the newly added remote system.
      */
 
     bool result;
@@ -280,12 +1084,37 @@ handle_add_remote_system_request(const ResyncServerCommand *command, char **erro
         return false;
     }
 
-    result = restart_workspace_process(config_entry, error_msg);
+    register_ssh_pool_workspace(ssh_pool, config_entry->workspace_information);
+
+    // Hand the new remote system to the running monitor, so that only the new remote system has to be synced initially
+    ByteBuffer *payload = remoteWorkspaceMetadata_to_binary(command->command_metadata.workspace_information->remote_systems, NULL);
+
+    if (payload != NULL) {
+        char *send_error_msg = NULL;
+        result = send_to_workspace_monitor(
+                config_entry->workspace_information->local_workspace_root_path,
+                MONITOR_ADD_REMOTE_SYSTEM,
+                payload,
+                &send_error_msg
+        );
+        destroy_byte_buffer(&payload);
+
+        if (result == true) {
+            return true;
+        }
+
+        LOG_ERROR("Unable to hand the new remote system to the running monitor, restarting it: %s", send_error_msg);
+        DO_FREE(send_error_msg);
+    }
+
+    // A handoff would go through the same control channel, so the monitor is restarted from scratch instead
+    result = restart_workspace_process_from_scratch(config_entry, error_msg);
     if (result == false) {
+        schedule_failed_monitor_restart(config_entry->workspace_information->local_workspace_root_path, *error_msg);
         SET_ERROR_MSG_WITH_CAUSE(
                 error_msg,
                 "Remote system was successfully added to the workspaces' config file entry, but restarting the "
-                "process that monitors and synchronizes the workspace failed",
+                "process that monitors and synchronizes the workspace failed, it is retried in the background",
                 error_msg
         );
         return false;
@@ -309,7 +1138,11 @@ handle_remove_workspace_request(const ResyncServerCommand *command, char **error
         return false;
     }
 
-    result = terminate_fs_monitoring_process(command->command_metadata.workspace_information->local_workspace_root_path, error_msg);
+    // The workspace is no longer managed by reSync, so its monitor must not be restarted if it crashed before
+    forget_supervised_monitor(monitor_supervisor, command->command_metadata.local_workspace_root_path);
+    unregister_ssh_pool_workspace(ssh_pool, command->command_metadata.local_workspace_root_path);
+
+    result = terminate_fs_monitoring_process(command->command_metadata.local_workspace_root_path, error_msg);
     if (result == false) {
         SET_ERROR_MSG_WITH_CAUSE(
                 error_msg,
@@ -328,7 +1161,8 @@ handle_remove_remote_system_request(const ResyncServerCommand *command, char **e
 {
     /*
      * Remove a remote system definition from the array of remote systems specified for a workspace. Furthermore, the
-     * processes responsible for monitoring and synchronizing the workspace is restarted.
+     * processes responsible for monitoring and synchronizing the workspace is told to stop syncing with the remote
+     * system. Only if that fails, the process is restarted.
      */
 
     bool result;
@@ -344,12 +1178,37 @@ handle_remove_remote_system_request(const ResyncServerCommand *command, char **e
         return false;
     }
 
-    result = restart_workspace_process(config_entry, error_msg);
+    register_ssh_pool_workspace(ssh_pool, config_entry->workspace_information);
+
+    ByteBuffer *payload = removeRemoteSystemMetadata_to_binary(command->command_metadata.rm_remote_system_md, NULL);
+
+    if (payload != NULL) {
+        char *send_error_msg = NULL;
+        result = send_to_workspace_monitor(
+                command->command_metadata.rm_remote_system_md->local_workspace_root_path,
+                MONITOR_REMOVE_REMOTE_SYSTEM,
+                payload,
+                &send_error_msg
+        );
+        destroy_byte_buffer(&payload);
+
+        if (result == true) {
+            return true;
+        }
+
+        LOG_ERROR("Unable to remove the remote system from the running monitor, restarting it: %s", send_error_msg);
+        DO_FREE(send_error_msg);
+    }
+
+    // A handoff would go through the same control channel, so the monitor is restarted from scratch instead
+    result = restart_workspace_process_from_scratch(config_entry, error_msg);
     if (result == false) {
+        schedule_failed_monitor_restart(config_entry->workspace_information->local_workspace_root_path, *error_msg);
         SET_ERROR_MSG_WITH_CAUSE(
                 error_msg,
                 "Removing the remote system from the workspaces' array of remote systems succeeded, but restarting the "
-                "process responsible for monitoring and synchronizing the workspace failed",
+                "process responsible for monitoring and synchronizing the workspace failed, it is retried in the "
+                "background",
                 error_msg
         );
         return false;
@@ -391,84 +1250,154 @@ handle_request(const char *cmd_buffer, char **error_msg)
     return command_handling_result;
 }
 
-static void
-server_loop(void)
+/*
+ * Reads and handles a single command of a client.
+ *
+ * @return false if reading the command failed in a way that the daemon should not continue accepting commands
+ */
+static bool
+handle_client_connection(const int client_fd)
 {
-    const int command_server_socket = create_unix_server_socket(DEFAULT_RESYNC_DAEMON_SOCKET_PATH);
+    // Specify a client socket timeout to prevent infinite waits if invalid input is provided
+    set_socket_timeout(client_fd, DEFAULT_RCV_TIMEOUT_SEC, DEFAULT_RCV_TIMEOUT_USEC);
 
-    while (!terminate_daemon) {
+    ssize_t bytes_received;
+    ssize_t received_cmd_buffer_chunks = 0;
+    char *command_buffer = NULL;
+    char buffer[COMMAND_BUFFER_CHUNK_SIZE];
 
-        int client_fd = accept(command_server_socket, NULL, NULL);
-        if (client_fd == -1) {
+    // '..chunk_size - 1 ' to ensure that the buffer is always 0 terminated by the memset operation
+    while ((bytes_received = recv(client_fd, buffer, COMMAND_BUFFER_CHUNK_SIZE-1, 0)) > 0) {
+        received_cmd_buffer_chunks++;
+
+        command_buffer = (char *) realloc(command_buffer, received_cmd_buffer_chunks * COMMAND_BUFFER_CHUNK_SIZE);
+        if (command_buffer == NULL) {
             unlink(DEFAULT_RESYNC_DAEMON_SOCKET_PATH);
-            fatal_error("accept");
+            fatal_error("realloc");
         }
 
-        // Specify a client socket timeout to prevent infinite waits if invalid input is provided
-        set_socket_timeout(client_fd, DEFAULT_RCV_TIMEOUT_SEC, DEFAULT_RCV_TIMEOUT_USEC);
+        const ssize_t offset = COMMAND_BUFFER_CHUNK_SIZE * (received_cmd_buffer_chunks - 1);
+        memset(command_buffer + offset, '\0', COMMAND_BUFFER_CHUNK_SIZE);
+        strncat(command_buffer, buffer, bytes_received);
 
-        ssize_t bytes_received;
-        ssize_t received_cmd_buffer_chunks = 0;
-        char *command_buffer = NULL;
-        char buffer[COMMAND_BUFFER_CHUNK_SIZE];
+        if (strncmp(buffer + (bytes_received-2), "\r\n", 2) == 0) {
+            break;
+        }
+    }
 
-        // '..chunk_size - 1 ' to ensure that the buffer is always 0 terminated by the memset operation
-        while ((bytes_received = recv(client_fd, buffer, COMMAND_BUFFER_CHUNK_SIZE-1, 0)) > 0) {
-            received_cmd_buffer_chunks++;
+    if (bytes_received < 0) {
+        DO_FREE(command_buffer);
 
-            command_buffer = (char *) realloc(command_buffer, received_cmd_buffer_chunks * COMMAND_BUFFER_CHUNK_SIZE);
-            if (command_buffer == NULL) {
-                unlink(DEFAULT_RESYNC_DAEMON_SOCKET_PATH);
-                fatal_error("realloc");
-            }
+        char *response_msg;
 
-            const ssize_t offset = COMMAND_BUFFER_CHUNK_SIZE * (received_cmd_buffer_chunks - 1);
-            memset(command_buffer + offset, '\0', COMMAND_BUFFER_CHUNK_SIZE);
-            strncat(command_buffer, buffer, bytes_received);
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            response_msg = "Connection closed as daemon did not receive a valid/complete request in a timely manner!\n";
+            write(client_fd, response_msg, strlen(response_msg));
+            close(client_fd);
+            return true;
+        }
 
-            if (strncmp(buffer + (bytes_received-2), "\r\n", 2) == 0) {
-                break;
-            }
+        response_msg = "An error occurred while reading the command from the client!\n";
+        write(client_fd, response_msg, strlen(response_msg));
+        close(client_fd);
+        return false;
+    }
+
+    char *error_msg = NULL;
+    bool res = handle_request(command_buffer, &error_msg);
+
+    char *response_msg;
+    if (res == true) {
+        response_msg = resync_strdup("Successfully performed the requested operation!\n");
+    } else {
+        if (error_msg == NULL) {
+            response_msg = resync_strdup("An error occurred while processing the request!\n");
+        } else {
+            response_msg = format_string("%s\n", error_msg);
+            DO_FREE(error_msg);
+        }
+    }
+
+    write(client_fd, response_msg, strlen(response_msg));
+    DO_FREE(response_msg);
+
+    close(client_fd);
+    DO_FREE(command_buffer);
+    return true;
+}
+
+/*
+ * @return the earlier of both poll timeouts, where -1 stands for no timeout
+ */
+static int
+get_earlier_poll_timeout(const int timeout_ms, const int other_timeout_ms)
+{
+    if (timeout_ms == -1 || (other_timeout_ms != -1 && other_timeout_ms < timeout_ms)) {
+        return other_timeout_ms;
+    }
+
+    return timeout_ms;
+}
+
+/*
+ * Waits for commands of clients and for messages of the workspace monitors, and hands out initial sync admissions and
+ *  sync leases.
+ */
+static void
+server_loop(void)
+{
+    const int command_server_socket = create_unix_server_socket(DEFAULT_RESYNC_DAEMON_SOCKET_PATH);
+    fcntl(command_server_socket, F_SETFD, FD_CLOEXEC);
+
+    while (!terminate_daemon) {
+        if (reload_workspace_monitors) {
+            reload_workspace_monitors = 0;
+            reload_all_workspace_monitors();
         }
 
-        if (bytes_received < 0) {
-            DO_FREE(command_buffer);
+        // Restarted monitors wait for the admission of their initial sync, so restarts are performed before granting
+        const int restart_timeout_ms = dispatch_monitor_restarts(monitor_supervisor, restart_crashed_workspace_monitor, NULL);
 
-            char *response_msg;
+        int poll_timeout_ms = dispatch_grants();
+        poll_timeout_ms = get_earlier_poll_timeout(poll_timeout_ms, restart_timeout_ms);
+        poll_timeout_ms = get_earlier_poll_timeout(poll_timeout_ms, maintain_ssh_masters(ssh_pool));
 
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                response_msg = "Connection closed as daemon did not receive a valid/complete request in a timely manner!\n";
-                write(client_fd, response_msg, strlen(response_msg));
-                close(client_fd);
+        struct pollfd *poll_fds;
+        WorkspaceProcessInfo **polled_monitors;
+        const unsigned int poll_fds_count = collect_poll_fds(command_server_socket, &poll_fds, &polled_monitors);
+
+        if (poll(poll_fds, poll_fds_count, poll_timeout_ms) == -1) {
+            DO_FREE(poll_fds);
+            DO_FREE(polled_monitors);
+            if (errno == EINTR) {
                 continue;
             }
+            unlink(DEFAULT_RESYNC_DAEMON_SOCKET_PATH);
+            fatal_error("poll");
+        }
 
-            response_msg = "An error occurred while reading the command from the client!\n";
-            write(client_fd, response_msg, strlen(response_msg));
-            close(client_fd);
-            break;
+        // Monitor messages are handled first, as handling a command may start and terminate monitors
+        for (unsigned int index = 1; index < poll_fds_count; index++) {
+            handle_workspace_monitor_poll_event(polled_monitors[index], &poll_fds[index]);
         }
 
-        char *error_msg = NULL;
-        bool res = handle_request(command_buffer, &error_msg);
+        const bool has_client = (poll_fds[0].revents & POLLIN) != 0;
+        DO_FREE(poll_fds);
+        DO_FREE(polled_monitors);
 
-        char *response_msg;
-        if (res == true) {
-            response_msg = resync_strdup("Successfully performed the requested operation!\n");
-        } else {
-            if (error_msg == NULL) {
-                response_msg = resync_strdup("An error occurred while processing the request!\n");
-            } else {
-                response_msg = format_string("%s\n", error_msg);
-                DO_FREE(error_msg);
-            }
+        if (!has_client) {
+            continue;
         }
 
-        write(client_fd, response_msg, strlen(response_msg));
-        DO_FREE(response_msg);
+        int client_fd = accept(command_server_socket, NULL, NULL);
+        if (client_fd == -1) {
+            unlink(DEFAULT_RESYNC_DAEMON_SOCKET_PATH);
+            fatal_error("accept");
+        }
 
-        close(client_fd);
-        DO_FREE(command_buffer);
+        if (!handle_client_connection(client_fd)) {
+            break;
+        }
     }
 
     close(command_server_socket);
@@ -476,12 +1405,34 @@ server_loop(void)
 }
 
 int
-main(const int argc, const char **argv)
+main(const int argc, char **argv)
 {
     openlog("reSync", LOG_PERROR | LOG_PID, 0);
 
+    if (!parse_daemon_options(argc, argv, &daemon_options)) {
+        fatal_custom_error("Invalid options specified");
+    }
+
     install_signal_handlers();
 
+    admission_controller = create_admission_controller(
+            daemon_options.initial_syncs_per_host,
+            daemon_options.initial_sync_stagger_ms
+    );
+    sync_governor = create_sync_governor(daemon_options.max_concurrent_syncs, daemon_options.max_syncs_per_host);
+    monitor_supervisor = create_monitor_supervisor(
+            daemon_options.restart_backoff_ms,
+            daemon_options.max_restart_backoff_ms
+    );
+    // The masters are only connected once the daemon runs in the background, so that they are its children
+    ssh_pool = create_ssh_pool();
+
+    // Monitors are started from the background as well, where relative paths no longer resolve
+    workspace_monitor_path = realpath(WORKSPACE_MONITOR_EXECUTABLE, NULL);
+    if (workspace_monitor_path == NULL) {
+        fatal_custom_error("Unable to locate the workspace monitor '%s': %s", WORKSPACE_MONITOR_EXECUTABLE, strerror(errno));
+    }
+
     // Parse the configuration file and start a fs monitoring & syncing processes for each workspace defined in it.
     bool res;
     char *error_msg = NULL;
@@ -504,5 +1455,7 @@ main(const int argc, const char **argv)
     // Start listen for incoming commands and handle them
     server_loop();
 
+    destroy_ssh_pool(&ssh_pool);
+
     return EXIT_SUCCESS;
 }
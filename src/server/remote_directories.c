@@ -0,0 +1,185 @@
+#include "remote_directories.h"
+
+typedef struct UnconfirmedDirectory {
+    char *path;
+    UT_hash_handle hh;
+} UnconfirmedDirectory;
+
+typedef struct RemoteDirectories {
+    const RemoteWorkspaceMetadata *remote_system;
+    /* Whether the remote system had all directories of the workspace as of its last complete sync */
+    bool is_known;
+    /* Directories that appeared since, by their path relative to the workspace root */
+    UnconfirmedDirectory *unconfirmed_directories;
+    uint32_t unconfirmed_directories_count;
+    struct RemoteDirectories *next;
+} RemoteDirectories;
+
+static RemoteDirectories *remote_directories = NULL;
+
+static RemoteDirectories *
+get_remote_directories(const RemoteWorkspaceMetadata *remote_system)
+{
+    RemoteDirectories *entry;
+    LL_SEARCH_SCALAR(remote_directories, entry, remote_system, remote_system);
+    if (entry == NULL) {
+        entry = (RemoteDirectories *) do_calloc(1, sizeof(RemoteDirectories));
+        entry->remote_system = remote_system;
+        LL_APPEND(remote_directories, entry);
+    }
+
+    return entry;
+}
+
+static void
+remove_unconfirmed_directory(RemoteDirectories *entry, UnconfirmedDirectory *directory)
+{
+    HASH_DELETE(hh, entry->unconfirmed_directories, directory);
+    entry->unconfirmed_directories_count--;
+    DO_FREE(directory->path);
+    DO_FREE(directory);
+}
+
+static void
+clear_unconfirmed_directories(RemoteDirectories *entry)
+{
+    UnconfirmedDirectory *directory, *tmp;
+    HASH_ITER(hh, entry->unconfirmed_directories, directory, tmp) {
+        remove_unconfirmed_directory(entry, directory);
+    }
+}
+
+/*
+ * @return whether the path is the given directory or lies below it
+ */
+static bool
+is_within_directory(const char *path, const char *relative_directory_path, const size_t directory_path_len)
+{
+    return strncmp(path, relative_directory_path, directory_path_len) == 0
+           && (path[directory_path_len] == '\0' || path[directory_path_len] == '/');
+}
+
+/*
+ * @return the length of the topmost unconfirmed directory that contains the path, or 0 if there is none. The path
+ *  itself is only considered if it is included.
+ */
+static size_t
+find_topmost_unconfirmed_directory(const RemoteDirectories *entry, const char *relative_path, const bool is_included)
+{
+    const size_t path_len = strlen(relative_path);
+
+    // Prefixes are looked up by their length, so that no key has to be allocated
+    for (size_t len = 1; len <= path_len; len++) {
+        if (relative_path[len] != '/' && (relative_path[len] != '\0' || !is_included)) {
+            continue;
+        }
+
+        UnconfirmedDirectory *directory;
+        HASH_FIND(hh, entry->unconfirmed_directories, relative_path, len, directory);
+        if (directory != NULL) {
+            return len;
+        }
+    }
+
+    return 0;
+}
+
+void
+confirm_remote_directory(const RemoteWorkspaceMetadata *remote_system, const char *relative_path)
+{
+    RemoteDirectories *entry = get_remote_directories(remote_system);
+    if (relative_path == NULL) {
+        clear_unconfirmed_directories(entry);
+        entry->is_known = true;
+        return;
+    }
+
+    // The directory can only exist if all of its ancestors exist, and rsync created everything below it
+    const size_t path_len = strlen(relative_path);
+    UnconfirmedDirectory *directory, *tmp;
+    HASH_ITER(hh, entry->unconfirmed_directories, directory, tmp) {
+        const size_t directory_path_len = strlen(directory->path);
+        if (is_within_directory(directory->path, relative_path, path_len)
+            || (directory_path_len < path_len && is_within_directory(relative_path, directory->path, directory_path_len))) {
+            remove_unconfirmed_directory(entry, directory);
+        }
+    }
+}
+
+void
+add_unconfirmed_remote_directory(const RemoteWorkspaceMetadata *remote_system, const char *relative_path)
+{
+    RemoteDirectories *entry = get_remote_directories(remote_system);
+    if (!entry->is_known || relative_path == NULL) {
+        return;
+    }
+
+    UnconfirmedDirectory *directory;
+    HASH_FIND_STR(entry->unconfirmed_directories, relative_path, directory);
+    if (directory != NULL) {
+        return;
+    }
+
+    if (entry->unconfirmed_directories_count >= REMOTE_DIRECTORIES_MAX_UNCONFIRMED) {
+        LOG(
+                "Too many directories of remote workspace '%s' on '%s' are unconfirmed, no longer tracking them",
+                remote_system->remote_workspace_root_path,
+                get_remote_system_host(remote_system)
+        );
+        invalidate_remote_directories(remote_system);
+        return;
+    }
+
+    directory = (UnconfirmedDirectory *) do_calloc(1, sizeof(UnconfirmedDirectory));
+    directory->path = resync_strdup(relative_path);
+    HASH_ADD_KEYPTR(hh, entry->unconfirmed_directories, directory->path, strlen(directory->path), directory);
+    entry->unconfirmed_directories_count++;
+}
+
+void
+invalidate_remote_directories(const RemoteWorkspaceMetadata *remote_system)
+{
+    RemoteDirectories *entry = get_remote_directories(remote_system);
+    clear_unconfirmed_directories(entry);
+    entry->is_known = false;
+}
+
+bool
+is_remote_directory_unconfirmed(const RemoteWorkspaceMetadata *remote_system, const char *relative_path)
+{
+    const RemoteDirectories *entry = get_remote_directories(remote_system);
+    return entry->is_known && relative_path != NULL && find_topmost_unconfirmed_directory(entry, relative_path, true) > 0;
+}
+
+char *
+get_remote_sync_root(const RemoteWorkspaceMetadata *remote_system, const char *relative_path)
+{
+    const RemoteDirectories *entry = get_remote_directories(remote_system);
+    if (!entry->is_known || relative_path == NULL) {
+        return resync_strdup(relative_path);
+    }
+
+    // rsync creates the directory it syncs, so only its ancestors have to exist
+    const size_t sync_root_len = find_topmost_unconfirmed_directory(entry, relative_path, false);
+    if (sync_root_len == 0) {
+        return resync_strdup(relative_path);
+    }
+
+    char *sync_root = strndup(relative_path, sync_root_len);
+    if (sync_root == NULL) {
+        fatal_error("strndup");
+    }
+    return sync_root;
+}
+
+void
+release_remote_directories(const RemoteWorkspaceMetadata *remote_system)
+{
+    RemoteDirectories *entry;
+    LL_SEARCH_SCALAR(remote_directories, entry, remote_system, remote_system);
+    if (entry != NULL) {
+        clear_unconfirmed_directories(entry);
+        LL_DELETE(remote_directories, entry);
+        DO_FREE(entry);
+    }
+}
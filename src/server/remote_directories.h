@@ -0,0 +1,65 @@
+#ifndef RESYNC_REMOTE_DIRECTORIES_H
+#define RESYNC_REMOTE_DIRECTORIES_H
+
+#include "../util/string.h"
+#include "../util/memory.h"
+#include "../util/error.h"
+#include "../util/debug.h"
+#include "../types/types.h"
+#include "../../lib/ulist.h"
+#include "../../lib/utash.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+/*
+ * Tracks which directories of the workspace are known to exist on a remote system, so that a directory is not synced
+ *  before the remote system has its parent directory. rsync creates the destination directory of a sync, but not its
+ *  parents, so such a sync fails and used to be retried for the entire workspace.
+ *
+ * Once the workspace was synced entirely, the remote system has all of its directories. Directories that appear in the
+ *  workspace afterwards are unconfirmed until a sync of them, of one of their ancestors or of one of their descendants
+ *  succeeds. A sync of a directory below an unconfirmed directory starts at the topmost unconfirmed directory instead,
+ *  which rsync creates along with everything below it. Nothing is known before the first complete sync and after a
+ *  failed sync, in which case directories are synced as requested.
+ */
+
+/* Remote systems with more unconfirmed directories are no longer tracked until their next complete sync */
+#define REMOTE_DIRECTORIES_MAX_UNCONFIRMED 4096
+
+/**
+ * Notes that the directory exists on the remote system after a successful sync of it.
+ *
+ * @param relative_path NULL for the workspace root, which confirms all directories of the workspace
+ */
+void confirm_remote_directory(const RemoteWorkspaceMetadata *remote_system, const char *relative_path);
+
+/**
+ * Notes that a directory appeared in the workspace, which the remote system may not have yet.
+ */
+void add_unconfirmed_remote_directory(const RemoteWorkspaceMetadata *remote_system, const char *relative_path);
+
+/**
+ * Forgets which directories the remote system has, e.g. as a sync with it failed.
+ */
+void invalidate_remote_directories(const RemoteWorkspaceMetadata *remote_system);
+
+/**
+ * @param relative_path NULL for the workspace root
+ * @return whether the directory or one of its ancestors is known to be unconfirmed on the remote system
+ */
+bool is_remote_directory_unconfirmed(const RemoteWorkspaceMetadata *remote_system, const char *relative_path);
+
+/**
+ * @param relative_path directory to sync, NULL for the workspace root
+ * @return the directory that a sync of the given directory has to start at, i.e. the topmost unconfirmed ancestor of
+ *  the directory or the directory itself, which has to be freed by the caller
+ */
+char *get_remote_sync_root(const RemoteWorkspaceMetadata *remote_system, const char *relative_path);
+
+/**
+ * Drops the directories of the remote system. Has to be called before the remote system is destroyed.
+ */
+void release_remote_directories(const RemoteWorkspaceMetadata *remote_system);
+
+#endif //RESYNC_REMOTE_DIRECTORIES_H
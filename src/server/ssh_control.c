@@ -0,0 +1,104 @@
+#include "ssh_control.h"
+
+bool
+is_ssh_remote_system(const RemoteWorkspaceMetadata *remote_system)
+{
+    return remote_system->connection_type == SSH || remote_system->connection_type == SSH_HOST_ALIAS;
+}
+
+char *
+get_ssh_connection_key(const RemoteWorkspaceMetadata *remote_system)
+{
+    if (remote_system->connection_type == SSH_HOST_ALIAS) {
+        return format_string("alias:%s", remote_system->connection_information.ssh_host_alias);
+    }
+
+    if (remote_system->connection_type != SSH) {
+        return NULL;
+    }
+
+    const SshConnectionInformation *connection_information = remote_system->connection_information.ssh_connection_information;
+
+    // The master connection authenticates with its identity, so remote systems with different identities must not
+    //  share it
+    return format_string(
+            "ssh:%s@%s#%s",
+            connection_information->username != NULL ? connection_information->username : "",
+            connection_information->hostname,
+            connection_information->path_to_identity_file != NULL ? connection_information->path_to_identity_file : ""
+    );
+}
+
+char *
+get_ssh_control_path(const char *connection_key)
+{
+    return format_string(
+            "%s/%016llx",
+            DEFAULT_RESYNC_SSH_CONTROL_DIRECTORY,
+            (unsigned long long) hash_string(connection_key)
+    );
+}
+
+char *
+construct_ssh_remote_shell_command(const RemoteWorkspaceMetadata *remote_system)
+{
+    char *connection_key = get_ssh_connection_key(remote_system);
+    char *control_path = get_ssh_control_path(connection_key);
+    DO_FREE(connection_key);
+
+    // 'ControlMaster=no' never turns a sync's ssh process into a master, it only joins the daemon's one
+    char *command;
+    if (remote_system->connection_type == SSH
+        && remote_system->connection_information.ssh_connection_information->path_to_identity_file != NULL) {
+        command = format_string(
+                "ssh -o ControlMaster=no -o ControlPath=%s -i \"%s\"",
+                control_path,
+                remote_system->connection_information.ssh_connection_information->path_to_identity_file
+        );
+    } else {
+        command = format_string("ssh -o ControlMaster=no -o ControlPath=%s", control_path);
+    }
+
+    DO_FREE(control_path);
+    return command;
+}
+
+char **
+construct_ssh_remote_command_arguments(const RemoteWorkspaceMetadata *remote_system, const char *remote_command)
+{
+    int index = 0;
+    char **args = (char **) do_calloc(16, sizeof(char *));
+
+    char *connection_key = get_ssh_connection_key(remote_system);
+    char *control_path = get_ssh_control_path(connection_key);
+    DO_FREE(connection_key);
+
+    args[index++] = resync_strdup("ssh");
+    args[index++] = resync_strdup("-o");
+    args[index++] = resync_strdup("ControlMaster=no");
+    args[index++] = resync_strdup("-o");
+    args[index++] = format_string("ControlPath=%s", control_path);
+    // Workspace monitors cannot answer password or host key prompts
+    args[index++] = resync_strdup("-o");
+    args[index++] = resync_strdup("BatchMode=yes");
+
+    DO_FREE(control_path);
+
+    if (remote_system->connection_type == SSH_HOST_ALIAS) {
+        args[index++] = resync_strdup(remote_system->connection_information.ssh_host_alias);
+    } else {
+        const SshConnectionInformation *connection_information = remote_system->connection_information.ssh_connection_information;
+        if (connection_information->path_to_identity_file != NULL) {
+            args[index++] = resync_strdup("-i");
+            args[index++] = resync_strdup(connection_information->path_to_identity_file);
+        }
+        if (connection_information->username != NULL) {
+            args[index++] = resync_strdup("-l");
+            args[index++] = resync_strdup(connection_information->username);
+        }
+        args[index++] = resync_strdup(connection_information->hostname);
+    }
+
+    args[index++] = resync_strdup(remote_command);
+    return args;
+}
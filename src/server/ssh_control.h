@@ -0,0 +1,45 @@
+#ifndef RESYNC_SSH_CONTROL_H
+#define RESYNC_SSH_CONTROL_H
+
+#include "../util/string.h"
+#include "../util/memory.h"
+#include "../types/types.h"
+
+#include <stdbool.h>
+
+/*
+ * Naming of the persistent ssh master connections that are kept open by the daemon (see 'ssh_pool.h'). Remote systems
+ *  that are reached with the same ssh destination and identity share a master connection, whose control socket is
+ *  found by the workspace monitors under a path derived from the connection key.
+ */
+
+#define DEFAULT_RESYNC_SSH_CONTROL_DIRECTORY "/tmp/reSync_ssh"
+
+/**
+ * @return true if rsync reaches the remote system via ssh
+ */
+bool is_ssh_remote_system(const RemoteWorkspaceMetadata *remote_system);
+
+/**
+ * @return key that identifies the ssh connection to the remote system, or NULL if it is not reached via ssh
+ */
+char *get_ssh_connection_key(const RemoteWorkspaceMetadata *remote_system);
+
+/**
+ * @return path of the control socket of the master connection with the given key
+ */
+char *get_ssh_control_path(const char *connection_key);
+
+/**
+ * @return the 'ssh' command rsync uses to reach the remote system, which multiplexes its session over the master
+ *  connection if one is open and connects on its own otherwise
+ */
+char *construct_ssh_remote_shell_command(const RemoteWorkspaceMetadata *remote_system);
+
+/**
+ * @return NULL terminated argument vector of an 'ssh' invocation that runs the remote command on the remote system,
+ *  multiplexed over the master connection if one is open
+ */
+char **construct_ssh_remote_command_arguments(const RemoteWorkspaceMetadata *remote_system, const char *remote_command);
+
+#endif //RESYNC_SSH_CONTROL_H
@@ -0,0 +1,292 @@
+#include "ssh_pool.h"
+
+static uint64_t
+now_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000 + (uint64_t) now.tv_nsec / 1000000;
+}
+
+static SshMaster *
+acquire_ssh_master(SshPool *pool, const char *connection_key, const RemoteWorkspaceMetadata *remote_system)
+{
+    SshMaster *master;
+    HASH_FIND_STR(pool->masters, connection_key, master);
+    if (master == NULL) {
+        master = (SshMaster *) do_calloc(1, sizeof(SshMaster));
+        master->connection_key = resync_strdup(connection_key);
+        master->control_path = get_ssh_control_path(connection_key);
+        master->remote_system = copy_remoteWorkspaceMetadata(remote_system);
+        master->pid = -1;
+        HASH_ADD_KEYPTR(hh, pool->masters, master->connection_key, strlen(master->connection_key), master);
+    }
+
+    master->references++;
+    return master;
+}
+
+static void
+terminate_ssh_master(SshMaster *master)
+{
+    if (master->pid == -1) {
+        return;
+    }
+
+    // Multiplexed sessions of running syncs are closed as well, their syncs fail and are retried by the monitors
+    kill(master->pid, SIGTERM);
+    waitpid(master->pid, NULL, 0);
+    master->pid = -1;
+    unlink(master->control_path);
+}
+
+static void
+destroy_ssh_master(SshPool *pool, SshMaster *master)
+{
+    HASH_DEL(pool->masters, master);
+    terminate_ssh_master(master);
+    destroy_remoteWorkspaceMetadata(&(master->remote_system));
+    DO_FREE(master->connection_key);
+    DO_FREE(master->control_path);
+    DO_FREE(master);
+}
+
+static void
+release_ssh_master(SshPool *pool, const char *connection_key)
+{
+    SshMaster *master;
+    HASH_FIND_STR(pool->masters, connection_key, master);
+    if (master != NULL && --(master->references) == 0) {
+        LOG("Closing the ssh master connection '%s'", master->connection_key);
+        destroy_ssh_master(pool, master);
+    }
+}
+
+static void
+destroy_ssh_pool_workspace(SshPool *pool, SshPoolWorkspace *workspace)
+{
+    HASH_DEL(pool->workspaces, workspace);
+    for (size_t i = 0; i < workspace->connection_keys_count; i++) {
+        release_ssh_master(pool, workspace->connection_keys[i]);
+        DO_FREE(workspace->connection_keys[i]);
+    }
+    DO_FREE(workspace->connection_keys);
+    DO_FREE(workspace->ws_path);
+    DO_FREE(workspace);
+}
+
+SshPool *
+create_ssh_pool(void)
+{
+    return (SshPool *) do_calloc(1, sizeof(SshPool));
+}
+
+void
+destroy_ssh_pool(SshPool **pool)
+{
+    if (pool == NULL || *pool == NULL) {
+        return;
+    }
+
+    SshPoolWorkspace *workspace, *tmp_workspace;
+    HASH_ITER(hh, (*pool)->workspaces, workspace, tmp_workspace) {
+        destroy_ssh_pool_workspace(*pool, workspace);
+    }
+
+    DO_FREE(*pool);
+}
+
+void
+register_ssh_pool_workspace(SshPool *pool, const WorkspaceInformation *ws_info)
+{
+    SshPoolWorkspace *new_workspace = (SshPoolWorkspace *) do_calloc(1, sizeof(SshPoolWorkspace));
+    new_workspace->ws_path = resync_strdup(ws_info->local_workspace_root_path);
+
+    size_t remote_systems_count = 0;
+    RemoteWorkspaceMetadata *remote_system;
+    LL_COUNT(ws_info->remote_systems, remote_system, remote_systems_count);
+    new_workspace->connection_keys = (char **) do_calloc(remote_systems_count + 1, sizeof(char *));
+
+    // Masters are acquired for the new destinations before the old ones are released, so that masters that are still
+    //  in use are not reconnected
+    LL_FOREACH(ws_info->remote_systems, remote_system) {
+        char *connection_key = get_ssh_connection_key(remote_system);
+        if (connection_key == NULL) {
+            continue;
+        }
+
+        bool is_duplicate = false;
+        for (size_t i = 0; i < new_workspace->connection_keys_count && !is_duplicate; i++) {
+            is_duplicate = is_equal(new_workspace->connection_keys[i], connection_key);
+        }
+
+        if (is_duplicate) {
+            DO_FREE(connection_key);
+            continue;
+        }
+
+        acquire_ssh_master(pool, connection_key, remote_system);
+        new_workspace->connection_keys[new_workspace->connection_keys_count++] = connection_key;
+    }
+
+    unregister_ssh_pool_workspace(pool, ws_info->local_workspace_root_path);
+    HASH_ADD_KEYPTR(hh, pool->workspaces, new_workspace->ws_path, strlen(new_workspace->ws_path), new_workspace);
+}
+
+void
+unregister_ssh_pool_workspace(SshPool *pool, const char *ws_path)
+{
+    SshPoolWorkspace *workspace;
+    HASH_FIND_STR(pool->workspaces, ws_path, workspace);
+    if (workspace != NULL) {
+        destroy_ssh_pool_workspace(pool, workspace);
+    }
+}
+
+static char **
+construct_ssh_master_cmd_arguments(const SshMaster *master)
+{
+    int index = 0;
+    char **args = (char **) do_calloc(24, sizeof(char *));
+
+    args[index++] = resync_strdup("ssh");
+    args[index++] = resync_strdup("-M");
+    args[index++] = resync_strdup("-N");
+    args[index++] = resync_strdup("-o");
+    args[index++] = format_string("ControlPath=%s", master->control_path);
+    args[index++] = resync_strdup("-o");
+    args[index++] = resync_strdup("ControlPersist=no");
+    // The daemon cannot answer password or host key prompts
+    args[index++] = resync_strdup("-o");
+    args[index++] = resync_strdup("BatchMode=yes");
+    args[index++] = resync_strdup("-o");
+    args[index++] = format_string("ConnectTimeout=%d", SSH_MASTER_CONNECT_TIMEOUT_SEC);
+    args[index++] = resync_strdup("-o");
+    args[index++] = format_string("ServerAliveInterval=%d", SSH_MASTER_ALIVE_INTERVAL_SEC);
+    args[index++] = resync_strdup("-o");
+    args[index++] = format_string("ServerAliveCountMax=%d", SSH_MASTER_ALIVE_COUNT_MAX);
+
+    const RemoteWorkspaceMetadata *remote_system = master->remote_system;
+    if (remote_system->connection_type == SSH_HOST_ALIAS) {
+        args[index++] = resync_strdup(remote_system->connection_information.ssh_host_alias);
+        return args;
+    }
+
+    const SshConnectionInformation *connection_information = remote_system->connection_information.ssh_connection_information;
+    if (connection_information->path_to_identity_file != NULL) {
+        args[index++] = resync_strdup("-i");
+        args[index++] = resync_strdup(connection_information->path_to_identity_file);
+    }
+    if (connection_information->username != NULL) {
+        args[index++] = resync_strdup("-l");
+        args[index++] = resync_strdup(connection_information->username);
+    }
+    args[index++] = resync_strdup(connection_information->hostname);
+
+    return args;
+}
+
+static void
+connect_ssh_master(SshMaster *master)
+{
+    if (mkdir(DEFAULT_RESYNC_SSH_CONTROL_DIRECTORY, 0700) == -1 && errno != EEXIST) {
+        LOG_ERROR("Unable to create the ssh control socket directory: %s", strerror(errno));
+    }
+
+    // A control socket left behind by a crashed daemon would make the new master run without accepting sessions
+    unlink(master->control_path);
+
+    char **args = construct_ssh_master_cmd_arguments(master);
+
+    const pid_t pid = fork();
+    if (pid == 0) {
+        const int null_fd = open("/dev/null", O_RDWR);
+        if (null_fd != -1) {
+            dup2(null_fd, STDIN_FILENO);
+        }
+        signal(SIGPIPE, SIG_DFL);
+
+        execvp("ssh", args);
+        fatal_error("execvp");
+    }
+
+    for (char **arg = args; *arg != NULL; arg++) {
+        DO_FREE(*arg);
+    }
+    DO_FREE(args);
+
+    if (pid == -1) {
+        LOG_ERROR("Unable to connect the ssh master '%s': %s", master->connection_key, strerror(errno));
+        master->reconnect_at_ms = now_ms() + SSH_MASTER_INITIAL_BACKOFF_MS;
+        return;
+    }
+
+    master->pid = pid;
+    master->started_at_ms = now_ms();
+    master->connects++;
+    LOG("Connecting the ssh master '%s' (connection #%d)", master->connection_key, master->connects);
+}
+
+/*
+ * Schedules the reconnect of a master whose process terminated.
+ */
+static void
+handle_ssh_master_exit(SshMaster *master, const int status, const uint64_t now)
+{
+    master->pid = -1;
+    unlink(master->control_path);
+
+    if (now - master->started_at_ms >= SSH_MASTER_STABLE_RUNTIME_MS) {
+        master->consecutive_failures = 0;
+    }
+
+    int backoff_ms = SSH_MASTER_INITIAL_BACKOFF_MS;
+    for (int i = 0; i < master->consecutive_failures && backoff_ms < SSH_MASTER_MAX_BACKOFF_MS; i++) {
+        backoff_ms *= 2;
+    }
+    if (backoff_ms > SSH_MASTER_MAX_BACKOFF_MS) {
+        backoff_ms = SSH_MASTER_MAX_BACKOFF_MS;
+    }
+
+    master->consecutive_failures++;
+    master->reconnect_at_ms = now + backoff_ms;
+
+    LOG_ERROR(
+            "ssh master '%s' terminated with status %d, reconnecting in %d ms",
+            master->connection_key,
+            WIFEXITED(status) ? WEXITSTATUS(status) : -1,
+            backoff_ms
+    );
+}
+
+int
+maintain_ssh_masters(SshPool *pool)
+{
+    const uint64_t now = now_ms();
+    int timeout_ms = -1;
+
+    SshMaster *master, *tmp;
+    HASH_ITER(hh, pool->masters, master, tmp) {
+        if (master->pid != -1) {
+            int status;
+            if (waitpid(master->pid, &status, WNOHANG) != master->pid) {
+                continue;
+            }
+            handle_ssh_master_exit(master, status, now);
+        }
+
+        if (master->reconnect_at_ms <= now) {
+            connect_ssh_master(master);
+            if (master->pid != -1) {
+                continue;
+            }
+        }
+
+        const int remaining_ms = (int) (master->reconnect_at_ms - now);
+        if (timeout_ms == -1 || remaining_ms < timeout_ms) {
+            timeout_ms = remaining_ms;
+        }
+    }
+
+    return timeout_ms;
+}
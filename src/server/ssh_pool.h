@@ -0,0 +1,92 @@
+#ifndef RESYNC_SSH_POOL_H
+#define RESYNC_SSH_POOL_H
+
+#include "ssh_control.h"
+#include "../util/string.h"
+#include "../util/memory.h"
+#include "../util/error.h"
+#include "../util/debug.h"
+#include "../types/types.h"
+#include "../../lib/ulist.h"
+#include "../../lib/utash.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+/*
+ * Pool of persistent ssh master connections owned by the daemon. Every ssh destination used by any managed workspace
+ *  gets one master connection ('ssh -M -N'), over which the rsync invocations of all workspace monitors multiplex
+ *  their sessions (see 'construct_ssh_remote_shell_command'), so that only the master performs an ssh handshake.
+ *
+ * The health of a master is checked by ssh itself through keep-alive messages, it terminates once the remote host no
+ *  longer responds. Terminated masters are reconnected with an exponential backoff. While a master is down, syncs
+ *  connect on their own.
+ */
+
+#define SSH_MASTER_ALIVE_INTERVAL_SEC 15
+#define SSH_MASTER_ALIVE_COUNT_MAX 3
+#define SSH_MASTER_CONNECT_TIMEOUT_SEC 10
+
+#define SSH_MASTER_INITIAL_BACKOFF_MS 1000
+#define SSH_MASTER_MAX_BACKOFF_MS (60 * 1000)
+/* A master that was connected for at least this long reconnects with the initial backoff */
+#define SSH_MASTER_STABLE_RUNTIME_MS (60 * 1000)
+
+typedef struct SshMaster {
+    char *connection_key;
+    char *control_path;
+    /* Describes how to reach the remote host, the remote workspace path is irrelevant */
+    RemoteWorkspaceMetadata *remote_system;
+    /* Number of workspaces that use the master */
+    int references;
+    /* PID of the running 'ssh' master process, or -1 */
+    pid_t pid;
+    uint64_t started_at_ms;
+    int consecutive_failures;
+    uint64_t reconnect_at_ms;
+    /* Number of times the master was (re)connected */
+    int connects;
+    UT_hash_handle hh;
+} SshMaster;
+
+typedef struct SshPoolWorkspace {
+    char *ws_path;
+    char **connection_keys;
+    size_t connection_keys_count;
+    UT_hash_handle hh;
+} SshPoolWorkspace;
+
+typedef struct SshPool {
+    SshMaster *masters;
+    SshPoolWorkspace *workspaces;
+} SshPool;
+
+SshPool *create_ssh_pool(void);
+
+/**
+ * Terminates all master connections.
+ */
+void destroy_ssh_pool(SshPool **pool);
+
+/**
+ * Sets the ssh destinations that are used by the workspace to those of its current remote systems. Masters that are
+ *  no longer used by any workspace are terminated, new ones are connected by the next 'maintain_ssh_masters'.
+ */
+void register_ssh_pool_workspace(SshPool *pool, const WorkspaceInformation *ws_info);
+
+void unregister_ssh_pool_workspace(SshPool *pool, const char *ws_path);
+
+/**
+ * Reaps terminated masters and (re)connects the masters whose backoff elapsed.
+ *
+ * @return the number of milliseconds until a master has to be reconnected, or -1 if there is none
+ */
+int maintain_ssh_masters(SshPool *pool);
+
+#endif //RESYNC_SSH_POOL_H
@@ -0,0 +1,128 @@
+#include "supervisor.h"
+
+static uint64_t
+now_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000 + (uint64_t) now.tv_nsec / 1000000;
+}
+
+static SupervisedMonitor *
+get_supervised_monitor(MonitorSupervisor *supervisor, const char *ws_path)
+{
+    SupervisedMonitor *monitor;
+    HASH_FIND_STR(supervisor->monitors, ws_path, monitor);
+    if (monitor == NULL) {
+        monitor = (SupervisedMonitor *) do_calloc(1, sizeof(SupervisedMonitor));
+        monitor->ws_path = resync_strdup(ws_path);
+        HASH_ADD_KEYPTR(hh, supervisor->monitors, monitor->ws_path, strlen(monitor->ws_path), monitor);
+    }
+
+    return monitor;
+}
+
+static void
+destroy_supervised_monitor(MonitorSupervisor *supervisor, SupervisedMonitor *monitor)
+{
+    HASH_DEL(supervisor->monitors, monitor);
+    DO_FREE(monitor->ws_path);
+    DO_FREE(monitor);
+}
+
+MonitorSupervisor *
+create_monitor_supervisor(const int initial_backoff_ms, const int max_backoff_ms)
+{
+    MonitorSupervisor *supervisor = (MonitorSupervisor *) do_calloc(1, sizeof(MonitorSupervisor));
+    supervisor->initial_backoff_ms = initial_backoff_ms;
+    supervisor->max_backoff_ms = (max_backoff_ms > initial_backoff_ms) ? max_backoff_ms : initial_backoff_ms;
+    return supervisor;
+}
+
+void
+destroy_monitor_supervisor(MonitorSupervisor **supervisor)
+{
+    if (supervisor == NULL || *supervisor == NULL) {
+        return;
+    }
+
+    SupervisedMonitor *monitor, *tmp;
+    HASH_ITER(hh, (*supervisor)->monitors, monitor, tmp) {
+        destroy_supervised_monitor(*supervisor, monitor);
+    }
+
+    DO_FREE(*supervisor);
+}
+
+void
+record_monitor_start(MonitorSupervisor *supervisor, const char *ws_path)
+{
+    SupervisedMonitor *monitor = get_supervised_monitor(supervisor, ws_path);
+    monitor->started_at_ms = now_ms();
+    monitor->restart_scheduled = false;
+}
+
+int
+record_monitor_crash(MonitorSupervisor *supervisor, const char *ws_path)
+{
+    SupervisedMonitor *monitor = get_supervised_monitor(supervisor, ws_path);
+    const uint64_t now = now_ms();
+
+    if (monitor->started_at_ms != 0 && now - monitor->started_at_ms >= MONITOR_STABLE_RUNTIME_MS) {
+        monitor->consecutive_crashes = 0;
+    }
+
+    int backoff_ms = supervisor->initial_backoff_ms;
+    for (int i = 0; i < monitor->consecutive_crashes && backoff_ms < supervisor->max_backoff_ms; i++) {
+        backoff_ms *= 2;
+    }
+    if (backoff_ms > supervisor->max_backoff_ms) {
+        backoff_ms = supervisor->max_backoff_ms;
+    }
+
+    monitor->consecutive_crashes++;
+    monitor->restarts++;
+    monitor->restart_scheduled = true;
+    monitor->restart_at_ms = now + backoff_ms;
+
+    return backoff_ms;
+}
+
+void
+forget_supervised_monitor(MonitorSupervisor *supervisor, const char *ws_path)
+{
+    SupervisedMonitor *monitor;
+    HASH_FIND_STR(supervisor->monitors, ws_path, monitor);
+    if (monitor != NULL) {
+        destroy_supervised_monitor(supervisor, monitor);
+    }
+}
+
+int
+dispatch_monitor_restarts(MonitorSupervisor *supervisor, MonitorRestartCallback callback, void *context)
+{
+    const uint64_t now = now_ms();
+
+    // The callback may record a crash for the restarted workspace again, which reschedules it in the future
+    SupervisedMonitor *monitor, *tmp;
+    HASH_ITER(hh, supervisor->monitors, monitor, tmp) {
+        if (monitor->restart_scheduled && monitor->restart_at_ms <= now) {
+            monitor->restart_scheduled = false;
+            callback(monitor->ws_path, context);
+        }
+    }
+
+    int timeout_ms = -1;
+    HASH_ITER(hh, supervisor->monitors, monitor, tmp) {
+        if (!monitor->restart_scheduled) {
+            continue;
+        }
+
+        const int remaining_ms = (monitor->restart_at_ms > now) ? (int) (monitor->restart_at_ms - now) : 0;
+        if (timeout_ms == -1 || remaining_ms < timeout_ms) {
+            timeout_ms = remaining_ms;
+        }
+    }
+
+    return timeout_ms;
+}
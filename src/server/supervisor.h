@@ -0,0 +1,69 @@
+#ifndef RESYNC_SUPERVISOR_H
+#define RESYNC_SUPERVISOR_H
+
+#include "../util/string.h"
+#include "../util/memory.h"
+#include "../util/error.h"
+#include "../../lib/utash.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+/*
+ * Restart bookkeeping for workspace monitors that terminated without being asked to. A crashed monitor is restarted
+ *  after a delay that doubles with every crash in a row, up to a maximum. A monitor that ran for at least
+ *  'MONITOR_STABLE_RUNTIME_MS' before crashing starts over with the initial delay.
+ */
+
+#define MONITOR_STABLE_RUNTIME_MS (60 * 1000)
+
+typedef struct SupervisedMonitor {
+    char *ws_path;
+    /* Number of restarts since the daemon started */
+    int restarts;
+    int consecutive_crashes;
+    uint64_t started_at_ms;
+    bool restart_scheduled;
+    uint64_t restart_at_ms;
+    UT_hash_handle hh;
+} SupervisedMonitor;
+
+typedef struct MonitorSupervisor {
+    int initial_backoff_ms;
+    int max_backoff_ms;
+    SupervisedMonitor *monitors;
+} MonitorSupervisor;
+
+typedef void (*MonitorRestartCallback)(const char *ws_path, void *context);
+
+MonitorSupervisor *create_monitor_supervisor(const int initial_backoff_ms, const int max_backoff_ms);
+
+void destroy_monitor_supervisor(MonitorSupervisor **supervisor);
+
+/**
+ * Records that a monitor for the workspace was started, which cancels a scheduled restart.
+ */
+void record_monitor_start(MonitorSupervisor *supervisor, const char *ws_path);
+
+/**
+ * Records that the workspace's monitor terminated unexpectedly and schedules its restart.
+ *
+ * @return the number of milliseconds after which the monitor is restarted
+ */
+int record_monitor_crash(MonitorSupervisor *supervisor, const char *ws_path);
+
+/**
+ * Forgets the workspace, e.g. because it is no longer managed by reSync.
+ */
+void forget_supervised_monitor(MonitorSupervisor *supervisor, const char *ws_path);
+
+/**
+ * Invokes the callback for all workspaces whose restart is due. The callback is expected to either record a start or a
+ *  crash for the workspace.
+ *
+ * @return the number of milliseconds until the next scheduled restart, or -1 if no restart is scheduled
+ */
+int dispatch_monitor_restarts(MonitorSupervisor *supervisor, MonitorRestartCallback callback, void *context);
+
+#endif //RESYNC_SUPERVISOR_H
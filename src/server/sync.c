@@ -1,5 +1,89 @@
 #include "sync.h"
 
+static SyncLeaseHandlers lease_handlers = {NULL, NULL};
+
+/* Resources that are excluded from every rsync invocation, see 'set_sync_ignore_rules' */
+static const IgnoreRules *ignore_rules = NULL;
+
+/* Batches written while syncing are placed next to the sync state of the workspace */
+#define SYNC_BATCH_FILE_EXTENSION "batch"
+
+/* Generation of remote systems that are not in the state their generation implies, e.g. as they were modified */
+#define SYNC_GENERATION_DIVERGED UINT64_MAX
+
+typedef struct RemoteSyncGeneration {
+    const RemoteWorkspaceMetadata *remote_system;
+    uint64_t generation;
+    struct RemoteSyncGeneration *next;
+} RemoteSyncGeneration;
+
+typedef struct SyncGroupMember {
+    RemoteWorkspaceMetadata *remote_system;
+    bool is_diverged;
+    struct SyncGroupMember *next;
+} SyncGroupMember;
+
+/* Remote systems that are synced with a single batch, see 'synchronize_directory_with_group' */
+typedef struct SyncGroup {
+    uint64_t generation;
+    SyncGroupMember *members;
+    struct SyncGroup *next;
+} SyncGroup;
+
+/* Connections to the agents of the remote systems that use the agent transport, established on first use */
+static AgentConnection *agent_connections = NULL;
+
+/* Generation of the remote systems that use the rsync transport, see 'synchronize_change' */
+static RemoteSyncGeneration *sync_generations = NULL;
+/* Number of changes that were synchronized so far, i.e. the generation of a remote system that is fully in sync */
+static uint64_t current_sync_generation = 0;
+
+/* Batch that an rsync invocation writes while syncing, or replays instead of syncing the local directory */
+typedef struct RsyncBatch {
+    const char *path;
+    bool is_replay;
+} RsyncBatch;
+
+/* Command that syncs a subtree of the workspace concurrently with others, see 'run_concurrent_sync_commands' */
+typedef struct ConcurrentSyncCommand {
+    char **args;
+    /* Descriptor the command reads its standard input from, or -1 if it reads none */
+    int input_fd;
+    /* Subtree the command syncs, NULL for the workspace root */
+    const char *relative_path;
+} ConcurrentSyncCommand;
+
+/* Directory whose digest is compared with that of a remote system, see 'check_remote_system_for_drift' */
+typedef struct DriftCheckDirectory {
+    /* NULL for the workspace root */
+    char *relative_path;
+    struct DriftCheckDirectory *next;
+} DriftCheckDirectory;
+
+/*
+ * Operations of a transport that synchronizes individual changes with a remote system. Operations that are NULL are
+ *  not needed by the transport.
+ */
+typedef struct SyncTransportOps {
+    void (*synchronize_change)(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system,
+                               const WorkspaceChange *change);
+    /* Completes all changes that are still in flight */
+    void (*flush)(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system);
+    void (*release)(const RemoteWorkspaceMetadata *remote_system);
+} SyncTransportOps;
+
+void
+set_sync_lease_handlers(const SyncLeaseHandlers *handlers)
+{
+    lease_handlers = *handlers;
+}
+
+void
+set_sync_ignore_rules(const IgnoreRules *rules)
+{
+    ignore_rules = rules;
+}
+
 static char *
 construct_rsync_local_dir_arg(WorkspaceInformation *ws_info, const char *relative_path)
 {
@@ -15,7 +99,7 @@ construct_remote_dir_arg_for_ssh(RemoteWorkspaceMetadata *remote_system, const c
 {
     char *remote_dir_path = concat_paths(remote_system->remote_workspace_root_path, relative_dir_path);
 
-    SshConnectionInformation *connection_information = remote_system->connection_information.sshConnectionInformation;
+    SshConnectionInformation *connection_information = remote_system->connection_information.ssh_connection_information;
 
     char *arg;
     if (connection_information->username != NULL) {
@@ -53,7 +137,7 @@ construct_remote_dir_arg_for_rsync_daemon(RemoteWorkspaceMetadata *remote_system
 {
     char *remote_dir_path = concat_paths(remote_system->remote_workspace_root_path, relative_dir_path);
 
-    RsyncConnectionInformation *connection_information = remote_system->connection_information.rsyncConnectionInformation;
+    RsyncConnectionInformation *connection_information = remote_system->connection_information.rsync_connection_information;
 
     char *user_and_host_segment;
     if (connection_information->username != NULL) {
@@ -89,6 +173,8 @@ construct_rsync_remote_dir_arg(RemoteWorkspaceMetadata *remote_system, const cha
             return construct_remote_dir_arg_for_ssh_host_alias(remote_system, relative_path);
         case RSYNC_DAEMON:
             return construct_remote_dir_arg_for_rsync_daemon(remote_system, relative_path);
+        case LOCAL_PATH:
+            return concat_paths(remote_system->remote_workspace_root_path, relative_path);
         default:
             fatal_custom_error(
                     "Unknown error occurred while constructing rsync remote dir arg because of connection type '%s'",
@@ -97,33 +183,190 @@ construct_rsync_remote_dir_arg(RemoteWorkspaceMetadata *remote_system, const cha
     }
 }
 
+/*
+ * Appends the options shared by all rsync invocations, which are at most 8 arguments.
+ */
+static void
+append_rsync_options(char **args, int *index, const RemoteWorkspaceMetadata *remote_system)
+{
+    const TransferProfile *profile = get_transfer_profile(remote_system);
+
+    // The statistics printed instead of running quietly measure the link, see 'transfer_tuning.h'
+    args[(*index)++] = resync_strdup("rsync");
+    args[(*index)++] = resync_strdup("-a");
+    args[(*index)++] = resync_strdup("--stats");
+    args[(*index)++] = resync_strdup("--delete");
+
+    if (profile->is_compressed) {
+        args[(*index)++] = resync_strdup("-z");
+    }
+    if (profile->is_compressed && profile->compress_level > 0) {
+        args[(*index)++] = format_string("--compress-level=%d", profile->compress_level);
+    }
+    if (profile->is_whole_file) {
+        args[(*index)++] = resync_strdup("--whole-file");
+    }
+    if (profile->is_inplace) {
+        args[(*index)++] = resync_strdup("--inplace");
+    }
+}
+
+/*
+ * Appends the ignore rules as filters of an rsync invocation that syncs the directory. Excluded resources are neither
+ *  transferred nor deleted on the remote system, as '--delete' spares them. The arguments are grown accordingly.
+ */
+static char **
+append_rsync_filters(char **args, int *index, int *args_buffer_size, const char *relative_path)
+{
+    char **filter_rules = get_rsync_filter_rules(ignore_rules, relative_path);
+
+    int filter_rules_count = 0;
+    while (filter_rules[filter_rules_count] != NULL) {
+        filter_rules_count++;
+    }
+
+    *args_buffer_size += filter_rules_count;
+    args = (char **) do_realloc(args, *args_buffer_size * sizeof(char *));
+
+    for (int i = 0; i < filter_rules_count; i++) {
+        args[(*index)++] = format_string("--filter=%s", filter_rules[i]);
+        DO_FREE(filter_rules[i]);
+    }
+
+    DO_FREE(filter_rules);
+    return args;
+}
+
+/*
+ * Appends the filters that exclude the partitions from an rsync invocation that syncs the workspace root. They precede
+ *  the ignore rules, since rsync applies the first filter that matches. The arguments are grown accordingly.
+ */
+static char **
+append_rsync_partition_filters(char **args, int *index, int *args_buffer_size, const SyncPartitionList *partitions)
+{
+    const SyncPartitionList *partition;
+    LL_FOREACH(partitions, partition) {
+        *args_buffer_size += 1;
+        args = (char **) do_realloc(args, *args_buffer_size * sizeof(char *));
+        args[(*index)++] = format_string("--filter=- /%s/", partition->path_relative_to_ws_root);
+    }
+
+    return args;
+}
+
+/*
+ * @param excluded_partitions partitions that are synced by invocations of their own and are neither transferred nor
+ *  deleted by this one, only passed for the workspace root
+ */
 static char**
-construct_rsync_cmd_arguments(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system, const char *relative_path)
+construct_rsync_cmd_arguments(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system,
+                              const char *relative_path, const RsyncBatch *batch,
+                              const SyncPartitionList *excluded_partitions)
 {
     int index = 0;
-    int current_args_buffer_size = 6;
+    int current_args_buffer_size = 12;
     char **args =  (char **) do_malloc(current_args_buffer_size * sizeof(char *));
 
-    args[index++] = resync_strdup("rsync");
-    args[index++] = resync_strdup("-azq");
-    args[index++] = resync_strdup("--delete");
+    append_rsync_options(args, &index, remote_system);
+    args = append_rsync_partition_filters(args, &index, &current_args_buffer_size, excluded_partitions);
+    args = append_rsync_filters(args, &index, &current_args_buffer_size, relative_path);
+    if (batch != NULL) {
+        args[index++] = format_string("--%s-batch=%s", batch->is_replay ? "read" : "write", batch->path);
+    }
 
-    if (remote_system->connection_type == SSH
-        && remote_system->connection_information.sshConnectionInformation->path_to_identity_file != NULL) {
+    if (is_ssh_remote_system(remote_system)) {
+        // Rides on the daemon's persistent master connection instead of performing a handshake for every sync. The
+        //  remote shell command has to be passed as separate argument, it is split into words by rsync itself.
+        current_args_buffer_size += 2;
+        args = (char **) do_realloc(args, current_args_buffer_size * sizeof(char*));
 
-        args = (char **) do_realloc(args, ++current_args_buffer_size * sizeof(char*));
+        args[index++] = resync_strdup("-e");
+        args[index++] = construct_ssh_remote_shell_command(remote_system);
+    }
 
-        char *path_to_identity_file = remote_system->connection_information.sshConnectionInformation->path_to_identity_file;
-        args[index++] = format_string("-e \"ssh -i %s\"", path_to_identity_file);
+    // A replayed batch takes the place of the local directory
+    if (batch == NULL || !batch->is_replay) {
+        args[index++] = construct_rsync_local_dir_arg(ws_info, relative_path);
     }
+    args[index++] = construct_rsync_remote_dir_arg(remote_system, relative_path);
+    args[index++] = (char *) NULL;
 
-    args[index++] = construct_rsync_local_dir_arg(ws_info, relative_path);
+    return args;
+}
+
+/*
+ * @return the arguments of an rsync invocation that appends the data that was appended to the file since it was last
+ *  synced to the remote file. '--append-verify' checks the entire file and transfers it again if the remote file is not
+ *  a prefix of it, while '--append' trusts the remote file, so that only the appended data is read on both ends.
+ */
+static char **
+construct_rsync_append_cmd_arguments(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system,
+                                     const char *relative_path, const bool is_verified)
+{
+    int index = 0;
+    char **args = (char **) do_malloc(14 * sizeof(char *));
+
+    append_rsync_options(args, &index, remote_system);
+    args[index++] = resync_strdup(is_verified ? "--append-verify" : "--append");
+
+    if (is_ssh_remote_system(remote_system)) {
+        args[index++] = resync_strdup("-e");
+        args[index++] = construct_ssh_remote_shell_command(remote_system);
+    }
+
+    args[index++] = concat_paths(ws_info->local_workspace_root_path, relative_path);
     args[index++] = construct_rsync_remote_dir_arg(remote_system, relative_path);
     args[index++] = (char *) NULL;
 
     return args;
 }
 
+/*
+ * @return the shell command that syncs the directory from the relay to the remote system behind it, which is run on the
+ *  relay. The remote system is reached with the relay's own ssh configuration.
+ */
+static char *
+construct_relayed_rsync_command(RemoteWorkspaceMetadata *relay, RemoteWorkspaceMetadata *remote_system,
+                                const char *relative_path)
+{
+    int index = 0;
+    int args_buffer_size = 12;
+    char **args = (char **) do_malloc(args_buffer_size * sizeof(char *));
+
+    append_rsync_options(args, &index, remote_system);
+    args = append_rsync_filters(args, &index, &args_buffer_size, relative_path);
+
+    if (is_ssh_remote_system(remote_system)) {
+        const SshConnectionInformation *connection_information = remote_system->connection_information.ssh_connection_information;
+
+        args[index++] = resync_strdup("-e");
+        if (remote_system->connection_type == SSH && connection_information->path_to_identity_file != NULL) {
+            args[index++] = format_string("ssh -o BatchMode=yes -i \"%s\"", connection_information->path_to_identity_file);
+        } else {
+            args[index++] = resync_strdup("ssh -o BatchMode=yes");
+        }
+    }
+
+    char *relay_dir_path = concat_paths(relay->remote_workspace_root_path, relative_path);
+    args[index++] = format_string("%s/", relay_dir_path);
+    args[index++] = construct_rsync_remote_dir_arg(remote_system, relative_path);
+    DO_FREE(relay_dir_path);
+
+    char *command = NULL;
+    for (int i = 0; i < index; i++) {
+        char *quoted_arg = quote_shell_argument(args[i]);
+        char *extended_command = (command == NULL) ? resync_strdup(quoted_arg) : format_string("%s %s", command, quoted_arg);
+
+        DO_FREE(quoted_arg);
+        DO_FREE(command);
+        DO_FREE(args[i]);
+        command = extended_command;
+    }
+
+    DO_FREE(args);
+    return command;
+}
+
 static void
 free_args_array(char **args)
 {
@@ -136,44 +379,446 @@ free_args_array(char **args)
     DO_FREE(args);
 }
 
-static int
-execute_rsync_command(char **args)
+static char *
+read_rsync_output(const int fd)
 {
+    size_t capacity = 4096, size = 0;
+    char *output = (char *) do_malloc(capacity);
+
+    while (true) {
+        if (size + 1 == capacity) {
+            capacity *= 2;
+            output = (char *) do_realloc(output, capacity);
+        }
+
+        const ssize_t ret = read(fd, output + size, capacity - size - 1);
+        if (ret == -1 && errno == EINTR) {
+            continue;
+        } else if (ret <= 0) {
+            break;
+        }
+        size += ret;
+    }
+
+    output[size] = '\0';
+    return output;
+}
+
+/*
+ * @param input_fd descriptor the command reads its standard input from, or -1 if it reads none
+ * @param output_fd set to the read end of a pipe that receives the standard output of the command
+ */
+static pid_t
+start_sync_command(char **args, const int input_fd, int *output_fd)
+{
+    int pipe_fds[2];
+    if (pipe2(pipe_fds, O_CLOEXEC) == -1) {
+        fatal_error("pipe2");
+    }
+
     const pid_t pid = fork();
 
     if (pid < 0) {
         fatal_error("fork");
     } else if (pid == 0) {
-        execvp("rsync", args);
+        if (input_fd != -1) {
+            dup2(input_fd, STDIN_FILENO);
+        }
+        dup2(pipe_fds[1], STDOUT_FILENO);
+        execvp(args[0], args);
         fatal_error("execvp");
     }
 
+    close(pipe_fds[1]);
+    *output_fd = pipe_fds[0];
+    return pid;
+}
+
+/*
+ * @param output set to the standard output of rsync
+ */
+static int
+execute_sync_command(char **args, char **output)
+{
+    int output_fd;
+    const pid_t pid = start_sync_command(args, -1, &output_fd);
+
+    *output = read_rsync_output(output_fd);
+    close(output_fd);
+
     int status;
     waitpid(pid, &status, 0);
 
     return WEXITSTATUS(status);
 }
 
+static double
+now_sec(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+/*
+ * Runs the command, which prints the statistics of an rsync invocation that syncs with the remote system, and measures
+ *  the link with them. The arguments are freed.
+ */
+static int
+run_sync_command(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system, char **args)
+{
+    char *output;
+    const double start = now_sec();
+    const int exit_status = execute_sync_command(args, &output);
+    const double elapsed_sec = now_sec() - start;
+    free_args_array(args);
+
+    RsyncTransferStats stats;
+    if (exit_status == EXIT_SUCCESS && parse_rsync_transfer_stats(output, elapsed_sec, &stats)) {
+        record_rsync_transfer(remote_system, &stats);
+
+        char *error_msg = NULL;
+        if (!store_transfer_status(ws_info, &error_msg)) {
+            LOG_ERROR("%s", error_msg);
+            DO_FREE(error_msg);
+        }
+    }
+
+    DO_FREE(output);
+    return exit_status;
+}
+
+static int
+run_rsync(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system, const char *relative_path,
+          const RsyncBatch *batch)
+{
+    return run_sync_command(ws_info, remote_system, construct_rsync_cmd_arguments(ws_info, remote_system, relative_path, batch, NULL));
+}
+
+static int
+run_relayed_rsync(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *relay, RemoteWorkspaceMetadata *remote_system,
+                  const char *relative_path)
+{
+    char *command = construct_relayed_rsync_command(relay, remote_system, relative_path);
+    char **args = construct_ssh_remote_command_arguments(relay, command);
+    DO_FREE(command);
+
+    return run_sync_command(ws_info, remote_system, args);
+}
+
+static void
+acquire_sync_lease(const RemoteWorkspaceMetadata *remote_system)
+{
+    if (lease_handlers.acquire != NULL) {
+        lease_handlers.acquire(get_remote_system_host(remote_system));
+    }
+}
+
+static void
+release_sync_lease(const RemoteWorkspaceMetadata *remote_system)
+{
+    if (lease_handlers.release != NULL) {
+        lease_handlers.release(get_remote_system_host(remote_system));
+    }
+}
+
+static RemoteSyncGeneration *
+get_remote_sync_generation(const RemoteWorkspaceMetadata *remote_system)
+{
+    RemoteSyncGeneration *entry;
+    LL_SEARCH_SCALAR(sync_generations, entry, remote_system, remote_system);
+    if (entry == NULL) {
+        // Changes are only synchronized once the initial sync brought all remote systems in sync with the workspace
+        entry = (RemoteSyncGeneration *) do_calloc(1, sizeof(RemoteSyncGeneration));
+        entry->remote_system = remote_system;
+        entry->generation = current_sync_generation;
+        LL_APPEND(sync_generations, entry);
+    }
+
+    return entry;
+}
+
+static void
+release_remote_sync_generation(const RemoteWorkspaceMetadata *remote_system)
+{
+    RemoteSyncGeneration *entry;
+    LL_SEARCH_SCALAR(sync_generations, entry, remote_system, remote_system);
+    if (entry != NULL) {
+        LL_DELETE(sync_generations, entry);
+        DO_FREE(entry);
+    }
+}
+
+/*
+ * Syncs the directory from the relay to the remote system behind it, so that the data crosses the link to the relay
+ *  only once, no matter how many remote systems are behind it.
+ */
 static void
+synchronize_through_relay(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *relay,
+                          RemoteWorkspaceMetadata *remote_system, const char *relative_path)
+{
+    acquire_sync_lease(remote_system);
+
+    if (run_relayed_rsync(ws_info, relay, remote_system, relative_path) != EXIT_SUCCESS
+        && run_relayed_rsync(ws_info, relay, remote_system, NULL) != EXIT_SUCCESS) {
+        fatal_custom_error("Error: Failed to sync with remote system through its relay");
+    }
+
+    release_sync_lease(remote_system);
+}
+
+static void
+synchronize_relayed_remote_systems(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *relay, const char *relative_path)
+{
+    RemoteWorkspaceMetadata *remote_system;
+    LL_FOREACH(ws_info->remote_systems, remote_system) {
+        if (get_relay_parent(ws_info, remote_system) == relay) {
+            synchronize_through_relay(ws_info, relay, remote_system, relative_path);
+        }
+    }
+}
+
+void
 synchronize_with_remote_system(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system, const char *relative_path)
 {
-    char **args = construct_rsync_cmd_arguments(ws_info, remote_system, relative_path);
+    if (remote_system->relay_parent != NULL) {
+        RemoteWorkspaceMetadata *relay = get_relay_parent(ws_info, remote_system);
+        if (relay == NULL) {
+            LOG_ERROR("Relay parent '%s' is not a remote system of the workspace", remote_system->relay_parent);
+            return;
+        }
 
-    int exit_status = execute_rsync_command(args);
-    free_args_array(args);
+        synchronize_through_relay(ws_info, relay, remote_system, relative_path);
+        return;
+    }
 
-    if (exit_status != EXIT_SUCCESS) {
+    acquire_sync_lease(remote_system);
+
+    // A directory whose parent the remote system may not have yet is synced along with the parent instead of failing
+    char *sync_root = get_remote_sync_root(remote_system, relative_path);
+    bool is_fully_synced = (sync_root == NULL);
+    if (run_rsync(ws_info, remote_system, sync_root, NULL) == EXIT_SUCCESS) {
+        confirm_remote_directory(remote_system, sync_root);
+    } else {
         // Attempt to sync the workspace starting from the ws root, since its possible that (parts) of the remote folder
         //  were manually deleted
-        args = construct_rsync_cmd_arguments(ws_info, remote_system, NULL);
+        invalidate_remote_directories(remote_system);
+        if (run_rsync(ws_info, remote_system, NULL, NULL) != EXIT_SUCCESS) {
+            fatal_custom_error("Error: Failed to sync with remote system");
+        }
+        confirm_remote_directory(remote_system, NULL);
+        is_fully_synced = true;
+    }
 
-        exit_status = execute_rsync_command(args);
-        free_args_array(args);
+    release_sync_lease(remote_system);
 
-        if (exit_status != EXIT_SUCCESS) {
-            fatal_custom_error("Error: Failed to sync with remote system");
+    if (is_fully_synced) {
+        get_remote_sync_generation(remote_system)->generation = current_sync_generation;
+    }
+
+    synchronize_relayed_remote_systems(ws_info, remote_system, is_fully_synced ? NULL : sync_root);
+    DO_FREE(sync_root);
+}
+
+/*
+ * Runs the commands with at most 'streams_count' of them at once. Their statistics are discarded, since commands that
+ *  share the link do not measure it. No further commands are started once one of them failed. The commands are freed.
+ *
+ * @return whether all commands exited successfully
+ */
+static bool
+run_concurrent_sync_commands(ConcurrentSyncCommand *commands, const uint32_t commands_count, const uint32_t streams_count)
+{
+    pid_t *pids = (pid_t *) do_calloc(streams_count, sizeof(pid_t));
+    struct pollfd *poll_fds = (struct pollfd *) do_calloc(streams_count, sizeof(struct pollfd));
+    for (uint32_t i = 0; i < streams_count; i++) {
+        poll_fds[i].fd = -1;
+    }
+
+    uint32_t next_command = 0;
+    uint32_t running_count = 0;
+    bool is_synced = true;
+
+    while (true) {
+        for (uint32_t i = 0; i < streams_count && next_command < commands_count && is_synced; i++) {
+            if (pids[i] != 0) {
+                continue;
+            }
+
+            ConcurrentSyncCommand *command = &commands[next_command++];
+            pids[i] = start_sync_command(command->args, command->input_fd, &poll_fds[i].fd);
+            poll_fds[i].events = POLLIN;
+
+            LOG("Syncing subtree '%s'", (command->relative_path != NULL) ? command->relative_path : "/");
+            running_count++;
+        }
+
+        if (running_count == 0) {
+            break;
+        }
+
+        if (poll(poll_fds, streams_count, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fatal_error("poll");
+        }
+
+        for (uint32_t i = 0; i < streams_count; i++) {
+            if (pids[i] == 0 || poll_fds[i].revents == 0) {
+                continue;
+            }
+
+            char output[4096];
+            const ssize_t ret = read(poll_fds[i].fd, output, sizeof(output));
+            if (ret > 0 || (ret == -1 && errno == EINTR)) {
+                continue;
+            }
+
+            // The output ends once the command exited
+            close(poll_fds[i].fd);
+            int status;
+            waitpid(pids[i], &status, 0);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+                is_synced = false;
+            }
+
+            pids[i] = 0;
+            poll_fds[i] = (struct pollfd) {.fd = -1, .events = 0, .revents = 0};
+            running_count--;
+        }
+    }
+
+    for (uint32_t i = 0; i < commands_count; i++) {
+        free_args_array(commands[i].args);
+        if (commands[i].input_fd != -1) {
+            close(commands[i].input_fd);
         }
     }
+
+    DO_FREE(pids);
+    DO_FREE(poll_fds);
+    return is_synced;
+}
+
+/*
+ * Syncs the partitions with concurrent rsync invocations, after the invocation for the workspace root created their
+ *  parent directories.
+ */
+static bool
+synchronize_partitions(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system,
+                       const SyncPartitionList *partitions, const uint32_t streams_count)
+{
+    char **args = construct_rsync_cmd_arguments(ws_info, remote_system, NULL, NULL, partitions);
+    if (run_sync_command(ws_info, remote_system, args) != EXIT_SUCCESS) {
+        return false;
+    }
+
+    const SyncPartitionList *partition;
+    uint32_t partitions_count;
+    LL_COUNT(partitions, partition, partitions_count);
+
+    ConcurrentSyncCommand *commands = (ConcurrentSyncCommand *) do_calloc(partitions_count, sizeof(ConcurrentSyncCommand));
+    uint32_t index = 0;
+    LL_FOREACH(partitions, partition) {
+        commands[index++] = (ConcurrentSyncCommand) {
+            .args = construct_rsync_cmd_arguments(ws_info, remote_system, partition->path_relative_to_ws_root, NULL, NULL),
+            .input_fd = -1,
+            .relative_path = partition->path_relative_to_ws_root
+        };
+    }
+
+    const bool is_synced = run_concurrent_sync_commands(commands, partitions_count, streams_count);
+    DO_FREE(commands);
+    return is_synced;
+}
+
+/*
+ * Streams the workspace to the remote system if its workspace root is empty (see 'bootstrap.h'), with a stream for
+ *  each partition and one for everything else. The latter is extracted last, since extracting the partitions modifies
+ *  the directories that contain them, whose modification times it restores.
+ *
+ * @return whether the remote system was bootstrapped
+ */
+static bool
+bootstrap_remote_system(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system,
+                        const SyncPartitionList *partitions, const uint32_t streams_count)
+{
+    bool is_compressed;
+    if (!is_bootstrap_target(remote_system, &is_compressed)) {
+        return false;
+    }
+
+    LOG("Bootstrapping the empty remote workspace '%s'%s", remote_system->remote_workspace_root_path,
+        is_compressed ? " with compressed archives" : "");
+
+    const SyncPartitionList *partition;
+    uint32_t partitions_count;
+    LL_COUNT(partitions, partition, partitions_count);
+
+    ConcurrentSyncCommand *commands = (ConcurrentSyncCommand *) do_calloc(partitions_count + 1, sizeof(ConcurrentSyncCommand));
+    uint32_t index = 0;
+    LL_FOREACH(partitions, partition) {
+        commands[index].relative_path = partition->path_relative_to_ws_root;
+        commands[index].args = construct_bootstrap_command(
+                ws_info, remote_system, ignore_rules, partition->path_relative_to_ws_root, NULL, is_compressed,
+                &commands[index].input_fd
+        );
+        index++;
+    }
+
+    ConcurrentSyncCommand *root_command = &commands[partitions_count];
+    root_command->relative_path = NULL;
+    root_command->args = construct_bootstrap_command(
+            ws_info, remote_system, ignore_rules, NULL, partitions, is_compressed, &root_command->input_fd
+    );
+
+    bool is_bootstrapped = run_concurrent_sync_commands(commands, partitions_count, streams_count);
+    if (is_bootstrapped) {
+        is_bootstrapped = run_concurrent_sync_commands(root_command, 1, 1);
+    } else {
+        free_args_array(root_command->args);
+        close(root_command->input_fd);
+    }
+    DO_FREE(commands);
+
+    if (!is_bootstrapped) {
+        LOG_ERROR("Failed to bootstrap the remote workspace '%s'", remote_system->remote_workspace_root_path);
+    }
+    return is_bootstrapped;
+}
+
+void
+synchronize_entire_workspace(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system,
+                             const SyncPartitionList *partitions, const uint32_t streams_count)
+{
+    if (remote_system->relay_parent != NULL) {
+        synchronize_with_remote_system(ws_info, remote_system, NULL);
+        return;
+    }
+
+    // The concurrent streams count as a single sync, as they ride on the same connection
+    acquire_sync_lease(remote_system);
+
+    bool is_synced = bootstrap_remote_system(ws_info, remote_system, partitions, streams_count);
+    if (!is_synced && partitions != NULL) {
+        is_synced = synchronize_partitions(ws_info, remote_system, partitions, streams_count);
+        if (!is_synced) {
+            LOG_ERROR("Partitioned sync with remote system failed, syncing the workspace as a whole");
+        }
+    }
+
+    release_sync_lease(remote_system);
+
+    // A failed bootstrap or partitioned sync is completed by syncing the workspace as a whole
+    if (!is_synced) {
+        synchronize_with_remote_system(ws_info, remote_system, NULL);
+        return;
+    }
+
+    confirm_remote_directory(remote_system, NULL);
+    get_remote_sync_generation(remote_system)->generation = current_sync_generation;
+    synchronize_relayed_remote_systems(ws_info, remote_system, NULL);
 }
 
 void
@@ -181,7 +826,661 @@ synchronize_workspace(WorkspaceInformation *workspace_information, const char *r
 {
     RemoteWorkspaceMetadata *entry;
     LL_FOREACH(workspace_information->remote_systems, entry) {
-        synchronize_with_remote_system(workspace_information, entry, relative_path);
+        // Remote systems behind a relay are synced along with it
+        if (entry->relay_parent == NULL) {
+            synchronize_with_remote_system(workspace_information, entry, relative_path);
+        }
+    }
+}
+
+
+static AgentConnection *
+get_agent_connection(RemoteWorkspaceMetadata *remote_system)
+{
+    AgentConnection *connection;
+    LL_SEARCH_SCALAR(agent_connections, connection, remote_system, remote_system);
+    if (connection == NULL) {
+        connection = create_agent_connection(remote_system);
+        LL_APPEND(agent_connections, connection);
+    }
+
+    return connection;
+}
+
+static void
+release_agent_connection(const RemoteWorkspaceMetadata *remote_system)
+{
+    AgentConnection *connection;
+    LL_SEARCH_SCALAR(agent_connections, connection, remote_system, remote_system);
+    if (connection != NULL) {
+        LL_DELETE(agent_connections, connection);
+        destroy_agent_connection(&connection);
+    }
+}
+
+static char *
+get_sync_batch_file_path(const WorkspaceInformation *ws_info)
+{
+    return format_string(
+            "%s/%016llx.%s",
+            DEFAULT_RESYNC_SYNC_STATE_DIRECTORY,
+            (unsigned long long) hash_string(ws_info->local_workspace_root_path),
+            SYNC_BATCH_FILE_EXTENSION
+    );
+}
+
+static void
+remove_sync_batch_files(const char *batch_path)
+{
+    // rsync writes a shell script for replaying the batch manually next to it
+    char *script_path = format_string("%s.sh", batch_path);
+    unlink(batch_path);
+    unlink(script_path);
+    DO_FREE(script_path);
+}
+
+/*
+ * @return the sync root of the directory that is valid for all members of the group, i.e. the topmost one, as the sync
+ *  roots of all members are the directory or one of its ancestors
+ */
+static char *
+get_group_sync_root(const SyncGroup *group, const char *relative_path)
+{
+    char *sync_root = resync_strdup(relative_path);
+
+    const SyncGroupMember *member;
+    LL_FOREACH(group->members, member) {
+        char *member_sync_root = get_remote_sync_root(member->remote_system, relative_path);
+        if (sync_root != NULL && (member_sync_root == NULL || strlen(member_sync_root) < strlen(sync_root))) {
+            DO_FREE(sync_root);
+            sync_root = member_sync_root;
+        } else {
+            DO_FREE(member_sync_root);
+        }
+    }
+
+    return sync_root;
+}
+
+/*
+ * Syncs the directory with the first remote system of the group while writing the changes into a batch, which is then
+ *  replayed to the other remote systems. The delta is therefore computed and read from the local disk once, instead of
+ *  once for every remote system. A remote system that is not in the state the batch was written against rejects the
+ *  files that fail to verify, and is synced on its own instead.
+ */
+static void
+synchronize_directory_with_group(WorkspaceInformation *ws_info, SyncGroup *group, const char *relative_path)
+{
+    if (group->members->next == NULL) {
+        synchronize_with_remote_system(ws_info, group->members->remote_system, relative_path);
+        return;
+    }
+
+    if (mkdir(DEFAULT_RESYNC_SYNC_STATE_DIRECTORY, 0700) == -1 && errno != EEXIST) {
+        LOG_ERROR("Unable to create the directory of the sync batch: %s", strerror(errno));
+    }
+
+    char *batch_path = get_sync_batch_file_path(ws_info);
+    RsyncBatch batch = {.path = batch_path, .is_replay = false};
+    char *sync_root = get_group_sync_root(group, relative_path);
+
+    RemoteWorkspaceMetadata *leader = group->members->remote_system;
+    acquire_sync_lease(leader);
+    const bool is_batch_written = (run_rsync(ws_info, leader, sync_root, &batch) == EXIT_SUCCESS);
+    release_sync_lease(leader);
+
+    if (is_batch_written) {
+        confirm_remote_directory(leader, sync_root);
+        synchronize_relayed_remote_systems(ws_info, leader, sync_root);
+    }
+
+    SyncGroupMember *member;
+    LL_FOREACH(group->members, member) {
+        if (!is_batch_written) {
+            synchronize_with_remote_system(ws_info, member->remote_system, relative_path);
+            continue;
+        } else if (member->remote_system == leader) {
+            continue;
+        }
+
+        batch.is_replay = true;
+        acquire_sync_lease(member->remote_system);
+        const int exit_status = run_rsync(ws_info, member->remote_system, sync_root, &batch);
+        release_sync_lease(member->remote_system);
+
+        if (exit_status != EXIT_SUCCESS) {
+            LOG_ERROR(
+                    "Remote system '%s:%s' diverged from the other remote systems, syncing it on its own",
+                    get_remote_system_host(member->remote_system),
+                    member->remote_system->remote_workspace_root_path
+            );
+            member->is_diverged = true;
+            synchronize_with_remote_system(ws_info, member->remote_system, relative_path);
+        } else {
+            confirm_remote_directory(member->remote_system, sync_root);
+            synchronize_relayed_remote_systems(ws_info, member->remote_system, sync_root);
+        }
     }
+
+    remove_sync_batch_files(batch_path);
+    DO_FREE(batch_path);
+    DO_FREE(sync_root);
+}
+
+static bool
+is_append_change(const WorkspaceChange *change)
+{
+    return change->type == FILE_WRITTEN && (change->is_appended || change->append_offset > 0);
 }
 
+/*
+ * Syncs the appended file on its own, or the directory containing it if that fails. Remote systems behind the remote
+ *  system receive the directory from it.
+ */
+static void
+synchronize_appended_file(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system,
+                          const WorkspaceChange *change)
+{
+    // Appending to a file in a directory that the remote system may not have yet would fail
+    if (is_remote_directory_unconfirmed(remote_system, change->relative_directory_path)) {
+        synchronize_with_remote_system(ws_info, remote_system, change->relative_directory_path);
+        return;
+    }
+
+    acquire_sync_lease(remote_system);
+    const int exit_status = run_sync_command(
+            ws_info,
+            remote_system,
+            construct_rsync_append_cmd_arguments(ws_info, remote_system, change->relative_path, change->append_offset == 0)
+    );
+    release_sync_lease(remote_system);
+
+    if (exit_status != EXIT_SUCCESS) {
+        synchronize_with_remote_system(ws_info, remote_system, change->relative_directory_path);
+        return;
+    }
+
+    synchronize_relayed_remote_systems(ws_info, remote_system, change->relative_directory_path);
+}
+
+static void
+synchronize_change_with_group(WorkspaceInformation *ws_info, SyncGroup *group, const WorkspaceChange *change)
+{
+    SyncGroupMember *member;
+    if (is_append_change(change)) {
+        // The appended data is small compared to the delta of the directory, so it is not worth a batch
+        LL_FOREACH(group->members, member) {
+            synchronize_appended_file(ws_info, member->remote_system, change);
+        }
+    } else if (change->type != MODE_CHANGED) {
+        // Modes are picked up by the next sync of the directory
+        if (change->type == RESOURCE_MOVED && !is_equal(change->relative_source_directory_path, change->relative_directory_path)) {
+            synchronize_directory_with_group(ws_info, group, change->relative_source_directory_path);
+        }
+
+        synchronize_directory_with_group(ws_info, group, change->relative_directory_path);
+    }
+
+    LL_FOREACH(group->members, member) {
+        // A diverged remote system is only grouped again once it is fully synced
+        RemoteSyncGeneration *entry = get_remote_sync_generation(member->remote_system);
+        if (member->is_diverged) {
+            entry->generation = SYNC_GENERATION_DIVERGED;
+        } else if (entry->generation != SYNC_GENERATION_DIVERGED) {
+            entry->generation = current_sync_generation;
+        }
+    }
+}
+
+static void
+synchronize_change_with_rsync(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system,
+                              const WorkspaceChange *change)
+{
+    // Modes are picked up by the next sync of the directory
+    if (change->type == MODE_CHANGED) {
+        return;
+    } else if (is_append_change(change) && remote_system->relay_parent == NULL) {
+        synchronize_appended_file(ws_info, remote_system, change);
+        return;
+    }
+
+    if (change->type == RESOURCE_MOVED && !is_equal(change->relative_source_directory_path, change->relative_directory_path)) {
+        synchronize_with_remote_system(ws_info, remote_system, change->relative_source_directory_path);
+    }
+
+    synchronize_with_remote_system(ws_info, remote_system, change->relative_directory_path);
+}
+
+static bool
+is_empty_directory(const char *path)
+{
+    DIR *dir = opendir(path);
+    if (dir == NULL) {
+        return false;
+    }
+
+    bool is_empty = true;
+    struct dirent *entry;
+    while (is_empty && (entry = readdir(dir)) != NULL) {
+        is_empty = strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0;
+    }
+
+    closedir(dir);
+    return is_empty;
+}
+
+static void
+stream_change_to_agent(WorkspaceInformation *ws_info, AgentConnection *connection, const WorkspaceChange *change)
+{
+    char *local_path = concat_paths(ws_info->local_workspace_root_path, change->relative_path);
+
+    switch (change->type) {
+        case FILE_WRITTEN:
+            if (change->append_offset > 0) {
+                send_agent_appended_data(
+                        connection,
+                        local_path,
+                        change->relative_path,
+                        change->append_offset,
+                        change->relative_directory_path
+                );
+            } else {
+                send_agent_file(connection, local_path, change->relative_path, change->relative_directory_path);
+            }
+            break;
+        case DIRECTORY_CREATED:
+            if (is_empty_directory(local_path)) {
+                send_agent_change(connection, AGENT_MKDIR, change->relative_path, NULL, change->mode, change->relative_directory_path);
+                break;
+            }
+
+            // Content that was created before the directory was watched, or that was moved in along with the
+            //  directory, is not reported by events. The directory is synced with rsync once all records that were
+            //  sent before are applied, so that the agent and rsync do not modify the remote workspace concurrently.
+            await_agent_acks(connection);
+            synchronize_with_remote_system(ws_info, connection->remote_system, change->relative_directory_path);
+            break;
+        case RESOURCE_DELETED:
+            send_agent_change(connection, AGENT_DELETE, change->relative_path, NULL, 0, change->relative_directory_path);
+            break;
+        case RESOURCE_MOVED: {
+            char *fallback_directory = get_common_directory(
+                    change->relative_source_directory_path,
+                    change->relative_directory_path
+            );
+            send_agent_change(connection, AGENT_RENAME, change->relative_source_path, change->relative_path, 0, fallback_directory);
+            // A mode change of the source may not be reported anymore, as the source no longer exists once its
+            //  event is handled
+            send_agent_change(connection, AGENT_CHMOD, change->relative_path, NULL, change->mode, change->relative_directory_path);
+            DO_FREE(fallback_directory);
+            break;
+        }
+        case MODE_CHANGED:
+            send_agent_change(connection, AGENT_CHMOD, change->relative_path, NULL, change->mode, change->relative_directory_path);
+            break;
+        case OTHER_WORKSPACE_CHANGE_TYPE:
+        default:
+            break;
+    }
+
+    DO_FREE(local_path);
+}
+
+static void
+synchronize_change_with_agent(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system,
+                              const WorkspaceChange *change)
+{
+    // Records are not subject to the sync leases, as they do not put any load on the remote system beyond applying
+    //  the change itself
+    AgentConnection *connection = get_agent_connection(remote_system);
+    if (ensure_agent_connected(connection)) {
+        stream_change_to_agent(ws_info, connection, change);
+    } else {
+        synchronize_change_with_rsync(ws_info, remote_system, change);
+    }
+}
+
+static void
+flush_agent_connection(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system)
+{
+    AgentConnection *connection;
+    LL_SEARCH_SCALAR(agent_connections, connection, remote_system, remote_system);
+    if (connection == NULL) {
+        return;
+    }
+
+    await_agent_acks(connection);
+
+    AgentFallbackDirectory *fallback_directories = take_agent_fallback_directories(connection);
+
+    AgentFallbackDirectory *entry, *tmp;
+    LL_FOREACH_SAFE(fallback_directories, entry, tmp) {
+        LL_DELETE(fallback_directories, entry);
+        synchronize_with_remote_system(ws_info, remote_system, entry->path_relative_to_ws_root);
+        DO_FREE(entry->path_relative_to_ws_root);
+        DO_FREE(entry);
+    }
+}
+
+static char *
+get_mirror_path(const RemoteWorkspaceMetadata *remote_system, const char *relative_path)
+{
+    return concat_paths(remote_system->remote_workspace_root_path, relative_path);
+}
+
+/*
+ * @return false if the change could not be mirrored and has to be synced with rsync instead
+ */
+static bool
+mirror_change(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system, const WorkspaceChange *change,
+              char **error_msg)
+{
+    char *local_path = concat_paths(ws_info->local_workspace_root_path, change->relative_path);
+    char *mirror_path = get_mirror_path(remote_system, change->relative_path);
+
+    bool res;
+    switch (change->type) {
+        case FILE_WRITTEN:
+            res = (change->append_offset > 0)
+                    ? mirror_local_appended_data(local_path, mirror_path, change->append_offset, error_msg)
+                    : mirror_local_file(local_path, mirror_path, error_msg);
+            break;
+        case DIRECTORY_CREATED:
+            // Content that is not reported by events is picked up by syncing the directory, see 'stream_change_to_agent'
+            res = is_empty_directory(local_path) && mirror_local_directory(mirror_path, change->mode, error_msg);
+            break;
+        case RESOURCE_DELETED:
+            res = mirror_local_deletion(mirror_path, error_msg);
+            break;
+        case RESOURCE_MOVED: {
+            char *mirror_source_path = get_mirror_path(remote_system, change->relative_source_path);
+            res = mirror_local_move(mirror_source_path, mirror_path, error_msg)
+                    && mirror_local_mode(mirror_path, change->mode, error_msg);
+            DO_FREE(mirror_source_path);
+            break;
+        }
+        case MODE_CHANGED:
+            res = mirror_local_mode(mirror_path, change->mode, error_msg);
+            break;
+        case OTHER_WORKSPACE_CHANGE_TYPE:
+        default:
+            res = true;
+            break;
+    }
+
+    DO_FREE(local_path);
+    DO_FREE(mirror_path);
+    return res;
+}
+
+static void
+synchronize_change_with_local_mirror(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system,
+                                     const WorkspaceChange *change)
+{
+    char *error_msg = NULL;
+    if (mirror_change(ws_info, remote_system, change, &error_msg)) {
+        return;
+    }
+
+    if (error_msg != NULL) {
+        LOG_ERROR("Falling back to rsync for the local mirror '%s': %s", remote_system->remote_workspace_root_path, error_msg);
+        DO_FREE(error_msg);
+    }
+
+    if (change->type == MODE_CHANGED) {
+        synchronize_with_remote_system(ws_info, remote_system, change->relative_directory_path);
+    } else {
+        synchronize_change_with_rsync(ws_info, remote_system, change);
+    }
+}
+
+/* Remote systems with the 'LOCAL_PATH' connection type are always mirrored directly, regardless of their transport */
+static const SyncTransportOps local_mirror_transport = {
+        .synchronize_change = synchronize_change_with_local_mirror,
+        .flush = NULL,
+        .release = NULL
+};
+
+static const SyncTransportOps sync_transports[] = {
+        [RSYNC_TRANSPORT] = {
+                .synchronize_change = synchronize_change_with_rsync,
+                .flush = NULL,
+                .release = NULL
+        },
+        [AGENT_TRANSPORT] = {
+                .synchronize_change = synchronize_change_with_agent,
+                .flush = flush_agent_connection,
+                .release = release_agent_connection
+        }
+};
+
+static const SyncTransportOps *
+get_sync_transport(const RemoteWorkspaceMetadata *remote_system)
+{
+    if (remote_system->connection_type == LOCAL_PATH) {
+        return &local_mirror_transport;
+    }
+    return &sync_transports[remote_system->transport];
+}
+
+/*
+ * Adds the remote system to the group of remote systems in the same generation, diverged remote systems form a group
+ *  of their own.
+ */
+static void
+add_to_sync_group(SyncGroup **groups, RemoteWorkspaceMetadata *remote_system)
+{
+    const uint64_t generation = get_remote_sync_generation(remote_system)->generation;
+
+    SyncGroup *group = NULL;
+    if (generation != SYNC_GENERATION_DIVERGED) {
+        LL_SEARCH_SCALAR(*groups, group, generation, generation);
+    }
+    if (group == NULL) {
+        group = (SyncGroup *) do_calloc(1, sizeof(SyncGroup));
+        group->generation = generation;
+        LL_APPEND(*groups, group);
+    }
+
+    SyncGroupMember *member = (SyncGroupMember *) do_calloc(1, sizeof(SyncGroupMember));
+    member->remote_system = remote_system;
+    LL_APPEND(group->members, member);
+}
+
+static void
+destroy_sync_groups(SyncGroup **groups)
+{
+    SyncGroup *group, *tmp_group;
+    LL_FOREACH_SAFE(*groups, group, tmp_group) {
+        LL_DELETE(*groups, group);
+
+        SyncGroupMember *member, *tmp_member;
+        LL_FOREACH_SAFE(group->members, member, tmp_member) {
+            LL_DELETE(group->members, member);
+            DO_FREE(member);
+        }
+        DO_FREE(group);
+    }
+}
+
+void
+synchronize_change(WorkspaceInformation *ws_info, const WorkspaceChange *change)
+{
+    current_sync_generation++;
+
+    // Remote systems that use the rsync transport and are in the same generation received the same changes since they
+    //  were last fully synced, so they are in the same state and share the delta of the change
+    SyncGroup *groups = NULL;
+
+    RemoteWorkspaceMetadata *remote_system;
+    LL_FOREACH(ws_info->remote_systems, remote_system) {
+        const SyncTransportOps *transport = get_sync_transport(remote_system);
+        if (remote_system->relay_parent != NULL) {
+            // Synced along with its relay
+            continue;
+        } else if (transport == &sync_transports[RSYNC_TRANSPORT]) {
+            // The remote system has the directory once the sync of its parent succeeded
+            if (change->type == DIRECTORY_CREATED || change->type == RESOURCE_MOVED) {
+                add_unconfirmed_remote_directory(remote_system, change->relative_path);
+            }
+            add_to_sync_group(&groups, remote_system);
+        } else {
+            transport->synchronize_change(ws_info, remote_system, change);
+        }
+    }
+
+    SyncGroup *group;
+    LL_FOREACH(groups, group) {
+        synchronize_change_with_group(ws_info, group, change);
+    }
+
+    destroy_sync_groups(&groups);
+}
+
+void
+flush_synchronized_changes(WorkspaceInformation *ws_info)
+{
+    RemoteWorkspaceMetadata *remote_system;
+    LL_FOREACH(ws_info->remote_systems, remote_system) {
+        const SyncTransportOps *transport = get_sync_transport(remote_system);
+        if (transport->flush != NULL) {
+            transport->flush(ws_info, remote_system);
+        }
+    }
+}
+
+static void
+add_drift_check_directory(DriftCheckDirectory **directories, const char *relative_path)
+{
+    DriftCheckDirectory *directory = (DriftCheckDirectory *) do_calloc(1, sizeof(DriftCheckDirectory));
+    directory->relative_path = resync_strdup(relative_path);
+    LL_APPEND(*directories, directory);
+}
+
+/*
+ * @return whether the directories have different entries or subdirectories, i.e. whether the directory itself drifted
+ *  rather than (only) one of its subtrees
+ */
+static bool
+is_directory_drifted(const DirectoryDigest *local_digest, const DirectoryDigest *remote_digest)
+{
+    if (local_digest->entries_hash != remote_digest->entries_hash
+        || local_digest->subdirs_count != remote_digest->subdirs_count) {
+        return true;
+    }
+
+    for (uint32_t i = 0; i < local_digest->subdirs_count; i++) {
+        if (strcmp(local_digest->subdir_names[i], remote_digest->subdir_names[i]) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Compares the index of the workspace with that of the remote workspace, starting at the workspace root and descending
+ *  only into subtrees whose hashes differ, and syncs the directories that drifted with rsync.
+ */
+static void
+check_remote_system_for_drift(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system,
+                              WorkspaceIndex *index)
+{
+    AgentConnection *connection = get_agent_connection(remote_system);
+    if (!ensure_agent_connected(connection)) {
+        return;
+    }
+
+    // Changes in flight would be reported as drift
+    flush_agent_connection(ws_info, remote_system);
+    if (!send_agent_digest_rules(connection, index->ignore_rules, index->flags)) {
+        return;
+    }
+
+    DriftCheckDirectory *pending_directories = NULL, *drifted_directories = NULL;
+    add_drift_check_directory(&pending_directories, NULL);
+    uint32_t compared_count = 0;
+
+    while (pending_directories != NULL && connection->fd != -1) {
+        DriftCheckDirectory *directory = pending_directories;
+        LL_DELETE(pending_directories, directory);
+
+        DirectoryDigest *local_digest = get_directory_digest(index, directory->relative_path);
+        DirectoryDigest *remote_digest = request_agent_digest(connection, directory->relative_path);
+        compared_count++;
+
+        // A directory that no longer exists locally is removed remotely by the sync of its event
+        const bool is_compared = (local_digest != NULL && connection->fd != -1);
+        if (is_compared && (remote_digest == NULL || is_directory_drifted(local_digest, remote_digest))) {
+            LL_APPEND(drifted_directories, directory);
+            directory = NULL;
+        } else if (is_compared) {
+            for (uint32_t i = 0; i < local_digest->subdirs_count; i++) {
+                if (local_digest->subdir_hashes[i] != remote_digest->subdir_hashes[i]) {
+                    char *subdir_path = concat_paths(directory->relative_path, local_digest->subdir_names[i]);
+                    add_drift_check_directory(&pending_directories, subdir_path);
+                    DO_FREE(subdir_path);
+                }
+            }
+        }
+
+        destroy_directory_digest(&local_digest);
+        destroy_directory_digest(&remote_digest);
+        if (directory != NULL) {
+            DO_FREE(directory->relative_path);
+            DO_FREE(directory);
+        }
+    }
+
+    // The check is repeated once the connection is reestablished
+    DriftCheckDirectory *directory, *tmp;
+    LL_FOREACH_SAFE(pending_directories, directory, tmp) {
+        LL_DELETE(pending_directories, directory);
+        DO_FREE(directory->relative_path);
+        DO_FREE(directory);
+    }
+
+    LL_FOREACH_SAFE(drifted_directories, directory, tmp) {
+        LL_DELETE(drifted_directories, directory);
+        LOG(
+                "Remote workspace '%s' on '%s' drifted in '%s', syncing it",
+                remote_system->remote_workspace_root_path,
+                get_remote_system_host(remote_system),
+                (directory->relative_path != NULL) ? directory->relative_path : "."
+        );
+        synchronize_with_remote_system(ws_info, remote_system, directory->relative_path);
+        DO_FREE(directory->relative_path);
+        DO_FREE(directory);
+    }
+
+    LOG(
+            "Compared %u directories with remote workspace '%s' on '%s'",
+            compared_count,
+            remote_system->remote_workspace_root_path,
+            get_remote_system_host(remote_system)
+    );
+}
+
+void
+check_remote_systems_for_drift(WorkspaceInformation *ws_info, WorkspaceIndex *index)
+{
+    RemoteWorkspaceMetadata *remote_system;
+    LL_FOREACH(ws_info->remote_systems, remote_system) {
+        // Remote systems behind a relay are synced along with it
+        if (remote_system->relay_parent == NULL && get_sync_transport(remote_system) == &sync_transports[AGENT_TRANSPORT]) {
+            check_remote_system_for_drift(ws_info, remote_system, index);
+        }
+    }
+}
+
+void
+release_remote_system_transport(const RemoteWorkspaceMetadata *remote_system)
+{
+    const SyncTransportOps *transport = get_sync_transport(remote_system);
+    if (transport->release != NULL) {
+        transport->release(remote_system);
+    }
+
+    release_transfer_tuning(remote_system);
+    release_remote_sync_generation(remote_system);
+    release_remote_directories(remote_system);
+}
@@ -5,12 +5,114 @@
 #include "../util/fs_util.h"
 #include "../util/error.h"
 #include "../util/debug.h"
-#include "../types.h"
+#include "../util/ignore_rules.h"
+#include "../types/types.h"
+#include "ssh_control.h"
+#include "agent_connection.h"
+#include "linux/local_mirror.h"
+#include "transfer_tuning.h"
+#include "sync_state.h"
+#include "sync_partitions.h"
+#include "bootstrap.h"
+#include "workspace_index.h"
+#include "remote_directories.h"
+#include "../../lib/ulist.h"
 
+#include <stdint.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <time.h>
+#include <poll.h>
+
+/*
+ * Hooks that are invoked before and after every sync with a remote system, e.g. to limit the number of concurrent syncs
+ *  across workspaces. The passed host identifies the remote system (see 'get_remote_system_host').
+ */
+typedef struct SyncLeaseHandlers {
+    void (*acquire)(const char *host);
+    void (*release)(const char *host);
+} SyncLeaseHandlers;
+
+void set_sync_lease_handlers(const SyncLeaseHandlers *handlers);
+
+/**
+ * Sets the rules of the resources that rsync neither transfers nor deletes. Changes of ignored resources are expected to
+ *  be filtered before they are synchronized. The rules are not copied and have to outlive all syncs.
+ */
+void set_sync_ignore_rules(const IgnoreRules *rules);
+
+typedef enum WorkspaceChangeType {
+    OTHER_WORKSPACE_CHANGE_TYPE,
+    FILE_WRITTEN,
+    DIRECTORY_CREATED,
+    RESOURCE_DELETED,
+    RESOURCE_MOVED,
+    MODE_CHANGED
+} WorkspaceChangeType;
+
+/*
+ * Change of a single resource of the workspace. Remote systems using the rsync transport sync the directories that
+ *  contain the resource, remote systems using the agent transport receive a change record describing the change.
+ */
+typedef struct WorkspaceChange {
+    WorkspaceChangeType type;
+    /* Path of the changed resource, or its new path if it was moved */
+    const char *relative_path;
+    /* Directory containing the resource, NULL for the workspace root */
+    const char *relative_directory_path;
+    /* Previous path of a moved resource and the directory that contained it */
+    const char *relative_source_path;
+    const char *relative_source_directory_path;
+    /* Permission bits of the resource, unless it was written or deleted */
+    mode_t mode;
+    /* Whether the written file only grew since it was last synced, so that the appended data can be transferred alone */
+    bool is_appended;
+    /*
+     * Size of the written file that the remote systems already have, if the file is only ever appended to and its content
+     *  up to this size is known to be unchanged (0 otherwise). Only the data after it is transferred.
+     */
+    uint64_t append_offset;
+} WorkspaceChange;
 
 void synchronize_workspace(WorkspaceInformation *workspace_information, const char *relative_path);
 
+void synchronize_with_remote_system(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system, const char *relative_path);
+
+/**
+ * Syncs the entire workspace with the remote system, as the initial sync does. An empty remote workspace is bootstrapped
+ *  (see 'bootstrap.h'), otherwise the partitions are synced concurrently (see 'sync_partitions.h'). Falls back to a
+ *  single rsync invocation if neither applies, the remote system is behind a relay, or one of the commands failed.
+ */
+void synchronize_entire_workspace(WorkspaceInformation *ws_info, RemoteWorkspaceMetadata *remote_system,
+                                  const SyncPartitionList *partitions, uint32_t streams_count);
+
+/**
+ * Propagates the change to all remote systems of the workspace. Change records streamed to agents may still be in
+ *  flight when the function returns, see 'flush_synchronized_changes'. Remote systems that use the rsync transport and
+ *  are in the same state receive a batch that is computed once for all of them.
+ */
+void synchronize_change(WorkspaceInformation *ws_info, const WorkspaceChange *change);
+
+/**
+ * Waits until the agents acknowledged all change records and syncs the directories of the changes that an agent failed
+ *  to apply with rsync.
+ */
+void flush_synchronized_changes(WorkspaceInformation *ws_info);
+
+/**
+ * Compares the workspace with the remote systems that use the agent transport and syncs the directories that drifted,
+ *  e.g. as the remote workspace was modified by hand (see 'workspace_index.h'). The index has to be built with the
+ *  ignore rules of the syncs. Remote systems whose agent is not connected are skipped.
+ */
+void check_remote_systems_for_drift(WorkspaceInformation *ws_info, WorkspaceIndex *index);
+
+/**
+ * Closes the connection to the remote system's agent, if any, and drops the measurements of its link. Has to be called
+ *  before the remote system is destroyed.
+ */
+void release_remote_system_transport(const RemoteWorkspaceMetadata *remote_system);
+
 #endif //RESYNC_SYNC_H
@@ -0,0 +1,114 @@
+#include "sync_partitions.h"
+
+/*
+ * Partitions are excluded from the invocation for the root by filter rules, in which these characters are wildcards
+ */
+static bool
+is_filter_safe_path(const char *path)
+{
+    return strpbrk(path, "*?[\\") == NULL;
+}
+
+static int
+compare_partitions(const SyncPartitionList *partition, const SyncPartitionList *other_partition)
+{
+    if (partition->entries_count == other_partition->entries_count) {
+        return 0;
+    }
+    return (partition->entries_count > other_partition->entries_count) ? -1 : 1;
+}
+
+static void
+add_sync_partitions(SyncPartitionList **partitions, const SyncSubtree *subtree, const uint64_t target_entries_count)
+{
+    const uint64_t min_entries_count = target_entries_count / SYNC_PARTITION_MIN_SIZE_DIVISOR;
+
+    const SyncSubtree *subdir;
+    LL_FOREACH(subtree->subtrees, subdir) {
+        if (subdir->entries_count < min_entries_count || !is_filter_safe_path(subdir->path_relative_to_ws_root)) {
+            continue;
+        }
+
+        // Subtrees that exceed the target size are split further, unless they consist of files only
+        if (subdir->entries_count > target_entries_count && subdir->subtrees != NULL) {
+            add_sync_partitions(partitions, subdir, target_entries_count);
+            continue;
+        }
+
+        SyncPartitionList *partition = (SyncPartitionList *) do_malloc(sizeof(SyncPartitionList));
+        partition->path_relative_to_ws_root = resync_strdup(subdir->path_relative_to_ws_root);
+        partition->entries_count = subdir->entries_count;
+        LL_PREPEND(*partitions, partition);
+    }
+}
+
+SyncSubtree *
+create_sync_subtree(const char *path_relative_to_ws_root)
+{
+    SyncSubtree *subtree = (SyncSubtree *) do_calloc(1, sizeof(SyncSubtree));
+    subtree->path_relative_to_ws_root = resync_strdup(path_relative_to_ws_root);
+    return subtree;
+}
+
+void
+destroy_sync_subtree(SyncSubtree **subtree)
+{
+    if (subtree == NULL || *subtree == NULL) {
+        return;
+    }
+
+    SyncSubtree *subdir, *tmp;
+    LL_FOREACH_SAFE((*subtree)->subtrees, subdir, tmp) {
+        LL_DELETE((*subtree)->subtrees, subdir);
+        destroy_sync_subtree(&subdir);
+    }
+
+    DO_FREE((*subtree)->path_relative_to_ws_root);
+    DO_FREE(*subtree);
+}
+
+uint32_t
+get_sync_streams_count(void)
+{
+    const long processors_count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (processors_count < 2) {
+        return 2;
+    }
+
+    return (processors_count > SYNC_PARTITION_MAX_STREAMS) ? SYNC_PARTITION_MAX_STREAMS : (uint32_t) processors_count;
+}
+
+SyncPartitionList *
+create_sync_partitions(const SyncSubtree *root, const uint32_t streams_count)
+{
+    if (root == NULL || root->entries_count < SYNC_PARTITION_MIN_ENTRIES || streams_count < 2) {
+        return NULL;
+    }
+
+    SyncPartitionList *partitions = NULL;
+    add_sync_partitions(&partitions, root, root->entries_count / (streams_count * SYNC_PARTITIONS_PER_STREAM));
+
+    // Nothing is gained from a single partition, its invocation would merely follow the one for the root
+    SyncPartitionList *partition;
+    uint32_t partitions_count;
+    LL_COUNT(partitions, partition, partitions_count);
+    if (partitions_count < 2) {
+        destroy_sync_partitions(&partitions);
+        return NULL;
+    }
+
+    // The largest partitions are synced first, so that the streams finish at roughly the same time
+    LL_SORT(partitions, compare_partitions);
+    return partitions;
+}
+
+void
+destroy_sync_partitions(SyncPartitionList **partitions)
+{
+    SyncPartitionList *partition, *tmp;
+    LL_FOREACH_SAFE(*partitions, partition, tmp) {
+        LL_DELETE(*partitions, partition);
+        DO_FREE(partition->path_relative_to_ws_root);
+        DO_FREE(partition);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef RESYNC_SYNC_PARTITIONS_H
+#define RESYNC_SYNC_PARTITIONS_H
+
+#include "../util/string.h"
+#include "../util/memory.h"
+#include "../util/error.h"
+#include "../../lib/ulist.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * The initial sync of a large workspace is split into subtrees (partitions) that are synced by concurrent rsync
+ *  invocations, as a single invocation walks the workspace and sends its file list sequentially and leaves the link
+ *  idle while doing so. The sizes of the subtrees are counted while the monitor walks the workspace to register its
+ *  watches, so that the partitions are balanced without walking the workspace again.
+ *
+ * Everything that is not part of a partition, i.e. the files and small subtrees of the directories that were split,
+ *  is synced by a single invocation for the workspace root that excludes the partitions. It also deletes the resources
+ *  that no longer exist at the top of the workspace, which no partition covers.
+ */
+
+/* Workspaces with fewer entries are synced by a single rsync invocation */
+#define SYNC_PARTITION_MIN_ENTRIES 20000
+/* Upper bound of the number of concurrent rsync invocations per remote system */
+#define SYNC_PARTITION_MAX_STREAMS 8
+/* Partitions are smaller than the share of a stream, so that a large partition does not leave the other streams idle */
+#define SYNC_PARTITIONS_PER_STREAM 4
+/* Subtrees smaller than this fraction of the target size of a partition are left to the invocation for the root */
+#define SYNC_PARTITION_MIN_SIZE_DIVISOR 8
+
+/* Number of entries of a directory of the workspace and of all directories below it */
+typedef struct SyncSubtree {
+    char *path_relative_to_ws_root;
+    uint64_t entries_count;
+    struct SyncSubtree *subtrees;
+    struct SyncSubtree *next;
+} SyncSubtree;
+
+typedef struct SyncPartitionList {
+    /* Path of the directory relative to the workspace root */
+    char *path_relative_to_ws_root;
+    uint64_t entries_count;
+    struct SyncPartitionList *next;
+} SyncPartitionList;
+
+SyncSubtree *create_sync_subtree(const char *path_relative_to_ws_root);
+
+void destroy_sync_subtree(SyncSubtree **subtree);
+
+/**
+ * @return the number of concurrent rsync invocations that sync the partitions of a remote system
+ */
+uint32_t get_sync_streams_count(void);
+
+/**
+ * Splits the workspace into partitions of roughly the same size.
+ *
+ * @param root subtree of the workspace root
+ * @return the partitions, ordered from the largest to the smallest one, or NULL if the workspace is not worth splitting
+ */
+SyncPartitionList *create_sync_partitions(const SyncSubtree *root, uint32_t streams_count);
+
+void destroy_sync_partitions(SyncPartitionList **partitions);
+
+#endif //RESYNC_SYNC_PARTITIONS_H
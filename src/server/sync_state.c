@@ -0,0 +1,181 @@
+#include "sync_state.h"
+
+/*
+ * The state file of a workspace is named after the hash of the workspace's path.
+ */
+static char *
+get_sync_state_file_path(const char *ws_path)
+{
+    return format_string(
+            "%s/%016llx.state",
+            DEFAULT_RESYNC_SYNC_STATE_DIRECTORY,
+            (unsigned long long) hash_string(ws_path)
+    );
+}
+
+void
+destroy_sync_state(SyncState **state)
+{
+    if (state == NULL || *state == NULL) {
+        return;
+    }
+
+    SyncedRemoteSystem *entry, *tmp;
+    LL_FOREACH_SAFE((*state)->synced_remote_systems, entry, tmp) {
+        LL_DELETE((*state)->synced_remote_systems, entry);
+        DO_FREE(entry->key);
+        DO_FREE(entry);
+    }
+
+    DO_FREE(*state);
+}
+
+static SyncState *
+decode_sync_state(const char *data, const size_t size, const char *ws_path, char **error_msg)
+{
+    ByteBufferReader reader = create_byte_buffer_reader(data, size);
+
+    const uint32_t magic = byte_buffer_read_u32(&reader);
+    const uint32_t version = byte_buffer_read_u32(&reader);
+    if (reader.error || magic != SYNC_STATE_MAGIC || version != SYNC_STATE_VERSION) {
+        SET_ERROR_MSG(error_msg, "Unsupported sync state format");
+        return NULL;
+    }
+
+    // Guards against hash collisions of the state file names
+    const char *persisted_ws_path = byte_buffer_read_string_view(&reader);
+    if (reader.error || !is_equal(persisted_ws_path, ws_path)) {
+        SET_ERROR_MSG(error_msg, "Sync state belongs to a different workspace");
+        return NULL;
+    }
+
+    SyncState *state = (SyncState *) do_calloc(1, sizeof(SyncState));
+    state->synced_until = (time_t) byte_buffer_read_u64(&reader);
+
+    const uint32_t remote_systems_count = byte_buffer_read_u32(&reader);
+    for (uint32_t i = 0; i < remote_systems_count && !reader.error; i++) {
+        const char *key = byte_buffer_read_string_view(&reader);
+        if (key == NULL) {
+            reader.error = true;
+            break;
+        }
+
+        SyncedRemoteSystem *entry = (SyncedRemoteSystem *) do_calloc(1, sizeof(SyncedRemoteSystem));
+        entry->key = resync_strdup(key);
+        LL_APPEND(state->synced_remote_systems, entry);
+    }
+
+    if (reader.error || reader.offset != reader.size) {
+        SET_ERROR_MSG(error_msg, "Sync state is malformed");
+        destroy_sync_state(&state);
+        return NULL;
+    }
+
+    return state;
+}
+
+SyncState *
+load_sync_state(const WorkspaceInformation *ws_info, char **error_msg)
+{
+    char *path = get_sync_state_file_path(ws_info->local_workspace_root_path);
+
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    DO_FREE(path);
+    if (fd == -1) {
+        if (errno != ENOENT) {
+            SET_ERROR_MSG_RAW(error_msg, format_string("Unable to open the sync state: %s", strerror(errno)));
+        }
+        return NULL;
+    }
+
+    struct stat state_stat;
+    if (fstat(fd, &state_stat) == -1) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to stat the sync state: %s", strerror(errno)));
+        close(fd);
+        return NULL;
+    }
+
+    char *data = (char *) do_malloc(state_stat.st_size + 1);
+    const int read_result = read_all(fd, data, state_stat.st_size);
+    close(fd);
+
+    if (read_result != 1) {
+        SET_ERROR_MSG(error_msg, "Unable to read the sync state");
+        DO_FREE(data);
+        return NULL;
+    }
+
+    SyncState *state = decode_sync_state(data, state_stat.st_size, ws_info->local_workspace_root_path, error_msg);
+    DO_FREE(data);
+    return state;
+}
+
+bool
+store_sync_state(const WorkspaceInformation *ws_info, const time_t synced_until, char **error_msg)
+{
+    ByteBuffer *buffer = create_byte_buffer(128);
+    byte_buffer_append_u32(buffer, SYNC_STATE_MAGIC);
+    byte_buffer_append_u32(buffer, SYNC_STATE_VERSION);
+    byte_buffer_append_string(buffer, ws_info->local_workspace_root_path);
+    byte_buffer_append_u64(buffer, (uint64_t) synced_until);
+
+    uint32_t remote_systems_count;
+    RemoteWorkspaceMetadata *remote_system;
+    LL_COUNT(ws_info->remote_systems, remote_system, remote_systems_count);
+    byte_buffer_append_u32(buffer, remote_systems_count);
+
+    LL_FOREACH(ws_info->remote_systems, remote_system) {
+        char *key = get_remote_system_key(remote_system);
+        byte_buffer_append_string(buffer, key);
+        DO_FREE(key);
+    }
+
+    if (mkdir(DEFAULT_RESYNC_SYNC_STATE_DIRECTORY, 0700) == -1 && errno != EEXIST) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to create the sync state directory: %s", strerror(errno)));
+        destroy_byte_buffer(&buffer);
+        return false;
+    }
+
+    char *path = get_sync_state_file_path(ws_info->local_workspace_root_path);
+    char *tmp_path = format_string("%s.tmp", path);
+
+    // The state only has to survive the monitor, not the host, so it is not flushed to disk. A state file that is
+    //  corrupted by a crash of the host is rejected, which results in a full sync.
+    bool res = false;
+    const int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd == -1 || !write_all(fd, buffer->data, buffer->size)) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to write the sync state: %s", strerror(errno)));
+    } else if (rename(tmp_path, path) == -1) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to replace the sync state: %s", strerror(errno)));
+    } else {
+        res = true;
+    }
+
+    if (fd != -1) {
+        close(fd);
+    }
+    if (res == false) {
+        unlink(tmp_path);
+    }
+
+    DO_FREE(tmp_path);
+    DO_FREE(path);
+    destroy_byte_buffer(&buffer);
+    return res;
+}
+
+bool
+is_remote_system_synced(const SyncState *state, const RemoteWorkspaceMetadata *remote_system)
+{
+    char *key = get_remote_system_key(remote_system);
+
+    SyncedRemoteSystem *entry;
+    LL_FOREACH(state->synced_remote_systems, entry) {
+        if (is_equal(entry->key, key)) {
+            break;
+        }
+    }
+
+    DO_FREE(key);
+    return entry != NULL;
+}
@@ -0,0 +1,54 @@
+#ifndef RESYNC_SYNC_STATE_H
+#define RESYNC_SYNC_STATE_H
+
+#include "../util/string.h"
+#include "../util/memory.h"
+#include "../util/error.h"
+#include "../util/byte_buffer.h"
+#include "../types/types.h"
+#include "../socket.h"
+#include "../../lib/ulist.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/*
+ * Sync progress of a workspace that is persisted by its monitor, so that a restarted monitor only has to sync what
+ *  changed since then instead of the entire workspace. All changes that happened before 'synced_until' were synced
+ *  with the listed remote systems. Remote systems that are not listed were not fully synced yet.
+ */
+
+#define DEFAULT_RESYNC_SYNC_STATE_DIRECTORY "/var/tmp/reSync"
+
+#define SYNC_STATE_MAGIC 0x53535352
+#define SYNC_STATE_VERSION 1
+
+typedef struct SyncedRemoteSystem {
+    char *key;
+    struct SyncedRemoteSystem *next;
+} SyncedRemoteSystem;
+
+typedef struct SyncState {
+    time_t synced_until;
+    SyncedRemoteSystem *synced_remote_systems;
+} SyncState;
+
+void destroy_sync_state(SyncState **state);
+
+/**
+ * @return the persisted sync state of the workspace, or NULL if none was persisted or it cannot be used
+ */
+SyncState *load_sync_state(const WorkspaceInformation *ws_info, char **error_msg);
+
+/**
+ * Atomically replaces the persisted sync state of the workspace, marking all of its remote systems as synced.
+ */
+bool store_sync_state(const WorkspaceInformation *ws_info, const time_t synced_until, char **error_msg);
+
+bool is_remote_system_synced(const SyncState *state, const RemoteWorkspaceMetadata *remote_system);
+
+#endif //RESYNC_SYNC_STATE_H
@@ -0,0 +1,314 @@
+#include "transfer_tuning.h"
+
+/* Weight of a new measurement in the moving averages of the link measurements */
+#define TRANSFER_TUNING_SMOOTHING 0.25
+
+/*
+ * Link measurements of a remote system. Averages are negative until the first measurement.
+ */
+typedef struct RemoteTransferTuning {
+    const RemoteWorkspaceMetadata *remote_system;
+    double latency_sec;
+    /* Bytes of uncompressed data per second, so that compression that outpaces the link counts as throughput */
+    double throughput;
+    uint32_t throughput_samples_count;
+    double transferred_file_size;
+    TransferProfile profile;
+    struct RemoteTransferTuning *next;
+} RemoteTransferTuning;
+
+static RemoteTransferTuning *tunings = NULL;
+
+/* Profile that is used until the link is measured, which matches the options used before any tuning */
+static const TransferProfile default_transfer_profile = {
+        .is_compressed = true,
+        .compress_level = 0,
+        .is_whole_file = false,
+        .is_inplace = false
+};
+
+/* Mirrors on the same host are limited by their disks only, which are faster than any compressor */
+static const TransferProfile local_transfer_profile = {
+        .is_compressed = false,
+        .compress_level = 0,
+        .is_whole_file = true,
+        .is_inplace = false
+};
+
+static RemoteTransferTuning *
+get_remote_transfer_tuning(const RemoteWorkspaceMetadata *remote_system)
+{
+    RemoteTransferTuning *tuning;
+    LL_SEARCH_SCALAR(tunings, tuning, remote_system, remote_system);
+    if (tuning == NULL) {
+        tuning = (RemoteTransferTuning *) do_calloc(1, sizeof(RemoteTransferTuning));
+        tuning->remote_system = remote_system;
+        tuning->latency_sec = -1;
+        tuning->throughput = -1;
+        tuning->transferred_file_size = -1;
+        tuning->profile = (remote_system->connection_type == LOCAL_PATH) ? local_transfer_profile : default_transfer_profile;
+        LL_APPEND(tunings, tuning);
+    }
+
+    return tuning;
+}
+
+const TransferProfile *
+get_transfer_profile(const RemoteWorkspaceMetadata *remote_system)
+{
+    return &get_remote_transfer_tuning(remote_system)->profile;
+}
+
+/*
+ * Parses the value of the statistics line if it starts with the label. Values may contain thousands separators.
+ */
+static bool
+parse_rsync_stats_value(const char *line, const char *label, uint64_t *value)
+{
+    const size_t label_len = strlen(label);
+    if (strncmp(line, label, label_len) != 0) {
+        return false;
+    }
+
+    const char *ptr = line + label_len;
+    while (*ptr == ' ') {
+        ptr++;
+    }
+    if (*ptr < '0' || *ptr > '9') {
+        return false;
+    }
+
+    uint64_t parsed_value = 0;
+    for (; (*ptr >= '0' && *ptr <= '9') || *ptr == ',' || *ptr == '.'; ptr++) {
+        if (*ptr >= '0' && *ptr <= '9') {
+            parsed_value = parsed_value * 10 + (uint64_t) (*ptr - '0');
+        }
+    }
+
+    *value = parsed_value;
+    return true;
+}
+
+bool
+parse_rsync_transfer_stats(const char *output, const double elapsed_sec, RsyncTransferStats *stats)
+{
+    memset(stats, 0, sizeof(RsyncTransferStats));
+    stats->elapsed_sec = elapsed_sec;
+
+    bool is_sent_found = false, is_received_found = false;
+    const char *line = output;
+    while (line != NULL && *line != '\0') {
+        is_sent_found |= parse_rsync_stats_value(line, "Total bytes sent:", &stats->bytes_sent);
+        is_received_found |= parse_rsync_stats_value(line, "Total bytes received:", &stats->bytes_received);
+        parse_rsync_stats_value(line, "Literal data:", &stats->literal_data_size);
+        parse_rsync_stats_value(line, "Total transferred file size:", &stats->transferred_file_size);
+        // rsync versions before 3.1 do not count regular files separately
+        parse_rsync_stats_value(line, "Number of regular files transferred:", &stats->transferred_files_count);
+        parse_rsync_stats_value(line, "Number of files transferred:", &stats->transferred_files_count);
+
+        line = strchr(line, '\n');
+        if (line != NULL) {
+            line++;
+        }
+    }
+
+    return is_sent_found && is_received_found;
+}
+
+static double
+update_average(const double average, const double value)
+{
+    return (average < 0) ? value : average + TRANSFER_TUNING_SMOOTHING * (value - average);
+}
+
+/*
+ * Once above a threshold, the throughput has to fall well below it again, so that links measured close to a threshold
+ *  do not flap between two profiles. Flapping is likely otherwise, as compression raises the measured throughput.
+ */
+static bool
+is_throughput_above(const double throughput, const double threshold, const bool is_above)
+{
+    return throughput >= (is_above ? threshold / 2 : threshold);
+}
+
+static TransferProfile
+choose_transfer_profile(const RemoteTransferTuning *tuning)
+{
+    if (tuning->remote_system->connection_type == LOCAL_PATH) {
+        return local_transfer_profile;
+    } else if (tuning->throughput_samples_count < TRANSFER_TUNING_MIN_SAMPLES) {
+        return tuning->profile;
+    }
+
+    const TransferProfile *current = &tuning->profile;
+    TransferProfile profile = default_transfer_profile;
+
+    if (is_throughput_above(tuning->throughput, TRANSFER_TUNING_FAST_LINK_THROUGHPUT, !current->is_compressed)) {
+        // Computing the delta requires reading the remote file and checksumming both files, which takes longer than
+        //  sending the data as is over a fast link
+        profile.is_compressed = false;
+        profile.is_whole_file = true;
+    } else if (is_throughput_above(tuning->throughput, TRANSFER_TUNING_MEDIUM_LINK_THROUGHPUT, !current->is_compressed || current->compress_level == 1)) {
+        profile.compress_level = 1;
+    }
+
+    // Saves writing a complete temporary copy of large files on the remote system to apply a small delta
+    profile.is_inplace = !profile.is_whole_file && tuning->transferred_file_size >= TRANSFER_TUNING_INPLACE_FILE_SIZE;
+
+    return profile;
+}
+
+static char *
+describe_transfer_profile(const TransferProfile *profile)
+{
+    char *compression;
+    if (!profile->is_compressed) {
+        compression = resync_strdup("uncompressed");
+    } else if (profile->compress_level == 0) {
+        compression = resync_strdup("compressed");
+    } else {
+        compression = format_string("compressed (level %d)", profile->compress_level);
+    }
+
+    char *description = format_string(
+            "%s, %s%s",
+            compression,
+            profile->is_whole_file ? "whole files" : "delta transfer",
+            profile->is_inplace ? ", in place" : ""
+    );
+
+    DO_FREE(compression);
+    return description;
+}
+
+void
+record_rsync_transfer(const RemoteWorkspaceMetadata *remote_system, const RsyncTransferStats *stats)
+{
+    RemoteTransferTuning *tuning = get_remote_transfer_tuning(remote_system);
+
+    const uint64_t wire_size = stats->bytes_sent + stats->bytes_received;
+    if (wire_size < TRANSFER_TUNING_LATENCY_MAX_BYTES) {
+        tuning->latency_sec = update_average(tuning->latency_sec, stats->elapsed_sec);
+    } else if (wire_size >= TRANSFER_TUNING_THROUGHPUT_MIN_BYTES) {
+        const double transfer_sec = stats->elapsed_sec - ((tuning->latency_sec > 0) ? tuning->latency_sec : 0);
+        const uint64_t data_size = (stats->literal_data_size > wire_size) ? stats->literal_data_size : wire_size;
+
+        if (transfer_sec > 0) {
+            tuning->throughput = update_average(tuning->throughput, (double) data_size / transfer_sec);
+            tuning->throughput_samples_count++;
+        }
+    }
+
+    if (stats->transferred_files_count > 0) {
+        tuning->transferred_file_size = update_average(
+                tuning->transferred_file_size,
+                (double) stats->transferred_file_size / (double) stats->transferred_files_count
+        );
+    }
+
+    const TransferProfile profile = choose_transfer_profile(tuning);
+    if (memcmp(&profile, &tuning->profile, sizeof(TransferProfile)) != 0) {
+        char *key = get_remote_system_key(remote_system);
+        char *description = describe_transfer_profile(&profile);
+        LOG("Transfer profile of remote system '%s' changed to: %s", key, description);
+        DO_FREE(description);
+        DO_FREE(key);
+
+        tuning->profile = profile;
+    }
+}
+
+static char *
+describe_remote_transfer_tuning(const RemoteWorkspaceMetadata *remote_system)
+{
+    const RemoteTransferTuning *tuning = get_remote_transfer_tuning(remote_system);
+
+    char *profile = describe_transfer_profile(&tuning->profile);
+    char *latency = (tuning->latency_sec < 0)
+            ? resync_strdup("unknown")
+            : format_string("%.1f ms", tuning->latency_sec * 1000);
+    char *throughput = (tuning->throughput < 0)
+            ? resync_strdup("unknown")
+            : format_string("%.2f MiB/s", tuning->throughput / (1024 * 1024));
+
+    char *key = get_remote_system_key(remote_system);
+    char *description = format_string(
+            "%s: %s; sync latency %s, throughput %s (%u samples)\n",
+            key,
+            profile,
+            latency,
+            throughput,
+            tuning->throughput_samples_count
+    );
+
+    DO_FREE(key);
+    DO_FREE(profile);
+    DO_FREE(latency);
+    DO_FREE(throughput);
+    return description;
+}
+
+bool
+store_transfer_status(const WorkspaceInformation *ws_info, char **error_msg)
+{
+    ByteBuffer *buffer = create_byte_buffer(256);
+
+    char *line = format_string("Workspace: %s\n", ws_info->local_workspace_root_path);
+    byte_buffer_append(buffer, line, strlen(line));
+    DO_FREE(line);
+
+    RemoteWorkspaceMetadata *remote_system;
+    LL_FOREACH(ws_info->remote_systems, remote_system) {
+        line = describe_remote_transfer_tuning(remote_system);
+        byte_buffer_append(buffer, line, strlen(line));
+        DO_FREE(line);
+    }
+
+    if (mkdir(DEFAULT_RESYNC_SYNC_STATE_DIRECTORY, 0700) == -1 && errno != EEXIST) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to create the sync state directory: %s", strerror(errno)));
+        destroy_byte_buffer(&buffer);
+        return false;
+    }
+
+    // Named like the sync state of the workspace
+    char *path = format_string(
+            "%s/%016llx.%s",
+            DEFAULT_RESYNC_SYNC_STATE_DIRECTORY,
+            (unsigned long long) hash_string(ws_info->local_workspace_root_path),
+            TRANSFER_STATUS_FILE_EXTENSION
+    );
+    char *tmp_path = format_string("%s.tmp", path);
+
+    bool res = false;
+    const int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1 || !write_all(fd, buffer->data, buffer->size)) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to write the transfer status: %s", strerror(errno)));
+    } else if (rename(tmp_path, path) == -1) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to replace the transfer status: %s", strerror(errno)));
+    } else {
+        res = true;
+    }
+
+    if (fd != -1) {
+        close(fd);
+    }
+    if (res == false) {
+        unlink(tmp_path);
+    }
+
+    DO_FREE(tmp_path);
+    DO_FREE(path);
+    destroy_byte_buffer(&buffer);
+    return res;
+}
+
+void
+release_transfer_tuning(const RemoteWorkspaceMetadata *remote_system)
+{
+    RemoteTransferTuning *tuning;
+    LL_SEARCH_SCALAR(tunings, tuning, remote_system, remote_system);
+    if (tuning != NULL) {
+        LL_DELETE(tunings, tuning);
+        DO_FREE(tuning);
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef RESYNC_TRANSFER_TUNING_H
+#define RESYNC_TRANSFER_TUNING_H
+
+#include "../util/string.h"
+#include "../util/memory.h"
+#include "../util/error.h"
+#include "../util/debug.h"
+#include "../util/byte_buffer.h"
+#include "../types/types.h"
+#include "../socket.h"
+#include "sync_state.h"
+#include "../../lib/ulist.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/*
+ * Adapts the rsync options of every remote system to its link, which is measured from the statistics of completed
+ *  syncs: syncs that transferred next to no data measure the fixed latency of a sync, which is dominated by round
+ *  trips, larger ones the throughput once that latency is subtracted. Until enough syncs were measured, the remote
+ *  system is synced with compression and delta transfer, like before any tuning.
+ */
+
+/* Syncs that sent and received less than this many bytes measure the latency of the link */
+#define TRANSFER_TUNING_LATENCY_MAX_BYTES ((uint64_t) (64 * 1024))
+/* Syncs that sent and received at least this many bytes measure the throughput of the link */
+#define TRANSFER_TUNING_THROUGHPUT_MIN_BYTES ((uint64_t) (1024 * 1024))
+/* Number of throughput measurements before the profile is adapted */
+#define TRANSFER_TUNING_MIN_SAMPLES 3
+
+/* Links at least as fast as this (bytes/sec) are neither compressed nor delta transferred */
+#define TRANSFER_TUNING_FAST_LINK_THROUGHPUT (64.0 * 1024 * 1024)
+/* Links at least as fast as this (bytes/sec) are compressed with the fastest compression level only */
+#define TRANSFER_TUNING_MEDIUM_LINK_THROUGHPUT (8.0 * 1024 * 1024)
+/* Delta transfers update files in place once the transferred files are this large on average */
+#define TRANSFER_TUNING_INPLACE_FILE_SIZE (64.0 * 1024 * 1024)
+
+/* Files that report the measured link and the chosen profile of every remote system of a workspace */
+#define TRANSFER_STATUS_FILE_EXTENSION "status"
+
+typedef struct TransferProfile {
+    bool is_compressed;
+    /* Compression level passed to rsync, 0 for rsync's default level */
+    int compress_level;
+    /* Sends changed files as a whole instead of computing their delta to the remote file */
+    bool is_whole_file;
+    /* Updates files in place instead of writing a temporary copy on the remote system */
+    bool is_inplace;
+} TransferProfile;
+
+/*
+ * Statistics of a completed sync, as reported by 'rsync --stats'.
+ */
+typedef struct RsyncTransferStats {
+    double elapsed_sec;
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    /* Size of the file data that was sent as is, i.e. not matched by the delta, before any compression */
+    uint64_t literal_data_size;
+    uint64_t transferred_files_count;
+    uint64_t transferred_file_size;
+} RsyncTransferStats;
+
+/**
+ * @return the profile that the next sync with the remote system should use
+ */
+const TransferProfile *get_transfer_profile(const RemoteWorkspaceMetadata *remote_system);
+
+/**
+ * Parses the output of 'rsync --stats'.
+ *
+ * @return false if the output does not contain the statistics
+ */
+bool parse_rsync_transfer_stats(const char *output, const double elapsed_sec, RsyncTransferStats *stats);
+
+/**
+ * Updates the link measurements of the remote system with a completed sync and adapts its profile accordingly.
+ */
+void record_rsync_transfer(const RemoteWorkspaceMetadata *remote_system, const RsyncTransferStats *stats);
+
+/**
+ * Atomically replaces the status file of the workspace, which lists the measurements and profiles of all of its remote
+ *  systems. The file is placed next to the sync state of the workspace.
+ */
+bool store_transfer_status(const WorkspaceInformation *ws_info, char **error_msg);
+
+/**
+ * Drops the measurements of the remote system. Has to be called before the remote system is destroyed.
+ */
+void release_transfer_tuning(const RemoteWorkspaceMetadata *remote_system);
+
+#endif //RESYNC_TRANSFER_TUNING_H
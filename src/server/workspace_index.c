@@ -0,0 +1,456 @@
+#include "workspace_index.h"
+
+/* Entry of a directory as it is hashed, see 'hash_directory_entries' */
+typedef struct IndexedEntry {
+    char *name;
+    char type;
+    uint32_t mode;
+    uint64_t size;
+    uint64_t content_hash;
+} IndexedEntry;
+
+static int
+compare_entries(const void *entry, const void *other_entry)
+{
+    return strcmp(((const IndexedEntry *) entry)->name, ((const IndexedEntry *) other_entry)->name);
+}
+
+static void
+hash_u64(DeltaHashState *state, const uint64_t value)
+{
+    // Hashes have to match across hosts
+    const uint64_t be_value = htobe64(value);
+    delta_hash_update(state, &be_value, sizeof(be_value));
+}
+
+static void
+hash_name(DeltaHashState *state, const char *name)
+{
+    delta_hash_update(state, name, strlen(name) + 1);
+}
+
+/*
+ * @return the hash of the content of the file, or of the target of the symbolic link, or 0 if it cannot be read
+ */
+static uint64_t
+hash_file_content(const int dir_fd, const char *name, const struct stat *file_stat)
+{
+    char buffer[64 * 1024];
+    DeltaHashState state;
+    delta_hash_init(&state);
+
+    if (S_ISLNK(file_stat->st_mode)) {
+        const ssize_t target_len = readlinkat(dir_fd, name, buffer, sizeof(buffer));
+        if (target_len == -1) {
+            return 0;
+        }
+        delta_hash_update(&state, buffer, (size_t) target_len);
+        return delta_hash_digest(&state);
+    }
+
+    if (!S_ISREG(file_stat->st_mode)) {
+        return 0;
+    }
+
+    const int fd = openat(dir_fd, name, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd == -1) {
+        return 0;
+    }
+
+    ssize_t bytes_read;
+    while ((bytes_read = read(fd, buffer, sizeof(buffer))) != 0) {
+        if (bytes_read == -1 && errno == EINTR) {
+            continue;
+        } else if (bytes_read == -1) {
+            close(fd);
+            return 0;
+        }
+        delta_hash_update(&state, buffer, (size_t) bytes_read);
+    }
+
+    close(fd);
+    return delta_hash_digest(&state);
+}
+
+static char *
+get_subdir_key(const char *key, const char *name)
+{
+    return (*key == '\0') ? resync_strdup(name) : format_string("%s/%s", key, name);
+}
+
+static void
+free_subdir_names(WorkspaceIndexNode *node)
+{
+    for (uint32_t i = 0; i < node->subdirs_count; i++) {
+        DO_FREE(node->subdir_names[i]);
+    }
+    DO_FREE(node->subdir_names);
+    node->subdirs_count = 0;
+}
+
+static void
+remove_subtree_nodes(WorkspaceIndex *index, const char *key)
+{
+    WorkspaceIndexNode *node;
+    HASH_FIND_STR(index->nodes, key, node);
+    if (node == NULL) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < node->subdirs_count; i++) {
+        char *subdir_key = get_subdir_key(key, node->subdir_names[i]);
+        remove_subtree_nodes(index, subdir_key);
+        DO_FREE(subdir_key);
+    }
+
+    HASH_DELETE(hh, index->nodes, node);
+    free_subdir_names(node);
+    DO_FREE(node->key);
+    DO_FREE(node);
+}
+
+/*
+ * Lists the entries of the directory, hashes those that are not directories and replaces the subdirectories of the
+ *  node. Nodes of subdirectories that no longer exist are removed.
+ *
+ * @return false if the directory cannot be read
+ */
+static bool
+hash_directory_entries(WorkspaceIndex *index, WorkspaceIndexNode *node)
+{
+    char *absolute_directory_path = (*node->key == '\0')
+            ? resync_strdup(index->workspace_root_path)
+            : concat_paths(index->workspace_root_path, node->key);
+    DIR *dirp = opendir(absolute_directory_path);
+    DO_FREE(absolute_directory_path);
+    if (dirp == NULL) {
+        return false;
+    }
+
+    const char *relative_directory_path = (*node->key == '\0') ? NULL : node->key;
+
+    size_t entries_count = 0, entries_capacity = 16;
+    IndexedEntry *entries = (IndexedEntry *) do_malloc(entries_capacity * sizeof(IndexedEntry));
+    size_t subdirs_count = 0;
+
+    struct dirent *dent;
+    while ((dent = readdir(dirp)) != NULL) {
+        if (strcmp(dent->d_name, ".") == 0 || strcmp(dent->d_name, "..") == 0) {
+            continue;
+        }
+
+        struct stat entry_stat;
+        if (fstatat(dirfd(dirp), dent->d_name, &entry_stat, AT_SYMLINK_NOFOLLOW) == -1) {
+            continue;
+        }
+
+        const bool is_directory = S_ISDIR(entry_stat.st_mode);
+        if ((is_directory && dent->d_name[0] == '.')
+            || is_ignored(index->ignore_rules, relative_directory_path, dent->d_name, is_directory)) {
+            continue;
+        }
+
+        if (entries_count == entries_capacity) {
+            entries_capacity *= 2;
+            entries = (IndexedEntry *) do_realloc(entries, entries_capacity * sizeof(IndexedEntry));
+        }
+
+        // The content of subdirectories is covered by their own hashes, only their permissions are part of the entries
+        entries[entries_count++] = (IndexedEntry) {
+            .name = resync_strdup(dent->d_name),
+            .type = is_directory ? 'd' : (S_ISREG(entry_stat.st_mode) ? 'f' : (S_ISLNK(entry_stat.st_mode) ? 'l' : 'o')),
+            .mode = (uint32_t) (entry_stat.st_mode & 07777),
+            .size = (S_ISREG(entry_stat.st_mode) || S_ISLNK(entry_stat.st_mode)) ? (uint64_t) entry_stat.st_size : 0,
+            .content_hash = (!is_directory && (index->flags & WORKSPACE_INDEX_CONTENT_HASHED))
+                    ? hash_file_content(dirfd(dirp), dent->d_name, &entry_stat) : 0
+        };
+        subdirs_count += is_directory;
+    }
+    closedir(dirp);
+
+    // The order of the entries depends on the file system, so they are hashed by name
+    qsort(entries, entries_count, sizeof(IndexedEntry), compare_entries);
+
+    char **subdir_names = (char **) do_malloc((subdirs_count + 1) * sizeof(char *));
+    size_t subdir_index = 0;
+
+    DeltaHashState state;
+    delta_hash_init(&state);
+    for (size_t i = 0; i < entries_count; i++) {
+        hash_name(&state, entries[i].name);
+        delta_hash_update(&state, &entries[i].type, sizeof(entries[i].type));
+        hash_u64(&state, entries[i].mode);
+        hash_u64(&state, entries[i].size);
+        hash_u64(&state, entries[i].content_hash);
+
+        if (entries[i].type == 'd') {
+            subdir_names[subdir_index++] = entries[i].name;
+        } else {
+            DO_FREE(entries[i].name);
+        }
+    }
+    DO_FREE(entries);
+
+    // Both lists are sorted, so the subdirectories that disappeared are found in a single pass
+    size_t new_index = 0;
+    for (uint32_t i = 0; i < node->subdirs_count; i++) {
+        while (new_index < subdirs_count && strcmp(subdir_names[new_index], node->subdir_names[i]) < 0) {
+            new_index++;
+        }
+        if (new_index == subdirs_count || strcmp(subdir_names[new_index], node->subdir_names[i]) != 0) {
+            char *subdir_key = get_subdir_key(node->key, node->subdir_names[i]);
+            remove_subtree_nodes(index, subdir_key);
+            DO_FREE(subdir_key);
+        }
+    }
+
+    free_subdir_names(node);
+    node->subdir_names = subdir_names;
+    node->subdirs_count = (uint32_t) subdirs_count;
+    node->entries_hash = delta_hash_digest(&state);
+    node->is_entries_hash_valid = true;
+    return true;
+}
+
+/*
+ * @return the node of the directory with a valid tree hash, or NULL if the directory cannot be read
+ */
+static WorkspaceIndexNode *
+get_hashed_node(WorkspaceIndex *index, const char *key)
+{
+    WorkspaceIndexNode *node;
+    HASH_FIND_STR(index->nodes, key, node);
+    if (node == NULL) {
+        node = (WorkspaceIndexNode *) do_calloc(1, sizeof(WorkspaceIndexNode));
+        node->key = resync_strdup(key);
+        HASH_ADD_KEYPTR(hh, index->nodes, node->key, strlen(node->key), node);
+    }
+
+    if (node->is_tree_hash_valid) {
+        return node;
+    }
+
+    if (!node->is_entries_hash_valid && !hash_directory_entries(index, node)) {
+        remove_subtree_nodes(index, key);
+        return NULL;
+    }
+
+    DeltaHashState state;
+    delta_hash_init(&state);
+    hash_u64(&state, node->entries_hash);
+
+    for (uint32_t i = 0; i < node->subdirs_count; i++) {
+        char *subdir_key = get_subdir_key(key, node->subdir_names[i]);
+        const WorkspaceIndexNode *subdir_node = get_hashed_node(index, subdir_key);
+        DO_FREE(subdir_key);
+
+        // A subdirectory that disappeared meanwhile is hashed as if it was empty, its parent's event will follow
+        hash_name(&state, node->subdir_names[i]);
+        hash_u64(&state, (subdir_node != NULL) ? subdir_node->tree_hash : 0);
+    }
+
+    node->tree_hash = delta_hash_digest(&state);
+    node->is_tree_hash_valid = true;
+    return node;
+}
+
+WorkspaceIndex *
+create_workspace_index(const char *workspace_root_path, const IgnoreRules *ignore_rules, const uint8_t flags)
+{
+    WorkspaceIndex *index = (WorkspaceIndex *) do_calloc(1, sizeof(WorkspaceIndex));
+    index->workspace_root_path = resync_strdup(workspace_root_path);
+    index->ignore_rules = ignore_rules;
+    index->flags = flags;
+    return index;
+}
+
+void
+reset_workspace_index(WorkspaceIndex *index, const IgnoreRules *ignore_rules)
+{
+    WorkspaceIndexNode *node, *tmp;
+    HASH_ITER(hh, index->nodes, node, tmp) {
+        HASH_DELETE(hh, index->nodes, node);
+        free_subdir_names(node);
+        DO_FREE(node->key);
+        DO_FREE(node);
+    }
+
+    index->ignore_rules = ignore_rules;
+}
+
+void
+destroy_workspace_index(WorkspaceIndex **index)
+{
+    if (index == NULL || *index == NULL) {
+        return;
+    }
+
+    reset_workspace_index(*index, NULL);
+    DO_FREE((*index)->workspace_root_path);
+    DO_FREE(*index);
+}
+
+void
+invalidate_workspace_index(WorkspaceIndex *index, const char *relative_directory_path)
+{
+    if (index == NULL) {
+        return;
+    }
+
+    char key[PATH_MAX];
+    if (relative_directory_path == NULL) {
+        key[0] = '\0';
+    } else if (strlen(relative_directory_path) < sizeof(key)) {
+        strcpy(key, relative_directory_path);
+    } else {
+        // Such a directory cannot be hashed either, the entire index is reset instead
+        reset_workspace_index(index, index->ignore_rules);
+        return;
+    }
+
+    WorkspaceIndexNode *node;
+    HASH_FIND_STR(index->nodes, key, node);
+    if (node != NULL) {
+        node->is_entries_hash_valid = false;
+    }
+
+    // The tree hashes of all ancestors depend on the directory. Once an invalid one is reached, the ones above it are
+    //  invalid already, as a tree hash is only valid if those of all subdirectories are.
+    while (true) {
+        HASH_FIND_STR(index->nodes, key, node);
+        if (node != NULL) {
+            if (!node->is_tree_hash_valid) {
+                break;
+            }
+            node->is_tree_hash_valid = false;
+        }
+
+        if (key[0] == '\0') {
+            break;
+        }
+
+        char *separator = strrchr(key, '/');
+        if (separator != NULL) {
+            *separator = '\0';
+        } else {
+            key[0] = '\0';
+        }
+    }
+}
+
+void
+invalidate_workspace_index_resource(WorkspaceIndex *index, const char *relative_path, const bool is_replaced)
+{
+    if (index == NULL) {
+        return;
+    }
+
+    char key[PATH_MAX];
+    if (strlen(relative_path) >= sizeof(key)) {
+        reset_workspace_index(index, index->ignore_rules);
+        return;
+    }
+    strcpy(key, relative_path);
+
+    if (is_replaced) {
+        remove_subtree_nodes(index, key);
+    }
+
+    char *separator = strrchr(key, '/');
+    if (separator == NULL) {
+        invalidate_workspace_index(index, NULL);
+        return;
+    }
+
+    *separator = '\0';
+    invalidate_workspace_index(index, key);
+}
+
+DirectoryDigest *
+get_directory_digest(WorkspaceIndex *index, const char *relative_directory_path)
+{
+    const char *key = (relative_directory_path != NULL) ? relative_directory_path : "";
+    const WorkspaceIndexNode *node = get_hashed_node(index, key);
+    if (node == NULL) {
+        return NULL;
+    }
+
+    DirectoryDigest *digest = (DirectoryDigest *) do_calloc(1, sizeof(DirectoryDigest));
+    digest->entries_hash = node->entries_hash;
+    digest->subdirs_count = node->subdirs_count;
+    digest->subdir_names = (char **) do_calloc(node->subdirs_count + 1, sizeof(char *));
+    digest->subdir_hashes = (uint64_t *) do_calloc(node->subdirs_count + 1, sizeof(uint64_t));
+
+    for (uint32_t i = 0; i < node->subdirs_count; i++) {
+        char *subdir_key = get_subdir_key(key, node->subdir_names[i]);
+        const WorkspaceIndexNode *subdir_node;
+        HASH_FIND_STR(index->nodes, subdir_key, subdir_node);
+        DO_FREE(subdir_key);
+
+        digest->subdir_names[i] = resync_strdup(node->subdir_names[i]);
+        digest->subdir_hashes[i] = (subdir_node != NULL) ? subdir_node->tree_hash : 0;
+    }
+
+    return digest;
+}
+
+void
+destroy_directory_digest(DirectoryDigest **digest)
+{
+    if (digest == NULL || *digest == NULL) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < (*digest)->subdirs_count; i++) {
+        DO_FREE((*digest)->subdir_names[i]);
+    }
+    DO_FREE((*digest)->subdir_names);
+    DO_FREE((*digest)->subdir_hashes);
+    DO_FREE(*digest);
+}
+
+void
+append_directory_digest(ByteBuffer *record, const DirectoryDigest *digest)
+{
+    agent_record_append_u64(record, digest->entries_hash);
+    agent_record_append_u32(record, digest->subdirs_count);
+
+    for (uint32_t i = 0; i < digest->subdirs_count; i++) {
+        agent_record_append_string(record, digest->subdir_names[i]);
+        agent_record_append_u64(record, digest->subdir_hashes[i]);
+    }
+}
+
+DirectoryDigest *
+read_directory_digest(ByteBufferReader *reader)
+{
+    const uint64_t entries_hash = agent_record_read_u64(reader);
+    const uint32_t subdirs_count = agent_record_read_u32(reader);
+    // Every subdirectory takes up more than a byte, which bounds the count of a well-formed record
+    if (reader->error || subdirs_count > reader->size - reader->offset) {
+        reader->error = true;
+        return NULL;
+    }
+
+    DirectoryDigest *digest = (DirectoryDigest *) do_calloc(1, sizeof(DirectoryDigest));
+    digest->entries_hash = entries_hash;
+    digest->subdir_names = (char **) do_calloc(subdirs_count + 1, sizeof(char *));
+    digest->subdir_hashes = (uint64_t *) do_calloc(subdirs_count + 1, sizeof(uint64_t));
+
+    for (uint32_t i = 0; i < subdirs_count && !reader->error; i++) {
+        const char *name = agent_record_read_string_view(reader);
+        digest->subdir_hashes[i] = agent_record_read_u64(reader);
+        if (name == NULL) {
+            reader->error = true;
+            break;
+        }
+        digest->subdir_names[i] = resync_strdup(name);
+        digest->subdirs_count++;
+    }
+
+    if (reader->error) {
+        destroy_directory_digest(&digest);
+        return NULL;
+    }
+    return digest;
+}
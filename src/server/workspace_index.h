@@ -0,0 +1,128 @@
+#ifndef RESYNC_WORKSPACE_INDEX_H
+#define RESYNC_WORKSPACE_INDEX_H
+
+#include "../util/string.h"
+#include "../util/memory.h"
+#include "../util/error.h"
+#include "../util/fs_util.h"
+#include "../util/byte_buffer.h"
+#include "../util/ignore_rules.h"
+#include "../../lib/utash.h"
+#include "delta.h"
+#include "agent_protocol.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <endian.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/*
+ * Merkle tree over a workspace, which allows to verify that a remote system did not drift from the workspace, e.g. as
+ *  it was modified by hand, without comparing every file. Every directory is hashed from the names, types, permissions
+ *  and sizes of its entries, and optionally from the content of its files, and from the hashes of its subdirectories,
+ *  so that equal hashes of the workspace root imply equal workspaces. The comparison descends only into directories
+ *  whose hashes differ.
+ *
+ * The monitor keeps the index of its workspace up to date with the events it receives: a directory is rehashed once an
+ *  event was reported for it, the hashes of all other directories are reused. The agent keeps the index of the remote
+ *  workspace across comparisons in the same way, driven by the records it applies (see 'AGENT_DIGEST'). It only starts
+ *  over with other ignore rules, so a change that is made on the remote system by hand is found once the directory that
+ *  contains it is rehashed, at the latest by the first comparison of the next agent.
+ *
+ * Modification times are not hashed, as the agent transport does not preserve them. Hidden directories are left out,
+ *  as the monitor does not watch them, and so are the resources that the ignore rules exclude.
+ */
+
+/* Flag of an index whose hashes include the content of the files */
+#define WORKSPACE_INDEX_CONTENT_HASHED 0x1
+
+/* Hashes of a directory as they are compared with those of a remote system */
+typedef struct DirectoryDigest {
+    /* Hash of the names, types and permissions of the entries of the directory and of the sizes of its files */
+    uint64_t entries_hash;
+    uint32_t subdirs_count;
+    /* Names of the subdirectories in ascending order and the hashes of their subtrees */
+    char **subdir_names;
+    uint64_t *subdir_hashes;
+} DirectoryDigest;
+
+typedef struct WorkspaceIndexNode {
+    /* Path of the directory relative to the workspace root, empty for the root */
+    char *key;
+    uint64_t entries_hash;
+    uint32_t subdirs_count;
+    /* In ascending order */
+    char **subdir_names;
+    /* Hash of the entries hash and of the names and tree hashes of the subdirectories */
+    uint64_t tree_hash;
+    bool is_entries_hash_valid;
+    /* Only valid if the tree hashes of all subdirectories are valid as well */
+    bool is_tree_hash_valid;
+    UT_hash_handle hh;
+} WorkspaceIndexNode;
+
+typedef struct WorkspaceIndex {
+    char *workspace_root_path;
+    /* Not owned by the index */
+    const IgnoreRules *ignore_rules;
+    uint8_t flags;
+    /* Directories that were hashed, by their key */
+    WorkspaceIndexNode *nodes;
+} WorkspaceIndex;
+
+/**
+ * Creates an empty index, directories are hashed once their digest is requested. The ignore rules have to outlive the
+ *  index.
+ */
+WorkspaceIndex *create_workspace_index(const char *workspace_root_path, const IgnoreRules *ignore_rules, uint8_t flags);
+
+void destroy_workspace_index(WorkspaceIndex **index);
+
+/**
+ * Forgets all hashes, e.g. as the ignore rules changed, which are used from now on.
+ */
+void reset_workspace_index(WorkspaceIndex *index, const IgnoreRules *ignore_rules);
+
+/**
+ * Marks the entries of the directory as changed. Does not allocate any memory, so that it can be called for every event.
+ *
+ * @param relative_directory_path NULL for the workspace root
+ */
+void invalidate_workspace_index(WorkspaceIndex *index, const char *relative_directory_path);
+
+/**
+ * Marks the entries of the directory that contains the resource as changed. If the resource was removed or replaced,
+ *  the hashes of its subtree are dropped as well, as they would be reused if a directory of the same name reappeared.
+ *
+ * @param relative_path path of the resource relative to the workspace root, which must not be the root itself
+ */
+void invalidate_workspace_index_resource(WorkspaceIndex *index, const char *relative_path, bool is_replaced);
+
+/**
+ * Hashes the directory and its subtree as far as they are not hashed yet.
+ *
+ * @param relative_directory_path NULL for the workspace root
+ * @return the digest of the directory, or NULL if it cannot be read, e.g. as it does not exist
+ */
+DirectoryDigest *get_directory_digest(WorkspaceIndex *index, const char *relative_directory_path);
+
+void destroy_directory_digest(DirectoryDigest **digest);
+
+/**
+ * Appends the digest to the body of an agent record.
+ */
+void append_directory_digest(ByteBuffer *record, const DirectoryDigest *digest);
+
+/**
+ * @return the digest read from the body of an agent record, or NULL if it is malformed, in which case the reader's
+ *  error flag is set
+ */
+DirectoryDigest *read_directory_digest(ByteBufferReader *reader);
+
+#endif //RESYNC_WORKSPACE_INDEX_H
@@ -72,3 +72,117 @@ create_unix_client_socket(const char *socket_path)
     return socket_fd;
 }
 
+
+bool
+write_all(const int fd, const void *buffer, const size_t size)
+{
+    size_t bytes_written = 0;
+
+    while (bytes_written < size) {
+        const ssize_t ret = write(fd, (const char *) buffer + bytes_written, size - bytes_written);
+        if (ret == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes_written += ret;
+    }
+
+    return true;
+}
+
+int
+read_all(const int fd, void *buffer, const size_t size)
+{
+    size_t bytes_read = 0;
+
+    while (bytes_read < size) {
+        const ssize_t ret = read(fd, (char *) buffer + bytes_read, size - bytes_read);
+        if (ret == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+
+        if (ret == 0) {
+            return (bytes_read == 0) ? 0 : -1;
+        }
+        bytes_read += ret;
+    }
+
+    return 1;
+}
+
+bool
+send_file_descriptor(const int socket_fd, const int fd_to_send)
+{
+    // At least one byte of regular data has to be sent alongside the ancillary data
+    char data = 0;
+    struct iovec iov = {.iov_base = &data, .iov_len = sizeof(data)};
+
+    union {
+        char buffer[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buffer;
+    msg.msg_controllen = sizeof(control.buffer);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd_to_send, sizeof(int));
+
+    ssize_t ret;
+    do {
+        ret = sendmsg(socket_fd, &msg, MSG_NOSIGNAL);
+    } while (ret == -1 && errno == EINTR);
+
+    return ret == sizeof(data);
+}
+
+int
+receive_file_descriptor(const int socket_fd)
+{
+    char data;
+    struct iovec iov = {.iov_base = &data, .iov_len = sizeof(data)};
+
+    union {
+        char buffer[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buffer;
+    msg.msg_controllen = sizeof(control.buffer);
+
+    ssize_t ret;
+    do {
+        ret = recvmsg(socket_fd, &msg, MSG_CMSG_CLOEXEC);
+    } while (ret == -1 && errno == EINTR);
+
+    if (ret != sizeof(data)) {
+        return -1;
+    }
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS
+        || cmsg->cmsg_len != CMSG_LEN(sizeof(int))) {
+        return -1;
+    }
+
+    int received_fd;
+    memcpy(&received_fd, CMSG_DATA(cmsg), sizeof(int));
+    return received_fd;
+}
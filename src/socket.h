@@ -4,6 +4,7 @@
 #include "util/error.h"
 
 #include <unistd.h>
+#include <stdbool.h>
 #include <sys/un.h>
 #include <sys/socket.h>
 
@@ -19,4 +20,32 @@ int create_unix_client_socket(const char *socket_path);
 
 void set_socket_timeout(const int socket_fd, const long sec, const long usec);
 
+/**
+ * Writes the entire buffer to the file descriptor, retrying on short writes and interrupts.
+ *
+ * @return true on success, false if an error occurred (errno is set accordingly)
+ */
+bool write_all(const int fd, const void *buffer, const size_t size);
+
+/**
+ * Reads exactly 'size' bytes from the file descriptor, retrying on short reads and interrupts.
+ *
+ * @return 1 on success, 0 if the peer closed the connection before any byte was read, -1 on error or a truncated read
+ */
+int read_all(const int fd, void *buffer, const size_t size);
+
+/**
+ * Passes a duplicate of the file descriptor to the peer of the unix socket (SCM_RIGHTS).
+ *
+ * @return true on success, false otherwise (errno is set accordingly)
+ */
+bool send_file_descriptor(const int socket_fd, const int fd_to_send);
+
+/**
+ * Receives a file descriptor that was passed by the peer of the unix socket via 'send_file_descriptor'.
+ *
+ * @return the received file descriptor, or -1 if no file descriptor could be received
+ */
+int receive_file_descriptor(const int socket_fd);
+
 #endif //RESYNC_SOCKET_H
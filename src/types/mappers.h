@@ -2,6 +2,7 @@
 #define RESYNC_MAPPERS_H
 
 #include "types.h"
+#include "../util/byte_buffer.h"
 #include "../../lib/json/cJSON.h"
 
 /*
@@ -26,6 +27,12 @@ cJSON *workspaceInformation_to_cjson(WorkspaceInformation *ws_info, char **error
 
 char *workspaceInformation_to_stringified_json(WorkspaceInformation *ws_info, char **error_msg);
 
+/**
+ * Returns the local workspace root path stored in the JSON representation of a WorkspaceInformation struct without
+ *  converting the entire object. The returned string is owned by the JSON object.
+ */
+const char *cjson_to_local_workspace_root_path(const cJSON *json_ws_info);
+
 /*
  * RemoteWorkspaceMetadata <-> JSON mappers
  */
@@ -33,6 +40,32 @@ RemoteWorkspaceMetadata *cjson_to_remoteWorkspaceMetadata(const cJSON *json_remo
 
 cJSON *remoteWorkspaceMetadata_to_cjson(RemoteWorkspaceMetadata *remote_ws_metadata, char **error_msg);
 
+/*
+ * RemoveRemoteSystemMetadata <-> JSON mappers
+ */
+RemoveRemoteSystemMetadata *cjson_to_removeRemoteSystemMetadata(const cJSON *rm_remove_system_md_json, char **error_msg);
+
+cJSON *removeRemoteSystemMetadata_to_cjson(RemoveRemoteSystemMetadata *rm_remote_system_md, char **error_msg);
+
+/*
+ * Compact, versioned binary mappers, used to exchange data between reSync processes on the same host (e.g. the daemon
+ *  and its workspace monitors).
+ *
+ * Decoding does not copy any strings: the returned structs are marked as views and their strings point into 'data',
+ *  which must therefore outlive them. The 'destroy_' functions only free the structs themselves in that case.
+ */
+ByteBuffer *workspaceInformation_to_binary(const WorkspaceInformation *ws_info, char **error_msg);
+
+WorkspaceInformation *binary_to_workspaceInformation(const char *data, const size_t size, char **error_msg);
+
+ByteBuffer *remoteWorkspaceMetadata_to_binary(const RemoteWorkspaceMetadata *remote_ws_md, char **error_msg);
+
+RemoteWorkspaceMetadata *binary_to_remoteWorkspaceMetadata(const char *data, const size_t size, char **error_msg);
+
+ByteBuffer *removeRemoteSystemMetadata_to_binary(const RemoveRemoteSystemMetadata *rm_remote_system_md, char **error_msg);
+
+RemoveRemoteSystemMetadata *binary_to_removeRemoteSystemMetadata(const char *data, const size_t size, char **error_msg);
+
 /*
  * Enum <-> string representation mappers
  */
@@ -40,6 +73,13 @@ ConnectionType string_to_connection_type(const char *stringified_connection_type
 
 char *connection_type_to_string(ConnectionType connection_type);
 
+/**
+ * @return true if the string names a sync transport, in which case it is stored in 'transport'
+ */
+bool string_to_sync_transport(const char *stringified_transport, SyncTransport *transport);
+
+char *sync_transport_to_string(SyncTransport transport);
+
 ResyncServerCommandType string_to_resync_server_command_type(const char *stringified_resync_server_command_type);
 
 char *resync_server_command_type_to_string(ResyncServerCommandType command_type);
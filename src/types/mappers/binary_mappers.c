@@ -0,0 +1,435 @@
+#include "../mappers.h"
+
+#include "../../../lib/ulist.h"
+
+/*
+ * Every binary record starts with a magic number identifying the record type and the version of the encoding, so that
+ *  a process never interprets data written by an incompatible reSync build.
+ */
+#define BINARY_FORMAT_VERSION 10
+
+#define WS_INFO_BINARY_MAGIC 0x49575352u /* "RSWI" */
+#define REMOTE_WS_MD_BINARY_MAGIC 0x4d525352u /* "RSRM" */
+#define RM_REMOTE_SYSTEM_MD_BINARY_MAGIC 0x52525352u /* "RSRR" */
+
+#define INITIAL_BINARY_BUFFER_SIZE 256
+
+static void
+append_header(ByteBuffer *buffer, const uint32_t magic)
+{
+    byte_buffer_append_u32(buffer, magic);
+    byte_buffer_append_u32(buffer, BINARY_FORMAT_VERSION);
+}
+
+static bool
+read_header(ByteBufferReader *reader, const uint32_t magic, char **error_msg)
+{
+    const uint32_t actual_magic = byte_buffer_read_u32(reader);
+    const uint32_t version = byte_buffer_read_u32(reader);
+
+    if (reader->error || actual_magic != magic) {
+        SET_ERROR_MSG(error_msg, "Binary data does not contain the expected record type");
+        return false;
+    }
+
+    if (version != BINARY_FORMAT_VERSION) {
+        SET_ERROR_MSG_RAW(
+                error_msg,
+                format_string("Unsupported binary format version %u (expected %u)", version, BINARY_FORMAT_VERSION)
+        );
+        return false;
+    }
+
+    return true;
+}
+
+static bool
+check_reader_fully_consumed(const ByteBufferReader *reader, char **error_msg)
+{
+    if (reader->error) {
+        SET_ERROR_MSG(error_msg, "Binary data is truncated or malformed");
+        return false;
+    }
+
+    if (reader->offset != reader->size) {
+        SET_ERROR_MSG(error_msg, "Binary data contains unexpected trailing bytes");
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * The returned strings are views into the reader's buffer. Casting away the const qualifier is fine, as structs marked
+ *  as views are never modified or freed through these pointers.
+ */
+static char *
+read_string_view(ByteBufferReader *reader)
+{
+    return (char *) byte_buffer_read_string_view(reader);
+}
+
+static bool
+append_remoteWorkspaceMetadata(ByteBuffer *buffer, const RemoteWorkspaceMetadata *remote_ws_md, char **error_msg)
+{
+    byte_buffer_append_string(buffer, remote_ws_md->remote_workspace_root_path);
+    byte_buffer_append_u8(buffer, (uint8_t) remote_ws_md->connection_type);
+    byte_buffer_append_u8(buffer, (uint8_t) remote_ws_md->transport);
+    byte_buffer_append_string(buffer, remote_ws_md->relay_parent);
+
+    switch (remote_ws_md->connection_type) {
+        case SSH: {
+            const SshConnectionInformation *ci = remote_ws_md->connection_information.ssh_connection_information;
+            if (ci == NULL) {
+                SET_ERROR_MSG(error_msg, "SSH connection information is missing!");
+                return false;
+            }
+
+            byte_buffer_append_string(buffer, ci->username);
+            byte_buffer_append_string(buffer, ci->hostname);
+            byte_buffer_append_string(buffer, ci->path_to_identity_file);
+            break;
+        }
+        case SSH_HOST_ALIAS:
+            byte_buffer_append_string(buffer, remote_ws_md->connection_information.ssh_host_alias);
+            break;
+        case RSYNC_DAEMON: {
+            const RsyncConnectionInformation *ci = remote_ws_md->connection_information.rsync_connection_information;
+            if (ci == NULL) {
+                SET_ERROR_MSG(error_msg, "Rsync daemon connection information is missing!");
+                return false;
+            }
+
+            byte_buffer_append_string(buffer, ci->username);
+            byte_buffer_append_string(buffer, ci->hostname);
+            byte_buffer_append_i32(buffer, ci->port);
+            break;
+        }
+        case LOCAL_PATH:
+            break;
+        case OTHER_CONNECTION_TYPE:
+        default:
+            SET_ERROR_MSG(error_msg, "Unable to encode remote system as its connection type is not supported!");
+            return false;
+    }
+
+    return true;
+}
+
+static RemoteWorkspaceMetadata *
+read_remoteWorkspaceMetadata_view(ByteBufferReader *reader, char **error_msg)
+{
+    RemoteWorkspaceMetadata *remote_ws_md = (RemoteWorkspaceMetadata *) do_calloc(1, sizeof(RemoteWorkspaceMetadata));
+    remote_ws_md->is_view = true;
+    remote_ws_md->remote_workspace_root_path = read_string_view(reader);
+    remote_ws_md->connection_type = (ConnectionType) byte_buffer_read_u8(reader);
+    remote_ws_md->transport = (SyncTransport) byte_buffer_read_u8(reader);
+    remote_ws_md->relay_parent = read_string_view(reader);
+
+    switch (remote_ws_md->connection_type) {
+        case SSH: {
+            SshConnectionInformation *ci = (SshConnectionInformation *) do_calloc(1, sizeof(SshConnectionInformation));
+            remote_ws_md->connection_information.ssh_connection_information = ci;
+            ci->username = read_string_view(reader);
+            ci->hostname = read_string_view(reader);
+            ci->path_to_identity_file = read_string_view(reader);
+
+            if (!reader->error && ci->hostname == NULL) {
+                SET_ERROR_MSG(error_msg, "SSH connection info is missing the hostname information!");
+                goto error_out;
+            }
+            break;
+        }
+        case SSH_HOST_ALIAS:
+            remote_ws_md->connection_information.ssh_host_alias = read_string_view(reader);
+
+            if (!reader->error && remote_ws_md->connection_information.ssh_host_alias == NULL) {
+                SET_ERROR_MSG(error_msg, "SSH host alias is missing!");
+                goto error_out;
+            }
+            break;
+        case RSYNC_DAEMON: {
+            RsyncConnectionInformation *ci = (RsyncConnectionInformation *) do_calloc(1, sizeof(RsyncConnectionInformation));
+            remote_ws_md->connection_information.rsync_connection_information = ci;
+            ci->username = read_string_view(reader);
+            ci->hostname = read_string_view(reader);
+            ci->port = byte_buffer_read_i32(reader);
+
+            if (!reader->error && ci->hostname == NULL) {
+                SET_ERROR_MSG(error_msg, "Rsync daemon connection info is missing the hostname information!");
+                goto error_out;
+            }
+            break;
+        }
+        case LOCAL_PATH:
+            break;
+        case OTHER_CONNECTION_TYPE:
+        default:
+            if (reader->error) {
+                SET_ERROR_MSG(error_msg, "Binary remote system data is truncated or malformed");
+            } else {
+                SET_ERROR_MSG(error_msg, "Binary remote system has an unsupported connection type!");
+            }
+            remote_ws_md->connection_type = OTHER_CONNECTION_TYPE;
+            goto error_out;
+    }
+
+    if (reader->error) {
+        SET_ERROR_MSG(error_msg, "Binary remote system data is truncated or malformed");
+        goto error_out;
+    }
+
+    if (remote_ws_md->remote_workspace_root_path == NULL) {
+        SET_ERROR_MSG(error_msg, "Binary remote system is missing the remote workspace root path!");
+        goto error_out;
+    }
+
+    if (remote_ws_md->transport != RSYNC_TRANSPORT && remote_ws_md->transport != AGENT_TRANSPORT) {
+        SET_ERROR_MSG(error_msg, "Binary remote system has an unsupported sync transport!");
+        goto error_out;
+    }
+
+    return remote_ws_md;
+
+error_out:
+    destroy_remoteWorkspaceMetadata(&remote_ws_md);
+    return NULL;
+}
+
+static void
+append_patterns(ByteBuffer *buffer, const IgnorePatternList *patterns)
+{
+    uint32_t patterns_count = 0;
+    const IgnorePatternList *pattern;
+    LL_COUNT(patterns, pattern, patterns_count);
+    byte_buffer_append_u32(buffer, patterns_count);
+
+    LL_FOREACH(patterns, pattern) {
+        byte_buffer_append_string(buffer, pattern->pattern);
+    }
+}
+
+static bool
+read_pattern_views(ByteBufferReader *reader, IgnorePatternList **patterns, char **error_msg)
+{
+    const uint32_t patterns_count = byte_buffer_read_u32(reader);
+    for (uint32_t i = 0; i < patterns_count && !reader->error; i++) {
+        IgnorePatternList *pattern = (IgnorePatternList *) do_calloc(1, sizeof(IgnorePatternList));
+        pattern->pattern = read_string_view(reader);
+        LL_APPEND(*patterns, pattern);
+
+        if (!reader->error && pattern->pattern == NULL) {
+            SET_ERROR_MSG(error_msg, "Binary workspace information is missing a pattern!");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+ByteBuffer *
+workspaceInformation_to_binary(const WorkspaceInformation *ws_info, char **error_msg)
+{
+    if (ws_info == NULL || ws_info->local_workspace_root_path == NULL) {
+        SET_ERROR_MSG(error_msg, "Unable to encode workspace information as it or its local workspace root path is missing!");
+        return NULL;
+    }
+
+    ByteBuffer *buffer = create_byte_buffer(INITIAL_BINARY_BUFFER_SIZE);
+    append_header(buffer, WS_INFO_BINARY_MAGIC);
+    byte_buffer_append_string(buffer, ws_info->local_workspace_root_path);
+    byte_buffer_append_i32(buffer, ws_info->priority);
+    byte_buffer_append_i32(buffer, ws_info->sync_weight);
+    byte_buffer_append_i32(buffer, ws_info->bulk_event_threshold);
+    byte_buffer_append_u8(buffer, (uint8_t) ws_info->is_append_transfer_enabled);
+    byte_buffer_append_i32(buffer, ws_info->drift_check_interval);
+    byte_buffer_append_u8(buffer, (uint8_t) ws_info->is_drift_check_content_hashed);
+
+    append_patterns(buffer, ws_info->ignore_patterns);
+    append_patterns(buffer, ws_info->append_stream_patterns);
+
+    uint32_t remote_systems_count = 0;
+    RemoteWorkspaceMetadata *entry;
+    LL_COUNT(ws_info->remote_systems, entry, remote_systems_count);
+    byte_buffer_append_u32(buffer, remote_systems_count);
+
+    LL_FOREACH(ws_info->remote_systems, entry) {
+        if (!append_remoteWorkspaceMetadata(buffer, entry, error_msg)) {
+            destroy_byte_buffer(&buffer);
+            return NULL;
+        }
+    }
+
+    return buffer;
+}
+
+WorkspaceInformation *
+binary_to_workspaceInformation(const char *data, const size_t size, char **error_msg)
+{
+    ByteBufferReader reader = create_byte_buffer_reader(data, size);
+    if (!read_header(&reader, WS_INFO_BINARY_MAGIC, error_msg)) {
+        return NULL;
+    }
+
+    WorkspaceInformation *ws_info = (WorkspaceInformation *) do_calloc(1, sizeof(WorkspaceInformation));
+    ws_info->is_view = true;
+    ws_info->local_workspace_root_path = read_string_view(&reader);
+    ws_info->priority = byte_buffer_read_i32(&reader);
+    ws_info->sync_weight = byte_buffer_read_i32(&reader);
+    ws_info->bulk_event_threshold = byte_buffer_read_i32(&reader);
+    ws_info->is_append_transfer_enabled = byte_buffer_read_u8(&reader) != 0;
+    ws_info->drift_check_interval = byte_buffer_read_i32(&reader);
+    ws_info->is_drift_check_content_hashed = byte_buffer_read_u8(&reader) != 0;
+
+    if (!read_pattern_views(&reader, &ws_info->ignore_patterns, error_msg)
+        || !read_pattern_views(&reader, &ws_info->append_stream_patterns, error_msg)) {
+        goto error_out;
+    }
+
+    const uint32_t remote_systems_count = byte_buffer_read_u32(&reader);
+    if (reader.error || ws_info->local_workspace_root_path == NULL) {
+        SET_ERROR_MSG(error_msg, "Binary workspace information is missing the local workspace root path!");
+        goto error_out;
+    }
+
+    for (uint32_t i = 0; i < remote_systems_count; i++) {
+        RemoteWorkspaceMetadata *remote_ws_md = read_remoteWorkspaceMetadata_view(&reader, error_msg);
+        if (remote_ws_md == NULL) {
+            goto error_out;
+        }
+
+        LL_APPEND(ws_info->remote_systems, remote_ws_md);
+    }
+
+    if (!check_reader_fully_consumed(&reader, error_msg)) {
+        goto error_out;
+    }
+
+    return ws_info;
+
+error_out:
+    destroy_workspaceInformation(&ws_info);
+    return NULL;
+}
+
+ByteBuffer *
+remoteWorkspaceMetadata_to_binary(const RemoteWorkspaceMetadata *remote_ws_md, char **error_msg)
+{
+    if (remote_ws_md == NULL) {
+        SET_ERROR_MSG(error_msg, "Unable to encode remote system as it is missing!");
+        return NULL;
+    }
+
+    ByteBuffer *buffer = create_byte_buffer(INITIAL_BINARY_BUFFER_SIZE);
+    append_header(buffer, REMOTE_WS_MD_BINARY_MAGIC);
+
+    if (!append_remoteWorkspaceMetadata(buffer, remote_ws_md, error_msg)) {
+        destroy_byte_buffer(&buffer);
+        return NULL;
+    }
+
+    return buffer;
+}
+
+RemoteWorkspaceMetadata *
+binary_to_remoteWorkspaceMetadata(const char *data, const size_t size, char **error_msg)
+{
+    ByteBufferReader reader = create_byte_buffer_reader(data, size);
+    if (!read_header(&reader, REMOTE_WS_MD_BINARY_MAGIC, error_msg)) {
+        return NULL;
+    }
+
+    RemoteWorkspaceMetadata *remote_ws_md = read_remoteWorkspaceMetadata_view(&reader, error_msg);
+    if (remote_ws_md == NULL) {
+        return NULL;
+    }
+
+    if (!check_reader_fully_consumed(&reader, error_msg)) {
+        destroy_remoteWorkspaceMetadata(&remote_ws_md);
+        return NULL;
+    }
+
+    return remote_ws_md;
+}
+
+ByteBuffer *
+removeRemoteSystemMetadata_to_binary(const RemoveRemoteSystemMetadata *rm_remote_system_md, char **error_msg)
+{
+    if (rm_remote_system_md == NULL) {
+        SET_ERROR_MSG(error_msg, "Unable to encode the remote system to remove as it is missing!");
+        return NULL;
+    }
+
+    ByteBuffer *buffer = create_byte_buffer(INITIAL_BINARY_BUFFER_SIZE);
+    append_header(buffer, RM_REMOTE_SYSTEM_MD_BINARY_MAGIC);
+    byte_buffer_append_string(buffer, rm_remote_system_md->local_workspace_root_path);
+    byte_buffer_append_string(buffer, rm_remote_system_md->remote_workspace_root_path);
+    byte_buffer_append_u8(buffer, (uint8_t) rm_remote_system_md->connection_type);
+
+    switch (rm_remote_system_md->connection_type) {
+        case SSH:
+        case RSYNC_DAEMON:
+            byte_buffer_append_string(buffer, rm_remote_system_md->remote_system_id_information.hostname);
+            break;
+        case SSH_HOST_ALIAS:
+            byte_buffer_append_string(buffer, rm_remote_system_md->remote_system_id_information.ssh_host_alias);
+            break;
+        case LOCAL_PATH:
+            byte_buffer_append_string(buffer, NULL);
+            break;
+        case OTHER_CONNECTION_TYPE:
+        default:
+            SET_ERROR_MSG(error_msg, "Unable to encode the remote system to remove as its connection type is not supported!");
+            destroy_byte_buffer(&buffer);
+            return NULL;
+    }
+
+    return buffer;
+}
+
+RemoveRemoteSystemMetadata *
+binary_to_removeRemoteSystemMetadata(const char *data, const size_t size, char **error_msg)
+{
+    ByteBufferReader reader = create_byte_buffer_reader(data, size);
+    if (!read_header(&reader, RM_REMOTE_SYSTEM_MD_BINARY_MAGIC, error_msg)) {
+        return NULL;
+    }
+
+    RemoveRemoteSystemMetadata *rm_remote_system_md = (RemoveRemoteSystemMetadata *) do_calloc(1, sizeof(RemoveRemoteSystemMetadata));
+    rm_remote_system_md->is_view = true;
+    rm_remote_system_md->local_workspace_root_path = read_string_view(&reader);
+    rm_remote_system_md->remote_workspace_root_path = read_string_view(&reader);
+    rm_remote_system_md->connection_type = (ConnectionType) byte_buffer_read_u8(&reader);
+
+    // Both members of the union are strings, so the identifying information can be read regardless of the type
+    rm_remote_system_md->remote_system_id_information.hostname = read_string_view(&reader);
+
+    if (!check_reader_fully_consumed(&reader, error_msg)) {
+        goto error_out;
+    }
+
+    if (rm_remote_system_md->local_workspace_root_path == NULL
+        || rm_remote_system_md->remote_workspace_root_path == NULL
+        || (rm_remote_system_md->remote_system_id_information.hostname == NULL && rm_remote_system_md->connection_type != LOCAL_PATH)) {
+        SET_ERROR_MSG(error_msg, "Binary data of the remote system to remove is incomplete!");
+        goto error_out;
+    }
+
+    switch (rm_remote_system_md->connection_type) {
+        case SSH:
+        case SSH_HOST_ALIAS:
+        case RSYNC_DAEMON:
+        case LOCAL_PATH:
+            break;
+        case OTHER_CONNECTION_TYPE:
+        default:
+            SET_ERROR_MSG(error_msg, "Binary data of the remote system to remove has an unsupported connection type!");
+            goto error_out;
+    }
+
+    return rm_remote_system_md;
+
+error_out:
+    destroy_removeRemoteSystemMetadata(&rm_remote_system_md);
+    return NULL;
+}
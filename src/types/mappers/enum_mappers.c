@@ -11,6 +11,8 @@ string_to_connection_type(const char *stringified_connection_type)
         return SSH_HOST_ALIAS;
     } else if (IS_RSYNC_DAEMON_CONNECTION_TYPE(stringified_connection_type)) {
         return RSYNC_DAEMON;
+    } else if (IS_LOCAL_PATH_CONNECTION_TYPE(stringified_connection_type)) {
+        return LOCAL_PATH;
     }
 
     return OTHER_CONNECTION_TYPE;
@@ -26,12 +28,41 @@ connection_type_to_string(ConnectionType connection_type)
             return CONNECTION_TYPE_SSH_HOST_ALIAS;
         case RSYNC_DAEMON:
             return CONNECTION_TYPE_RSYNC_DAEMON;
+        case LOCAL_PATH:
+            return CONNECTION_TYPE_LOCAL_PATH;
         case OTHER_CONNECTION_TYPE:
         default:
             return NULL;
     }
 }
 
+bool
+string_to_sync_transport(const char *stringified_transport, SyncTransport *transport)
+{
+    if (is_equal(stringified_transport, SYNC_TRANSPORT_RSYNC)) {
+        *transport = RSYNC_TRANSPORT;
+        return true;
+    } else if (is_equal(stringified_transport, SYNC_TRANSPORT_AGENT)) {
+        *transport = AGENT_TRANSPORT;
+        return true;
+    }
+
+    return false;
+}
+
+char *
+sync_transport_to_string(SyncTransport transport)
+{
+    switch (transport) {
+        case RSYNC_TRANSPORT:
+            return SYNC_TRANSPORT_RSYNC;
+        case AGENT_TRANSPORT:
+            return SYNC_TRANSPORT_AGENT;
+        default:
+            return NULL;
+    }
+}
+
 ResyncServerCommandType
 string_to_resync_server_command_type(const char *stringified_resync_server_command_type)
 {
@@ -18,9 +18,19 @@
 /* Workspace information JSON object */
 #define WS_INFO_KEY_LOCAL_WORKSPACE_ROOT_PATH "local-workspace-root-path"
 #define WS_INFO_KEY_REMOTE_SYSTEMS "remote-systems"
+#define WS_INFO_KEY_PRIORITY "priority"
+#define WS_INFO_KEY_SYNC_WEIGHT "sync-weight"
+#define WS_INFO_KEY_BULK_EVENT_THRESHOLD "bulk-event-threshold"
+#define WS_INFO_KEY_APPEND_TRANSFERS "append-transfers"
+#define WS_INFO_KEY_DRIFT_CHECK_INTERVAL "drift-check-interval"
+#define WS_INFO_KEY_DRIFT_CHECK_CONTENT "drift-check-content"
+#define WS_INFO_KEY_IGNORE_PATTERNS "ignore-patterns"
+#define WS_INFO_KEY_APPEND_STREAM_PATTERNS "append-stream-patterns"
 #define WS_INFO_RSMD_REMOTE_WORKSPACE_ROOT_PATH "remote-workspace-root-path"
 #define WS_INFO_RSMD_CONNECTION_TYPE "connection-type"
 #define WS_INFO_RSMD_CONNECTION_INFORMATION "connection-information"
+#define WS_INFO_RSMD_TRANSPORT "transport"
+#define WS_INFO_RSMD_RELAY_PARENT "relay-parent"
 #define WS_INFO_RSMD_SSH_CI_USERNAME "username"
 #define WS_INFO_RSMD_SSH_CI_HOSTNAME "hostname"
 #define WS_INFO_RSMD_SSH_CI_IDENTITY_FILE "identity-file"
@@ -38,11 +48,17 @@
 #define CONNECTION_TYPE_SSH_HOST_ALIAS_LEN (strlen(CONNECTION_TYPE_SSH_HOST_ALIAS))
 #define CONNECTION_TYPE_RSYNC_DAEMON "RSYNC_DAEMON"
 #define CONNECTION_TYPE_RSYNC_DAEMON_LEN (strlen(CONNECTION_TYPE_RSYNC_DAEMON))
+#define CONNECTION_TYPE_LOCAL_PATH "LOCAL_PATH"
+#define CONNECTION_TYPE_LOCAL_PATH_LEN (strlen(CONNECTION_TYPE_LOCAL_PATH))
+
+#define SYNC_TRANSPORT_RSYNC "rsync"
+#define SYNC_TRANSPORT_AGENT "agent"
 
 #define CHECK_CONNECTION_TYPE(x, y, z) ((x) != NULL && strncmp(x, y, z) == 0 && strlen(x) == (z))
 #define IS_SSH_CONNECTION_TYPE(x) CHECK_CONNECTION_TYPE(x, CONNECTION_TYPE_SSH, CONNECTION_TYPE_SSH_LEN)
 #define IS_SSH_HOST_ALIAS_CONNECTION_TYPE(x) CHECK_CONNECTION_TYPE(x, CONNECTION_TYPE_SSH_HOST_ALIAS, CONNECTION_TYPE_SSH_HOST_ALIAS_LEN)
 #define IS_RSYNC_DAEMON_CONNECTION_TYPE(x) CHECK_CONNECTION_TYPE(x, CONNECTION_TYPE_RSYNC_DAEMON, CONNECTION_TYPE_RSYNC_DAEMON_LEN)
+#define IS_LOCAL_PATH_CONNECTION_TYPE(x) CHECK_CONNECTION_TYPE(x, CONNECTION_TYPE_LOCAL_PATH, CONNECTION_TYPE_LOCAL_PATH_LEN)
 
 #define CMD_TYPE_ADD_WORKSPACE "add-workspace"
 #define CMD_TYPE_ADD_WORKSPACE_LEN (strlen("add-workspace"))
@@ -98,7 +98,7 @@ cjson_object_to_ssh_host_alias_id_info(const cJSON *json_object, char **error_ms
     return resync_strdup(entry->valuestring);
 }
 
-static cJSON *
+cJSON *
 removeRemoteSystemMetadata_to_cjson(RemoveRemoteSystemMetadata *rm_remote_system_md, char **error_msg)
 {
     if (rm_remote_system_md == NULL) {
@@ -142,6 +142,9 @@ removeRemoteSystemMetadata_to_cjson(RemoveRemoteSystemMetadata *rm_remote_system
         case RSYNC_DAEMON:
             remote_system_id_info_json = rsync_daemon_id_info_to_cjson_object(rm_remote_system_md, error_msg);
             break;
+        case LOCAL_PATH:
+            // Local paths are identified by the remote workspace path alone
+            return rm_remote_system_md_json;
         case OTHER_CONNECTION_TYPE:
         default:
             SET_ERROR_MSG(error_msg, "Remote system metadata specifies unsupported connection type!");
@@ -161,7 +164,7 @@ error_out:
     return NULL;
 }
 
-static RemoveRemoteSystemMetadata *
+RemoveRemoteSystemMetadata *
 cjson_to_removeRemoteSystemMetadata(const cJSON *rm_remove_system_md_json, char **error_msg)
 {
     cJSON *entry;
@@ -199,6 +202,10 @@ cjson_to_removeRemoteSystemMetadata(const cJSON *rm_remove_system_md_json, char
     }
     rm_remote_system_md->connection_type = connection_type;
 
+    if (connection_type == LOCAL_PATH) {
+        return rm_remote_system_md;
+    }
+
     entry = cJSON_GetObjectItemCaseSensitive(rm_remove_system_md_json, RM_RS_KEY_REMOTE_SYSTEM_ID_INFORMATION);
     if (entry == NULL) {
         SET_ERROR_MSG_RAW(error_msg, JSON_MEMBER_MISSING(RM_RS_KEY_REMOTE_SYSTEM_ID_INFORMATION, rm_remove_system_md_json));
@@ -44,6 +44,17 @@ create_json_number(const int number)
     return json_number;
 }
 
+cJSON *
+create_json_bool(const bool value)
+{
+    cJSON *json_bool = cJSON_CreateBool(value);
+    if (json_bool == NULL) {
+        fatal_custom_error("cJSON_CreateBool failed");
+    }
+
+    return json_bool;
+}
+
 cJSON *
 stringified_cjson_to_cjson(const char *stringified_json_object, char **error_msg)
 {
@@ -19,6 +19,8 @@ cJSON *create_json_string(const char *string);
 
 cJSON *create_json_number(const int number);
 
+cJSON *create_json_bool(const bool value);
+
 cJSON *stringified_cjson_to_cjson(const char *stringified_json_object, char **error_msg);
 
 #endif //RESYNC_JSON_UTILS_H
@@ -4,6 +4,7 @@
 
 #include "../../../lib/ulist.h"
 #include "../../util/fs_util.h"
+#include "../../util/ignore_rules.h"
 
 #define MIN_PORT_NUMBER 0
 #define MAX_PORT_NUMBER 65535
@@ -218,6 +219,21 @@ error_out:
     return NULL;
 }
 
+/*
+ * @return true if the path is equal to the directory path or lies inside of it
+ */
+static bool
+is_path_within(const char *path, const char *directory_path)
+{
+    size_t directory_path_len = strlen(directory_path);
+    while (directory_path_len > 1 && directory_path[directory_path_len - 1] == '/') {
+        directory_path_len--;
+    }
+
+    return strncmp(path, directory_path, directory_path_len) == 0
+           && (path[directory_path_len] == '\0' || path[directory_path_len] == '/' || directory_path_len == 1);
+}
+
 static cJSON *
 sshHostAliasConnectionInformation_to_cJSON(char *ssh_host_alias, char **error_msg)
 {
@@ -285,6 +301,10 @@ remoteWorkspaceMetadata_to_cjson(RemoteWorkspaceMetadata *remote_ws_metadata, ch
 
     cJSON *connection_information;
     switch (remote_ws_metadata->connection_type) {
+        case LOCAL_PATH:
+            // The remote workspace path is all there is to know about a local path
+            connection_information = NULL;
+            break;
         case SSH:
             connection_information = sshConnectionInformation_to_cJSON(
                     remote_ws_metadata->connection_information.ssh_connection_information, error_msg
@@ -306,11 +326,26 @@ remoteWorkspaceMetadata_to_cjson(RemoteWorkspaceMetadata *remote_ws_metadata, ch
             goto error_out;
     }
 
-    if (connection_information == NULL) {
+    if (connection_information == NULL && remote_ws_metadata->connection_type != LOCAL_PATH) {
         goto error_out;
     }
 
-    cJSON_AddItemToObject(remote_ws_metadata_json, WS_INFO_RSMD_CONNECTION_INFORMATION, connection_information);
+    if (connection_information != NULL) {
+        cJSON_AddItemToObject(remote_ws_metadata_json, WS_INFO_RSMD_CONNECTION_INFORMATION, connection_information);
+    }
+
+    if (remote_ws_metadata->transport != RSYNC_TRANSPORT) {
+        char *stringified_transport = sync_transport_to_string(remote_ws_metadata->transport);
+        if (stringified_transport == NULL) {
+            SET_ERROR_MSG(error_msg, "RemoteWorkspaceMetadata struct specifies an unsupported sync transport!");
+            goto error_out;
+        }
+        cJSON_AddItemToObject(remote_ws_metadata_json, WS_INFO_RSMD_TRANSPORT, create_json_string(stringified_transport));
+    }
+
+    if (remote_ws_metadata->relay_parent != NULL) {
+        cJSON_AddItemToObject(remote_ws_metadata_json, WS_INFO_RSMD_RELAY_PARENT, create_json_string(remote_ws_metadata->relay_parent));
+    }
 
     return remote_ws_metadata_json;
 
@@ -366,13 +401,17 @@ cjson_to_remoteWorkspaceMetadata(const cJSON *json_remote_ws_metadata, char **er
     remote_ws_metadata->connection_type = connection_type;
 
     entry = cJSON_GetObjectItemCaseSensitive(json_remote_ws_metadata, WS_INFO_RSMD_CONNECTION_INFORMATION);
-    if (entry == NULL) {
+    if (entry == NULL && connection_type != LOCAL_PATH) {
         SET_ERROR_MSG_RAW(error_msg, JSON_MEMBER_MISSING(WS_INFO_RSMD_CONNECTION_INFORMATION, json_remote_ws_metadata));
         goto error_out;
     }
 
     void *connection_information;
     switch (connection_type) {
+        case LOCAL_PATH:
+            // Any connection information is ignored, the remote workspace path is all there is to know
+            connection_information = remote_ws_metadata->remote_workspace_root_path;
+            break;
         case SSH:
             connection_information = cjson_to_sshConnectionInformation(entry, error_msg);
             remote_ws_metadata->connection_information.ssh_connection_information = (SshConnectionInformation *) connection_information;
@@ -398,6 +437,54 @@ cjson_to_remoteWorkspaceMetadata(const cJSON *json_remote_ws_metadata, char **er
         goto error_out;
     }
 
+    entry = cJSON_GetObjectItemCaseSensitive(json_remote_ws_metadata, WS_INFO_RSMD_TRANSPORT);
+    if (entry != NULL) {
+        if (!STRING_VAL_EXISTS(entry) || !string_to_sync_transport(entry->valuestring, &(remote_ws_metadata->transport))) {
+            SET_ERROR_MSG_RAW(
+                    error_msg,
+                    format_string("Unsupported sync transport is specified in json object: \n'%s'", cJSON_Print(json_remote_ws_metadata))
+            );
+            goto error_out;
+        }
+
+        // The agent is started through ssh, neither a rsync daemon nor a local path provide a way to run it
+        if (remote_ws_metadata->transport == AGENT_TRANSPORT && (connection_type == RSYNC_DAEMON || connection_type == LOCAL_PATH)) {
+            SET_ERROR_MSG_RAW(
+                    error_msg,
+                    format_string(
+                            "Remote workspace '%s' can only use the agent transport when connecting via ssh",
+                            remote_ws_metadata->remote_workspace_root_path
+                    )
+            );
+            goto error_out;
+        }
+    }
+
+    entry = cJSON_GetObjectItemCaseSensitive(json_remote_ws_metadata, WS_INFO_RSMD_RELAY_PARENT);
+    if (entry != NULL) {
+        if (!STRING_VAL_EXISTS(entry)) {
+            SET_ERROR_MSG_RAW(
+                    error_msg,
+                    format_string("Relay parent of remote workspace '%s' is not a string", remote_ws_metadata->remote_workspace_root_path)
+            );
+            goto error_out;
+        }
+
+        // The relay runs rsync for the remote system behind it, there is no way to start an agent from there
+        if (remote_ws_metadata->transport == AGENT_TRANSPORT) {
+            SET_ERROR_MSG_RAW(
+                    error_msg,
+                    format_string(
+                            "Remote workspace '%s' cannot use the agent transport behind a relay",
+                            remote_ws_metadata->remote_workspace_root_path
+                    )
+            );
+            goto error_out;
+        }
+
+        remote_ws_metadata->relay_parent = resync_strdup(entry->valuestring);
+    }
+
     return remote_ws_metadata;
 
 error_out:
@@ -405,6 +492,95 @@ error_out:
     return NULL;
 }
 
+/*
+ * Patterns are compiled by the monitor of the workspace, so malformed ones are rejected along with the configuration.
+ *
+ * @param kind kind of the patterns for error messages, e.g. "Ignore"
+ */
+static bool
+cjson_to_patterns(const cJSON *json_patterns, const WorkspaceInformation *ws_info, const char *kind,
+                  IgnorePatternList **patterns, char **error_msg)
+{
+    if (!cJSON_IsArray(json_patterns)) {
+        SET_ERROR_MSG_RAW(
+                error_msg,
+                format_string("%s patterns of workspace '%s' are not an array", kind, ws_info->local_workspace_root_path)
+        );
+        return false;
+    }
+
+    IgnoreRules *rules = create_ignore_rules();
+    bool res = true;
+
+    cJSON *entry;
+    cJSON_ArrayForEach(entry, json_patterns) {
+        if (!cJSON_IsString(entry) || !STRING_VAL_EXISTS(entry)) {
+            SET_ERROR_MSG_RAW(
+                    error_msg,
+                    format_string("%s pattern of workspace '%s' is not a string", kind, ws_info->local_workspace_root_path)
+            );
+            res = false;
+            break;
+        }
+
+        if (!add_ignore_pattern(rules, entry->valuestring, error_msg)) {
+            res = false;
+            break;
+        }
+
+        IgnorePatternList *pattern = (IgnorePatternList *) do_calloc(1, sizeof(IgnorePatternList));
+        pattern->pattern = resync_strdup(entry->valuestring);
+        LL_APPEND(*patterns, pattern);
+    }
+
+    destroy_ignore_rules(&rules);
+    return res;
+}
+
+/*
+ * A relay runs rsync for the remote systems behind it through ssh, so it has to be reached via ssh and be synced with
+ *  rsync itself. Relays cannot be nested.
+ */
+static bool
+validate_relay_parents(const WorkspaceInformation *ws_info, char **error_msg)
+{
+    RemoteWorkspaceMetadata *remote_system;
+    LL_FOREACH(ws_info->remote_systems, remote_system) {
+        if (remote_system->relay_parent == NULL) {
+            continue;
+        }
+
+        const RemoteWorkspaceMetadata *relay = get_relay_parent(ws_info, remote_system);
+        if (relay == NULL) {
+            SET_ERROR_MSG_RAW(
+                    error_msg,
+                    format_string(
+                            "Relay parent '%s' of remote workspace '%s' is not a remote system of workspace '%s'",
+                            remote_system->relay_parent,
+                            remote_system->remote_workspace_root_path,
+                            ws_info->local_workspace_root_path
+                    )
+            );
+            return false;
+        }
+
+        if ((relay->connection_type != SSH && relay->connection_type != SSH_HOST_ALIAS)
+            || relay->transport != RSYNC_TRANSPORT || relay->relay_parent != NULL) {
+            SET_ERROR_MSG_RAW(
+                    error_msg,
+                    format_string(
+                            "Remote system '%s' cannot relay syncs, as it is not reached via ssh, does not use the "
+                            "rsync transport or is behind a relay itself",
+                            remote_system->relay_parent
+                    )
+            );
+            return false;
+        }
+    }
+
+    return true;
+}
+
 WorkspaceInformation *
 cjson_to_workspaceInformation(const cJSON *json_ws_info, char **error_msg)
 {
@@ -424,6 +600,95 @@ cjson_to_workspaceInformation(const cJSON *json_ws_info, char **error_msg)
         goto error_out;
     }
 
+    entry = cJSON_GetObjectItemCaseSensitive(json_ws_info, WS_INFO_KEY_PRIORITY);
+    if (entry != NULL) {
+        if (!cJSON_IsNumber(entry)) {
+            SET_ERROR_MSG_RAW(
+                    error_msg,
+                    format_string("Priority of workspace '%s' is not an integer", ws_info->local_workspace_root_path)
+            );
+            goto error_out;
+        }
+
+        ws_info->priority = entry->valueint;
+    }
+
+    entry = cJSON_GetObjectItemCaseSensitive(json_ws_info, WS_INFO_KEY_SYNC_WEIGHT);
+    if (entry != NULL) {
+        if (!cJSON_IsNumber(entry) || entry->valueint < 1) {
+            SET_ERROR_MSG_RAW(
+                    error_msg,
+                    format_string("Sync weight of workspace '%s' is not a positive integer", ws_info->local_workspace_root_path)
+            );
+            goto error_out;
+        }
+
+        ws_info->sync_weight = entry->valueint;
+    }
+
+    entry = cJSON_GetObjectItemCaseSensitive(json_ws_info, WS_INFO_KEY_BULK_EVENT_THRESHOLD);
+    if (entry != NULL) {
+        if (!cJSON_IsNumber(entry) || entry->valueint < 1) {
+            SET_ERROR_MSG_RAW(
+                    error_msg,
+                    format_string("Bulk event threshold of workspace '%s' is not a positive integer", ws_info->local_workspace_root_path)
+            );
+            goto error_out;
+        }
+
+        ws_info->bulk_event_threshold = entry->valueint;
+    }
+
+    entry = cJSON_GetObjectItemCaseSensitive(json_ws_info, WS_INFO_KEY_APPEND_TRANSFERS);
+    if (entry != NULL) {
+        if (!cJSON_IsBool(entry)) {
+            SET_ERROR_MSG_RAW(
+                    error_msg,
+                    format_string("Append transfers of workspace '%s' are neither enabled nor disabled", ws_info->local_workspace_root_path)
+            );
+            goto error_out;
+        }
+
+        ws_info->is_append_transfer_enabled = cJSON_IsTrue(entry);
+    }
+
+    entry = cJSON_GetObjectItemCaseSensitive(json_ws_info, WS_INFO_KEY_DRIFT_CHECK_INTERVAL);
+    if (entry != NULL) {
+        if (!cJSON_IsNumber(entry) || entry->valueint < 0) {
+            SET_ERROR_MSG_RAW(
+                    error_msg,
+                    format_string("Drift check interval of workspace '%s' is not a non-negative integer", ws_info->local_workspace_root_path)
+            );
+            goto error_out;
+        }
+
+        ws_info->drift_check_interval = entry->valueint;
+    }
+
+    entry = cJSON_GetObjectItemCaseSensitive(json_ws_info, WS_INFO_KEY_DRIFT_CHECK_CONTENT);
+    if (entry != NULL) {
+        if (!cJSON_IsBool(entry)) {
+            SET_ERROR_MSG_RAW(
+                    error_msg,
+                    format_string("Content drift checks of workspace '%s' are neither enabled nor disabled", ws_info->local_workspace_root_path)
+            );
+            goto error_out;
+        }
+
+        ws_info->is_drift_check_content_hashed = cJSON_IsTrue(entry);
+    }
+
+    entry = cJSON_GetObjectItemCaseSensitive(json_ws_info, WS_INFO_KEY_IGNORE_PATTERNS);
+    if (entry != NULL && !cjson_to_patterns(entry, ws_info, "Ignore", &ws_info->ignore_patterns, error_msg)) {
+        goto error_out;
+    }
+
+    entry = cJSON_GetObjectItemCaseSensitive(json_ws_info, WS_INFO_KEY_APPEND_STREAM_PATTERNS);
+    if (entry != NULL
+        && !cjson_to_patterns(entry, ws_info, "Append stream", &ws_info->append_stream_patterns, error_msg)) {
+        goto error_out;
+    }
+
     cJSON *remote_systems_array = cJSON_GetObjectItemCaseSensitive(json_ws_info, WS_INFO_KEY_REMOTE_SYSTEMS);
     if (remote_systems_array == NULL) {
         SET_ERROR_MSG_RAW(
@@ -444,6 +709,22 @@ cjson_to_workspaceInformation(const cJSON *json_ws_info, char **error_msg)
         }
 
         LL_APPEND(ws_info->remote_systems, remote_ws_metadata_entry);
+
+        // A mirror inside of the workspace would be synced into itself, and syncing into a directory containing the
+        //  workspace would delete it. Mirrors behind a relay are on the relay's host.
+        if (remote_ws_metadata_entry->connection_type == LOCAL_PATH && remote_ws_metadata_entry->relay_parent == NULL
+            && (is_path_within(remote_ws_metadata_entry->remote_workspace_root_path, ws_info->local_workspace_root_path)
+                || is_path_within(ws_info->local_workspace_root_path, remote_ws_metadata_entry->remote_workspace_root_path))) {
+            SET_ERROR_MSG_RAW(
+                    error_msg,
+                    format_string(
+                            "Local path '%s' overlaps with workspace '%s'",
+                            remote_ws_metadata_entry->remote_workspace_root_path,
+                            ws_info->local_workspace_root_path
+                    )
+            );
+            goto error_out;
+        }
     }
 
     if (remote_systems_counter == 0) {
@@ -454,6 +735,10 @@ cjson_to_workspaceInformation(const cJSON *json_ws_info, char **error_msg)
         goto error_out;
     }
 
+    if (!validate_relay_parents(ws_info, error_msg)) {
+        goto error_out;
+    }
+
     return ws_info;
 
 error_out:
@@ -461,6 +746,17 @@ error_out:
     return NULL;
 }
 
+const char *
+cjson_to_local_workspace_root_path(const cJSON *json_ws_info)
+{
+    cJSON *entry = cJSON_GetObjectItemCaseSensitive(json_ws_info, WS_INFO_KEY_LOCAL_WORKSPACE_ROOT_PATH);
+    if (!STRING_VAL_EXISTS(entry)) {
+        return NULL;
+    }
+
+    return entry->valuestring;
+}
+
 WorkspaceInformation *
 stringified_json_to_workspaceInformation(const char *stringified_json_ws_info, char **error_msg)
 {
@@ -477,6 +773,19 @@ stringified_json_to_workspaceInformation(const char *stringified_json_ws_info, c
     return cjson_to_workspaceInformation(json_ws_info, error_msg);
 }
 
+static cJSON *
+patterns_to_cjson(const IgnorePatternList *patterns)
+{
+    cJSON *patterns_array = create_json_array();
+
+    const IgnorePatternList *pattern;
+    LL_FOREACH(patterns, pattern) {
+        cJSON_AddItemToArray(patterns_array, create_json_string(pattern->pattern));
+    }
+
+    return patterns_array;
+}
+
 cJSON *
 workspaceInformation_to_cjson(WorkspaceInformation *ws_info, char **error_msg)
 {
@@ -513,6 +822,42 @@ workspaceInformation_to_cjson(WorkspaceInformation *ws_info, char **error_msg)
         goto error_out;
     }
 
+    if (ws_info->priority != 0) {
+        cJSON_AddItemToObject(ws_info_json, WS_INFO_KEY_PRIORITY, create_json_number(ws_info->priority));
+    }
+
+    if (ws_info->sync_weight != 0) {
+        cJSON_AddItemToObject(ws_info_json, WS_INFO_KEY_SYNC_WEIGHT, create_json_number(ws_info->sync_weight));
+    }
+
+    if (ws_info->bulk_event_threshold != 0) {
+        cJSON_AddItemToObject(ws_info_json, WS_INFO_KEY_BULK_EVENT_THRESHOLD, create_json_number(ws_info->bulk_event_threshold));
+    }
+
+    if (ws_info->is_append_transfer_enabled) {
+        cJSON_AddItemToObject(ws_info_json, WS_INFO_KEY_APPEND_TRANSFERS, create_json_bool(true));
+    }
+
+    if (ws_info->drift_check_interval != 0) {
+        cJSON_AddItemToObject(ws_info_json, WS_INFO_KEY_DRIFT_CHECK_INTERVAL, create_json_number(ws_info->drift_check_interval));
+    }
+
+    if (ws_info->is_drift_check_content_hashed) {
+        cJSON_AddItemToObject(ws_info_json, WS_INFO_KEY_DRIFT_CHECK_CONTENT, create_json_bool(true));
+    }
+
+    if (ws_info->ignore_patterns != NULL) {
+        cJSON_AddItemToObject(ws_info_json, WS_INFO_KEY_IGNORE_PATTERNS, patterns_to_cjson(ws_info->ignore_patterns));
+    }
+
+    if (ws_info->append_stream_patterns != NULL) {
+        cJSON_AddItemToObject(
+                ws_info_json,
+                WS_INFO_KEY_APPEND_STREAM_PATTERNS,
+                patterns_to_cjson(ws_info->append_stream_patterns)
+        );
+    }
+
     cJSON *remote_systems_array = create_json_array();
     cJSON_AddItemToObject(ws_info_json, WS_INFO_KEY_REMOTE_SYSTEMS, remote_systems_array);
 
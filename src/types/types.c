@@ -1,4 +1,5 @@
 #include "types.h"
+#include "../../lib/ulist.h"
 
 void
 destroy_resyncServerCommand(ResyncServerCommand **command)
@@ -9,29 +10,259 @@ destroy_resyncServerCommand(ResyncServerCommand **command)
 void
 destroy_removeRemoteSystemMetadata(RemoveRemoteSystemMetadata **rm_remote_system_md)
 {
-    //TODO
+    if (rm_remote_system_md == NULL || *rm_remote_system_md == NULL) {
+        return;
+    }
+
+    if (!(*rm_remote_system_md)->is_view) {
+        DO_FREE((*rm_remote_system_md)->local_workspace_root_path);
+        DO_FREE((*rm_remote_system_md)->remote_workspace_root_path);
+
+        switch ((*rm_remote_system_md)->connection_type) {
+            case SSH:
+            case RSYNC_DAEMON:
+                DO_FREE((*rm_remote_system_md)->remote_system_id_information.hostname);
+                break;
+            case SSH_HOST_ALIAS:
+                DO_FREE((*rm_remote_system_md)->remote_system_id_information.ssh_host_alias);
+                break;
+            case OTHER_CONNECTION_TYPE:
+            default:
+                break;
+        }
+    }
+
+    DO_FREE(*rm_remote_system_md);
+}
+
+static void
+destroy_pattern_list(IgnorePatternList **patterns, const bool is_view)
+{
+    IgnorePatternList *pattern, *tmp;
+    LL_FOREACH_SAFE(*patterns, pattern, tmp) {
+        LL_DELETE(*patterns, pattern);
+        if (!is_view) {
+            DO_FREE(pattern->pattern);
+        }
+        DO_FREE(pattern);
+    }
 }
 
 void
 destroy_workspaceInformation(WorkspaceInformation **ws_info)
 {
-    //TODO
+    if (ws_info == NULL || *ws_info == NULL) {
+        return;
+    }
+
+    RemoteWorkspaceMetadata *entry, *tmp;
+    LL_FOREACH_SAFE((*ws_info)->remote_systems, entry, tmp) {
+        LL_DELETE((*ws_info)->remote_systems, entry);
+        destroy_remoteWorkspaceMetadata(&entry);
+    }
+
+    destroy_pattern_list(&(*ws_info)->ignore_patterns, (*ws_info)->is_view);
+    destroy_pattern_list(&(*ws_info)->append_stream_patterns, (*ws_info)->is_view);
+
+    if (!(*ws_info)->is_view) {
+        DO_FREE((*ws_info)->local_workspace_root_path);
+    }
+    DO_FREE(*ws_info);
 }
 
 void
 destroy_remoteWorkspaceMetadata(RemoteWorkspaceMetadata **remote_ws_md)
 {
-    //TODO
+    if (remote_ws_md == NULL || *remote_ws_md == NULL) {
+        return;
+    }
+
+    if ((*remote_ws_md)->is_view) {
+        // Only the connection information structs are owned, their strings point into the decoded buffer
+        switch ((*remote_ws_md)->connection_type) {
+            case SSH:
+                DO_FREE((*remote_ws_md)->connection_information.ssh_connection_information);
+                break;
+            case RSYNC_DAEMON:
+                DO_FREE((*remote_ws_md)->connection_information.rsync_connection_information);
+                break;
+            default:
+                break;
+        }
+
+        DO_FREE(*remote_ws_md);
+        return;
+    }
+
+    switch ((*remote_ws_md)->connection_type) {
+        case SSH:
+            destroy_sshConnectionInformation(&((*remote_ws_md)->connection_information.ssh_connection_information));
+            break;
+        case SSH_HOST_ALIAS:
+            DO_FREE((*remote_ws_md)->connection_information.ssh_host_alias);
+            break;
+        case RSYNC_DAEMON:
+            destroy_rsyncConnectionInformation(&((*remote_ws_md)->connection_information.rsync_connection_information));
+            break;
+        case OTHER_CONNECTION_TYPE:
+        default:
+            break;
+    }
+
+    DO_FREE((*remote_ws_md)->remote_workspace_root_path);
+    DO_FREE((*remote_ws_md)->relay_parent);
+    DO_FREE(*remote_ws_md);
 }
 
 void
 destroy_rsyncConnectionInformation(RsyncConnectionInformation **connection_info)
 {
-    //TODO
+    if (connection_info == NULL || *connection_info == NULL) {
+        return;
+    }
+
+    DO_FREE((*connection_info)->username);
+    DO_FREE((*connection_info)->hostname);
+    DO_FREE(*connection_info);
 }
 
 void
 destroy_sshConnectionInformation(SshConnectionInformation **connection_info)
 {
-    //TODO
+    if (connection_info == NULL || *connection_info == NULL) {
+        return;
+    }
+
+    DO_FREE((*connection_info)->username);
+    DO_FREE((*connection_info)->hostname);
+    DO_FREE((*connection_info)->path_to_identity_file);
+    DO_FREE(*connection_info);
+}
+
+const char *
+get_remote_system_host(const RemoteWorkspaceMetadata *remote_ws_md)
+{
+    if (remote_ws_md == NULL) {
+        return NULL;
+    }
+
+    switch (remote_ws_md->connection_type) {
+        case SSH:
+            return remote_ws_md->connection_information.ssh_connection_information->hostname;
+        case SSH_HOST_ALIAS:
+            return remote_ws_md->connection_information.ssh_host_alias;
+        case RSYNC_DAEMON:
+            return remote_ws_md->connection_information.rsync_connection_information->hostname;
+        case LOCAL_PATH:
+            return LOCAL_PATH_HOST;
+        case OTHER_CONNECTION_TYPE:
+        default:
+            return NULL;
+    }
+}
+
+char *
+get_remote_system_key(const RemoteWorkspaceMetadata *remote_ws_md)
+{
+    return format_string("%s:%s", get_remote_system_host(remote_ws_md), remote_ws_md->remote_workspace_root_path);
+}
+
+RemoteWorkspaceMetadata *
+get_relay_parent(const WorkspaceInformation *ws_info, const RemoteWorkspaceMetadata *remote_ws_md)
+{
+    if (remote_ws_md->relay_parent == NULL) {
+        return NULL;
+    }
+
+    RemoteWorkspaceMetadata *entry;
+    LL_FOREACH(ws_info->remote_systems, entry) {
+        char *key = get_remote_system_key(entry);
+        const bool is_relay_parent = (entry != remote_ws_md && is_equal(key, remote_ws_md->relay_parent));
+        DO_FREE(key);
+
+        if (is_relay_parent) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+RemoteWorkspaceMetadata *
+copy_remoteWorkspaceMetadata(const RemoteWorkspaceMetadata *remote_ws_md)
+{
+    if (remote_ws_md == NULL) {
+        return NULL;
+    }
+
+    RemoteWorkspaceMetadata *copy = (RemoteWorkspaceMetadata *) do_calloc(1, sizeof(RemoteWorkspaceMetadata));
+    copy->remote_workspace_root_path = resync_strdup(remote_ws_md->remote_workspace_root_path);
+    copy->connection_type = remote_ws_md->connection_type;
+    copy->transport = remote_ws_md->transport;
+    copy->relay_parent = resync_strdup(remote_ws_md->relay_parent);
+
+    switch (remote_ws_md->connection_type) {
+        case SSH: {
+            const SshConnectionInformation *ci = remote_ws_md->connection_information.ssh_connection_information;
+            SshConnectionInformation *ci_copy = (SshConnectionInformation *) do_calloc(1, sizeof(SshConnectionInformation));
+            ci_copy->username = resync_strdup(ci->username);
+            ci_copy->hostname = resync_strdup(ci->hostname);
+            ci_copy->path_to_identity_file = resync_strdup(ci->path_to_identity_file);
+            copy->connection_information.ssh_connection_information = ci_copy;
+            break;
+        }
+        case SSH_HOST_ALIAS:
+            copy->connection_information.ssh_host_alias = resync_strdup(remote_ws_md->connection_information.ssh_host_alias);
+            break;
+        case RSYNC_DAEMON: {
+            const RsyncConnectionInformation *ci = remote_ws_md->connection_information.rsync_connection_information;
+            RsyncConnectionInformation *ci_copy = (RsyncConnectionInformation *) do_calloc(1, sizeof(RsyncConnectionInformation));
+            ci_copy->username = resync_strdup(ci->username);
+            ci_copy->hostname = resync_strdup(ci->hostname);
+            ci_copy->port = ci->port;
+            copy->connection_information.rsync_connection_information = ci_copy;
+            break;
+        }
+        case OTHER_CONNECTION_TYPE:
+        default:
+            break;
+    }
+
+    return copy;
+}
+
+bool
+is_remote_system_identified_by(const RemoteWorkspaceMetadata *remote_system, const RemoveRemoteSystemMetadata *rm_rsys_data)
+{
+    if (remote_system == NULL || rm_rsys_data == NULL) {
+        return false;
+    }
+
+    if (!is_equal(remote_system->remote_workspace_root_path, rm_rsys_data->remote_workspace_root_path)
+        || remote_system->connection_type != rm_rsys_data->connection_type) {
+        return false;
+    }
+
+    switch (remote_system->connection_type) {
+        case SSH:
+            return is_equal(
+                    remote_system->connection_information.ssh_connection_information->hostname,
+                    rm_rsys_data->remote_system_id_information.hostname
+            );
+        case SSH_HOST_ALIAS:
+            return is_equal(
+                    remote_system->connection_information.ssh_host_alias,
+                    rm_rsys_data->remote_system_id_information.ssh_host_alias
+            );
+        case RSYNC_DAEMON:
+            return is_equal(
+                    remote_system->connection_information.rsync_connection_information->hostname,
+                    rm_rsys_data->remote_system_id_information.hostname
+            );
+        case LOCAL_PATH:
+            return true;
+        case OTHER_CONNECTION_TYPE:
+        default:
+            return false;
+    }
 }
@@ -7,9 +7,22 @@ typedef enum ConnectionType {
     OTHER_CONNECTION_TYPE,
     SSH,
     SSH_HOST_ALIAS,
-    RSYNC_DAEMON
+    RSYNC_DAEMON,
+    /* The remote workspace is a directory on the same host, e.g. on a second disk or a backup mount */
+    LOCAL_PATH
 } ConnectionType;
 
+/* Host of remote systems with the 'LOCAL_PATH' connection type */
+#define LOCAL_PATH_HOST "localhost"
+
+/* How changes are propagated to a remote system */
+typedef enum SyncTransport {
+    /* Every change is synced by an 'rsync' invocation */
+    RSYNC_TRANSPORT,
+    /* Changes are streamed to a 'reSync' agent running on the remote system (see 'agent_protocol.h') */
+    AGENT_TRANSPORT
+} SyncTransport;
+
 typedef enum ResyncServerCommandType {
     OTHER_RESYNC_SERVER_COMMAND_TYPE,
     ADD_WORKSPACE,
@@ -40,12 +53,72 @@ typedef struct RemoteWorkspaceMetadata {
         RsyncConnectionInformation *rsync_connection_information;
     } connection_information;
 
+    /* Only remote systems that are reached via ssh can use the agent transport */
+    SyncTransport transport;
+
+    /*
+     * Key (see 'get_remote_system_key') of the remote system of the same workspace that relays all syncs to this one,
+     *  NULL if it is synced directly. The connection information describes how the relay reaches this remote system,
+     *  e.g. a remote system with the 'LOCAL_PATH' connection type is a directory on the relay's host.
+     */
+    char *relay_parent;
+
+    /* Strings point into a buffer decoded by the binary mappers and are not owned (freed) by this struct */
+    bool is_view;
+
     struct RemoteWorkspaceMetadata *next;
 } RemoteWorkspaceMetadata;
 
+typedef struct IgnorePatternList {
+    char *pattern;
+    struct IgnorePatternList *next;
+} IgnorePatternList;
+
 typedef struct WorkspaceInformation {
     char *local_workspace_root_path;
     RemoteWorkspaceMetadata *remote_systems;
+
+    /*
+     * Patterns in the syntax of '.resyncignore' files (see 'ignore_rules.h') that exclude resources from being watched
+     *  and synced. The '.resyncignore' file at the workspace root takes precedence over them.
+     */
+    IgnorePatternList *ignore_patterns;
+
+    /* Workspaces with a higher priority are synced first when competing for the same remote systems */
+    int priority;
+
+    /* Share of the daemon-wide sync capacity relative to other workspaces, while they compete for it (0 means 1) */
+    int sync_weight;
+
+    /*
+     * Events per second from which the monitor considers changes to be part of a bulk operation, e.g. a checkout, and
+     *  syncs them once the operation is over instead of one by one (0 means the default, see 'bulk_mode.h')
+     */
+    int bulk_event_threshold;
+
+    /*
+     * Whether files that only grew since they were last synced, e.g. logs, are synced by transferring the appended data
+     *  alone instead of a delta of the entire file
+     */
+    bool is_append_transfer_enabled;
+
+    /*
+     * Interval in seconds in which the monitor verifies that the remote systems using the agent transport did not drift
+     *  from the workspace, e.g. as they were modified by hand (0 disables the verification, see 'workspace_index.h')
+     */
+    int drift_check_interval;
+
+    /* Whether the drift verification compares the content of files, not only their names, types, permissions and sizes */
+    bool is_drift_check_content_hashed;
+
+    /*
+     * Patterns in the syntax of '.resyncignore' files that select files which are only ever appended to, e.g. logs. Only
+     *  the data appended since such a file was last synced is transferred, unless it was truncated or replaced.
+     */
+    IgnorePatternList *append_stream_patterns;
+
+    /* Strings point into a buffer decoded by the binary mappers and are not owned (freed) by this struct */
+    bool is_view;
 } WorkspaceInformation;
 
 typedef struct RemoveRemoteSystemMetadata {
@@ -54,6 +127,7 @@ typedef struct RemoveRemoteSystemMetadata {
 
     /* Specifying the connection type + connection information allows us to identity the remote system to be removed.
      * This is needed as we can sync a workspace to the same remote workspace path on different remote systems.
+     * Local paths are identified by the remote workspace path alone.
      */
     ConnectionType connection_type;
     union {
@@ -63,6 +137,8 @@ typedef struct RemoveRemoteSystemMetadata {
         char *ssh_host_alias;
     } remote_system_id_information;
 
+    /* Strings point into a buffer decoded by the binary mappers and are not owned (freed) by this struct */
+    bool is_view;
 } RemoveRemoteSystemMetadata;
 
 typedef struct ResyncServerCommand {
@@ -94,4 +170,33 @@ void destroy_rsyncConnectionInformation(RsyncConnectionInformation **connection_
 
 void destroy_sshConnectionInformation(SshConnectionInformation **connection_info);
 
+/**
+ * Returns the name that identifies the host of a remote system, i.e. its hostname or, when connecting via an ssh host
+ *  alias, the alias. The returned string is owned by the remote system.
+ */
+const char *get_remote_system_host(const RemoteWorkspaceMetadata *remote_ws_md);
+
+/**
+ * @return key that identifies the remote system among the remote systems of a workspace, i.e. '<host>:<remote path>'
+ */
+char *get_remote_system_key(const RemoteWorkspaceMetadata *remote_ws_md);
+
+/**
+ * @return the remote system of the workspace that relays the syncs to the given one, or NULL if there is none
+ */
+RemoteWorkspaceMetadata *get_relay_parent(const WorkspaceInformation *ws_info, const RemoteWorkspaceMetadata *remote_ws_md);
+
+/**
+ * Creates a deep copy of the remote system, e.g. to keep it beyond the lifetime of the buffer a view points into. The
+ *  copy is not linked to any other remote system.
+ */
+RemoteWorkspaceMetadata *copy_remoteWorkspaceMetadata(const RemoteWorkspaceMetadata *remote_ws_md);
+
+/**
+ * Checks whether the remote system is the one described by the data identifying a remote system that should be removed.
+ *
+ * @return true if the remote workspace path, the connection type and the identifying connection information match
+ */
+bool is_remote_system_identified_by(const RemoteWorkspaceMetadata *remote_system, const RemoveRemoteSystemMetadata *rm_rsys_data);
+
 #endif //RESYNC_TYPES_H
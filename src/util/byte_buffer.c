@@ -0,0 +1,170 @@
+#include "byte_buffer.h"
+
+#define NULL_STRING_LENGTH UINT32_MAX
+
+ByteBuffer *
+create_byte_buffer(const size_t initial_capacity)
+{
+    ByteBuffer *buffer = (ByteBuffer *) do_calloc(1, sizeof(ByteBuffer));
+    buffer->capacity = (initial_capacity > 0) ? initial_capacity : 64;
+    buffer->data = (char *) do_malloc(buffer->capacity);
+    return buffer;
+}
+
+void
+destroy_byte_buffer(ByteBuffer **buffer)
+{
+    if (buffer == NULL || *buffer == NULL) {
+        return;
+    }
+
+    DO_FREE((*buffer)->data);
+    DO_FREE(*buffer);
+}
+
+void
+byte_buffer_append(ByteBuffer *buffer, const void *data, const size_t size)
+{
+    if (buffer->size + size > buffer->capacity) {
+        size_t new_capacity = buffer->capacity * 2;
+        while (new_capacity < buffer->size + size) {
+            new_capacity *= 2;
+        }
+
+        buffer->data = (char *) do_realloc(buffer->data, new_capacity);
+        buffer->capacity = new_capacity;
+    }
+
+    if (size > 0) {
+        memcpy(buffer->data + buffer->size, data, size);
+        buffer->size += size;
+    }
+}
+
+void
+byte_buffer_append_u8(ByteBuffer *buffer, const uint8_t value)
+{
+    byte_buffer_append(buffer, &value, sizeof(value));
+}
+
+void
+byte_buffer_append_u32(ByteBuffer *buffer, const uint32_t value)
+{
+    byte_buffer_append(buffer, &value, sizeof(value));
+}
+
+void
+byte_buffer_append_i32(ByteBuffer *buffer, const int32_t value)
+{
+    byte_buffer_append(buffer, &value, sizeof(value));
+}
+
+void
+byte_buffer_append_u64(ByteBuffer *buffer, const uint64_t value)
+{
+    byte_buffer_append(buffer, &value, sizeof(value));
+}
+
+void
+byte_buffer_append_string(ByteBuffer *buffer, const char *string)
+{
+    if (string == NULL) {
+        byte_buffer_append_u32(buffer, NULL_STRING_LENGTH);
+        return;
+    }
+
+    const uint32_t length = strlen(string);
+    byte_buffer_append_u32(buffer, length);
+    byte_buffer_append(buffer, string, length + 1);
+}
+
+ByteBufferReader
+create_byte_buffer_reader(const char *data, const size_t size)
+{
+    ByteBufferReader reader = {.data = data, .size = size, .offset = 0, .error = false};
+    return reader;
+}
+
+const void *
+byte_buffer_read(ByteBufferReader *reader, const size_t size)
+{
+    if (reader->error || size > reader->size - reader->offset) {
+        reader->error = true;
+        return NULL;
+    }
+
+    const void *ptr = reader->data + reader->offset;
+    reader->offset += size;
+    return ptr;
+}
+
+uint8_t
+byte_buffer_read_u8(ByteBufferReader *reader)
+{
+    uint8_t value = 0;
+    const void *ptr = byte_buffer_read(reader, sizeof(value));
+    if (ptr != NULL) {
+        memcpy(&value, ptr, sizeof(value));
+    }
+    return value;
+}
+
+uint32_t
+byte_buffer_read_u32(ByteBufferReader *reader)
+{
+    uint32_t value = 0;
+    const void *ptr = byte_buffer_read(reader, sizeof(value));
+    if (ptr != NULL) {
+        memcpy(&value, ptr, sizeof(value));
+    }
+    return value;
+}
+
+int32_t
+byte_buffer_read_i32(ByteBufferReader *reader)
+{
+    int32_t value = 0;
+    const void *ptr = byte_buffer_read(reader, sizeof(value));
+    if (ptr != NULL) {
+        memcpy(&value, ptr, sizeof(value));
+    }
+    return value;
+}
+
+uint64_t
+byte_buffer_read_u64(ByteBufferReader *reader)
+{
+    uint64_t value = 0;
+    const void *ptr = byte_buffer_read(reader, sizeof(value));
+    if (ptr != NULL) {
+        memcpy(&value, ptr, sizeof(value));
+    }
+    return value;
+}
+
+const char *
+byte_buffer_read_string_view(ByteBufferReader *reader)
+{
+    const uint32_t length = byte_buffer_read_u32(reader);
+    if (reader->error || length == NULL_STRING_LENGTH) {
+        return NULL;
+    }
+
+    const char *ptr = (const char *) byte_buffer_read(reader, (size_t) length + 1);
+    if (ptr == NULL) {
+        return NULL;
+    }
+
+    if (ptr[length] != '\0' || memchr(ptr, '\0', length) != NULL) {
+        reader->error = true;
+        return NULL;
+    }
+
+    return ptr;
+}
+
+char *
+byte_buffer_read_string(ByteBufferReader *reader)
+{
+    return resync_strdup(byte_buffer_read_string_view(reader));
+}
@@ -0,0 +1,78 @@
+#ifndef RESYNC_BYTE_BUFFER_H
+#define RESYNC_BYTE_BUFFER_H
+
+#include "string.h"
+#include "memory.h"
+#include "error.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+/*
+ * Growable buffer for serializing data that is exchanged between reSync processes on the same host. Integers are
+ *  stored in the host's byte order.
+ */
+typedef struct ByteBuffer {
+    char *data;
+    size_t size;
+    size_t capacity;
+} ByteBuffer;
+
+/*
+ * Cursor over a serialized buffer. Once a read exceeds the bounds of the buffer, 'error' is set and all subsequent
+ *  reads return zero values, so that callers only have to check for errors once after reading a record.
+ */
+typedef struct ByteBufferReader {
+    const char *data;
+    size_t size;
+    size_t offset;
+    bool error;
+} ByteBufferReader;
+
+ByteBuffer *create_byte_buffer(const size_t initial_capacity);
+
+void destroy_byte_buffer(ByteBuffer **buffer);
+
+void byte_buffer_append(ByteBuffer *buffer, const void *data, const size_t size);
+
+void byte_buffer_append_u8(ByteBuffer *buffer, const uint8_t value);
+
+void byte_buffer_append_u32(ByteBuffer *buffer, const uint32_t value);
+
+void byte_buffer_append_i32(ByteBuffer *buffer, const int32_t value);
+
+void byte_buffer_append_u64(ByteBuffer *buffer, const uint64_t value);
+
+/**
+ * Appends the string as length prefixed, NULL terminated sequence of bytes. NULL strings are distinguishable from empty
+ *  strings.
+ */
+void byte_buffer_append_string(ByteBuffer *buffer, const char *string);
+
+ByteBufferReader create_byte_buffer_reader(const char *data, const size_t size);
+
+const void *byte_buffer_read(ByteBufferReader *reader, const size_t size);
+
+uint8_t byte_buffer_read_u8(ByteBufferReader *reader);
+
+uint32_t byte_buffer_read_u32(ByteBufferReader *reader);
+
+int32_t byte_buffer_read_i32(ByteBufferReader *reader);
+
+uint64_t byte_buffer_read_u64(ByteBufferReader *reader);
+
+/**
+ * Reads a string written by 'byte_buffer_append_string' without copying it.
+ *
+ * @return pointer to the NULL terminated string inside of the reader's buffer, or NULL if a NULL string was written or
+ *  the buffer is malformed (in which case the reader's error flag is set)
+ */
+const char *byte_buffer_read_string_view(ByteBufferReader *reader);
+
+/**
+ * Reads a string written by 'byte_buffer_append_string' and returns a copy of it.
+ */
+char *byte_buffer_read_string(ByteBufferReader *reader);
+
+#endif //RESYNC_BYTE_BUFFER_H
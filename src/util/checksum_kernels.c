@@ -0,0 +1,348 @@
+#include "checksum_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RESYNC_X86_CHECKSUM_KERNELS
+#include <immintrin.h>
+#endif
+
+#define ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+static void
+scalar_rolling_sums(const unsigned char *data, const size_t size, uint32_t *a, uint32_t *b)
+{
+    uint32_t sum_a = 0, sum_b = 0;
+    for (size_t i = 0; i < size; i++) {
+        sum_a += data[i];
+        sum_b += (uint32_t) (size - i) * data[i];
+    }
+
+    *a = sum_a;
+    *b = sum_b;
+}
+
+static inline uint64_t
+read_u64_le(const unsigned char *ptr)
+{
+    uint64_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return le64toh(value);
+}
+
+#define HASH_KEY(i) (ROTL64(CHECKSUM_PRIME64_1 * (2 * (uint64_t) (i) + 1), 23) ^ CHECKSUM_PRIME64_4)
+
+/*
+ * Keys of the strong hash. Like the secret of XXH3, the keys of a stripe are offset by its position in the block, and
+ *  the accumulators are scrambled with the keys following those of the last stripe.
+ */
+static const uint64_t hash_keys[CHECKSUM_HASH_BLOCK_STRIPES + CHECKSUM_HASH_LANES] = {
+        HASH_KEY(0), HASH_KEY(1), HASH_KEY(2), HASH_KEY(3), HASH_KEY(4), HASH_KEY(5),
+        HASH_KEY(6), HASH_KEY(7), HASH_KEY(8), HASH_KEY(9), HASH_KEY(10), HASH_KEY(11),
+        HASH_KEY(12), HASH_KEY(13), HASH_KEY(14), HASH_KEY(15), HASH_KEY(16), HASH_KEY(17),
+        HASH_KEY(18), HASH_KEY(19), HASH_KEY(20), HASH_KEY(21), HASH_KEY(22), HASH_KEY(23)
+};
+
+static const uint64_t *const scramble_keys = hash_keys + CHECKSUM_HASH_BLOCK_STRIPES;
+
+static void
+scalar_accumulate_stripe(uint64_t acc[CHECKSUM_HASH_LANES], const unsigned char *data, const uint64_t *keys)
+{
+    for (int i = 0; i < CHECKSUM_HASH_LANES; i++) {
+        const uint64_t value = read_u64_le(data + 8 * i);
+        const uint64_t keyed = value ^ keys[i];
+
+        // Adding the plain value to the neighbouring lane keeps its bits even if the product is zero
+        acc[i ^ 1] += value;
+        acc[i] += (keyed & 0xFFFFFFFFULL) * (keyed >> 32);
+    }
+}
+
+static void
+scalar_scramble(uint64_t acc[CHECKSUM_HASH_LANES])
+{
+    for (int i = 0; i < CHECKSUM_HASH_LANES; i++) {
+        uint64_t value = acc[i];
+        value ^= value >> 47;
+        value ^= scramble_keys[i];
+        acc[i] = value * CHECKSUM_PRIME32_1;
+    }
+}
+
+static void
+scalar_hash_stripes(uint64_t acc[CHECKSUM_HASH_LANES], const unsigned char *data, size_t stripe_count,
+                    uint32_t *block_stripe)
+{
+    uint32_t stripe = *block_stripe;
+    for (; stripe_count > 0; stripe_count--, data += CHECKSUM_HASH_STRIPE_SIZE) {
+        scalar_accumulate_stripe(acc, data, hash_keys + stripe);
+        if (++stripe == CHECKSUM_HASH_BLOCK_STRIPES) {
+            scalar_scramble(acc);
+            stripe = 0;
+        }
+    }
+
+    *block_stripe = stripe;
+}
+
+static const ChecksumKernels scalar_kernels = {
+        .name = "scalar",
+        .rolling_sums = scalar_rolling_sums,
+        .hash_stripes = scalar_hash_stripes
+};
+
+#ifdef RESYNC_X86_CHECKSUM_KERNELS
+
+/*
+ * The vectorized part of the block is split into chunks. Like in Adler-32 implementations, a is summed up after every
+ *  chunk, which weights every chunk by the number of chunks from it to the end of the vectorized part. The offsets
+ *  inside of the chunks are subtracted as weighted byte sums. All lanes wrap around modulo 2^32, just like the scalar
+ *  sums.
+ */
+static void
+combine_rolling_sums(const unsigned char *data, const size_t size, const size_t vectorized_size,
+                     const uint32_t chunk_size, const uint32_t vectorized_a, const uint32_t prefix_sum,
+                     const uint32_t weighted_sum, uint32_t *a, uint32_t *b)
+{
+    uint32_t sum_a = vectorized_a;
+    uint32_t sum_b = chunk_size * prefix_sum - weighted_sum;
+
+    // The bytes after the vectorized part add to the weight of every byte in it
+    sum_b += (uint32_t) (size - vectorized_size) * sum_a;
+
+    for (size_t i = vectorized_size; i < size; i++) {
+        sum_a += data[i];
+        sum_b += (uint32_t) (size - i) * data[i];
+    }
+
+    *a = sum_a;
+    *b = sum_b;
+}
+
+__attribute__((target("sse4.2")))
+static uint32_t
+sse_sum_epi32(const __m128i v)
+{
+    __m128i sum = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (uint32_t) _mm_cvtsi128_si32(sum);
+}
+
+__attribute__((target("sse4.2")))
+static void
+sse42_rolling_sums(const unsigned char *data, const size_t size, uint32_t *a, uint32_t *b)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i weights = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    __m128i v_a = zero, v_prefix = zero, v_weighted = zero;
+
+    const size_t vectorized_size = size & ~(size_t) 15;
+    for (size_t i = 0; i < vectorized_size; i += 16) {
+        const __m128i chunk = _mm_loadu_si128((const __m128i *) (data + i));
+
+        v_a = _mm_add_epi32(v_a, _mm_sad_epu8(chunk, zero));
+        v_prefix = _mm_add_epi32(v_prefix, v_a);
+        v_weighted = _mm_add_epi32(v_weighted, _mm_madd_epi16(_mm_maddubs_epi16(chunk, weights), ones));
+    }
+
+    combine_rolling_sums(
+            data, size, vectorized_size, 16,
+            sse_sum_epi32(v_a), sse_sum_epi32(v_prefix), sse_sum_epi32(v_weighted),
+            a, b
+    );
+}
+
+/*
+ * The vectorized hash kernels process two lanes per 128 bit register. Swapping the 64 bit halves of the data adds every
+ *  lane to its neighbour, which the scalar kernel does with 'i ^ 1'.
+ */
+__attribute__((target("sse4.2")))
+static __m128i
+sse_accumulate(const __m128i acc, const unsigned char *data, const uint64_t *keys)
+{
+    const __m128i value = _mm_loadu_si128((const __m128i *) data);
+    const __m128i keyed = _mm_xor_si128(value, _mm_loadu_si128((const __m128i *) keys));
+    const __m128i product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+    return _mm_add_epi64(_mm_add_epi64(acc, _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2))), product);
+}
+
+/*
+ * Multiplies the 64 bit lanes by a 32 bit prime as the sum of the products of their halves
+ */
+__attribute__((target("sse4.2")))
+static __m128i
+sse_scramble(__m128i acc, const uint64_t *keys)
+{
+    const __m128i prime = _mm_set1_epi32((int) CHECKSUM_PRIME32_1);
+    acc = _mm_xor_si128(acc, _mm_srli_epi64(acc, 47));
+    acc = _mm_xor_si128(acc, _mm_loadu_si128((const __m128i *) keys));
+
+    const __m128i product_low = _mm_mul_epu32(acc, prime);
+    const __m128i product_high = _mm_mul_epu32(_mm_srli_epi64(acc, 32), prime);
+    return _mm_add_epi64(product_low, _mm_slli_epi64(product_high, 32));
+}
+
+__attribute__((target("sse4.2")))
+static void
+sse42_hash_stripes(uint64_t acc[CHECKSUM_HASH_LANES], const unsigned char *data, size_t stripe_count,
+                   uint32_t *block_stripe)
+{
+    __m128i v_acc[CHECKSUM_HASH_LANES / 2];
+    for (int i = 0; i < CHECKSUM_HASH_LANES / 2; i++) {
+        v_acc[i] = _mm_loadu_si128((const __m128i *) (acc + 2 * i));
+    }
+
+    uint32_t stripe = *block_stripe;
+    for (; stripe_count > 0; stripe_count--, data += CHECKSUM_HASH_STRIPE_SIZE) {
+        for (int i = 0; i < CHECKSUM_HASH_LANES / 2; i++) {
+            v_acc[i] = sse_accumulate(v_acc[i], data + 16 * i, hash_keys + stripe + 2 * i);
+        }
+        if (++stripe == CHECKSUM_HASH_BLOCK_STRIPES) {
+            for (int i = 0; i < CHECKSUM_HASH_LANES / 2; i++) {
+                v_acc[i] = sse_scramble(v_acc[i], scramble_keys + 2 * i);
+            }
+            stripe = 0;
+        }
+    }
+
+    for (int i = 0; i < CHECKSUM_HASH_LANES / 2; i++) {
+        _mm_storeu_si128((__m128i *) (acc + 2 * i), v_acc[i]);
+    }
+    *block_stripe = stripe;
+}
+
+static const ChecksumKernels sse42_kernels = {
+        .name = "sse4.2",
+        .rolling_sums = sse42_rolling_sums,
+        .hash_stripes = sse42_hash_stripes
+};
+
+__attribute__((target("avx2")))
+static uint32_t
+avx2_sum_epi32(const __m256i v)
+{
+    const __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    return sse_sum_epi32(sum);
+}
+
+__attribute__((target("avx2")))
+static void
+avx2_rolling_sums(const unsigned char *data, const size_t size, uint32_t *a, uint32_t *b)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i weights = _mm256_setr_epi8(
+            0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+            16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31
+    );
+
+    __m256i v_a = zero, v_prefix = zero, v_weighted = zero;
+
+    const size_t vectorized_size = size & ~(size_t) 31;
+    for (size_t i = 0; i < vectorized_size; i += 32) {
+        const __m256i chunk = _mm256_loadu_si256((const __m256i *) (data + i));
+
+        v_a = _mm256_add_epi32(v_a, _mm256_sad_epu8(chunk, zero));
+        v_prefix = _mm256_add_epi32(v_prefix, v_a);
+        v_weighted = _mm256_add_epi32(v_weighted, _mm256_madd_epi16(_mm256_maddubs_epi16(chunk, weights), ones));
+    }
+
+    combine_rolling_sums(
+            data, size, vectorized_size, 32,
+            avx2_sum_epi32(v_a), avx2_sum_epi32(v_prefix), avx2_sum_epi32(v_weighted),
+            a, b
+    );
+}
+
+__attribute__((target("avx2")))
+static __m256i
+avx2_accumulate(const __m256i acc, const unsigned char *data, const uint64_t *keys)
+{
+    const __m256i value = _mm256_loadu_si256((const __m256i *) data);
+    const __m256i keyed = _mm256_xor_si256(value, _mm256_loadu_si256((const __m256i *) keys));
+    const __m256i product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));
+    return _mm256_add_epi64(_mm256_add_epi64(acc, _mm256_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2))), product);
+}
+
+__attribute__((target("avx2")))
+static __m256i
+avx2_scramble(__m256i acc, const uint64_t *keys)
+{
+    const __m256i prime = _mm256_set1_epi32((int) CHECKSUM_PRIME32_1);
+    acc = _mm256_xor_si256(acc, _mm256_srli_epi64(acc, 47));
+    acc = _mm256_xor_si256(acc, _mm256_loadu_si256((const __m256i *) keys));
+
+    const __m256i product_low = _mm256_mul_epu32(acc, prime);
+    const __m256i product_high = _mm256_mul_epu32(_mm256_srli_epi64(acc, 32), prime);
+    return _mm256_add_epi64(product_low, _mm256_slli_epi64(product_high, 32));
+}
+
+__attribute__((target("avx2")))
+static void
+avx2_hash_stripes(uint64_t acc[CHECKSUM_HASH_LANES], const unsigned char *data, size_t stripe_count,
+                  uint32_t *block_stripe)
+{
+    __m256i v_acc_low = _mm256_loadu_si256((const __m256i *) acc);
+    __m256i v_acc_high = _mm256_loadu_si256((const __m256i *) (acc + 4));
+
+    uint32_t stripe = *block_stripe;
+    for (; stripe_count > 0; stripe_count--, data += CHECKSUM_HASH_STRIPE_SIZE) {
+        v_acc_low = avx2_accumulate(v_acc_low, data, hash_keys + stripe);
+        v_acc_high = avx2_accumulate(v_acc_high, data + 32, hash_keys + stripe + 4);
+        if (++stripe == CHECKSUM_HASH_BLOCK_STRIPES) {
+            v_acc_low = avx2_scramble(v_acc_low, scramble_keys);
+            v_acc_high = avx2_scramble(v_acc_high, scramble_keys + 4);
+            stripe = 0;
+        }
+    }
+
+    _mm256_storeu_si256((__m256i *) acc, v_acc_low);
+    _mm256_storeu_si256((__m256i *) (acc + 4), v_acc_high);
+    *block_stripe = stripe;
+}
+
+static const ChecksumKernels avx2_kernels = {
+        .name = "avx2",
+        .rolling_sums = avx2_rolling_sums,
+        .hash_stripes = avx2_hash_stripes
+};
+
+#endif
+
+static const ChecksumKernels *supported_kernels[3] = {NULL};
+static size_t supported_kernels_count = 0;
+
+static void
+detect_checksum_kernels(void)
+{
+    if (supported_kernels_count > 0) {
+        return;
+    }
+
+    supported_kernels[supported_kernels_count++] = &scalar_kernels;
+
+#ifdef RESYNC_X86_CHECKSUM_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        supported_kernels[supported_kernels_count++] = &sse42_kernels;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        supported_kernels[supported_kernels_count++] = &avx2_kernels;
+    }
+#endif
+}
+
+const ChecksumKernels *
+get_checksum_kernels(void)
+{
+    detect_checksum_kernels();
+    return supported_kernels[supported_kernels_count - 1];
+}
+
+const ChecksumKernels *const *
+get_supported_checksum_kernels(size_t *count)
+{
+    detect_checksum_kernels();
+    *count = supported_kernels_count;
+    return supported_kernels;
+}
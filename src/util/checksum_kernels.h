@@ -0,0 +1,60 @@
+#ifndef RESYNC_CHECKSUM_KERNELS_H
+#define RESYNC_CHECKSUM_KERNELS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <endian.h>
+
+/*
+ * Checksum kernels for the hot loops of delta and change detection code. Every kernel has a portable scalar variant,
+ *  vectorized variants are selected at runtime depending on the instruction sets supported by the CPU. All variants
+ *  compute identical results, so checksums can be exchanged between hosts that use different variants.
+ */
+
+/* Primes of the XXH64 and XXH3 hashes, which the strong hash of 'hash_stripes' is derived from */
+#define CHECKSUM_PRIME32_1 0x9E3779B1U
+#define CHECKSUM_PRIME32_2 0x85EBCA77U
+#define CHECKSUM_PRIME32_3 0xC2B2AE3DU
+#define CHECKSUM_PRIME64_1 0x9E3779B185EBCA87ULL
+#define CHECKSUM_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define CHECKSUM_PRIME64_3 0x165667B19E3779F9ULL
+#define CHECKSUM_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define CHECKSUM_PRIME64_5 0x27D4EB2F165667C5ULL
+
+/* Number of 64 bit accumulators of the strong hash, each of which consumes one 8 byte lane of every stripe */
+#define CHECKSUM_HASH_LANES 8
+/* Size of the stripes consumed by 'hash_stripes' */
+#define CHECKSUM_HASH_STRIPE_SIZE (CHECKSUM_HASH_LANES * 8)
+/* The accumulators are scrambled after every block of this many stripes */
+#define CHECKSUM_HASH_BLOCK_STRIPES 16
+
+typedef struct ChecksumKernels {
+    /* Instruction set the kernels are built for, e.g. for reporting by benchmarks */
+    const char *name;
+    /*
+     * Computes the sums of the rolling checksum over the block, i.e. a = sum of data[i] and
+     *  b = sum of (size - i) * data[i], both modulo 2^32.
+     */
+    void (*rolling_sums)(const unsigned char *data, const size_t size, uint32_t *a, uint32_t *b);
+    /*
+     * Consumes the stripes into the accumulators of the strong hash, in the way XXH3 does: every lane is mixed with a
+     *  key by a 32x32 bit multiplication, which vector units provide, and the accumulators are scrambled at the end of
+     *  every block. 'block_stripe' is the number of stripes of the current block that were consumed before, it is
+     *  advanced past the given stripes.
+     */
+    void (*hash_stripes)(uint64_t acc[CHECKSUM_HASH_LANES], const unsigned char *data, size_t stripe_count,
+                         uint32_t *block_stripe);
+} ChecksumKernels;
+
+/**
+ * @return the fastest kernels supported by the CPU. The selection is made once, on the first call.
+ */
+const ChecksumKernels *get_checksum_kernels(void);
+
+/**
+ * @return all kernel variants supported by the CPU, starting with the scalar one
+ */
+const ChecksumKernels *const *get_supported_checksum_kernels(size_t *count);
+
+#endif //RESYNC_CHECKSUM_KERNELS_H
@@ -44,6 +44,29 @@ concat_paths(const char *path1, const char *path2)
     return resync_strdup(non_null_path);
 }
 
+char *
+get_common_directory(const char *relative_directory_path, const char *other_relative_directory_path)
+{
+    if (relative_directory_path == NULL || other_relative_directory_path == NULL) {
+        return NULL;
+    }
+
+    size_t common_len = 0;
+    for (size_t i = 0; ; i++) {
+        const char c1 = relative_directory_path[i];
+        const char c2 = other_relative_directory_path[i];
+
+        if ((c1 == '\0' || c1 == '/') && (c2 == '\0' || c2 == '/')) {
+            common_len = i;
+        }
+        if (c1 != c2 || c1 == '\0') {
+            break;
+        }
+    }
+
+    return (common_len > 0) ? strndup(relative_directory_path, common_len) : NULL;
+}
+
 bool
 validate_absolute_path(const char *path, char **error_msg)
 {
@@ -97,7 +120,8 @@ validate_file_exists(const char *path, char **error_msg)
 }
 
 DirectoryPathList *
-get_paths_of_subdirectories(const DirectoryPath *path)
+get_paths_of_subdirectories(const DirectoryPath *path, const IgnoreRules *ignore_rules, time_t *latest_change,
+                            uint64_t *entries_count)
 {
     DirectoryPathList *head = NULL;
     DIR *dirp;
@@ -110,9 +134,22 @@ get_paths_of_subdirectories(const DirectoryPath *path)
         fatal_error("opendir");
     }
 
+    if (latest_change != NULL) {
+        struct stat dirstat;
+        if (fstat(dirfd(dirp), &dirstat) == -1) {
+            fatal_custom_error("'stat' failed for '%s'.", absolute_directory_path);
+        }
+        *latest_change = dirstat.st_ctime;
+    }
+
+    if (entries_count != NULL) {
+        *entries_count = 0;
+    }
+
     while ((dent = readdir(dirp)) != NULL) {
 
-        if (strncmp(dent->d_name, ".", 1) == 0 || strncmp(dent->d_name, "..", 2) == 0) {
+        const bool is_hidden = strncmp(dent->d_name, ".", 1) == 0;
+        if (is_hidden && (latest_change == NULL || strcmp(dent->d_name, ".") == 0 || strcmp(dent->d_name, "..") == 0)) {
             continue;
         }
 
@@ -124,7 +161,21 @@ get_paths_of_subdirectories(const DirectoryPath *path)
             fatal_custom_error("'stat' failed for '%s'.", subdir_absolute_path);
         }
 
-        if (!S_ISDIR(dirstat.st_mode)) {
+        if (is_ignored(ignore_rules, path->subdir_path_relative_to_ws_root, dent->d_name, S_ISDIR(dirstat.st_mode))) {
+            DO_FREE(subdir_absolute_path);
+            DO_FREE(subdir_path_relative_to_ws_root);
+            continue;
+        }
+
+        if (entries_count != NULL && !is_hidden) {
+            (*entries_count)++;
+        }
+
+        // Hidden entries are only looked at for changes of the files they contain
+        if (!S_ISDIR(dirstat.st_mode) || is_hidden) {
+            if (latest_change != NULL && !S_ISDIR(dirstat.st_mode) && dirstat.st_ctime > *latest_change) {
+                *latest_change = dirstat.st_ctime;
+            }
             DO_FREE(subdir_absolute_path);
             DO_FREE(subdir_path_relative_to_ws_root);
             continue;
@@ -166,3 +217,35 @@ get_path_to_parent_directory(const char *directory)
     return parent_path;
 }
 
+int
+remove_tree_at(const int dir_fd, const char *path)
+{
+    if (unlinkat(dir_fd, path, 0) == 0) {
+        return 0;
+    } else if (errno != EISDIR && errno != EPERM) {
+        return -1;
+    }
+
+    const int fd = openat(dir_fd, path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd == -1) {
+        return -1;
+    }
+
+    DIR *dir = fdopendir(fd);
+    if (dir == NULL) {
+        close(fd);
+        return -1;
+    }
+
+    int res = 0;
+    struct dirent *entry;
+    while (res == 0 && (entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        res = remove_tree_at(fd, entry->d_name);
+    }
+    closedir(dir);
+
+    return (res == 0) ? unlinkat(dir_fd, path, AT_REMOVEDIR) : res;
+}
@@ -5,13 +5,17 @@
 #include "../../lib/ulist.h"
 #include "memory.h"
 #include "error.h"
+#include "ignore_rules.h"
 
 #include <stdio.h>
+#include <fcntl.h>
 #include <dirent.h>
 #include <unistd.h>
 #include <stdbool.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
+#include <stdint.h>
 
 typedef struct DirectoryPath {
     const char *workspace_root_path;
@@ -31,13 +35,28 @@ void destroy_directory_path(DirectoryPath **dir_path);
 
 char *concat_paths(const char *path1, const char *path2);
 
+/**
+ * @param relative_directory_path path relative to the workspace root, NULL for the workspace root itself
+ * @return the innermost directory that contains both directories, NULL for the workspace root
+ */
+char *get_common_directory(const char *relative_directory_path, const char *other_relative_directory_path);
+
 bool validate_absolute_path(const char *path, char **error_msg);
 
 bool validate_directory_exists(const char *path, char **error_msg);
 
 bool validate_file_exists(const char *path, char **error_msg);
 
-DirectoryPathList *get_paths_of_subdirectories(const DirectoryPath *path);
+/**
+ * Returns the paths of all (non-hidden) subdirectories of the directory that are not ignored.
+ *
+ * @param ignore_rules rules of the workspace, may be NULL. Ignored files do not count as changes either.
+ * @param latest_change if not NULL, is set to the most recent change time of the directory itself and of the files
+ *  it directly contains, which is obtained from the same 'stat' calls without any additional walk
+ * @param entries_count if not NULL, is set to the number of (non-hidden) entries of the directory that are not ignored
+ */
+DirectoryPathList *get_paths_of_subdirectories(const DirectoryPath *path, const IgnoreRules *ignore_rules,
+                                               time_t *latest_change, uint64_t *entries_count);
 
 /**
  * Returns the absolute path to the parent directory, if one exists.
@@ -47,5 +66,13 @@ DirectoryPathList *get_paths_of_subdirectories(const DirectoryPath *path);
  */
 char *get_path_to_parent_directory(const char *directory);
 
+/**
+ * Removes the file or the directory including its content. Symbolic links are removed, not followed.
+ *
+ * @param dir_fd directory the path is resolved relative to, or 'AT_FDCWD'
+ * @return 0 on success, -1 otherwise (errno is set accordingly)
+ */
+int remove_tree_at(const int dir_fd, const char *path);
+
 
 #endif //RESYNC_FS_UTIL_H
@@ -0,0 +1,522 @@
+#include "ignore_rules.h"
+
+/*
+ * @param class points to the '[' that opens the character class
+ * @return the ']' that closes the character class, or NULL if it is not closed
+ */
+static const char *
+find_character_class_end(const char *class)
+{
+    const char *ptr = class + 1;
+    if (*ptr == '!' || *ptr == '^') {
+        ptr++;
+    }
+    // A ']' right at the start is a member of the class
+    if (*ptr == ']') {
+        ptr++;
+    }
+
+    for (; *ptr != '\0'; ptr++) {
+        if (*ptr == '\\' && ptr[1] != '\0') {
+            ptr++;
+        } else if (*ptr == ']') {
+            return ptr;
+        }
+    }
+
+    return NULL;
+}
+
+static bool
+is_in_character_class(const char *class, const char *class_end, const unsigned char c)
+{
+    const char *ptr = class + 1;
+    const bool is_negated = (*ptr == '!' || *ptr == '^');
+    if (is_negated) {
+        ptr++;
+    }
+
+    bool is_member = false;
+    while (ptr < class_end) {
+        if (*ptr == '\\') {
+            ptr++;
+        }
+        const unsigned char low = (unsigned char) *ptr++;
+
+        unsigned char high = low;
+        if (*ptr == '-' && ptr + 1 < class_end) {
+            ptr++;
+            if (*ptr == '\\') {
+                ptr++;
+            }
+            high = (unsigned char) *ptr++;
+        }
+
+        is_member |= (c >= low && c <= high);
+    }
+
+    return c != '/' && is_member != is_negated;
+}
+
+/*
+ * Matches the text against the glob pattern. '*' and '?' do not match a '/', whereas a '**' that makes up an entire
+ *  segment of the pattern matches any number of segments, including none.
+ *
+ * @param pattern_start start of the entire pattern, to tell whether a '**' starts a segment
+ */
+static bool
+match_glob(const char *pattern_start, const char *pattern, const char *text)
+{
+    for (; *pattern != '\0'; pattern++, text++) {
+        if (*pattern == '*') {
+            const bool is_segment_start = (pattern == pattern_start || pattern[-1] == '/');
+            const char *stars = pattern;
+            while (*pattern == '*') {
+                pattern++;
+            }
+
+            if (pattern - stars >= 2 && is_segment_start && (*pattern == '/' || *pattern == '\0')) {
+                // A trailing '**' matches everything inside of the directory matched so far
+                if (*pattern == '\0') {
+                    return true;
+                }
+
+                if (match_glob(pattern_start, pattern + 1, text)) {
+                    return true;
+                }
+                for (; *text != '\0'; text++) {
+                    if (*text == '/' && match_glob(pattern_start, pattern + 1, text + 1)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            for (;; text++) {
+                if (match_glob(pattern_start, pattern, text)) {
+                    return true;
+                } else if (*text == '\0' || *text == '/') {
+                    return false;
+                }
+            }
+        }
+
+        if (*text == '\0') {
+            return false;
+        }
+
+        if (*pattern == '?') {
+            if (*text == '/') {
+                return false;
+            }
+            continue;
+        }
+
+        if (*pattern == '[') {
+            const char *class_end = find_character_class_end(pattern);
+            if (class_end != NULL) {
+                if (!is_in_character_class(pattern, class_end, (unsigned char) *text)) {
+                    return false;
+                }
+                pattern = class_end;
+                continue;
+            }
+        }
+
+        if (*pattern == '\\' && pattern[1] != '\0') {
+            pattern++;
+        }
+        if (*pattern != *text) {
+            return false;
+        }
+    }
+
+    return *text == '\0';
+}
+
+IgnoreRules *
+create_ignore_rules(void)
+{
+    return (IgnoreRules *) do_calloc(1, sizeof(IgnoreRules));
+}
+
+static void
+destroy_ignore_literals(IgnoreLiteral **literals)
+{
+    IgnoreLiteral *literal, *tmp;
+    HASH_ITER(hh, *literals, literal, tmp) {
+        HASH_DEL(*literals, literal);
+        DO_FREE(literal->key);
+        DO_FREE(literal);
+    }
+}
+
+void
+destroy_ignore_rules(IgnoreRules **rules)
+{
+    if (rules == NULL || *rules == NULL) {
+        return;
+    }
+
+    for (ssize_t i = 0; i < (*rules)->rules_count; i++) {
+        DO_FREE((*rules)->rules[i].pattern);
+        DO_FREE((*rules)->rules[i].line);
+    }
+    DO_FREE((*rules)->rules);
+    DO_FREE((*rules)->glob_rules);
+    destroy_ignore_literals(&(*rules)->literal_names);
+    destroy_ignore_literals(&(*rules)->literal_paths);
+    DO_FREE(*rules);
+}
+
+/*
+ * Checks that every character class is closed and that the pattern does not end with an escape.
+ *
+ * @param is_glob set to whether the pattern contains wildcards
+ */
+static bool
+validate_glob_pattern(const char *pattern, bool *is_glob, char **error_msg)
+{
+    *is_glob = false;
+
+    for (const char *ptr = pattern; *ptr != '\0'; ptr++) {
+        if (*ptr == '\\') {
+            if (ptr[1] == '\0') {
+                SET_ERROR_MSG_RAW(error_msg, format_string("Ignore pattern '%s' ends with an escape", pattern));
+                return false;
+            }
+            ptr++;
+        } else if (*ptr == '[') {
+            const char *class_end = find_character_class_end(ptr);
+            if (class_end == NULL) {
+                SET_ERROR_MSG_RAW(error_msg, format_string("Ignore pattern '%s' contains an unclosed '['", pattern));
+                return false;
+            }
+            *is_glob = true;
+            ptr = class_end;
+        } else if (*ptr == '*' || *ptr == '?') {
+            *is_glob = true;
+        }
+    }
+
+    return true;
+}
+
+static void
+unescape_pattern(char *pattern)
+{
+    char *target = pattern;
+    for (const char *ptr = pattern; *ptr != '\0'; ptr++) {
+        if (*ptr == '\\') {
+            ptr++;
+        }
+        *target++ = *ptr;
+    }
+    *target = '\0';
+}
+
+static void
+add_ignore_literal(IgnoreLiteral **literals, const IgnoreRule *rule, const ssize_t position)
+{
+    IgnoreLiteral *literal;
+    HASH_FIND_STR(*literals, rule->pattern, literal);
+    if (literal == NULL) {
+        literal = (IgnoreLiteral *) do_calloc(1, sizeof(IgnoreLiteral));
+        literal->key = resync_strdup(rule->pattern);
+        literal->last_file_rule = -1;
+        HASH_ADD_KEYPTR(hh, *literals, literal->key, strlen(literal->key), literal);
+    }
+
+    literal->last_rule = position;
+    if (!rule->is_directory_only) {
+        literal->last_file_rule = position;
+    }
+}
+
+bool
+add_ignore_pattern(IgnoreRules *rules, const char *line, char **error_msg)
+{
+    const char *start = line;
+    const char *end = line + strlen(line);
+
+    // Trailing spaces are only kept if they are escaped
+    while (end > start && (end[-1] == '\n' || end[-1] == '\r')) {
+        end--;
+    }
+    while (end > start && end[-1] == ' ' && !(end - start >= 2 && end[-2] == '\\')) {
+        end--;
+    }
+
+    if (start == end || *start == '#') {
+        return true;
+    }
+    const char *line_end = end;
+
+    IgnoreRule rule = {.pattern = NULL};
+    if (*start == '!') {
+        rule.is_negated = true;
+        start++;
+    }
+    if (end > start && end[-1] == '/') {
+        rule.is_directory_only = true;
+        end--;
+    }
+    if (start < end && *start == '/') {
+        rule.is_anchored = true;
+        start++;
+    }
+
+    // Patterns such as '/' or '!' do not match anything
+    if (start == end) {
+        return true;
+    }
+
+    rule.pattern = strndup(start, end - start);
+    if (rule.pattern == NULL) {
+        fatal_error("strndup");
+    }
+    rule.is_anchored |= (strchr(rule.pattern, '/') != NULL);
+
+    bool is_glob;
+    if (!validate_glob_pattern(rule.pattern, &is_glob, error_msg)) {
+        DO_FREE(rule.pattern);
+        return false;
+    }
+
+    rule.is_literal = !is_glob;
+    if (rule.is_literal) {
+        unescape_pattern(rule.pattern);
+    }
+
+    rule.line = strndup(line, line_end - line);
+    if (rule.line == NULL) {
+        fatal_error("strndup");
+    }
+
+    if (rules->rules_count == rules->rules_capacity) {
+        rules->rules_capacity = (rules->rules_capacity == 0) ? 16 : rules->rules_capacity * 2;
+        rules->rules = (IgnoreRule *) do_realloc(rules->rules, rules->rules_capacity * sizeof(IgnoreRule));
+        rules->glob_rules = (ssize_t *) do_realloc(rules->glob_rules, rules->rules_capacity * sizeof(ssize_t));
+    }
+
+    const ssize_t position = rules->rules_count++;
+    rules->rules[position] = rule;
+
+    if (!rule.is_literal) {
+        rules->glob_rules[rules->glob_rules_count++] = position;
+    } else {
+        add_ignore_literal(rule.is_anchored ? &rules->literal_paths : &rules->literal_names, &rule, position);
+    }
+
+    return true;
+}
+
+bool
+add_ignore_file(IgnoreRules *rules, const char *path, char **error_msg)
+{
+    FILE *file = fopen(path, "re");
+    if (file == NULL) {
+        if (errno == ENOENT) {
+            return true;
+        }
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to open '%s': %s", path, strerror(errno)));
+        return false;
+    }
+
+    bool res = true;
+    char *line = NULL;
+    size_t line_capacity = 0;
+    size_t line_number = 0;
+
+    while (res && getline(&line, &line_capacity, file) != -1) {
+        line_number++;
+
+        char *pattern_error_msg = NULL;
+        if (!add_ignore_pattern(rules, line, &pattern_error_msg)) {
+            SET_ERROR_MSG_RAW(error_msg, format_string("Line %zu of '%s': %s", line_number, path, pattern_error_msg));
+            DO_FREE(pattern_error_msg);
+            res = false;
+        }
+    }
+
+    if (res && ferror(file)) {
+        SET_ERROR_MSG_RAW(error_msg, format_string("Unable to read '%s'", path));
+        res = false;
+    }
+
+    free(line);
+    fclose(file);
+    return res;
+}
+
+static ssize_t
+find_literal_rule(IgnoreLiteral *literals, const char *key, const bool is_directory)
+{
+    IgnoreLiteral *literal;
+    HASH_FIND_STR(literals, key, literal);
+    if (literal == NULL) {
+        return -1;
+    }
+
+    return is_directory ? literal->last_rule : literal->last_file_rule;
+}
+
+bool
+is_ignored(const IgnoreRules *rules, const char *relative_directory_path, const char *name, const bool is_directory)
+{
+    if (rules == NULL || rules->rules_count == 0) {
+        return false;
+    }
+
+    char path_buffer[PATH_MAX];
+    const char *relative_path = name;
+    if (relative_directory_path != NULL) {
+        const int path_len = snprintf(path_buffer, sizeof(path_buffer), "%s/%s", relative_directory_path, name);
+        if (path_len < 0 || (size_t) path_len >= sizeof(path_buffer)) {
+            return false;
+        }
+        relative_path = path_buffer;
+    }
+
+    ssize_t match = find_literal_rule(rules->literal_names, name, is_directory);
+    const ssize_t path_match = find_literal_rule(rules->literal_paths, relative_path, is_directory);
+    if (path_match > match) {
+        match = path_match;
+    }
+
+    // Only rules after the matching literal one can still take precedence
+    for (ssize_t i = rules->glob_rules_count - 1; i >= 0 && rules->glob_rules[i] > match; i--) {
+        const IgnoreRule *rule = &rules->rules[rules->glob_rules[i]];
+        if (rule->is_directory_only && !is_directory) {
+            continue;
+        }
+
+        const char *text = rule->is_anchored ? relative_path : name;
+        if (match_glob(rule->pattern, rule->pattern, text)) {
+            match = rules->glob_rules[i];
+            break;
+        }
+    }
+
+    return match >= 0 && !rules->rules[match].is_negated;
+}
+
+/*
+ * @return whether the segments of the pattern and the directory, which do not contain a '/', match
+ */
+static bool
+match_segment(const IgnoreRule *rule, const char *pattern_segment, const size_t pattern_segment_len,
+              const char *directory_segment, const size_t directory_segment_len)
+{
+    char *pattern = strndup(pattern_segment, pattern_segment_len);
+    char *directory = strndup(directory_segment, directory_segment_len);
+    if (pattern == NULL || directory == NULL) {
+        fatal_error("strndup");
+    }
+
+    const bool is_match = rule->is_literal ? strcmp(pattern, directory) == 0 : match_glob(pattern, pattern, directory);
+
+    DO_FREE(pattern);
+    DO_FREE(directory);
+    return is_match;
+}
+
+/*
+ * Matches the leading segments of the anchored pattern against the directory.
+ *
+ * @return the rest of the pattern, which is relative to the directory, or NULL if the pattern cannot match inside of
+ *  the directory. The rest starts with a '**' segment if the directory is (partly) matched by one.
+ */
+static const char *
+get_pattern_below_directory(const IgnoreRule *rule, const char *relative_directory_path)
+{
+    const char *pattern = rule->pattern;
+    const char *directory = relative_directory_path;
+
+    while (directory != NULL && *directory != '\0') {
+        const size_t pattern_segment_len = strcspn(pattern, "/");
+        const size_t directory_segment_len = strcspn(directory, "/");
+
+        if (!rule->is_literal && pattern_segment_len == 2 && strncmp(pattern, "**", 2) == 0) {
+            return pattern;
+        }
+
+        // A pattern that ends within the directory matches the directory or one of its parents, which are synced
+        //  along with their content or not at all
+        if (pattern[pattern_segment_len] == '\0'
+            || !match_segment(rule, pattern, pattern_segment_len, directory, directory_segment_len)) {
+            return NULL;
+        }
+
+        pattern += pattern_segment_len + 1;
+        directory += directory_segment_len;
+        if (*directory == '/') {
+            directory++;
+        }
+    }
+
+    return pattern;
+}
+
+/*
+ * rsync only resolves escapes in patterns that contain wildcards, so literal patterns are escaped again if they contain
+ *  characters that rsync would take for wildcards.
+ */
+static char *
+format_rsync_filter_rule(const IgnoreRule *rule, const char *anchor, const char *pattern)
+{
+    const char *prefix = rule->is_negated ? "+ " : "- ";
+    const char *suffix = rule->is_directory_only ? "/" : "";
+
+    if (!rule->is_literal || strpbrk(pattern, "*?[") == NULL) {
+        return format_string("%s%s%s%s", prefix, anchor, pattern, suffix);
+    }
+
+    char *escaped_pattern = (char *) do_malloc(2 * strlen(pattern) + 1);
+    char *target = escaped_pattern;
+    for (const char *ptr = pattern; *ptr != '\0'; ptr++) {
+        if (strchr("*?[\\", *ptr) != NULL) {
+            *target++ = '\\';
+        }
+        *target++ = *ptr;
+    }
+    *target = '\0';
+
+    char *filter_rule = format_string("%s%s%s%s", prefix, anchor, escaped_pattern, suffix);
+    DO_FREE(escaped_pattern);
+    return filter_rule;
+}
+
+char **
+get_rsync_filter_rules(const IgnoreRules *rules, const char *relative_directory_path)
+{
+    const ssize_t rules_count = (rules == NULL) ? 0 : rules->rules_count;
+
+    // Anchored patterns starting with '**' may take two filter rules
+    char **filter_rules = (char **) do_malloc((2 * rules_count + 1) * sizeof(char *));
+    ssize_t filter_rules_count = 0;
+
+    for (ssize_t i = rules_count - 1; i >= 0; i--) {
+        const IgnoreRule *rule = &rules->rules[i];
+
+        if (!rule->is_anchored) {
+            filter_rules[filter_rules_count++] = format_rsync_filter_rule(rule, "", rule->pattern);
+            continue;
+        }
+
+        const char *pattern = get_pattern_below_directory(rule, relative_directory_path);
+        if (pattern == NULL) {
+            continue;
+        }
+
+        filter_rules[filter_rules_count++] = format_rsync_filter_rule(rule, "/", pattern);
+
+        // Whether rsync lets a leading '**/' match no directory at all depends on its version
+        if (!rule->is_literal && strncmp(pattern, "**/", 3) == 0) {
+            filter_rules[filter_rules_count++] = format_rsync_filter_rule(rule, "/", pattern + 3);
+        }
+    }
+
+    filter_rules[filter_rules_count] = NULL;
+    return filter_rules;
+}
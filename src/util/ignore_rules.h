@@ -0,0 +1,102 @@
+#ifndef RESYNC_IGNORE_RULES_H
+#define RESYNC_IGNORE_RULES_H
+
+#include "string.h"
+#include "memory.h"
+#include "error.h"
+#include "../../lib/utash.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+/*
+ * Rules that exclude resources of a workspace from being watched and synced, written in the syntax of '.gitignore'
+ *  files: one pattern per line, blank lines and lines starting with '#' are skipped, '!' re-includes what an earlier
+ *  pattern excluded, a trailing '/' only matches directories, and patterns that contain a '/' anywhere but at their
+ *  end are matched against the path relative to the workspace root instead of the name of the resource. '*' and '?'
+ *  do not match a '/', '**' matches any number of directories, and '[...]' matches a character class. The last
+ *  matching pattern decides, and resources inside of an excluded directory cannot be re-included.
+ *
+ * Patterns without wildcards, which is what most ignore files consist of (e.g. 'node_modules/' or '/target'), are
+ *  compiled into hash tables keyed by name and path respectively, so that only patterns with wildcards are matched one
+ *  by one.
+ */
+
+/* File at the root of a workspace that lists the patterns of the workspace, in addition to those of its configuration */
+#define IGNORE_FILE_NAME ".resyncignore"
+
+typedef struct IgnoreRule {
+    /* Glob pattern without the '!' prefix and without a leading or trailing '/' */
+    char *pattern;
+    bool is_negated;
+    bool is_directory_only;
+    /* Matched against the path relative to the workspace root instead of the name of the resource */
+    bool is_anchored;
+    /* Contains no wildcards, escapes are already resolved */
+    bool is_literal;
+    /* Line the rule was compiled from, so that the rules can be compiled again elsewhere, e.g. by an agent */
+    char *line;
+} IgnoreRule;
+
+/*
+ * Literal patterns that match the same name or path. Rules are referenced by their position, as later rules take
+ *  precedence. A position of -1 means that there is no such rule.
+ */
+typedef struct IgnoreLiteral {
+    char *key;
+    ssize_t last_rule;
+    /* Last rule that applies to files as well, i.e. that is not restricted to directories */
+    ssize_t last_file_rule;
+    UT_hash_handle hh;
+} IgnoreLiteral;
+
+typedef struct IgnoreRules {
+    IgnoreRule *rules;
+    ssize_t rules_count;
+    ssize_t rules_capacity;
+    /* Positions of the rules with wildcards, in ascending order */
+    ssize_t *glob_rules;
+    ssize_t glob_rules_count;
+    IgnoreLiteral *literal_names;
+    IgnoreLiteral *literal_paths;
+} IgnoreRules;
+
+IgnoreRules *create_ignore_rules(void);
+
+void destroy_ignore_rules(IgnoreRules **rules);
+
+/**
+ * Compiles a single line of an ignore file and appends it to the rules, i.e. it takes precedence over all rules that
+ *  were added before. Blank lines and comments are accepted, but do not add a rule.
+ *
+ * @return false if the pattern is malformed
+ */
+bool add_ignore_pattern(IgnoreRules *rules, const char *line, char **error_msg);
+
+/**
+ * Appends the patterns of the ignore file. A file that does not exist does not add any rules.
+ */
+bool add_ignore_file(IgnoreRules *rules, const char *path, char **error_msg);
+
+/**
+ * Decides whether the resource is excluded, provided that its directory is not. Does not allocate any memory, so that
+ *  it can filter events before they are handled.
+ *
+ * @param relative_directory_path directory containing the resource, NULL for the workspace root
+ */
+bool is_ignored(const IgnoreRules *rules, const char *relative_directory_path, const char *name, const bool is_directory);
+
+/**
+ * Translates the rules into rsync filter rules (e.g. '- /target/') for an rsync invocation that syncs the given
+ *  directory, i.e. whose transfer root is the directory. rsync applies the first matching rule, so the order is
+ *  reversed. Patterns that cannot match inside of the directory are left out.
+ *
+ * @param relative_directory_path synced directory, NULL for the workspace root
+ * @return NULL terminated array of filter rules, which has to be freed along with its entries
+ */
+char **get_rsync_filter_rules(const IgnoreRules *rules, const char *relative_directory_path);
+
+#endif //RESYNC_IGNORE_RULES_H
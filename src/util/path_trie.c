@@ -0,0 +1,230 @@
+#include "path_trie.h"
+
+/*
+ * Advances to the next non-empty segment of the path. Returns the length of the segment, or 0 if the end of the path
+ *  was reached. The segment is not copied, 'segment' points into the passed path.
+ */
+static ssize_t
+next_path_segment(const char **cursor, const char **segment)
+{
+    const char *ptr = *cursor;
+
+    while (*ptr == '/') {
+        ptr++;
+    }
+
+    *segment = ptr;
+    while (*ptr != '\0' && *ptr != '/') {
+        ptr++;
+    }
+
+    *cursor = ptr;
+    return ptr - *segment;
+}
+
+static PathTrieNode *
+create_path_trie_node(const char *segment, const ssize_t segment_len, PathTrieNode *parent)
+{
+    PathTrieNode *node = (PathTrieNode *) do_calloc(1, sizeof(PathTrieNode));
+    node->segment = strndup(segment, segment_len);
+    if (node->segment == NULL) {
+        fatal_error("strndup");
+    }
+    node->parent = parent;
+    return node;
+}
+
+static PathTrieNode *
+find_child(const PathTrieNode *node, const char *segment, const ssize_t segment_len)
+{
+    PathTrieNode *child;
+    HASH_FIND(hh, node->children, segment, (unsigned) segment_len, child);
+    return child;
+}
+
+static PathTrieNode *
+find_node(const PathTrie *trie, const char *path)
+{
+    if (trie == NULL || path == NULL) {
+        return NULL;
+    }
+
+    PathTrieNode *node = trie->root;
+    const char *cursor = path;
+    const char *segment;
+    ssize_t segment_len;
+
+    while (node != NULL && (segment_len = next_path_segment(&cursor, &segment)) > 0) {
+        node = find_child(node, segment, segment_len);
+    }
+
+    return node;
+}
+
+static void
+destroy_path_trie_node(PathTrieNode **node)
+{
+    PathTrieNode *child, *tmp;
+    HASH_ITER(hh, (*node)->children, child, tmp) {
+        HASH_DEL((*node)->children, child);
+        destroy_path_trie_node(&child);
+    }
+
+    DO_FREE((*node)->segment);
+    DO_FREE(*node);
+}
+
+PathTrie *
+create_path_trie(void)
+{
+    PathTrie *trie = (PathTrie *) do_calloc(1, sizeof(PathTrie));
+    trie->root = create_path_trie_node("", 0, NULL);
+    return trie;
+}
+
+void
+destroy_path_trie(PathTrie **trie)
+{
+    if (trie == NULL || *trie == NULL) {
+        return;
+    }
+
+    destroy_path_trie_node(&((*trie)->root));
+    DO_FREE(*trie);
+}
+
+bool
+path_trie_insert(PathTrie *trie, const char *path, void *value)
+{
+    if (trie == NULL || path == NULL) {
+        fatal_custom_error("Unable to insert a path into the path trie as the trie or the path is missing");
+    }
+
+    PathTrieNode *node = trie->root;
+    const char *cursor = path;
+    const char *segment;
+    ssize_t segment_len;
+
+    while ((segment_len = next_path_segment(&cursor, &segment)) > 0) {
+        PathTrieNode *child = find_child(node, segment, segment_len);
+        if (child == NULL) {
+            child = create_path_trie_node(segment, segment_len, node);
+            HASH_ADD_KEYPTR(hh, node->children, child->segment, (unsigned) segment_len, child);
+        }
+        node = child;
+    }
+
+    node->value = value;
+    if (node->is_terminal) {
+        return false;
+    }
+
+    node->is_terminal = true;
+    trie->size++;
+
+    for (PathTrieNode *ancestor = node->parent; ancestor != NULL; ancestor = ancestor->parent) {
+        ancestor->terminal_descendants++;
+    }
+
+    return true;
+}
+
+bool
+path_trie_remove(PathTrie *trie, const char *path, void **value)
+{
+    PathTrieNode *node = find_node(trie, path);
+    if (node == NULL || !node->is_terminal) {
+        return false;
+    }
+
+    if (value != NULL) {
+        *value = node->value;
+    }
+
+    node->is_terminal = false;
+    node->value = NULL;
+    trie->size--;
+
+    for (PathTrieNode *ancestor = node->parent; ancestor != NULL; ancestor = ancestor->parent) {
+        ancestor->terminal_descendants--;
+    }
+
+    // Prune the chain of nodes that neither mark a stored path nor lead to one
+    while (node->parent != NULL && !node->is_terminal && node->children == NULL) {
+        PathTrieNode *parent = node->parent;
+        HASH_DEL(parent->children, node);
+        destroy_path_trie_node(&node);
+        node = parent;
+    }
+
+    return true;
+}
+
+bool
+path_trie_lookup(const PathTrie *trie, const char *path, void **value)
+{
+    PathTrieNode *node = find_node(trie, path);
+    if (node == NULL || !node->is_terminal) {
+        return false;
+    }
+
+    if (value != NULL) {
+        *value = node->value;
+    }
+
+    return true;
+}
+
+bool
+path_trie_overlaps(const PathTrie *trie, const char *path)
+{
+    if (trie == NULL || path == NULL) {
+        return false;
+    }
+
+    PathTrieNode *node = trie->root;
+    const char *cursor = path;
+    const char *segment;
+    ssize_t segment_len;
+
+    while (true) {
+        if (node->is_terminal) {
+            // The path itself or one of its ancestors is stored
+            return true;
+        }
+
+        if ((segment_len = next_path_segment(&cursor, &segment)) == 0) {
+            break;
+        }
+
+        node = find_child(node, segment, segment_len);
+        if (node == NULL) {
+            return false;
+        }
+    }
+
+    return node->terminal_descendants > 0;
+}
+
+static void
+foreach_value(PathTrieNode *node, void (*callback)(void **value, void *context), void *context)
+{
+    if (node->is_terminal) {
+        callback(&(node->value), context);
+    }
+
+    PathTrieNode *child, *tmp;
+    HASH_ITER(hh, node->children, child, tmp) {
+        foreach_value(child, callback, context);
+    }
+}
+
+void
+path_trie_foreach_value(PathTrie *trie, void (*callback)(void **value, void *context), void *context)
+{
+    if (trie == NULL || callback == NULL) {
+        return;
+    }
+
+    foreach_value(trie->root, callback, context);
+}
@@ -0,0 +1,68 @@
+#ifndef RESYNC_PATH_TRIE_H
+#define RESYNC_PATH_TRIE_H
+
+#include "string.h"
+#include "memory.h"
+#include "../../lib/utash.h"
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+/*
+ * Component-wise trie over '/' separated paths. Every node represents a single path segment, e.g. '/home/user/ws' is
+ *  stored as the chain 'home' -> 'user' -> 'ws'. Nodes that correspond to an inserted path are marked as terminal and
+ *  can carry an arbitrary value. Empty segments (leading, trailing or repeated '/') are ignored, so '/a//b/' and 'a/b'
+ *  refer to the same node.
+ */
+typedef struct PathTrieNode {
+    char *segment;
+    bool is_terminal;
+    void *value;
+    /* Number of terminal nodes in the subtree below this node (the node itself is not counted) */
+    ssize_t terminal_descendants;
+    struct PathTrieNode *parent;
+    struct PathTrieNode *children;
+    UT_hash_handle hh;
+} PathTrieNode;
+
+typedef struct PathTrie {
+    PathTrieNode *root;
+    ssize_t size;
+} PathTrie;
+
+PathTrie *create_path_trie(void);
+
+void destroy_path_trie(PathTrie **trie);
+
+/**
+ * Inserts the path into the trie. If the path is already contained in the trie, its value is replaced.
+ *
+ * @return true if the path was newly inserted, false if it was already contained in the trie
+ */
+bool path_trie_insert(PathTrie *trie, const char *path, void *value);
+
+/**
+ * Removes the path from the trie and prunes all nodes that are no longer needed.
+ *
+ * @param value if not NULL, is set to the value that was stored for the removed path
+ * @return true if the path was contained in the trie, false otherwise
+ */
+bool path_trie_remove(PathTrie *trie, const char *path, void **value);
+
+/**
+ * @param value if not NULL, is set to the value that is stored for the path
+ * @return true if exactly this path is contained in the trie, false otherwise
+ */
+bool path_trie_lookup(const PathTrie *trie, const char *path, void **value);
+
+/**
+ * @return true if the path itself, one of its ancestors or one of its descendants is contained in the trie
+ */
+bool path_trie_overlaps(const PathTrie *trie, const char *path);
+
+/**
+ * Invokes the callback for the value of every path contained in the trie. The callback may replace the value.
+ */
+void path_trie_foreach_value(PathTrie *trie, void (*callback)(void **value, void *context), void *context);
+
+#endif //RESYNC_PATH_TRIE_H
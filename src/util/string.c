@@ -72,3 +72,42 @@ is_equal(const char *str1, const char *str2)
 
     return false;
 }
+
+char *
+quote_shell_argument(const char *arg)
+{
+    size_t quotes_count = 0;
+    for (const char *ptr = arg; *ptr != '\0'; ptr++) {
+        quotes_count += (*ptr == '\'');
+    }
+
+    char *quoted_arg = (char *) do_malloc(strlen(arg) + quotes_count * 3 + 3);
+    char *out = quoted_arg;
+
+    *out++ = '\'';
+    for (const char *ptr = arg; *ptr != '\0'; ptr++) {
+        if (*ptr == '\'') {
+            memcpy(out, "'\\''", 4);
+            out += 4;
+        } else {
+            *out++ = *ptr;
+        }
+    }
+    *out++ = '\'';
+    *out = '\0';
+
+    return quoted_arg;
+}
+
+uint64_t
+hash_string(const char *str)
+{
+    // 64 bit FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const char *ptr = str; *ptr != '\0'; ptr++) {
+        hash ^= (unsigned char) *ptr;
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
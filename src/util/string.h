@@ -8,6 +8,7 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 #include "error.h"
@@ -45,4 +46,14 @@ bool is_blank(const char *str);
 
 bool is_equal(const char *str1, const char *str2);
 
+/**
+ * Quotes the argument for a POSIX shell, e.g. for commands that are run on a remote system through ssh.
+ */
+char *quote_shell_argument(const char *arg);
+
+/**
+ * Non-cryptographic hash of the string, e.g. to derive file names from arbitrary paths.
+ */
+uint64_t hash_string(const char *str);
+
 #endif //RESYNC_STRING_H
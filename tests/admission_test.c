@@ -0,0 +1,158 @@
+#include "../src/server/admission.h"
+#include "../src/types/mappers.h"
+#include "test.h"
+
+/*
+ * Requests the initial sync of workspaces that sync to overlapping remote hosts and checks which of them are admitted.
+ */
+
+typedef struct GrantedAdmissions {
+    int count;
+    char granted_ws_paths[8][64];
+} GrantedAdmissions;
+
+static void
+grant(const char *ws_path, void *context)
+{
+    GrantedAdmissions *admissions = (GrantedAdmissions *) context;
+    CHECK(admissions->count < 8);
+    snprintf(admissions->granted_ws_paths[admissions->count++], sizeof(admissions->granted_ws_paths[0]), "%s", ws_path);
+}
+
+static bool
+is_granted(const GrantedAdmissions *admissions, const char *ws_path)
+{
+    for (int i = 0; i < admissions->count; i++) {
+        if (is_equal(admissions->granted_ws_paths[i], ws_path)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Requests the admission of a workspace that syncs to a path on each of the hosts, which are separated by spaces.
+ */
+static void
+request(AdmissionController *controller, const char *ws_path, const int priority, const char *hosts)
+{
+    char *remote_systems = resync_strdup("");
+    char *hosts_copy = resync_strdup(hosts);
+    char *save_ptr = NULL;
+    for (char *host = strtok_r(hosts_copy, " ", &save_ptr); host != NULL; host = strtok_r(NULL, " ", &save_ptr)) {
+        char *extended = format_string(
+                "%s%s{\"remote-workspace-root-path\": \"/srv/%s\", \"connection-type\": \"SSH_HOST_ALIAS\", "
+                "\"connection-information\": {\"ssh-host-alias\": \"%s\"}}",
+                remote_systems,
+                (*remote_systems == '\0') ? "" : ", ",
+                ws_path,
+                host
+        );
+        DO_FREE(remote_systems);
+        remote_systems = extended;
+    }
+
+    char *json = format_string(
+            "{\"local-workspace-root-path\": \"%s\", \"remote-systems\": [%s], \"priority\": %d}",
+            ws_path,
+            remote_systems,
+            priority
+    );
+    char *error_msg = NULL;
+    WorkspaceInformation *ws_info = stringified_json_to_workspaceInformation(json, &error_msg);
+    CHECK(ws_info != NULL);
+
+    request_initial_sync_admission(controller, ws_info);
+
+    destroy_workspaceInformation(&ws_info);
+    DO_FREE(json);
+    DO_FREE(hosts_copy);
+    DO_FREE(remote_systems);
+}
+
+static void
+test_concurrency_limit(void)
+{
+    AdmissionController *controller = create_admission_controller(2, 0);
+    GrantedAdmissions admissions = {.count = 0};
+
+    // A workspace that syncs to the same host twice only occupies it once
+    request(controller, "/a", 0, "build build");
+    request(controller, "/b", 0, "build");
+    request(controller, "/c", 0, "build");
+    request(controller, "/d", 0, "backup");
+    CHECK(dispatch_initial_sync_admissions(controller, grant, &admissions) == -1);
+    CHECK(admissions.count == 3);
+    CHECK(is_granted(&admissions, "/a") && is_granted(&admissions, "/b") && is_granted(&admissions, "/d"));
+
+    // Granted workspaces are not admitted again
+    CHECK(dispatch_initial_sync_admissions(controller, grant, &admissions) == -1);
+    CHECK(admissions.count == 3);
+
+    // A finished initial sync frees its slot
+    release_initial_sync_admission(controller, "/a");
+    CHECK(dispatch_initial_sync_admissions(controller, grant, &admissions) == -1);
+    CHECK(admissions.count == 4 && is_granted(&admissions, "/c"));
+
+    // Releasing a workspace without a request has no effect
+    release_initial_sync_admission(controller, "/unknown");
+
+    destroy_admission_controller(&controller);
+    CHECK(controller == NULL);
+}
+
+static void
+test_priorities(void)
+{
+    AdmissionController *controller = create_admission_controller(1, 0);
+    GrantedAdmissions admissions = {.count = 0};
+
+    request(controller, "/running", 0, "build");
+    CHECK(dispatch_initial_sync_admissions(controller, grant, &admissions) == -1);
+
+    // The waiting workspace with the highest priority goes first, and those with a lower one must not overtake it on
+    //  any of its hosts, even where a slot is free
+    request(controller, "/low", 0, "backup");
+    request(controller, "/high", 5, "build backup");
+    request(controller, "/other", 0, "archive");
+    CHECK(dispatch_initial_sync_admissions(controller, grant, &admissions) == -1);
+    CHECK(admissions.count == 2 && is_granted(&admissions, "/other"));
+
+    release_initial_sync_admission(controller, "/running");
+    CHECK(dispatch_initial_sync_admissions(controller, grant, &admissions) == -1);
+    CHECK(admissions.count == 3 && is_granted(&admissions, "/high"));
+
+    // A repeated request replaces the former one and releases its slots
+    request(controller, "/high", 5, "build");
+    CHECK(dispatch_initial_sync_admissions(controller, grant, &admissions) == -1);
+    CHECK(admissions.count == 5 && is_granted(&admissions, "/low"));
+    CHECK(is_equal(admissions.granted_ws_paths[3], "/high"));
+
+    destroy_admission_controller(&controller);
+}
+
+static void
+test_stagger_interval(void)
+{
+    AdmissionController *controller = create_admission_controller(2, 60 * 1000);
+    GrantedAdmissions admissions = {.count = 0};
+
+    request(controller, "/a", 0, "build");
+    request(controller, "/b", 0, "build");
+
+    // Consecutive initial syncs on a host are delayed, which determines the timeout of the caller
+    const int timeout_ms = dispatch_initial_sync_admissions(controller, grant, &admissions);
+    CHECK(admissions.count == 1 && is_granted(&admissions, "/a"));
+    CHECK(timeout_ms > 0 && timeout_ms <= 60 * 1000);
+
+    destroy_admission_controller(&controller);
+}
+
+int
+main(void)
+{
+    test_concurrency_limit();
+    test_priorities();
+    test_stagger_interval();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,169 @@
+#include "../src/server/agent_protocol.h"
+#include "../src/server/workspace_index.h"
+#include "test.h"
+
+#include <unistd.h>
+
+/*
+ * Sends the record through a pipe, as records are framed by their size and decoded from a stream
+ */
+static AgentRecord *
+send_and_receive(ByteBuffer *record)
+{
+    int pipe_fds[2];
+    CHECK(pipe(pipe_fds) == 0);
+
+    char *error_msg = NULL;
+    CHECK(send_agent_record(pipe_fds[1], record, &error_msg));
+    close(pipe_fds[1]);
+
+    AgentRecord *received_record = receive_agent_record(pipe_fds[0], &error_msg);
+    CHECK(error_msg == NULL);
+    close(pipe_fds[0]);
+
+    return received_record;
+}
+
+static void
+test_record_round_trip(void)
+{
+    const char data[] = {0, 1, 2, (char) 0xff};
+
+    ByteBuffer *record = create_agent_record(AGENT_WRITE, 42);
+    agent_record_append_u8(record, 0xab);
+    agent_record_append_u32(record, 0x01020304);
+    agent_record_append_u64(record, 0x0102030405060708ULL);
+    agent_record_append_string(record, "dir/file");
+    agent_record_append_string(record, "");
+    agent_record_append_string(record, NULL);
+    agent_record_append_bytes(record, data, sizeof(data));
+
+    AgentRecord *received_record = send_and_receive(record);
+    destroy_byte_buffer(&record);
+
+    CHECK(received_record != NULL);
+    CHECK(received_record->type == AGENT_WRITE);
+    CHECK(received_record->seq == 42);
+
+    ByteBufferReader reader = create_agent_record_reader(received_record);
+    CHECK(agent_record_read_u8(&reader) == 0xab);
+    CHECK(agent_record_read_u32(&reader) == 0x01020304);
+    CHECK(agent_record_read_u64(&reader) == 0x0102030405060708ULL);
+
+    const char *path = agent_record_read_string_view(&reader);
+    CHECK(path != NULL && strcmp(path, "dir/file") == 0);
+    const char *empty = agent_record_read_string_view(&reader);
+    CHECK(empty != NULL && *empty == '\0');
+    CHECK(agent_record_read_string_view(&reader) == NULL);
+
+    uint32_t size;
+    const void *received_data = agent_record_read_bytes(&reader, &size);
+    CHECK(size == sizeof(data) && memcmp(received_data, data, sizeof(data)) == 0);
+
+    CHECK(!reader.error && reader.offset == reader.size);
+
+    destroy_agent_record(&received_record);
+    CHECK(received_record == NULL);
+}
+
+static void
+test_integers_in_network_byte_order(void)
+{
+    ByteBuffer *record = create_agent_record(AGENT_HELLO, 1);
+    agent_record_append_u32(record, AGENT_PROTOCOL_VERSION);
+
+    AgentRecord *received_record = send_and_receive(record);
+    destroy_byte_buffer(&record);
+
+    const unsigned char *body = (const unsigned char *) received_record->body;
+    CHECK(received_record->body_size == 4);
+    CHECK(body[0] == 0 && body[1] == 0 && body[2] == 0 && body[3] == AGENT_PROTOCOL_VERSION);
+
+    destroy_agent_record(&received_record);
+}
+
+static void
+test_malformed_strings_are_rejected(void)
+{
+    // A string with an embedded NULL byte must not be read as a shorter path
+    ByteBuffer *body = create_byte_buffer(16);
+    agent_record_append_u32(body, 3);
+    byte_buffer_append(body, "a\0b", 4);
+
+    ByteBufferReader reader = create_byte_buffer_reader(body->data, body->size);
+    CHECK(agent_record_read_string_view(&reader) == NULL);
+    CHECK(reader.error);
+    destroy_byte_buffer(&body);
+
+    // The announced length exceeds the body
+    body = create_byte_buffer(16);
+    agent_record_append_u32(body, 100);
+    byte_buffer_append(body, "abc", 4);
+
+    reader = create_byte_buffer_reader(body->data, body->size);
+    CHECK(agent_record_read_string_view(&reader) == NULL);
+    CHECK(reader.error);
+    CHECK(agent_record_read_u32(&reader) == 0);
+    destroy_byte_buffer(&body);
+}
+
+static void
+test_oversized_records_are_rejected(void)
+{
+    int pipe_fds[2];
+    CHECK(pipe(pipe_fds) == 0);
+
+    // A frame header that announces more than the maximum record size
+    const unsigned char header[] = {0xff, 0xff, 0xff, 0xff, AGENT_WRITE, 0, 0, 0, 1};
+    CHECK(write(pipe_fds[1], header, sizeof(header)) == sizeof(header));
+    close(pipe_fds[1]);
+
+    char *error_msg = NULL;
+    CHECK(receive_agent_record(pipe_fds[0], &error_msg) == NULL);
+    CHECK(error_msg != NULL);
+    DO_FREE(error_msg);
+    close(pipe_fds[0]);
+}
+
+static void
+test_directory_digest_round_trip(void)
+{
+    char *subdir_names[] = {"a", "b"};
+    uint64_t subdir_hashes[] = {1, 0xffffffffffffffffULL};
+    const DirectoryDigest digest = {
+            .entries_hash = 0x1234,
+            .subdirs_count = 2,
+            .subdir_names = subdir_names,
+            .subdir_hashes = subdir_hashes
+    };
+
+    ByteBuffer *body = create_byte_buffer(64);
+    append_directory_digest(body, &digest);
+
+    ByteBufferReader reader = create_byte_buffer_reader(body->data, body->size);
+    DirectoryDigest *read_digest = read_directory_digest(&reader);
+    CHECK(read_digest != NULL && !reader.error && reader.offset == reader.size);
+    CHECK(read_digest->entries_hash == 0x1234);
+    CHECK(read_digest->subdirs_count == 2);
+    CHECK(strcmp(read_digest->subdir_names[0], "a") == 0 && read_digest->subdir_hashes[0] == 1);
+    CHECK(strcmp(read_digest->subdir_names[1], "b") == 0 && read_digest->subdir_hashes[1] == 0xffffffffffffffffULL);
+    destroy_directory_digest(&read_digest);
+
+    // A truncated digest must not be read
+    reader = create_byte_buffer_reader(body->data, body->size - 1);
+    CHECK(read_directory_digest(&reader) == NULL);
+    CHECK(reader.error);
+
+    destroy_byte_buffer(&body);
+}
+
+int
+main(void)
+{
+    test_record_round_trip();
+    test_integers_in_network_byte_order();
+    test_malformed_strings_are_rejected();
+    test_oversized_records_are_rejected();
+    test_directory_digest_round_trip();
+    return EXIT_SUCCESS;
+}
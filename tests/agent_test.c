@@ -0,0 +1,301 @@
+#include "../src/server/agent_protocol.h"
+#include "../src/server/delta.h"
+#include "../src/util/fs_util.h"
+#include "test.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+/*
+ * Applies records through the agent executable, whose path is passed in the 'RESYNC_AGENT' environment variable, to a
+ *  temporary workspace and checks the acknowledgements and the resulting files.
+ */
+
+static int to_agent_fd = -1;
+static int from_agent_fd = -1;
+static uint32_t next_seq = 1;
+
+static pid_t
+start_agent(const char *workspace_root_path)
+{
+    const char *agent_path = getenv("RESYNC_AGENT");
+    CHECK(agent_path != NULL);
+
+    int to_agent_fds[2], from_agent_fds[2];
+    CHECK(pipe(to_agent_fds) == 0 && pipe(from_agent_fds) == 0);
+
+    const pid_t pid = fork();
+    CHECK(pid != -1);
+    if (pid == 0) {
+        dup2(to_agent_fds[0], STDIN_FILENO);
+        dup2(from_agent_fds[1], STDOUT_FILENO);
+        close(to_agent_fds[0]);
+        close(to_agent_fds[1]);
+        close(from_agent_fds[0]);
+        close(from_agent_fds[1]);
+        execl(agent_path, agent_path, workspace_root_path, (char *) NULL);
+        _exit(EXIT_FAILURE);
+    }
+
+    close(to_agent_fds[0]);
+    close(from_agent_fds[1]);
+    to_agent_fd = to_agent_fds[1];
+    from_agent_fd = from_agent_fds[0];
+    return pid;
+}
+
+/*
+ * Sends the record and waits for its acknowledgement, whose reader is positioned at the record specific payload
+ *
+ * @return whether the agent applied the record
+ */
+static bool
+exchange(ByteBuffer *record, AgentRecord **ack, ByteBufferReader *payload_reader)
+{
+    const uint32_t seq = next_seq - 1;
+    char *error_msg = NULL;
+    CHECK(send_agent_record(to_agent_fd, record, &error_msg));
+    destroy_byte_buffer(&record);
+
+    *ack = receive_agent_record(from_agent_fd, &error_msg);
+    CHECK(*ack != NULL);
+    CHECK((*ack)->type == AGENT_ACK && (*ack)->seq == seq);
+
+    *payload_reader = create_agent_record_reader(*ack);
+    const uint8_t status = agent_record_read_u8(payload_reader);
+    const char *error = agent_record_read_string_view(payload_reader);
+    CHECK(!payload_reader->error);
+    CHECK((status == AGENT_ACK_OK) == (error == NULL));
+    return status == AGENT_ACK_OK;
+}
+
+static bool
+exchange_without_payload(ByteBuffer *record)
+{
+    AgentRecord *ack;
+    ByteBufferReader reader;
+    const bool is_applied = exchange(record, &ack, &reader);
+    destroy_agent_record(&ack);
+    return is_applied;
+}
+
+static ByteBuffer *
+create_record(const AgentRecordType type)
+{
+    return create_agent_record(type, next_seq++);
+}
+
+static char *
+read_workspace_file(const char *workspace_root_path, const char *relative_path, size_t *size)
+{
+    char *path = concat_paths(workspace_root_path, relative_path);
+    const int fd = open(path, O_RDONLY);
+    DO_FREE(path);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    struct stat file_stat;
+    CHECK(fstat(fd, &file_stat) == 0);
+    char *content = (char *) do_malloc(file_stat.st_size + 1);
+    CHECK(read_all(fd, content, file_stat.st_size) == 1 || file_stat.st_size == 0);
+    close(fd);
+
+    *size = file_stat.st_size;
+    return content;
+}
+
+static void
+test_write_and_structure_records(const char *workspace_root_path)
+{
+    ByteBuffer *record = create_record(AGENT_MKDIR);
+    agent_record_append_string(record, "dir");
+    agent_record_append_u32(record, 0755);
+    CHECK(exchange_without_payload(record));
+
+    // A file transmitted in two chunks
+    record = create_record(AGENT_WRITE);
+    agent_record_append_string(record, "dir/file");
+    agent_record_append_u32(record, 0640);
+    agent_record_append_u8(record, AGENT_WRITE_FIRST_CHUNK);
+    agent_record_append_bytes(record, "hello ", 6);
+    CHECK(exchange_without_payload(record));
+
+    record = create_record(AGENT_WRITE);
+    agent_record_append_string(record, "dir/file");
+    agent_record_append_u32(record, 0640);
+    agent_record_append_u8(record, AGENT_WRITE_LAST_CHUNK);
+    agent_record_append_bytes(record, "world", 5);
+    CHECK(exchange_without_payload(record));
+
+    size_t size;
+    char *content = read_workspace_file(workspace_root_path, "dir/file", &size);
+    CHECK(content != NULL && size == 11 && memcmp(content, "hello world", 11) == 0);
+    DO_FREE(content);
+
+    // Appends are only applied at the end of the file
+    record = create_record(AGENT_APPEND);
+    agent_record_append_string(record, "dir/file");
+    agent_record_append_u64(record, 5);
+    agent_record_append_bytes(record, "!", 1);
+    CHECK(!exchange_without_payload(record));
+
+    record = create_record(AGENT_APPEND);
+    agent_record_append_string(record, "dir/file");
+    agent_record_append_u64(record, 11);
+    agent_record_append_bytes(record, "!", 1);
+    CHECK(exchange_without_payload(record));
+
+    content = read_workspace_file(workspace_root_path, "dir/file", &size);
+    CHECK(content != NULL && size == 12 && memcmp(content, "hello world!", 12) == 0);
+    DO_FREE(content);
+
+    record = create_record(AGENT_RENAME);
+    agent_record_append_string(record, "dir/file");
+    agent_record_append_string(record, "dir/renamed");
+    CHECK(exchange_without_payload(record));
+
+    content = read_workspace_file(workspace_root_path, "dir/renamed", &size);
+    CHECK(content != NULL && size == 12);
+    DO_FREE(content);
+
+    record = create_record(AGENT_DELETE);
+    agent_record_append_string(record, "dir");
+    CHECK(exchange_without_payload(record));
+    CHECK(read_workspace_file(workspace_root_path, "dir/renamed", &size) == NULL);
+
+    // Records must not reach outside of the workspace
+    record = create_record(AGENT_DELETE);
+    agent_record_append_string(record, "../outside");
+    CHECK(!exchange_without_payload(record));
+}
+
+typedef struct DeltaRecord {
+    ByteBuffer *operations;
+} DeltaRecord;
+
+static bool
+append_copy(void *ctx, const uint32_t block_index, const uint32_t block_count)
+{
+    DeltaRecord *delta = (DeltaRecord *) ctx;
+    agent_record_append_u8(delta->operations, AGENT_DELTA_COPY);
+    agent_record_append_u32(delta->operations, block_index);
+    agent_record_append_u32(delta->operations, block_count);
+    return true;
+}
+
+static bool
+append_literal(void *ctx, const char *data, const uint32_t size)
+{
+    DeltaRecord *delta = (DeltaRecord *) ctx;
+    agent_record_append_u8(delta->operations, AGENT_DELTA_LITERAL);
+    agent_record_append_bytes(delta->operations, data, size);
+    return true;
+}
+
+static void
+test_delta_transfer(const char *workspace_root_path)
+{
+    const size_t size = 128 * 1024;
+    char *base = (char *) do_malloc(size);
+    for (size_t i = 0; i < size; i++) {
+        base[i] = (char) (i * 7 + i / 1000);
+    }
+
+    ByteBuffer *record = create_record(AGENT_WRITE);
+    agent_record_append_string(record, "large");
+    agent_record_append_u32(record, 0644);
+    agent_record_append_u8(record, AGENT_WRITE_FIRST_CHUNK | AGENT_WRITE_LAST_CHUNK);
+    agent_record_append_bytes(record, base, size);
+    CHECK(exchange_without_payload(record));
+
+    record = create_record(AGENT_SIGNATURE);
+    agent_record_append_string(record, "large");
+    AgentRecord *ack;
+    ByteBufferReader reader;
+    CHECK(exchange(record, &ack, &reader));
+    FileSignature *signature = read_file_signature(&reader);
+    CHECK(signature != NULL);
+    destroy_agent_record(&ack);
+
+    // The modified file differs in a few bytes in the middle
+    char *file = (char *) do_malloc(size);
+    memcpy(file, base, size);
+    memcpy(file + size / 2, "modified", 8);
+
+    const int fd = memfd_create("agent-test", 0);
+    CHECK(fd != -1 && write(fd, file, size) == (ssize_t) size && lseek(fd, 0, SEEK_SET) == 0);
+
+    DeltaRecord delta = {.operations = create_byte_buffer(1024)};
+    const DeltaEmitter emitter = {.copy = append_copy, .literal = append_literal, .ctx = &delta};
+    uint64_t file_size, file_hash;
+    char *error_msg = NULL;
+    CHECK(generate_delta(fd, signature, &emitter, &file_size, &file_hash, &error_msg));
+    close(fd);
+    CHECK(delta.operations->size < size / 4);
+
+    record = create_record(AGENT_DELTA);
+    agent_record_append_string(record, "large");
+    agent_record_append_u32(record, 0644);
+    agent_record_append_u8(record, AGENT_WRITE_FIRST_CHUNK | AGENT_WRITE_LAST_CHUNK);
+    agent_record_append_u32(record, signature->block_size);
+    agent_record_append_bytes(record, delta.operations->data, delta.operations->size);
+    agent_record_append_u64(record, file_size);
+    agent_record_append_u64(record, file_hash);
+    CHECK(exchange_without_payload(record));
+
+    size_t reconstructed_size;
+    char *reconstructed = read_workspace_file(workspace_root_path, "large", &reconstructed_size);
+    CHECK(reconstructed != NULL && reconstructed_size == size && memcmp(reconstructed, file, size) == 0);
+    DO_FREE(reconstructed);
+
+    // A delta whose result does not match the announced hash must not replace the file
+    record = create_record(AGENT_DELTA);
+    agent_record_append_string(record, "large");
+    agent_record_append_u32(record, 0644);
+    agent_record_append_u8(record, AGENT_WRITE_FIRST_CHUNK | AGENT_WRITE_LAST_CHUNK);
+    agent_record_append_u32(record, signature->block_size);
+    agent_record_append_bytes(record, delta.operations->data, delta.operations->size);
+    agent_record_append_u64(record, file_size);
+    agent_record_append_u64(record, file_hash + 1);
+    CHECK(!exchange_without_payload(record));
+
+    reconstructed = read_workspace_file(workspace_root_path, "large", &reconstructed_size);
+    CHECK(reconstructed != NULL && reconstructed_size == size && memcmp(reconstructed, file, size) == 0);
+    DO_FREE(reconstructed);
+
+    destroy_byte_buffer(&delta.operations);
+    destroy_file_signature(&signature);
+    DO_FREE(file);
+    DO_FREE(base);
+}
+
+int
+main(void)
+{
+    char workspace_root_path[] = "/tmp/resync-agent-test-XXXXXX";
+    CHECK(mkdtemp(workspace_root_path) != NULL);
+
+    const pid_t pid = start_agent(workspace_root_path);
+
+    ByteBuffer *record = create_record(AGENT_HELLO);
+    agent_record_append_u32(record, AGENT_PROTOCOL_VERSION);
+    CHECK(exchange_without_payload(record));
+
+    test_write_and_structure_records(workspace_root_path);
+    test_delta_transfer(workspace_root_path);
+
+    // The agent terminates once the stream is closed
+    close(to_agent_fd);
+    int status;
+    CHECK(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+    close(from_agent_fd);
+
+    char *command = format_string("rm -rf '%s'", workspace_root_path);
+    CHECK(system(command) == 0);
+    DO_FREE(command);
+    return EXIT_SUCCESS;
+}
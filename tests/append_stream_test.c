@@ -0,0 +1,131 @@
+#include "../src/server/append_stream.h"
+#include "../src/util/fs_util.h"
+#include "test.h"
+
+/*
+ * Tracks the shipped offsets of files in a temporary directory while they are appended to, rewritten and rotated.
+ */
+
+static void
+write_file(const char *path, const char *mode, const char *content)
+{
+    FILE *file = fopen(path, mode);
+    CHECK(file != NULL);
+    CHECK(fputs(content, file) >= 0);
+    CHECK(fclose(file) == 0);
+}
+
+/*
+ * @return the shipped offset of the file, after recording that it was shipped entirely
+ */
+static uint64_t
+ship(AppendStreams *streams, const char *relative_path, const char *absolute_path)
+{
+    AppendStreamFingerprint fingerprint;
+    const uint64_t offset = get_shipped_offset(streams, relative_path, absolute_path, &fingerprint);
+    record_shipped_offset(streams, relative_path, &fingerprint);
+    return offset;
+}
+
+static void
+test_selection(AppendStreams *streams)
+{
+    CHECK(is_append_stream(streams, "app.log"));
+    CHECK(is_append_stream(streams, "logs/nested/app.log"));
+    CHECK(is_append_stream(streams, "journal/data"));
+    CHECK(!is_append_stream(streams, "app.log.txt"));
+    CHECK(!is_append_stream(streams, "logs/app.txt"));
+    CHECK(!is_append_stream(NULL, "app.log"));
+}
+
+static void
+test_appends_rewrites_and_rotation(AppendStreams *streams, const char *root)
+{
+    char *path = concat_paths(root, "app.log");
+
+    // The first write of a file is shipped entirely
+    write_file(path, "w", "line 1\n");
+    CHECK(ship(streams, "app.log", path) == 0);
+
+    write_file(path, "a", "line 2\n");
+    CHECK(ship(streams, "app.log", path) == strlen("line 1\n"));
+
+    AppendStreamFingerprint fingerprint;
+    CHECK(get_shipped_offset(streams, "app.log", path, &fingerprint) == fingerprint.size);
+
+    // A file whose end was rewritten does not continue its stream
+    write_file(path, "w", "line 1\nline X\nline 3\n");
+    CHECK(ship(streams, "app.log", path) == 0);
+
+    // Neither does a truncated file
+    write_file(path, "w", "line 1\n");
+    CHECK(ship(streams, "app.log", path) == 0);
+
+    // Nor a rotated one, even if the new file has the same content
+    char *rotated_path = concat_paths(root, "app.log.1");
+    CHECK(rename(path, rotated_path) == 0);
+    write_file(path, "w", "line 1\nline 2\n");
+    CHECK(ship(streams, "app.log", path) == 0);
+
+    // A file that vanished is forgotten
+    CHECK(unlink(path) == 0);
+    CHECK(ship(streams, "app.log", path) == 0);
+    write_file(path, "w", "line 1\nline 2\n");
+    CHECK(ship(streams, "app.log", path) == 0);
+
+    DO_FREE(rotated_path);
+    DO_FREE(path);
+}
+
+static void
+test_forgetting(AppendStreams *streams, const char *root)
+{
+    char *directory_path = concat_paths(root, "logs");
+    char *path = concat_paths(root, "logs/app.log");
+    char *sibling_path = concat_paths(root, "logs.log");
+    CHECK(mkdir(directory_path, 0700) == 0);
+
+    write_file(path, "w", "line 1\n");
+    write_file(sibling_path, "w", "line 1\n");
+    ship(streams, "logs/app.log", path);
+    ship(streams, "logs.log", sibling_path);
+
+    // Only the resources below the directory are forgotten, not the ones that merely share its prefix
+    forget_shipped_offsets(streams, "logs", true);
+    write_file(path, "a", "line 2\n");
+    write_file(sibling_path, "a", "line 2\n");
+    CHECK(ship(streams, "logs/app.log", path) == 0);
+    CHECK(ship(streams, "logs.log", sibling_path) == strlen("line 1\n"));
+
+    forget_shipped_offsets(streams, "logs.log", false);
+    CHECK(ship(streams, "logs.log", sibling_path) == 0);
+
+    DO_FREE(sibling_path);
+    DO_FREE(path);
+    DO_FREE(directory_path);
+}
+
+int
+main(void)
+{
+    char root[] = "/tmp/resync-append-stream-XXXXXX";
+    CHECK(mkdtemp(root) != NULL);
+
+    char *error_msg = NULL;
+    CHECK(create_append_streams(NULL, &error_msg) == NULL);
+
+    IgnorePatternList journal_pattern = {.pattern = "journal/*", .next = NULL};
+    IgnorePatternList log_pattern = {.pattern = "*.log", .next = &journal_pattern};
+    AppendStreams *streams = create_append_streams(&log_pattern, &error_msg);
+    CHECK(streams != NULL && error_msg == NULL);
+
+    test_selection(streams);
+    test_appends_rewrites_and_rotation(streams, root);
+    test_forgetting(streams, root);
+    destroy_append_streams(&streams);
+
+    char *command = format_string("rm -rf '%s'", root);
+    CHECK(system(command) == 0);
+    DO_FREE(command);
+    return EXIT_SUCCESS;
+}
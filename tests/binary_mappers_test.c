@@ -0,0 +1,154 @@
+#include "../src/types/mappers.h"
+#include "../lib/ulist.h"
+#include "test.h"
+
+/*
+ * Encodes workspace information and remote system metadata in the binary format that the daemon passes to the
+ *  monitors, decodes them again and compares the result through the JSON mappers.
+ */
+
+/* Encoding a workspace as JSON requires its root to exist */
+#define WS_INFO_JSON \
+    "{\"local-workspace-root-path\": \"/tmp\", \"remote-systems\": [" \
+    "{\"remote-workspace-root-path\": \"/srv/project\", \"connection-type\": \"SSH\", \"transport\": \"agent\", " \
+    "\"connection-information\": {\"username\": \"user\", \"hostname\": \"build\", \"identity-file\": \"/id\"}}, " \
+    "{\"remote-workspace-root-path\": \"/srv/relay\", \"connection-type\": \"SSH_HOST_ALIAS\", " \
+    "\"connection-information\": {\"ssh-host-alias\": \"relay\"}}, " \
+    "{\"remote-workspace-root-path\": \"/srv/behind\", \"connection-type\": \"LOCAL_PATH\", " \
+    "\"relay-parent\": \"relay:/srv/relay\"}, " \
+    "{\"remote-workspace-root-path\": \"/srv/daemon\", \"connection-type\": \"RSYNC_DAEMON\", " \
+    "\"connection-information\": {\"username\": \"user\", \"hostname\": \"backup\", \"port\": 873}}, " \
+    "{\"remote-workspace-root-path\": \"/mnt/backup\", \"connection-type\": \"LOCAL_PATH\"}], " \
+    "\"ignore-patterns\": [\"*.o\", \"build/\"], \"append-stream-patterns\": [\"*.log\"], \"priority\": 2, " \
+    "\"sync-weight\": 3, \"bulk-event-threshold\": 500, \"append-transfers\": true, \"drift-check-interval\": 60, " \
+    "\"drift-check-content\": true}"
+
+static bool
+is_within(const char *string, const ByteBuffer *buffer)
+{
+    return string >= buffer->data && string < buffer->data + buffer->size;
+}
+
+static void
+test_workspace_information(void)
+{
+    char *error_msg = NULL;
+    WorkspaceInformation *ws_info = stringified_json_to_workspaceInformation(WS_INFO_JSON, &error_msg);
+    CHECK(ws_info != NULL);
+
+    ByteBuffer *buffer = workspaceInformation_to_binary(ws_info, &error_msg);
+    CHECK(buffer != NULL);
+
+    WorkspaceInformation *decoded = binary_to_workspaceInformation(buffer->data, buffer->size, &error_msg);
+    CHECK(decoded != NULL && decoded->is_view);
+
+    // Decoding does not copy any strings
+    CHECK(is_within(decoded->local_workspace_root_path, buffer));
+    CHECK(is_within(decoded->remote_systems->remote_workspace_root_path, buffer));
+    CHECK(is_within(decoded->ignore_patterns->pattern, buffer));
+
+    char *json = workspaceInformation_to_stringified_json(ws_info, &error_msg);
+    char *decoded_json = workspaceInformation_to_stringified_json(decoded, &error_msg);
+    CHECK(json != NULL && decoded_json != NULL && strcmp(json, decoded_json) == 0);
+
+    // Every truncation and any trailing data is detected
+    for (size_t size = 0; size < buffer->size; size++) {
+        CHECK(binary_to_workspaceInformation(buffer->data, size, &error_msg) == NULL);
+        CHECK(error_msg != NULL);
+        DO_FREE(error_msg);
+    }
+    byte_buffer_append_u32(buffer, 0);
+    CHECK(binary_to_workspaceInformation(buffer->data, buffer->size, &error_msg) == NULL);
+    DO_FREE(error_msg);
+
+    // Records of another type or version are rejected
+    CHECK(binary_to_remoteWorkspaceMetadata(buffer->data, buffer->size, &error_msg) == NULL);
+    DO_FREE(error_msg);
+    buffer->data[4] ^= 1;
+    CHECK(binary_to_workspaceInformation(buffer->data, buffer->size - sizeof(uint32_t), &error_msg) == NULL);
+    CHECK(strstr(error_msg, "version") != NULL);
+    DO_FREE(error_msg);
+
+    DO_FREE(decoded_json);
+    DO_FREE(json);
+    destroy_workspaceInformation(&decoded);
+    destroy_byte_buffer(&buffer);
+    destroy_workspaceInformation(&ws_info);
+}
+
+static void
+test_remote_system(void)
+{
+    char *error_msg = NULL;
+    WorkspaceInformation *ws_info = stringified_json_to_workspaceInformation(WS_INFO_JSON, &error_msg);
+    CHECK(ws_info != NULL);
+
+    RemoteWorkspaceMetadata *remote_system;
+    LL_FOREACH(ws_info->remote_systems, remote_system) {
+        ByteBuffer *buffer = remoteWorkspaceMetadata_to_binary(remote_system, &error_msg);
+        CHECK(buffer != NULL);
+
+        RemoteWorkspaceMetadata *decoded = binary_to_remoteWorkspaceMetadata(buffer->data, buffer->size, &error_msg);
+        CHECK(decoded != NULL && decoded->is_view && decoded->next == NULL);
+
+        // A copy owns its strings, so that it outlives the buffer
+        RemoteWorkspaceMetadata *copy = copy_remoteWorkspaceMetadata(decoded);
+        destroy_remoteWorkspaceMetadata(&decoded);
+        destroy_byte_buffer(&buffer);
+        CHECK(!copy->is_view);
+
+        char *key = get_remote_system_key(remote_system);
+        char *copy_key = get_remote_system_key(copy);
+        CHECK(is_equal(key, copy_key));
+        CHECK(copy->connection_type == remote_system->connection_type);
+        CHECK(copy->transport == remote_system->transport);
+        CHECK(is_equal(copy->relay_parent, remote_system->relay_parent));
+
+        DO_FREE(copy_key);
+        DO_FREE(key);
+        destroy_remoteWorkspaceMetadata(&copy);
+    }
+
+    destroy_workspaceInformation(&ws_info);
+}
+
+static void
+test_remove_remote_system(void)
+{
+    char *error_msg = NULL;
+    RemoveRemoteSystemMetadata rm_rsys = {
+            .local_workspace_root_path = "/tmp",
+            .remote_workspace_root_path = "/srv/project",
+            .connection_type = SSH,
+            .remote_system_id_information.hostname = "build"
+    };
+
+    ByteBuffer *buffer = removeRemoteSystemMetadata_to_binary(&rm_rsys, &error_msg);
+    CHECK(buffer != NULL);
+
+    RemoveRemoteSystemMetadata *decoded = binary_to_removeRemoteSystemMetadata(buffer->data, buffer->size, &error_msg);
+    CHECK(decoded != NULL);
+    CHECK(is_equal(decoded->local_workspace_root_path, rm_rsys.local_workspace_root_path));
+    CHECK(is_equal(decoded->remote_workspace_root_path, rm_rsys.remote_workspace_root_path));
+    CHECK(decoded->connection_type == SSH);
+    CHECK(is_equal(decoded->remote_system_id_information.hostname, "build"));
+
+    // The decoded metadata identifies the remote system it was created for, and no other one
+    WorkspaceInformation *ws_info = stringified_json_to_workspaceInformation(WS_INFO_JSON, &error_msg);
+    CHECK(ws_info != NULL);
+    CHECK(is_remote_system_identified_by(ws_info->remote_systems, decoded));
+    CHECK(!is_remote_system_identified_by(ws_info->remote_systems->next, decoded));
+
+    destroy_workspaceInformation(&ws_info);
+    destroy_removeRemoteSystemMetadata(&decoded);
+    destroy_byte_buffer(&buffer);
+}
+
+int
+main(void)
+{
+    test_workspace_information();
+    test_remote_system();
+    test_remove_remote_system();
+    return EXIT_SUCCESS;
+}
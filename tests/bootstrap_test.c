@@ -0,0 +1,229 @@
+#include "../src/server/bootstrap.h"
+#include "../src/types/mappers.h"
+#include "test.h"
+
+#include <sys/stat.h>
+
+/*
+ * Detects remote systems that can be bootstrapped and runs the tar pipelines that stream the workspace to them. ssh is
+ *  replaced by a fake that runs the remote command locally, so the remote systems are directories of the test as well.
+ */
+
+#define SSH_SCRIPT "#!/bin/sh\nfor arg; do last=\"$arg\"; done\nexec sh -c \"$last\"\n"
+
+static char root[] = "/tmp/resync-bootstrap-XXXXXX";
+
+static void
+write_file(const char *path, const char *content)
+{
+    FILE *file = fopen(path, "w");
+    CHECK(file != NULL);
+    CHECK(fputs(content, file) >= 0);
+    CHECK(fclose(file) == 0);
+}
+
+static bool
+exists(const char *directory_path, const char *relative_path)
+{
+    char *path = concat_paths(directory_path, relative_path);
+    struct stat path_stat;
+    const bool exists = lstat(path, &path_stat) == 0;
+    DO_FREE(path);
+    return exists;
+}
+
+static WorkspaceInformation *
+parse_workspace(const char *ws_path, const char *remote_system_json)
+{
+    char *json = format_string(
+            "{\"local-workspace-root-path\": \"%s\", \"remote-systems\": [%s]}",
+            ws_path,
+            remote_system_json
+    );
+    char *error_msg = NULL;
+    WorkspaceInformation *ws_info = stringified_json_to_workspaceInformation(json, &error_msg);
+    CHECK(ws_info != NULL);
+    DO_FREE(json);
+    return ws_info;
+}
+
+static WorkspaceInformation *
+parse_local_mirror(const char *ws_path, const char *mirror_path)
+{
+    char *remote_system_json = format_string(
+            "{\"remote-workspace-root-path\": \"%s\", \"connection-type\": \"LOCAL_PATH\"}",
+            mirror_path
+    );
+    WorkspaceInformation *ws_info = parse_workspace(ws_path, remote_system_json);
+    DO_FREE(remote_system_json);
+    return ws_info;
+}
+
+/*
+ * Runs the bootstrap command with its list of entries on the standard input.
+ *
+ * @return whether the command exited successfully
+ */
+static bool
+run_bootstrap(const WorkspaceInformation *ws_info, const IgnoreRules *ignore_rules, const char *relative_path,
+              const SyncPartitionList *excluded_partitions, const bool is_compressed)
+{
+    int input_fd;
+    char **args = construct_bootstrap_command(ws_info, ws_info->remote_systems, ignore_rules, relative_path,
+                                              excluded_partitions, is_compressed, &input_fd);
+
+    const pid_t pid = fork();
+    CHECK(pid != -1);
+    if (pid == 0) {
+        dup2(input_fd, STDIN_FILENO);
+        execvp(args[0], args);
+        _exit(EXIT_FAILURE);
+    }
+    close(input_fd);
+
+    int status;
+    CHECK(waitpid(pid, &status, 0) == pid);
+
+    for (char **arg = args; *arg != NULL; arg++) {
+        DO_FREE(*arg);
+    }
+    DO_FREE(args);
+    return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+static void
+test_local_targets(const char *workspace_path)
+{
+    char *mirror_path = concat_paths(root, "target");
+    bool is_compressed = true;
+
+    // A missing or empty root is a target, archives to a local mirror are never compressed
+    WorkspaceInformation *ws_info = parse_local_mirror(workspace_path, mirror_path);
+    CHECK(is_bootstrap_target(ws_info->remote_systems, &is_compressed) && !is_compressed);
+    CHECK(mkdir(mirror_path, 0700) == 0);
+    CHECK(is_bootstrap_target(ws_info->remote_systems, &is_compressed));
+    destroy_workspaceInformation(&ws_info);
+
+    char *bin_path = concat_paths(root, "bin");
+    ws_info = parse_local_mirror(workspace_path, bin_path);
+    CHECK(!is_bootstrap_target(ws_info->remote_systems, &is_compressed));
+    destroy_workspaceInformation(&ws_info);
+
+    // rsync daemons cannot run tar
+    ws_info = parse_workspace(
+            workspace_path,
+            "{\"remote-workspace-root-path\": \"/srv/daemon\", \"connection-type\": \"RSYNC_DAEMON\", "
+            "\"connection-information\": {\"hostname\": \"backup\", \"port\": 873}}"
+    );
+    CHECK(!is_bootstrap_target(ws_info->remote_systems, &is_compressed) && !is_compressed);
+    destroy_workspaceInformation(&ws_info);
+
+    DO_FREE(bin_path);
+    DO_FREE(mirror_path);
+}
+
+static void
+test_local_mirror(const char *workspace_path, const IgnoreRules *ignore_rules)
+{
+    char *mirror_path = concat_paths(root, "mirror");
+    WorkspaceInformation *ws_info = parse_local_mirror(workspace_path, mirror_path);
+
+    // Ignored resources and excluded partitions are skipped, symbolic links are not followed
+    char partition_path[] = "part";
+    const SyncPartitionList partition = {.path_relative_to_ws_root = partition_path, .entries_count = 1, .next = NULL};
+    CHECK(run_bootstrap(ws_info, ignore_rules, NULL, &partition, false));
+    CHECK(exists(mirror_path, "file") && exists(mirror_path, "dir/nested"));
+    CHECK(!exists(mirror_path, "debug.o") && !exists(mirror_path, "part"));
+
+    struct stat link_stat;
+    char *link_path = concat_paths(mirror_path, "link");
+    CHECK(lstat(link_path, &link_stat) == 0 && S_ISLNK(link_stat.st_mode));
+
+    // A partition is streamed into the same root by a command of its own
+    CHECK(run_bootstrap(ws_info, ignore_rules, "part", NULL, false));
+    CHECK(exists(mirror_path, "part/inner") && exists(mirror_path, "file"));
+    destroy_workspaceInformation(&ws_info);
+
+    // A root that cannot be created fails the command
+    char *blocked_mirror_path = concat_paths(mirror_path, "file/mirror");
+    ws_info = parse_local_mirror(workspace_path, blocked_mirror_path);
+    CHECK(!run_bootstrap(ws_info, ignore_rules, NULL, NULL, false));
+    destroy_workspaceInformation(&ws_info);
+
+    DO_FREE(blocked_mirror_path);
+    DO_FREE(link_path);
+    DO_FREE(mirror_path);
+}
+
+static void
+test_ssh_remote_system(const char *workspace_path, const IgnoreRules *ignore_rules)
+{
+    char *remote_path = concat_paths(root, "remote");
+    char *remote_system_json = format_string(
+            "{\"remote-workspace-root-path\": \"%s\", \"connection-type\": \"SSH_HOST_ALIAS\", "
+            "\"connection-information\": {\"ssh-host-alias\": \"host\"}}",
+            remote_path
+    );
+    WorkspaceInformation *ws_info = parse_workspace(workspace_path, remote_system_json);
+
+    // Both ends run on this host, so the archives are compressed if it provides the compressor
+    bool is_compressed;
+    CHECK(is_bootstrap_target(ws_info->remote_systems, &is_compressed));
+    CHECK(is_compressed == (system("command -v " BOOTSTRAP_COMPRESSOR " >/dev/null") == 0));
+
+    CHECK(run_bootstrap(ws_info, ignore_rules, NULL, NULL, is_compressed));
+    CHECK(exists(remote_path, "file") && exists(remote_path, "part/inner") && !exists(remote_path, "debug.o"));
+    CHECK(!is_bootstrap_target(ws_info->remote_systems, &is_compressed) && !is_compressed);
+
+    destroy_workspaceInformation(&ws_info);
+    DO_FREE(remote_system_json);
+    DO_FREE(remote_path);
+}
+
+static void
+clean_up(void)
+{
+    char *command = format_string("rm -rf '%s'", root);
+    system(command);
+    DO_FREE(command);
+}
+
+int
+main(void)
+{
+    CHECK(mkdtemp(root) != NULL);
+    CHECK(atexit(clean_up) == 0);
+
+    char *workspace_path = concat_paths(root, "workspace");
+    char *bin_path = concat_paths(root, "bin");
+    char *ssh_path = concat_paths(bin_path, "ssh");
+    CHECK(mkdir(workspace_path, 0700) == 0 && mkdir(bin_path, 0700) == 0);
+    write_file(ssh_path, SSH_SCRIPT);
+    CHECK(chmod(ssh_path, 0700) == 0);
+
+    char *path = format_string("%s:%s", bin_path, getenv("PATH"));
+    CHECK(setenv("PATH", path, 1) == 0);
+
+    char *command = format_string(
+            "cd '%s' && mkdir -p dir part && echo content > file && touch debug.o dir/nested part/inner "
+            "&& ln -s file link",
+            workspace_path
+    );
+    CHECK(system(command) == 0);
+
+    char *error_msg = NULL;
+    IgnoreRules *ignore_rules = create_ignore_rules();
+    CHECK(add_ignore_pattern(ignore_rules, "*.o", &error_msg));
+
+    test_local_targets(workspace_path);
+    test_local_mirror(workspace_path, ignore_rules);
+    test_ssh_remote_system(workspace_path, ignore_rules);
+
+    destroy_ignore_rules(&ignore_rules);
+    DO_FREE(command);
+    DO_FREE(path);
+    DO_FREE(ssh_path);
+    DO_FREE(bin_path);
+    DO_FREE(workspace_path);
+    return EXIT_SUCCESS;
+}
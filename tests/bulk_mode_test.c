@@ -0,0 +1,202 @@
+#include "../src/server/linux/bulk_mode.h"
+#include "../src/types/mappers.h"
+#include "test.h"
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+/*
+ * Detects bulk operations by their event rate and by git's lock file, and checks which subtrees are synced once they
+ *  are over. rsync is replaced by a fake that records the remote directory of every sync.
+ */
+
+#define RSYNC_SCRIPT "#!/bin/sh\nfor arg; do last=\"$arg\"; done\necho \"$last\" >> '%s/syncs'\nexit 0\n"
+
+static char root[] = "/tmp/resync-bulk-mode-XXXXXX";
+
+static void
+write_file(const char *path, const char *content)
+{
+    FILE *file = fopen(path, "w");
+    CHECK(file != NULL);
+    CHECK(fputs(content, file) >= 0);
+    CHECK(fclose(file) == 0);
+}
+
+/*
+ * @return the remote directories that were synced, separated by spaces, and clears the record
+ */
+static char *
+take_syncs(void)
+{
+    char *syncs_path = concat_paths(root, "syncs");
+    char *summary = resync_strdup("");
+
+    FILE *syncs_file = fopen(syncs_path, "r");
+    char line[PATH_MAX];
+    while (syncs_file != NULL && fgets(line, sizeof(line), syncs_file) != NULL) {
+        line[strcspn(line, "\n")] = '\0';
+        char *extended = format_string("%s%s%s", summary, (*summary == '\0') ? "" : " ", line);
+        DO_FREE(summary);
+        summary = extended;
+    }
+
+    if (syncs_file != NULL) {
+        fclose(syncs_file);
+        CHECK(unlink(syncs_path) == 0);
+    }
+    DO_FREE(syncs_path);
+    return summary;
+}
+
+static void
+leave_and_check_syncs(WorkspaceInformation *ws_info, const char *expected_syncs)
+{
+    leave_bulk_mode(ws_info);
+    CHECK(!is_bulk_mode_active());
+
+    char *syncs = take_syncs();
+    CHECK(is_equal(syncs, expected_syncs));
+    DO_FREE(syncs);
+}
+
+static void
+test_event_rate(WorkspaceInformation *ws_info)
+{
+    configure_bulk_mode(10);
+    CHECK(get_bulk_mode_timeout_ms() == -1);
+
+    // Queued events count towards the rate as well
+    count_events_for_bulk_mode(5, 0);
+    CHECK(!is_bulk_mode_active());
+    count_events_for_bulk_mode(3, 5);
+    CHECK(is_bulk_mode_active());
+
+    const int timeout_ms = get_bulk_mode_timeout_ms();
+    CHECK(timeout_ms > 0 && timeout_ms <= BULK_MODE_QUIESCENCE_MS);
+    CHECK(!is_bulk_operation_over());
+
+    // Subtrees within a dirty subtree are synced along with it
+    mark_dirty_subtree("a/b");
+    mark_dirty_subtree("a");
+    mark_dirty_subtree("a/c");
+    mark_dirty_subtree("ab");
+    leave_and_check_syncs(ws_info, "host:/srv/ws/a host:/srv/ws/ab");
+
+    // The events of the operation do not start another one
+    count_events_for_bulk_mode(5, 0);
+    CHECK(!is_bulk_mode_active());
+}
+
+static void
+test_merged_subtrees(WorkspaceInformation *ws_info)
+{
+    // Too many subtrees are merged into their common directory
+    for (int i = 0; i <= BULK_MODE_MAX_DIRTY_SUBTREES; i++) {
+        char *path = format_string("m/%d/sub", i);
+        mark_dirty_subtree(path);
+        DO_FREE(path);
+    }
+    leave_and_check_syncs(ws_info, "host:/srv/ws/m");
+
+    // Nothing is left to merge with the workspace root
+    mark_dirty_subtree("x");
+    mark_dirty_subtree(NULL);
+    mark_dirty_subtree("y");
+    leave_and_check_syncs(ws_info, "host:/srv/ws");
+}
+
+static void
+test_lock_file(void)
+{
+    char *git_path = concat_paths(root, "workspace/" BULK_OPERATION_LOCK_DIRECTORY);
+    char *lock_path = concat_paths(git_path, BULK_OPERATION_LOCK_FILE_NAME);
+    char *workspace_path = concat_paths(root, "workspace");
+    CHECK(mkdir(git_path, 0700) == 0);
+
+    const int inotify_fd = inotify_init1(IN_CLOEXEC);
+    CHECK(inotify_fd != -1);
+    watch_bulk_operation_lock(inotify_fd, workspace_path);
+
+    char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+    // Holding the lock file starts a bulk operation that survives longer pauses
+    write_file(lock_path, "");
+    const ssize_t size = read(inotify_fd, buffer, sizeof(buffer));
+    CHECK(size >= (ssize_t) sizeof(struct inotify_event));
+    handle_bulk_operation_lock_event((const struct inotify_event *) buffer);
+    CHECK(is_bulk_mode_active());
+    CHECK(get_bulk_mode_timeout_ms() > BULK_MODE_QUIESCENCE_MS);
+
+    // Events of other files or watches do not release it
+    struct inotify_event *event = (struct inotify_event *) buffer;
+    event->mask = IN_DELETE;
+    event->wd++;
+    handle_bulk_operation_lock_event(event);
+    CHECK(get_bulk_mode_timeout_ms() > BULK_MODE_QUIESCENCE_MS);
+
+    CHECK(unlink(lock_path) == 0);
+    CHECK(read(inotify_fd, buffer, sizeof(buffer)) >= (ssize_t) sizeof(struct inotify_event));
+    handle_bulk_operation_lock_event((const struct inotify_event *) buffer);
+    CHECK(get_bulk_mode_timeout_ms() <= BULK_MODE_QUIESCENCE_MS);
+
+    // The operation is over once no event arrived for a while
+    usleep((BULK_MODE_QUIESCENCE_MS + 100) * 1000);
+    CHECK(is_bulk_operation_over());
+
+    close(inotify_fd);
+    DO_FREE(workspace_path);
+    DO_FREE(lock_path);
+    DO_FREE(git_path);
+}
+
+static void
+clean_up(void)
+{
+    char *command = format_string("rm -rf '%s'", root);
+    system(command);
+    DO_FREE(command);
+}
+
+int
+main(void)
+{
+    CHECK(mkdtemp(root) != NULL);
+    CHECK(atexit(clean_up) == 0);
+
+    char *workspace_path = concat_paths(root, "workspace");
+    char *bin_path = concat_paths(root, "bin");
+    char *rsync_path = concat_paths(bin_path, "rsync");
+    CHECK(mkdir(workspace_path, 0700) == 0 && mkdir(bin_path, 0700) == 0);
+
+    char *rsync_script = format_string(RSYNC_SCRIPT, root);
+    write_file(rsync_path, rsync_script);
+    CHECK(chmod(rsync_path, 0700) == 0);
+
+    char *path = format_string("%s:%s", bin_path, getenv("PATH"));
+    CHECK(setenv("PATH", path, 1) == 0);
+
+    char *json = format_string(
+            "{\"local-workspace-root-path\": \"%s\", \"remote-systems\": [{\"remote-workspace-root-path\": \"/srv/ws\", "
+            "\"connection-type\": \"SSH_HOST_ALIAS\", \"connection-information\": {\"ssh-host-alias\": \"host\"}}]}",
+            workspace_path
+    );
+    char *error_msg = NULL;
+    WorkspaceInformation *ws_info = stringified_json_to_workspaceInformation(json, &error_msg);
+    CHECK(ws_info != NULL);
+
+    test_event_rate(ws_info);
+    test_merged_subtrees(ws_info);
+    test_lock_file();
+
+    leave_bulk_mode(ws_info);
+    release_remote_system_transport(ws_info->remote_systems);
+    destroy_workspaceInformation(&ws_info);
+    DO_FREE(json);
+    DO_FREE(path);
+    DO_FREE(rsync_script);
+    DO_FREE(rsync_path);
+    DO_FREE(bin_path);
+    DO_FREE(workspace_path);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+#include "../src/util/checksum_kernels.h"
+#include "test.h"
+
+/* Spans several hash blocks, so that the accumulators are scrambled in between */
+#define DATA_SIZE (3 * CHECKSUM_HASH_BLOCK_STRIPES * CHECKSUM_HASH_STRIPE_SIZE + 100)
+
+static void
+fill_random(unsigned char *data, const size_t size, uint64_t state)
+{
+    for (size_t i = 0; i < size; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        data[i] = (unsigned char) (state >> 56);
+    }
+}
+
+static void
+test_rolling_sums(const ChecksumKernels *scalar, const ChecksumKernels *kernels, const unsigned char *data)
+{
+    // Sizes around the vector widths exercise the scalar tail of the vectorized kernels
+    for (size_t size = 0; size <= 200; size++) {
+        uint32_t expected_a, expected_b, a, b;
+        scalar->rolling_sums(data, size, &expected_a, &expected_b);
+        kernels->rolling_sums(data, size, &a, &b);
+        CHECK(a == expected_a && b == expected_b);
+    }
+
+    uint32_t expected_a, expected_b, a, b;
+    scalar->rolling_sums(data, DATA_SIZE, &expected_a, &expected_b);
+    kernels->rolling_sums(data, DATA_SIZE, &a, &b);
+    CHECK(a == expected_a && b == expected_b);
+}
+
+static void
+hash_in_pieces(const ChecksumKernels *kernels, const unsigned char *data, const size_t stripe_count,
+               const size_t piece_stripes, uint64_t acc[CHECKSUM_HASH_LANES])
+{
+    for (int i = 0; i < CHECKSUM_HASH_LANES; i++) {
+        acc[i] = CHECKSUM_PRIME64_1 * (uint64_t) (i + 1);
+    }
+
+    uint32_t block_stripe = 0;
+    for (size_t stripe = 0; stripe < stripe_count; stripe += piece_stripes) {
+        const size_t count = (stripe + piece_stripes <= stripe_count) ? piece_stripes : stripe_count - stripe;
+        kernels->hash_stripes(acc, data + stripe * CHECKSUM_HASH_STRIPE_SIZE, count, &block_stripe);
+    }
+    CHECK(block_stripe == stripe_count % CHECKSUM_HASH_BLOCK_STRIPES);
+}
+
+static void
+test_hash_stripes(const ChecksumKernels *scalar, const ChecksumKernels *kernels, const unsigned char *data)
+{
+    const size_t stripe_count = DATA_SIZE / CHECKSUM_HASH_STRIPE_SIZE;
+
+    uint64_t expected[CHECKSUM_HASH_LANES];
+    hash_in_pieces(scalar, data, stripe_count, stripe_count, expected);
+
+    // Neither the variant nor the way the stripes are split up may change the accumulators
+    const size_t piece_sizes[] = {1, 3, CHECKSUM_HASH_BLOCK_STRIPES, CHECKSUM_HASH_BLOCK_STRIPES + 1, stripe_count};
+    for (size_t p = 0; p < sizeof(piece_sizes) / sizeof(piece_sizes[0]); p++) {
+        uint64_t acc[CHECKSUM_HASH_LANES];
+        hash_in_pieces(kernels, data, stripe_count, piece_sizes[p], acc);
+        CHECK(memcmp(acc, expected, sizeof(acc)) == 0);
+    }
+}
+
+static void
+test_hash_depends_on_every_lane(const ChecksumKernels *kernels, const unsigned char *data)
+{
+    uint64_t expected[CHECKSUM_HASH_LANES];
+    hash_in_pieces(kernels, data, 1, 1, expected);
+
+    unsigned char stripe[CHECKSUM_HASH_STRIPE_SIZE];
+    for (size_t i = 0; i < sizeof(stripe); i++) {
+        memcpy(stripe, data, sizeof(stripe));
+        stripe[i] ^= 1;
+
+        uint64_t acc[CHECKSUM_HASH_LANES];
+        hash_in_pieces(kernels, stripe, 1, 1, acc);
+        CHECK(memcmp(acc, expected, sizeof(acc)) != 0);
+    }
+}
+
+int
+main(void)
+{
+    static unsigned char data[DATA_SIZE];
+    fill_random(data, sizeof(data), 1);
+
+    size_t kernels_count;
+    const ChecksumKernels *const *kernels = get_supported_checksum_kernels(&kernels_count);
+    CHECK(kernels_count > 0 && get_checksum_kernels() == kernels[kernels_count - 1]);
+
+    for (size_t k = 0; k < kernels_count; k++) {
+        test_rolling_sums(kernels[0], kernels[k], data);
+        test_hash_stripes(kernels[0], kernels[k], data);
+        test_hash_depends_on_every_lane(kernels[k], data);
+    }
+    return EXIT_SUCCESS;
+}
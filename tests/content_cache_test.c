@@ -0,0 +1,182 @@
+#include "../src/server/content_cache.h"
+#include "test.h"
+
+/*
+ * Writes files of a temporary workspace and checks which of the writes the content cache recognizes as no-ops.
+ */
+
+static char root[] = "/tmp/resync-content-cache-XXXXXX";
+
+static char *
+write_file(const char *relative_path, const char *content, const time_t mtime_sec)
+{
+    char *path = concat_paths(root, relative_path);
+    FILE *file = fopen(path, "w");
+    CHECK(file != NULL);
+    CHECK(fputs(content, file) >= 0);
+    CHECK(fclose(file) == 0);
+
+    const struct timespec times[2] = {{.tv_sec = mtime_sec, .tv_nsec = 0}, {.tv_sec = mtime_sec, .tv_nsec = 0}};
+    CHECK(utimensat(AT_FDCWD, path, times, 0) == 0);
+    return path;
+}
+
+/*
+ * Writes the file and checks whether the write is recognized as a no-op. The write is recorded as synced otherwise.
+ */
+static bool
+is_write_unchanged(ContentCache *cache, const char *relative_path, const char *content, const time_t mtime_sec)
+{
+    char *path = write_file(relative_path, content, mtime_sec);
+
+    ContentFingerprint fingerprint;
+    const bool is_unchanged = is_content_unchanged(cache, relative_path, path, &fingerprint);
+    if (!is_unchanged) {
+        record_synced_content(cache, relative_path, path, &fingerprint);
+    }
+
+    DO_FREE(path);
+    return is_unchanged;
+}
+
+static void
+test_writes(void)
+{
+    ContentCache *cache = create_content_cache();
+
+    CHECK(!is_write_unchanged(cache, "file", "content", 1000));
+    CHECK(HASH_COUNT(cache->entries) == 1);
+
+    // Rewriting the same content is a no-op, whether or not the modification time changed
+    CHECK(is_write_unchanged(cache, "file", "content", 1000));
+    CHECK(is_write_unchanged(cache, "file", "content", 2000));
+    CHECK(is_write_unchanged(cache, "file", "content", 2000));
+
+    // Content of the same size is compared by its hash
+    CHECK(!is_write_unchanged(cache, "file", "CONTENT", 3000));
+    CHECK(!is_write_unchanged(cache, "file", "content", 4000));
+    CHECK(!is_write_unchanged(cache, "file", "longer content", 5000));
+
+    // A file that changed after it was fingerprinted is not cached, as the remote content is unknown
+    char *path = write_file("racy", "content", 1000);
+    ContentFingerprint fingerprint;
+    CHECK(!is_content_unchanged(cache, "racy", path, &fingerprint) && fingerprint.is_hashed);
+    DO_FREE(path);
+    path = write_file("racy", "changed", 2000);
+    record_synced_content(cache, "racy", path, &fingerprint);
+    CHECK(HASH_COUNT(cache->entries) == 1);
+    DO_FREE(path);
+
+    // Only regular files are cached
+    char *link_path = concat_paths(root, "link");
+    char *file_path = concat_paths(root, "file");
+    CHECK(symlink(file_path, link_path) == 0);
+    CHECK(!is_content_unchanged(cache, "link", link_path, &fingerprint) && !fingerprint.is_hashed);
+    CHECK(!is_content_unchanged(cache, "missing", "/nonexistent", &fingerprint) && !fingerprint.is_hashed);
+    DO_FREE(file_path);
+    DO_FREE(link_path);
+
+    destroy_content_cache(&cache);
+    CHECK(cache == NULL);
+}
+
+static void
+test_invalidation(void)
+{
+    ContentCache *cache = create_content_cache();
+    char *dir_path = concat_paths(root, "dir");
+    char *other_dir_path = concat_paths(root, "dirx");
+    CHECK(mkdir(dir_path, 0700) == 0 && mkdir(other_dir_path, 0700) == 0);
+
+    CHECK(!is_write_unchanged(cache, "dir/a", "a", 1000));
+    CHECK(!is_write_unchanged(cache, "dir/b", "b", 1000));
+    CHECK(!is_write_unchanged(cache, "dirx/c", "c", 1000));
+    CHECK(HASH_COUNT(cache->entries) == 3);
+
+    // A directory takes everything below it with it, but not its siblings that share its name as a prefix
+    invalidate_cached_content(cache, "dir", true);
+    CHECK(HASH_COUNT(cache->entries) == 1);
+    CHECK(!is_write_unchanged(cache, "dir/a", "a", 1000));
+
+    invalidate_cached_content(cache, "dir/a", false);
+    CHECK(!is_write_unchanged(cache, "dir/a", "a", 1000));
+
+    clear_content_cache(cache);
+    CHECK(cache->entries == NULL && cache->is_modified);
+
+    destroy_content_cache(&cache);
+    DO_FREE(other_dir_path);
+    DO_FREE(dir_path);
+}
+
+static void
+test_persistence(void)
+{
+    WorkspaceInformation ws_info = {.local_workspace_root_path = root};
+    char *error_msg = NULL;
+
+    CHECK(load_content_cache(&ws_info, &error_msg) == NULL && error_msg == NULL);
+
+    ContentCache *cache = create_content_cache();
+    CHECK(!is_write_unchanged(cache, "kept", "kept", 1000));
+    CHECK(!is_write_unchanged(cache, "changed", "changed", 1000));
+    CHECK(store_content_cache(cache, &ws_info, &error_msg));
+    CHECK(!cache->is_modified);
+    destroy_content_cache(&cache);
+
+    // Files that changed while the cache was not maintained are dropped when it is loaded
+    char *path = write_file("changed", "changed", 2000);
+    DO_FREE(path);
+    cache = load_content_cache(&ws_info, &error_msg);
+    CHECK(cache != NULL && !cache->is_modified);
+    CHECK(HASH_COUNT(cache->entries) == 1);
+    CHECK(is_write_unchanged(cache, "kept", "kept", 1000));
+
+    // An unmodified cache is not written again
+    char *cache_path = format_string(
+            "%s/%016llx.contents",
+            DEFAULT_RESYNC_SYNC_STATE_DIRECTORY,
+            (unsigned long long) hash_string(root)
+    );
+    CHECK(unlink(cache_path) == 0);
+    CHECK(store_content_cache(cache, &ws_info, &error_msg));
+    CHECK(access(cache_path, F_OK) == -1);
+
+    // Neither is the cache of another workspace loaded, should their file names collide
+    cache->is_modified = true;
+    CHECK(store_content_cache(cache, &ws_info, &error_msg));
+    char *other_cache_path = format_string(
+            "%s/%016llx.contents",
+            DEFAULT_RESYNC_SYNC_STATE_DIRECTORY,
+            (unsigned long long) hash_string("/other")
+    );
+    CHECK(rename(cache_path, other_cache_path) == 0);
+    const WorkspaceInformation other_ws_info = {.local_workspace_root_path = "/other"};
+    CHECK(load_content_cache(&other_ws_info, &error_msg) == NULL && error_msg != NULL);
+    DO_FREE(error_msg);
+    CHECK(unlink(other_cache_path) == 0);
+
+    DO_FREE(other_cache_path);
+    DO_FREE(cache_path);
+    destroy_content_cache(&cache);
+}
+
+static void
+clean_up(void)
+{
+    char *command = format_string("rm -rf '%s'", root);
+    system(command);
+    DO_FREE(command);
+}
+
+int
+main(void)
+{
+    CHECK(mkdtemp(root) != NULL);
+    CHECK(atexit(clean_up) == 0);
+
+    test_writes();
+    test_invalidation();
+    test_persistence();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,324 @@
+#include "../src/socket.h"
+#include "../src/util/fs_util.h"
+#include "../src/util/string.h"
+#include "../src/util/memory.h"
+#include "test.h"
+
+#include <time.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+/*
+ * Runs the daemon, whose path is passed in the 'RESYNC_DAEMON' environment variable, with a single workspace that is
+ *  mirrored to a local path, and checks how it supervises the workspace monitor, whose path is passed in the
+ *  'RESYNC_MONITOR' environment variable. The test process is a child subreaper, so that the daemon and the monitors,
+ *  which are detached from their parents, become its children once these terminated.
+ */
+
+#define WAIT_TIMEOUT_SEC 10
+
+static char daemon_path[PATH_MAX];
+static char monitor_path[PATH_MAX];
+static char root[] = "/tmp/resync-daemon-XXXXXX";
+
+static void
+write_file(const char *path, const char *content)
+{
+    FILE *file = fopen(path, "w");
+    CHECK(file != NULL);
+    CHECK(fputs(content, file) >= 0);
+    CHECK(fclose(file) == 0);
+}
+
+/*
+ * @return the child of the test process that runs the executable, other than the excluded one, or -1 if there is none
+ */
+static pid_t
+find_child(const char *executable_path, const pid_t excluded_pid)
+{
+    DIR *proc_dir = opendir("/proc");
+    CHECK(proc_dir != NULL);
+
+    pid_t found_pid = -1;
+    struct dirent *dir_entry;
+    while (found_pid == -1 && (dir_entry = readdir(proc_dir)) != NULL) {
+        const pid_t pid = (pid_t) strtol(dir_entry->d_name, NULL, 10);
+        if (pid <= 0 || pid == excluded_pid) {
+            continue;
+        }
+
+        // The name of the executable in parentheses may contain spaces, the parent PID follows the state after it
+        char *stat_path = format_string("/proc/%d/stat", pid);
+        char *exe_path = format_string("/proc/%d/exe", pid);
+        char stat[512], exe[PATH_MAX];
+        const int stat_fd = open(stat_path, O_RDONLY);
+        const ssize_t stat_size = (stat_fd == -1) ? -1 : read(stat_fd, stat, sizeof(stat) - 1);
+        const ssize_t exe_size = readlink(exe_path, exe, sizeof(exe) - 1);
+        if (stat_fd != -1) {
+            close(stat_fd);
+        }
+        DO_FREE(exe_path);
+        DO_FREE(stat_path);
+
+        if (stat_size <= 0 || exe_size <= 0) {
+            continue;
+        }
+        stat[stat_size] = '\0';
+        exe[exe_size] = '\0';
+
+        const char *comm_end = strrchr(stat, ')');
+        char state;
+        pid_t parent_pid;
+        if (comm_end != NULL && sscanf(comm_end + 1, " %c %d", &state, &parent_pid) == 2 && state != 'Z'
+            && parent_pid == getpid() && is_equal(exe, executable_path)) {
+            found_pid = pid;
+        }
+    }
+
+    closedir(proc_dir);
+    return found_pid;
+}
+
+static pid_t
+wait_for_child(const char *executable_path, const pid_t excluded_pid)
+{
+    const time_t deadline = time(NULL) + WAIT_TIMEOUT_SEC;
+
+    pid_t pid;
+    while ((pid = find_child(executable_path, excluded_pid)) == -1 && time(NULL) < deadline) {
+        usleep(50 * 1000);
+    }
+
+    CHECK(pid != -1);
+    return pid;
+}
+
+static void
+terminate_child(const pid_t pid)
+{
+    CHECK(kill(pid, SIGTERM) == 0);
+    CHECK(waitpid(pid, NULL, 0) == pid);
+}
+
+/*
+ * Kills the daemon and the monitors that are left behind by a failed check, and removes the directory.
+ */
+static void
+clean_up(void)
+{
+    const char *executable_paths[] = {daemon_path, monitor_path};
+    for (size_t i = 0; i < sizeof(executable_paths) / sizeof(executable_paths[0]); i++) {
+        pid_t pid;
+        while ((pid = find_child(executable_paths[i], -1)) != -1) {
+            kill(pid, SIGKILL);
+            waitpid(pid, NULL, 0);
+        }
+    }
+
+    char *command = format_string("rm -rf '%s'", root);
+    system(command);
+    DO_FREE(command);
+}
+
+/*
+ * Starts the daemon in the directory of the test and waits until it runs in the background.
+ */
+static void
+start_daemon(void)
+{
+    const pid_t pid = fork();
+    CHECK(pid != -1);
+    if (pid == 0) {
+        const int null_fd = open("/dev/null", O_RDWR);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+
+        // The daemon finds its configuration file and the monitor relative to the directory it is started in
+        if (chdir(root) == -1) {
+            _exit(EXIT_FAILURE);
+        }
+
+        // Syncs to the mirror are not checked, so they succeed without transferring anything
+        char *path = format_string("%s/bin:%s", root, getenv("PATH"));
+        setenv("PATH", path, 1);
+
+        execl(daemon_path, daemon_path, "--restart-backoff-ms", "100", (char *) NULL);
+        _exit(EXIT_FAILURE);
+    }
+
+    int status;
+    CHECK(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+}
+
+/*
+ * Creates the workspace, its mirror, the configuration file and a link to the monitor in the directory of the test.
+ */
+static void
+create_daemon_directory(void)
+{
+    char *workspace_path = concat_paths(root, "workspace");
+    char *mirror_path = concat_paths(root, "mirror");
+    char *bin_path = concat_paths(root, "bin");
+    char *linux_path = concat_paths(root, "linux");
+    CHECK(mkdir(workspace_path, 0700) == 0 && mkdir(mirror_path, 0700) == 0);
+    CHECK(mkdir(bin_path, 0700) == 0 && mkdir(linux_path, 0700) == 0);
+
+    char *monitor_link_path = concat_paths(linux_path, "ws");
+    CHECK(symlink(monitor_path, monitor_link_path) == 0);
+
+    char *rsync_path = concat_paths(bin_path, "rsync");
+    write_file(rsync_path, "#!/bin/sh\nexit 0\n");
+    CHECK(chmod(rsync_path, 0700) == 0);
+
+    char *config_path = concat_paths(root, "resync.json");
+    char *config = format_string(
+            "[{\"local-workspace-root-path\": \"%s\", \"remote-systems\": [{\"remote-workspace-root-path\": \"%s\", "
+            "\"connection-type\": \"LOCAL_PATH\"}]}]",
+            workspace_path,
+            mirror_path
+    );
+    write_file(config_path, config);
+
+    DO_FREE(config);
+    DO_FREE(config_path);
+    DO_FREE(rsync_path);
+    DO_FREE(monitor_link_path);
+    DO_FREE(linux_path);
+    DO_FREE(bin_path);
+    DO_FREE(mirror_path);
+    DO_FREE(workspace_path);
+}
+
+static pid_t
+test_crashed_monitor_is_restarted(const pid_t monitor_pid)
+{
+    CHECK(kill(monitor_pid, SIGKILL) == 0);
+    CHECK(waitpid(monitor_pid, NULL, 0) == monitor_pid);
+
+    return wait_for_child(monitor_path, monitor_pid);
+}
+
+/*
+ * @return the number of command line arguments of the process
+ */
+static int
+count_arguments(const pid_t pid)
+{
+    char *cmdline_path = format_string("/proc/%d/cmdline", pid);
+    char cmdline[1024];
+    const int cmdline_fd = open(cmdline_path, O_RDONLY);
+    CHECK(cmdline_fd != -1);
+    const ssize_t cmdline_size = read(cmdline_fd, cmdline, sizeof(cmdline));
+    close(cmdline_fd);
+    DO_FREE(cmdline_path);
+
+    int count = 0;
+    for (ssize_t i = 0; i < cmdline_size; i++) {
+        count += (cmdline[i] == '\0');
+    }
+    return count;
+}
+
+static pid_t
+test_reload_hands_over_watch_state(const pid_t daemon_pid, pid_t monitor_pid)
+{
+    const time_t deadline = time(NULL) + WAIT_TIMEOUT_SEC;
+
+    // A monitor that did not finish its initial sync yet is restarted from scratch, so the reload is repeated until
+    //  the monitor is replaced by one that received the inotify instance and watch state of its predecessor
+    while (true) {
+        CHECK(kill(daemon_pid, SIGHUP) == 0);
+        CHECK(waitpid(monitor_pid, NULL, 0) == monitor_pid);
+        monitor_pid = wait_for_child(monitor_path, monitor_pid);
+
+        if (count_arguments(monitor_pid) == 5) {
+            return monitor_pid;
+        }
+
+        CHECK(time(NULL) < deadline);
+        usleep(100 * 1000);
+    }
+}
+
+/*
+ * Sends the command to the daemon, like the client does.
+ */
+static void
+send_command(const char *command)
+{
+    const int socket_fd = create_unix_client_socket(DEFAULT_RESYNC_DAEMON_SOCKET_PATH);
+    CHECK(socket_fd != -1);
+    CHECK(write_all(socket_fd, command, strlen(command)));
+
+    char response[1024];
+    const ssize_t response_size = read(socket_fd, response, sizeof(response) - 1);
+    close(socket_fd);
+    CHECK(response_size > 0);
+
+    response[response_size] = '\0';
+    CHECK(strncmp(response, "Successfully", strlen("Successfully")) == 0);
+}
+
+static void
+test_added_remote_system_is_bootstrapped(void)
+{
+    char *workspace_path = concat_paths(root, "workspace");
+    char *file_path = concat_paths(workspace_path, "file");
+    char *mirror_path = concat_paths(root, "added-mirror");
+    char *mirrored_file_path = concat_paths(mirror_path, "file");
+    write_file(file_path, "content");
+
+    char *command = format_string(
+            "{\"type\": \"add-remote-system\", \"command-metadata\": {\"local-workspace-root-path\": \"%s\", "
+            "\"remote-systems\": [{\"remote-workspace-root-path\": \"%s\", \"connection-type\": \"LOCAL_PATH\"}]}}\r\n",
+            workspace_path,
+            mirror_path
+    );
+    send_command(command);
+
+    // Syncs by rsync do not transfer anything, so the file only reaches the mirror if the mirror is bootstrapped
+    const time_t deadline = time(NULL) + WAIT_TIMEOUT_SEC;
+    while (access(mirrored_file_path, F_OK) == -1 && time(NULL) < deadline) {
+        usleep(50 * 1000);
+    }
+    CHECK(access(mirrored_file_path, F_OK) == 0);
+
+    DO_FREE(command);
+    DO_FREE(mirrored_file_path);
+    DO_FREE(mirror_path);
+    DO_FREE(file_path);
+    DO_FREE(workspace_path);
+}
+
+int
+main(void)
+{
+    const char *daemon_env = getenv("RESYNC_DAEMON");
+    const char *monitor_env = getenv("RESYNC_MONITOR");
+    CHECK(daemon_env != NULL && monitor_env != NULL);
+    CHECK(realpath(daemon_env, daemon_path) != NULL && realpath(monitor_env, monitor_path) != NULL);
+
+    CHECK(mkdtemp(root) != NULL);
+    CHECK(atexit(clean_up) == 0);
+    create_daemon_directory();
+
+    CHECK(prctl(PR_SET_CHILD_SUBREAPER, 1) == 0);
+    start_daemon();
+    const pid_t daemon_pid = wait_for_child(daemon_path, -1);
+    pid_t monitor_pid = wait_for_child(monitor_path, -1);
+
+    monitor_pid = test_crashed_monitor_is_restarted(monitor_pid);
+    monitor_pid = test_reload_hands_over_watch_state(daemon_pid, monitor_pid);
+    test_added_remote_system_is_bootstrapped();
+
+    // The daemon leaves the monitors running when it terminates
+    terminate_child(daemon_pid);
+    terminate_child(monitor_pid);
+    return EXIT_SUCCESS;
+}
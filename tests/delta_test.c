@@ -0,0 +1,221 @@
+#include "../src/server/delta.h"
+#include "test.h"
+
+#include <unistd.h>
+#include <sys/mman.h>
+
+/* Reconstructs the file from the base and the delta, as the agent does */
+typedef struct Reconstruction {
+    const unsigned char *base;
+    uint32_t block_size;
+    ByteBuffer *file;
+    uint32_t copied_blocks;
+    uint32_t literal_size;
+} Reconstruction;
+
+static bool
+apply_copy(void *ctx, const uint32_t block_index, const uint32_t block_count)
+{
+    Reconstruction *reconstruction = (Reconstruction *) ctx;
+    byte_buffer_append(
+            reconstruction->file,
+            reconstruction->base + (size_t) block_index * reconstruction->block_size,
+            (size_t) block_count * reconstruction->block_size
+    );
+    reconstruction->copied_blocks += block_count;
+    return true;
+}
+
+static bool
+apply_literal(void *ctx, const char *data, const uint32_t size)
+{
+    Reconstruction *reconstruction = (Reconstruction *) ctx;
+    CHECK(size <= DELTA_MAX_LITERAL_SIZE);
+    byte_buffer_append(reconstruction->file, data, size);
+    reconstruction->literal_size += size;
+    return true;
+}
+
+static int
+create_file(const unsigned char *data, const size_t size)
+{
+    const int fd = memfd_create("delta-test", 0);
+    CHECK(fd != -1);
+    CHECK(write(fd, data, size) == (ssize_t) size);
+    CHECK(lseek(fd, 0, SEEK_SET) == 0);
+    return fd;
+}
+
+static void
+fill_random(unsigned char *data, const size_t size, uint64_t seed)
+{
+    for (size_t i = 0; i < size; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        data[i] = (unsigned char) seed;
+    }
+}
+
+/*
+ * Sends the signature of the base over the wire format, encodes the file as delta against it and checks that applying
+ *  the delta to the base yields the file.
+ *
+ * @return the reconstruction, whose buffer has to be destroyed by the caller
+ */
+static Reconstruction
+round_trip(const unsigned char *base, const size_t base_size, const unsigned char *file, const size_t file_size)
+{
+    char *error_msg = NULL;
+
+    const int base_fd = create_file(base, base_size);
+    FileSignature *signature = compute_file_signature(base_fd, base_size, &error_msg);
+    close(base_fd);
+    CHECK(signature != NULL);
+    CHECK(signature->block_size == get_delta_block_size(base_size));
+    CHECK(signature->block_count == base_size / signature->block_size);
+
+    ByteBuffer *encoded_signature = create_byte_buffer(1024);
+    append_file_signature(encoded_signature, signature);
+    ByteBufferReader reader = create_byte_buffer_reader(encoded_signature->data, encoded_signature->size);
+    FileSignature *received_signature = read_file_signature(&reader);
+    CHECK(received_signature != NULL && !reader.error);
+    CHECK(received_signature->block_size == signature->block_size);
+    CHECK(received_signature->block_count == signature->block_count);
+    for (uint32_t i = 0; i < signature->block_count; i++) {
+        CHECK(received_signature->blocks[i].weak == signature->blocks[i].weak);
+        CHECK(received_signature->blocks[i].strong == signature->blocks[i].strong);
+    }
+    destroy_byte_buffer(&encoded_signature);
+    destroy_file_signature(&signature);
+
+    Reconstruction reconstruction = {
+            .base = base,
+            .block_size = received_signature->block_size,
+            .file = create_byte_buffer(file_size + 1)
+    };
+    const DeltaEmitter emitter = {.copy = apply_copy, .literal = apply_literal, .ctx = &reconstruction};
+
+    const int file_fd = create_file(file, file_size);
+    uint64_t generated_size, generated_hash;
+    CHECK(generate_delta(file_fd, received_signature, &emitter, &generated_size, &generated_hash, &error_msg));
+    close(file_fd);
+    destroy_file_signature(&received_signature);
+
+    CHECK(generated_size == file_size);
+    CHECK(generated_hash == delta_hash(file, file_size));
+    CHECK(reconstruction.file->size == file_size);
+    CHECK(memcmp(reconstruction.file->data, file, file_size) == 0);
+
+    return reconstruction;
+}
+
+static void
+test_unchanged_file_is_copied(void)
+{
+    const size_t size = 256 * 1024;
+    unsigned char *base = (unsigned char *) do_malloc(size);
+    fill_random(base, size, 1);
+
+    Reconstruction reconstruction = round_trip(base, size, base, size);
+    CHECK(reconstruction.literal_size == 0);
+
+    destroy_byte_buffer(&reconstruction.file);
+    DO_FREE(base);
+}
+
+static void
+test_modified_file(void)
+{
+    const size_t base_size = 256 * 1024 + 123;
+    unsigned char *base = (unsigned char *) do_malloc(base_size);
+    fill_random(base, base_size, 2);
+
+    // Bytes are inserted and removed, so that all following blocks are found at unaligned offsets
+    const size_t file_size = base_size + 7 - 100;
+    unsigned char *file = (unsigned char *) do_malloc(file_size);
+    memcpy(file, base, 1000);
+    memcpy(file + 1000, "inserted", 7);
+    memcpy(file + 1007, base + 1000, 100 * 1024);
+    memcpy(file + 1007 + 100 * 1024, base + 1000 + 100 * 1024 + 100, base_size - 1000 - 100 * 1024 - 100);
+
+    Reconstruction reconstruction = round_trip(base, base_size, file, file_size);
+    CHECK(reconstruction.copied_blocks > 0);
+    CHECK(reconstruction.literal_size < file_size / 4);
+
+    destroy_byte_buffer(&reconstruction.file);
+    DO_FREE(file);
+    DO_FREE(base);
+}
+
+static void
+test_unrelated_and_empty_files(void)
+{
+    const size_t size = 64 * 1024;
+    unsigned char *base = (unsigned char *) do_malloc(size);
+    unsigned char *file = (unsigned char *) do_malloc(size);
+    fill_random(base, size, 3);
+    fill_random(file, size, 4);
+
+    Reconstruction reconstruction = round_trip(base, size, file, size);
+    CHECK(reconstruction.copied_blocks == 0);
+    destroy_byte_buffer(&reconstruction.file);
+
+    reconstruction = round_trip(base, size, file, 0);
+    CHECK(reconstruction.file->size == 0);
+    destroy_byte_buffer(&reconstruction.file);
+
+    reconstruction = round_trip(base, 0, file, size);
+    CHECK(reconstruction.literal_size == size);
+    destroy_byte_buffer(&reconstruction.file);
+
+    DO_FREE(file);
+    DO_FREE(base);
+}
+
+static void
+test_rolling_checksum(void)
+{
+    const uint32_t block_size = 1024;
+    unsigned char data[4096];
+    fill_random(data, sizeof(data), 5);
+
+    // Rolling the window has to yield the checksum of the block at the new position
+    RollingChecksum rolled;
+    rolling_checksum_init(&rolled, data, block_size);
+    for (size_t offset = 1; offset + block_size <= sizeof(data); offset++) {
+        rolling_checksum_roll(&rolled, data[offset - 1], data[offset + block_size - 1]);
+
+        RollingChecksum computed;
+        rolling_checksum_init(&computed, data + offset, block_size);
+        CHECK(rolling_checksum_value(&rolled) == rolling_checksum_value(&computed));
+    }
+}
+
+static void
+test_incremental_hash(void)
+{
+    unsigned char data[1000];
+    fill_random(data, sizeof(data), 6);
+
+    // The hash must not depend on how the data is split up
+    DeltaHashState state;
+    delta_hash_init(&state);
+    for (size_t offset = 0, chunk = 1; offset < sizeof(data); offset += chunk, chunk = chunk * 2 + 1) {
+        const size_t size = (offset + chunk <= sizeof(data)) ? chunk : sizeof(data) - offset;
+        delta_hash_update(&state, data + offset, size);
+    }
+    CHECK(delta_hash_digest(&state) == delta_hash(data, sizeof(data)));
+    CHECK(delta_hash(data, sizeof(data)) != delta_hash(data, sizeof(data) - 1));
+}
+
+int
+main(void)
+{
+    test_rolling_checksum();
+    test_incremental_hash();
+    test_unchanged_file_is_copied();
+    test_modified_file();
+    test_unrelated_and_empty_files();
+    return EXIT_SUCCESS;
+}
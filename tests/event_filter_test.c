@@ -0,0 +1,58 @@
+#include "../src/server/linux/event_filter.h"
+#include "test.h"
+
+/*
+ * Classifies inotify events of the files that editors produce while saving and of regular files.
+ */
+
+static void
+test_editor_files(void)
+{
+    const uint32_t mask = IN_CLOSE_WRITE;
+
+    CHECK(filter_event(mask, ".main.c.swp") == EVENT_FILTER_SWAP_FILE);
+    CHECK(filter_event(mask, ".main.c.swx") == EVENT_FILTER_SWAP_FILE);
+    CHECK(filter_event(mask, "main.c.kate-swp") == EVENT_FILTER_SWAP_FILE);
+    CHECK(filter_event(mask, "main.c~") == EVENT_FILTER_BACKUP_FILE);
+    CHECK(filter_event(mask, "4913") == EVENT_FILTER_WRITE_PROBE);
+    CHECK(filter_event(mask, ".#main.c") == EVENT_FILTER_EDITOR_LOCK_FILE);
+    CHECK(filter_event(mask, "#main.c#") == EVENT_FILTER_EDITOR_LOCK_FILE);
+    CHECK(filter_event(mask, "main.c___jb_tmp___") == EVENT_FILTER_ATOMIC_SAVE_FILE);
+    CHECK(filter_event(mask, ".goutputstream-ABC123") == EVENT_FILTER_ATOMIC_SAVE_FILE);
+
+    // Names that merely resemble them pass, e.g. the prefix and the suffix of a rule must not overlap
+    CHECK(filter_event(mask, "main.c") == EVENT_FILTER_PASSED);
+    CHECK(filter_event(mask, "main.swp") == EVENT_FILTER_PASSED);
+    CHECK(filter_event(mask, "49130") == EVENT_FILTER_PASSED);
+    CHECK(filter_event(mask, "#") == EVENT_FILTER_PASSED);
+    CHECK(filter_event(mask, "#include") == EVENT_FILTER_PASSED);
+    CHECK(filter_event(mask, ".gitignore") == EVENT_FILTER_PASSED);
+    CHECK(filter_event(mask, ".swp") == EVENT_FILTER_PASSED);
+    CHECK(filter_event(mask, "") == EVENT_FILTER_PASSED);
+}
+
+static void
+test_masks(void)
+{
+    // Created files are synced once they are closed after writing
+    CHECK(filter_event(IN_CREATE, "main.c") == EVENT_FILTER_FILE_CREATED);
+    CHECK(filter_event(IN_MOVED_TO, "main.c") == EVENT_FILTER_PASSED);
+    CHECK(filter_event(IN_DELETE, "main.c") == EVENT_FILTER_PASSED);
+
+    // Directories and events of the watched directory itself are never discarded, whatever their name
+    CHECK(filter_event(IN_CREATE | IN_ISDIR, "src") == EVENT_FILTER_PASSED);
+    CHECK(filter_event(IN_CREATE | IN_ISDIR, "backup~") == EVENT_FILTER_PASSED);
+    CHECK(filter_event(IN_DELETE_SELF, NULL) == EVENT_FILTER_PASSED);
+}
+
+int
+main(void)
+{
+    test_editor_files();
+    test_masks();
+
+    // Reporting twice without any events in between is allowed
+    report_filtered_events();
+    report_filtered_events();
+    return EXIT_SUCCESS;
+}
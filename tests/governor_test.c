@@ -0,0 +1,133 @@
+#include "../src/server/governor.h"
+#include "test.h"
+
+/*
+ * Requests sync leases for several workspaces and checks the limits and the share of each workspace.
+ */
+
+typedef struct GrantedLeases {
+    int count;
+    const char *last_ws_path;
+    const char *last_host;
+} GrantedLeases;
+
+static void
+grant(const char *ws_path, const char *host, void *context)
+{
+    GrantedLeases *leases = (GrantedLeases *) context;
+    leases->count++;
+    leases->last_ws_path = ws_path;
+    leases->last_host = host;
+}
+
+static void
+test_limits(void)
+{
+    SyncGovernor *governor = create_sync_governor(3, 2);
+    GrantedLeases leases = {.count = 0};
+
+    request_sync_lease(governor, "/a", 1, "build");
+    request_sync_lease(governor, "/b", 1, "build");
+    request_sync_lease(governor, "/c", 1, "build");
+    request_sync_lease(governor, "/c", 1, "backup");
+    request_sync_lease(governor, "/d", 1, "archive");
+    request_sync_lease(governor, "/e", 1, "archive");
+
+    // Neither limit is exceeded, and the oldest request of a workspace blocks its later ones
+    dispatch_sync_leases(governor, grant, &leases);
+    CHECK(leases.count == 3);
+    CHECK(governor->leases_in_flight == 3);
+
+    // A returned lease makes room for exactly one more
+    dispatch_sync_leases(governor, grant, &leases);
+    CHECK(leases.count == 3);
+    release_sync_lease(governor, leases.last_ws_path, leases.last_host);
+    CHECK(governor->leases_in_flight == 2);
+    dispatch_sync_leases(governor, grant, &leases);
+    CHECK(leases.count == 4);
+
+    // Releasing a lease that was not granted has no effect
+    release_sync_lease(governor, "/unknown", "build");
+    release_sync_lease(governor, leases.last_ws_path, "elsewhere");
+    CHECK(governor->leases_in_flight == 3);
+
+    destroy_sync_governor(&governor);
+    CHECK(governor == NULL);
+}
+
+static void
+test_release_all(void)
+{
+    SyncGovernor *governor = create_sync_governor(1, 1);
+    GrantedLeases leases = {.count = 0};
+
+    request_sync_lease(governor, "/a", 1, "build");
+    dispatch_sync_leases(governor, grant, &leases);
+    request_sync_lease(governor, "/a", 1, "build");
+    request_sync_lease(governor, "/b", 1, "build");
+
+    // A terminated monitor returns its granted leases and withdraws its pending ones
+    release_all_sync_leases(governor, "/a");
+    CHECK(governor->leases_in_flight == 0);
+    dispatch_sync_leases(governor, grant, &leases);
+    CHECK(leases.count == 2 && is_equal(leases.last_ws_path, "/b"));
+
+    release_sync_lease(governor, "/b", "build");
+    dispatch_sync_leases(governor, grant, &leases);
+    CHECK(leases.count == 2);
+
+    destroy_sync_governor(&governor);
+}
+
+static void
+test_weighted_fairness(void)
+{
+    SyncGovernor *governor = create_sync_governor(1, 1);
+    GrantedLeases leases = {.count = 0};
+
+    // A workspace with twice the weight is granted twice as many leases while both compete
+    const int grants_count = 30;
+    for (int i = 0; i < grants_count; i++) {
+        request_sync_lease(governor, "/heavy", 2, "build");
+        request_sync_lease(governor, "/heavy", 2, "build");
+        request_sync_lease(governor, "/light", 1, "build");
+    }
+
+    int heavy_count = 0;
+    for (int i = 0; i < grants_count; i++) {
+        dispatch_sync_leases(governor, grant, &leases);
+        CHECK(leases.count == i + 1);
+        heavy_count += is_equal(leases.last_ws_path, "/heavy");
+        release_sync_lease(governor, leases.last_ws_path, leases.last_host);
+    }
+    CHECK(heavy_count >= 19 && heavy_count <= 21);
+
+    // A workspace that did not compete meanwhile does not catch up on the leases it missed
+    release_all_sync_leases(governor, "/light");
+    for (int i = 0; i < grants_count; i++) {
+        dispatch_sync_leases(governor, grant, &leases);
+        release_sync_lease(governor, leases.last_ws_path, leases.last_host);
+    }
+    for (int i = 0; i < 4; i++) {
+        request_sync_lease(governor, "/light", 1, "build");
+    }
+
+    int light_count = 0;
+    for (int i = 0; i < 6; i++) {
+        dispatch_sync_leases(governor, grant, &leases);
+        light_count += is_equal(leases.last_ws_path, "/light");
+        release_sync_lease(governor, leases.last_ws_path, leases.last_host);
+    }
+    CHECK(light_count >= 1 && light_count <= 3);
+
+    destroy_sync_governor(&governor);
+}
+
+int
+main(void)
+{
+    test_limits();
+    test_release_all();
+    test_weighted_fairness();
+    return EXIT_SUCCESS;
+}
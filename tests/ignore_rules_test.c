@@ -0,0 +1,168 @@
+#include "../src/util/ignore_rules.h"
+#include "test.h"
+
+#include <unistd.h>
+
+/*
+ * Compiles ignore patterns and checks which resources they exclude and the rsync filter rules they translate to.
+ */
+
+static IgnoreRules *
+compile(const char **lines, const size_t lines_count)
+{
+    IgnoreRules *rules = create_ignore_rules();
+    for (size_t i = 0; i < lines_count; i++) {
+        char *error_msg = NULL;
+        CHECK(add_ignore_pattern(rules, lines[i], &error_msg));
+        CHECK(error_msg == NULL);
+    }
+    return rules;
+}
+
+static void
+test_matching(void)
+{
+    const char *lines[] = {
+            "# comment",
+            "",
+            "*.o",
+            "!keep.o",
+            "build/",
+            "/target",
+            "docs/*.md",
+            "**/logs",
+            "a/**/b",
+            "[abc].txt",
+            "\\#literal",
+            "node_modules/"
+    };
+    IgnoreRules *rules = compile(lines, sizeof(lines) / sizeof(lines[0]));
+
+    // Comments and blank lines do not add rules
+    CHECK(rules->rules_count == 10);
+
+    // Patterns without a '/' match the name in any directory, the last matching pattern decides
+    CHECK(is_ignored(rules, NULL, "main.o", false));
+    CHECK(is_ignored(rules, "src/lib", "main.o", false));
+    CHECK(!is_ignored(rules, "src", "main.c", false));
+    CHECK(!is_ignored(rules, "src", "keep.o", false));
+
+    // A trailing '/' only matches directories
+    CHECK(is_ignored(rules, "src", "build", true));
+    CHECK(!is_ignored(rules, "src", "build", false));
+    CHECK(is_ignored(rules, "web", "node_modules", true));
+    CHECK(!is_ignored(rules, "web", "node_modules", false));
+
+    // Patterns with a '/' are anchored at the workspace root, where '*' does not match a '/'
+    CHECK(is_ignored(rules, NULL, "target", true));
+    CHECK(!is_ignored(rules, "sub", "target", true));
+    CHECK(is_ignored(rules, "docs", "index.md", false));
+    CHECK(!is_ignored(rules, "docs/api", "index.md", false));
+    CHECK(!is_ignored(rules, "sub/docs", "index.md", false));
+
+    // '**' matches any number of directories, including none
+    CHECK(is_ignored(rules, NULL, "logs", true));
+    CHECK(is_ignored(rules, "x/y", "logs", false));
+    CHECK(is_ignored(rules, "a", "b", false));
+    CHECK(is_ignored(rules, "a/x/y", "b", false));
+    CHECK(!is_ignored(rules, "x/a", "b", false));
+
+    // Character classes and escapes
+    CHECK(is_ignored(rules, NULL, "b.txt", false));
+    CHECK(!is_ignored(rules, NULL, "d.txt", false));
+    CHECK(is_ignored(rules, NULL, "#literal", false));
+
+    destroy_ignore_rules(&rules);
+    CHECK(rules == NULL);
+}
+
+static void
+test_malformed_patterns(void)
+{
+    IgnoreRules *rules = create_ignore_rules();
+    char *error_msg = NULL;
+
+    CHECK(!add_ignore_pattern(rules, "file\\", &error_msg));
+    CHECK(error_msg != NULL);
+    DO_FREE(error_msg);
+
+    CHECK(!add_ignore_pattern(rules, "[abc", &error_msg));
+    CHECK(error_msg != NULL);
+    DO_FREE(error_msg);
+
+    CHECK(rules->rules_count == 0);
+    destroy_ignore_rules(&rules);
+}
+
+static void
+test_ignore_file(void)
+{
+    char path[] = "/tmp/resync-ignore-XXXXXX";
+    const int fd = mkstemp(path);
+    CHECK(fd != -1);
+    const char content[] = "# generated\n*.tmp\ncache/\n";
+    CHECK(write(fd, content, strlen(content)) == (ssize_t) strlen(content));
+    close(fd);
+
+    IgnoreRules *rules = create_ignore_rules();
+    char *error_msg = NULL;
+    CHECK(add_ignore_file(rules, path, &error_msg));
+    CHECK(rules->rules_count == 2);
+    CHECK(is_ignored(rules, "x", "a.tmp", false) && is_ignored(rules, NULL, "cache", true));
+
+    // A missing file adds nothing, a malformed line is reported with its number
+    CHECK(add_ignore_file(rules, "/nonexistent/.resyncignore", &error_msg));
+    CHECK(rules->rules_count == 2);
+
+    FILE *file = fopen(path, "w");
+    CHECK(file != NULL && fputs("*.tmp\n[broken\n", file) >= 0 && fclose(file) == 0);
+    CHECK(!add_ignore_file(rules, path, &error_msg));
+    CHECK(error_msg != NULL && strstr(error_msg, "Line 2") != NULL);
+    DO_FREE(error_msg);
+
+    unlink(path);
+    destroy_ignore_rules(&rules);
+}
+
+static bool
+are_filter_rules(char **filter_rules, const char **expected_filter_rules, const size_t expected_count)
+{
+    bool is_equal_rules = true;
+    size_t count = 0;
+    for (char **filter_rule = filter_rules; *filter_rule != NULL; filter_rule++, count++) {
+        is_equal_rules &= (count < expected_count && is_equal(*filter_rule, expected_filter_rules[count]));
+        DO_FREE(*filter_rule);
+    }
+    DO_FREE(filter_rules);
+    return is_equal_rules && count == expected_count;
+}
+
+static void
+test_rsync_filter_rules(void)
+{
+    const char *lines[] = {"*.o", "!keep.o", "/target/", "docs/*.md", "**/gen", "\\*star"};
+    IgnoreRules *rules = compile(lines, sizeof(lines) / sizeof(lines[0]));
+
+    // rsync applies the first matching rule, and escapes of literal patterns are only resolved with wildcards present
+    const char *root_filter_rules[] = {"- \\*star", "- /**/gen", "- /gen", "- /docs/*.md", "- /target/", "+ keep.o", "- *.o"};
+    CHECK(are_filter_rules(get_rsync_filter_rules(rules, NULL), root_filter_rules, 7));
+
+    // Anchored patterns are made relative to the synced directory, or left out if they cannot match inside of it
+    const char *docs_filter_rules[] = {"- \\*star", "- /**/gen", "- /gen", "- /*.md", "+ keep.o", "- *.o"};
+    CHECK(are_filter_rules(get_rsync_filter_rules(rules, "docs"), docs_filter_rules, 6));
+
+    const char *no_filter_rules[] = {NULL};
+    CHECK(are_filter_rules(get_rsync_filter_rules(NULL, NULL), no_filter_rules, 0));
+
+    destroy_ignore_rules(&rules);
+}
+
+int
+main(void)
+{
+    test_matching();
+    test_malformed_patterns();
+    test_ignore_file();
+    test_rsync_filter_rules();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+#include "../src/server/linux/local_mirror.h"
+#include "test.h"
+
+/*
+ * Mirrors changes between two temporary directories and checks the content of the mirror.
+ */
+
+static void
+write_file(const char *path, const char *content)
+{
+    FILE *file = fopen(path, "w");
+    CHECK(file != NULL);
+    CHECK(fputs(content, file) >= 0);
+    CHECK(fclose(file) == 0);
+}
+
+static bool
+has_content(const char *path, const char *content)
+{
+    char buffer[256];
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return false;
+    }
+    const size_t size = fread(buffer, 1, sizeof(buffer) - 1, file);
+    fclose(file);
+
+    buffer[size] = '\0';
+    return strcmp(buffer, content) == 0;
+}
+
+static void
+test_file(const char *source_root, const char *mirror_root)
+{
+    char *source_path = concat_paths(source_root, "file");
+    char *target_path = concat_paths(mirror_root, "file");
+    char *error_msg = NULL;
+
+    write_file(source_path, "first version");
+    CHECK(mirror_local_file(source_path, target_path, &error_msg));
+    CHECK(has_content(target_path, "first version"));
+
+    // Replacing a larger file must not leave any of its data behind
+    write_file(source_path, "second");
+    CHECK(mirror_local_file(source_path, target_path, &error_msg));
+    CHECK(has_content(target_path, "second"));
+
+    struct stat source_stat, target_stat;
+    CHECK(stat(source_path, &source_stat) == 0 && stat(target_path, &target_stat) == 0);
+    CHECK(source_stat.st_mtim.tv_sec == target_stat.st_mtim.tv_sec);
+    CHECK(source_stat.st_mtim.tv_nsec == target_stat.st_mtim.tv_nsec);
+
+    // A source that vanished is skipped, its deletion is mirrored separately
+    char *missing_path = concat_paths(source_root, "missing");
+    char *missing_target_path = concat_paths(mirror_root, "missing");
+    CHECK(mirror_local_file(missing_path, missing_target_path, &error_msg));
+    CHECK(access(missing_target_path, F_OK) == -1);
+
+    CHECK(error_msg == NULL);
+    DO_FREE(missing_target_path);
+    DO_FREE(missing_path);
+    DO_FREE(target_path);
+    DO_FREE(source_path);
+}
+
+static void
+test_appended_data(const char *source_root, const char *mirror_root)
+{
+    char *source_path = concat_paths(source_root, "log");
+    char *target_path = concat_paths(mirror_root, "log");
+    char *error_msg = NULL;
+
+    write_file(source_path, "line 1\n");
+    CHECK(mirror_local_file(source_path, target_path, &error_msg));
+
+    write_file(source_path, "line 1\nline 2\n");
+    CHECK(mirror_local_appended_data(source_path, target_path, strlen("line 1\n"), &error_msg));
+    CHECK(has_content(target_path, "line 1\nline 2\n"));
+
+    // A target that does not end at the offset is left to rsync, whether it is shorter or would keep stale data
+    write_file(source_path, "line 1\nline 2\nline 3\n");
+    CHECK(!mirror_local_appended_data(source_path, target_path, strlen("line 1\n"), &error_msg));
+    write_file(target_path, "line 1\nline 2\nstale data\n");
+    CHECK(!mirror_local_appended_data(source_path, target_path, strlen("line 1\nline 2\n"), &error_msg));
+    CHECK(has_content(target_path, "line 1\nline 2\nstale data\n"));
+
+    CHECK(error_msg == NULL);
+    DO_FREE(target_path);
+    DO_FREE(source_path);
+}
+
+static void
+test_directory_mode_move_and_deletion(const char *mirror_root)
+{
+    char *directory_path = concat_paths(mirror_root, "dir");
+    char *nested_path = concat_paths(mirror_root, "dir/nested");
+    char *moved_path = concat_paths(mirror_root, "moved");
+    char *error_msg = NULL;
+
+    CHECK(mirror_local_directory(directory_path, 0750, &error_msg));
+    CHECK(mirror_local_directory(nested_path, 0700, &error_msg));
+
+    // Unlike 'mkdir', the mode is not subject to the umask, and an existing directory only gets its mode updated
+    struct stat directory_stat;
+    CHECK(mirror_local_directory(directory_path, 0755, &error_msg));
+    CHECK(stat(directory_path, &directory_stat) == 0 && (directory_stat.st_mode & 07777) == 0755);
+
+    // A directory whose parent is missing in the mirror is left to rsync
+    char *orphan_path = concat_paths(mirror_root, "missing/orphan");
+    CHECK(!mirror_local_directory(orphan_path, 0700, &error_msg));
+    CHECK(error_msg == NULL);
+
+    // Moving a directory onto a non-empty one replaces it
+    CHECK(mirror_local_directory(moved_path, 0700, &error_msg));
+    char *moved_content_path = concat_paths(mirror_root, "moved/stale");
+    write_file(moved_content_path, "stale");
+    CHECK(mirror_local_move(directory_path, moved_path, &error_msg));
+    CHECK(access(directory_path, F_OK) == -1);
+    CHECK(access(moved_content_path, F_OK) == -1);
+
+    char *moved_nested_path = concat_paths(mirror_root, "moved/nested");
+    CHECK(access(moved_nested_path, F_OK) == 0);
+
+    CHECK(mirror_local_mode(moved_path, 0700, &error_msg));
+    CHECK(stat(moved_path, &directory_stat) == 0 && (directory_stat.st_mode & 07777) == 0700);
+
+    CHECK(mirror_local_deletion(moved_path, &error_msg));
+    CHECK(access(moved_path, F_OK) == -1);
+    CHECK(mirror_local_deletion(moved_path, &error_msg));
+
+    CHECK(error_msg == NULL);
+    DO_FREE(moved_nested_path);
+    DO_FREE(moved_content_path);
+    DO_FREE(orphan_path);
+    DO_FREE(moved_path);
+    DO_FREE(nested_path);
+    DO_FREE(directory_path);
+}
+
+int
+main(void)
+{
+    char source_root[] = "/tmp/resync-mirror-source-XXXXXX";
+    char mirror_root[] = "/tmp/resync-mirror-target-XXXXXX";
+    CHECK(mkdtemp(source_root) != NULL && mkdtemp(mirror_root) != NULL);
+
+    test_file(source_root, mirror_root);
+    test_appended_data(source_root, mirror_root);
+    test_directory_mode_move_and_deletion(mirror_root);
+
+    char *command = format_string("rm -rf '%s' '%s'", source_root, mirror_root);
+    CHECK(system(command) == 0);
+    DO_FREE(command);
+    return EXIT_SUCCESS;
+}
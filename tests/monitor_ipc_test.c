@@ -0,0 +1,89 @@
+#include "../src/server/monitor_ipc.h"
+#include "test.h"
+
+#include <unistd.h>
+#include <sys/socket.h>
+
+/*
+ * Exchanges control messages over a connected pair of unix stream sockets, as the daemon and a monitor do.
+ */
+
+static void
+test_messages(const int daemon_fd, const int monitor_fd)
+{
+    char *error_msg = NULL;
+
+    CHECK(send_monitor_control_message(daemon_fd, MONITOR_SYNC_LEASE_GRANT, "host", strlen("host"), &error_msg));
+    CHECK(send_monitor_control_message(daemon_fd, MONITOR_HANDOFF_REQUEST, NULL, 0, &error_msg));
+
+    // Messages arrive in order, textual payloads are terminated
+    MonitorControlMessage *message = receive_monitor_control_message(monitor_fd, &error_msg);
+    CHECK(message != NULL && message->type == MONITOR_SYNC_LEASE_GRANT);
+    CHECK(message->payload_size == strlen("host") && strcmp(message->payload, "host") == 0);
+    destroy_monitor_control_message(&message);
+    CHECK(message == NULL);
+
+    message = receive_monitor_control_message(monitor_fd, &error_msg);
+    CHECK(message != NULL && message->type == MONITOR_HANDOFF_REQUEST && message->payload_size == 0);
+    destroy_monitor_control_message(&message);
+
+    // Binary payloads may contain NUL bytes
+    const char payload[] = {'a', '\0', 'b'};
+    CHECK(send_monitor_control_message(monitor_fd, MONITOR_HANDOFF_STATE, payload, sizeof(payload), &error_msg));
+    message = receive_monitor_control_message(daemon_fd, &error_msg);
+    CHECK(message != NULL && message->payload_size == sizeof(payload));
+    CHECK(memcmp(message->payload, payload, sizeof(payload)) == 0);
+    destroy_monitor_control_message(&message);
+
+    CHECK(!send_monitor_control_message(daemon_fd, MONITOR_ADD_REMOTE_SYSTEM, payload, MONITOR_CONTROL_MAX_PAYLOAD_SIZE + 1, &error_msg));
+    CHECK(error_msg != NULL);
+    DO_FREE(error_msg);
+}
+
+static void
+test_corrupted_and_closed_channels(void)
+{
+    char *error_msg = NULL;
+    int fds[2];
+
+    // A header that announces more than the maximum payload is rejected before anything is allocated
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    const MonitorControlMessageHeader header = {.type = MONITOR_ADD_REMOTE_SYSTEM, .payload_size = UINT32_MAX};
+    CHECK(write_all(fds[0], &header, sizeof(header)));
+    CHECK(receive_monitor_control_message(fds[1], &error_msg) == NULL);
+    CHECK(error_msg != NULL);
+    DO_FREE(error_msg);
+    close(fds[0]);
+    close(fds[1]);
+
+    // A payload that is cut short is an error
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    const MonitorControlMessageHeader truncated_header = {.type = MONITOR_ADD_REMOTE_SYSTEM, .payload_size = 10};
+    CHECK(write_all(fds[0], &truncated_header, sizeof(truncated_header)) && write_all(fds[0], "abc", 3));
+    close(fds[0]);
+    CHECK(receive_monitor_control_message(fds[1], &error_msg) == NULL);
+    CHECK(error_msg != NULL);
+    DO_FREE(error_msg);
+    close(fds[1]);
+
+    // A channel that is closed between messages is not
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    close(fds[0]);
+    CHECK(receive_monitor_control_message(fds[1], &error_msg) == NULL);
+    CHECK(error_msg == NULL);
+    close(fds[1]);
+}
+
+int
+main(void)
+{
+    int fds[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    test_messages(fds[0], fds[1]);
+    test_corrupted_and_closed_channels();
+
+    close(fds[0]);
+    close(fds[1]);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+#include "../src/util/path_trie.h"
+#include "test.h"
+
+static void
+count_and_increment_value(void **value, void *context)
+{
+    *value = (void *) ((intptr_t) *value + 1);
+    (*(int *) context)++;
+}
+
+static void
+test_insert_and_lookup(void)
+{
+    PathTrie *trie = create_path_trie();
+
+    CHECK(path_trie_insert(trie, "/home/user/ws", (void *) 1));
+    CHECK(path_trie_insert(trie, "/srv/data", (void *) 2));
+    CHECK(trie->size == 2);
+
+    // Empty segments are ignored, so the path is already contained
+    CHECK(!path_trie_insert(trie, "//home/user/ws/", (void *) 3));
+    CHECK(trie->size == 2);
+
+    void *value = NULL;
+    CHECK(path_trie_lookup(trie, "/home/user/ws", &value) && value == (void *) 3);
+    CHECK(path_trie_lookup(trie, "home/user/ws", NULL));
+    CHECK(!path_trie_lookup(trie, "/home/user", NULL));
+    CHECK(!path_trie_lookup(trie, "/home/user/ws/sub", NULL));
+    CHECK(!path_trie_lookup(trie, "/home/user/w", NULL));
+
+    destroy_path_trie(&trie);
+    CHECK(trie == NULL);
+}
+
+static void
+test_overlaps(void)
+{
+    PathTrie *trie = create_path_trie();
+    path_trie_insert(trie, "/home/user/ws", NULL);
+
+    CHECK(path_trie_overlaps(trie, "/home/user/ws"));
+    CHECK(path_trie_overlaps(trie, "/home/user/ws/sub/dir"));
+    CHECK(path_trie_overlaps(trie, "/home/user"));
+    CHECK(path_trie_overlaps(trie, "/home"));
+    CHECK(!path_trie_overlaps(trie, "/home/other"));
+    CHECK(!path_trie_overlaps(trie, "/home/user/wss"));
+    CHECK(!path_trie_overlaps(trie, "/srv"));
+
+    destroy_path_trie(&trie);
+}
+
+static void
+test_remove(void)
+{
+    PathTrie *trie = create_path_trie();
+    path_trie_insert(trie, "/home/user/ws", (void *) 1);
+    path_trie_insert(trie, "/home/user/ws/nested", (void *) 2);
+    path_trie_insert(trie, "/srv/data", (void *) 3);
+
+    void *value = NULL;
+    CHECK(path_trie_remove(trie, "/home/user/ws", &value) && value == (void *) 1);
+    CHECK(!path_trie_remove(trie, "/home/user/ws", NULL));
+    CHECK(trie->size == 2);
+
+    // The nested path keeps the nodes of its ancestors
+    CHECK(path_trie_lookup(trie, "/home/user/ws/nested", NULL));
+    CHECK(path_trie_overlaps(trie, "/home/user/ws"));
+
+    CHECK(path_trie_remove(trie, "/home/user/ws/nested", NULL));
+    CHECK(!path_trie_overlaps(trie, "/home"));
+    CHECK(trie->root->terminal_descendants == 1);
+    CHECK(HASH_COUNT(trie->root->children) == 1);
+
+    destroy_path_trie(&trie);
+}
+
+static void
+test_foreach_value(void)
+{
+    PathTrie *trie = create_path_trie();
+    path_trie_insert(trie, "/a", (void *) 10);
+    path_trie_insert(trie, "/a/b", (void *) 20);
+    path_trie_insert(trie, "/c", (void *) 30);
+
+    int count = 0;
+    path_trie_foreach_value(trie, count_and_increment_value, &count);
+    CHECK(count == 3);
+
+    void *value = NULL;
+    CHECK(path_trie_lookup(trie, "/a/b", &value) && value == (void *) 21);
+
+    destroy_path_trie(&trie);
+}
+
+int
+main(void)
+{
+    test_insert_and_lookup();
+    test_overlaps();
+    test_remove();
+    test_foreach_value();
+    return EXIT_SUCCESS;
+}
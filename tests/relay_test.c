@@ -0,0 +1,189 @@
+#include "../src/server/sync.h"
+#include "../src/types/mappers.h"
+#include "../src/util/fs_util.h"
+#include "test.h"
+
+#include <sys/stat.h>
+
+/*
+ * Validates the relay parents of workspace configurations and syncs a workspace through a relay. rsync and ssh are
+ *  replaced by fakes that record their arguments, so the sync on the relay is only checked as the command that is run
+ *  there.
+ */
+
+#define FAKE_SCRIPT "#!/bin/sh\necho \"$0 $@\" >> '%s/invocations'\nexit 0\n"
+
+#define RELAY_JSON \
+    "{\"remote-workspace-root-path\": \"/srv/relay\", \"connection-type\": \"SSH_HOST_ALIAS\", " \
+    "\"connection-information\": {\"ssh-host-alias\": \"relay\"}%s}"
+#define BEHIND_JSON \
+    "{\"remote-workspace-root-path\": \"%s\", \"connection-type\": \"LOCAL_PATH\", \"relay-parent\": \"%s\"%s}"
+
+static char root[] = "/tmp/resync-relay-XXXXXX";
+
+static void
+write_file(const char *path, const char *content)
+{
+    FILE *file = fopen(path, "w");
+    CHECK(file != NULL);
+    CHECK(fputs(content, file) >= 0);
+    CHECK(fclose(file) == 0);
+}
+
+static WorkspaceInformation *
+parse_workspace(const char *ws_path, const char *remote_systems_json, char **error_msg)
+{
+    char *json = format_string(
+            "{\"local-workspace-root-path\": \"%s\", \"remote-systems\": [%s]}",
+            ws_path,
+            remote_systems_json
+    );
+    WorkspaceInformation *ws_info = stringified_json_to_workspaceInformation(json, error_msg);
+    DO_FREE(json);
+    return ws_info;
+}
+
+/*
+ * @return whether the workspace with the relay and the remote system behind it is rejected
+ */
+static bool
+is_rejected(const char *relay_options, const char *relay_parent, const char *behind_options)
+{
+    char *relay = format_string(RELAY_JSON, relay_options);
+    char *behind = format_string(BEHIND_JSON, "/mnt/behind", relay_parent, behind_options);
+    char *remote_systems = format_string("%s, %s", relay, behind);
+
+    char *error_msg = NULL;
+    WorkspaceInformation *ws_info = parse_workspace("/ws", remote_systems, &error_msg);
+    const bool is_rejected = (ws_info == NULL && error_msg != NULL);
+
+    destroy_workspaceInformation(&ws_info);
+    DO_FREE(error_msg);
+    DO_FREE(remote_systems);
+    DO_FREE(behind);
+    DO_FREE(relay);
+    return is_rejected;
+}
+
+static void
+test_validation(void)
+{
+    CHECK(!is_rejected("", "relay:/srv/relay", ""));
+
+    // The relay has to be another remote system of the workspace
+    CHECK(is_rejected("", "relay:/srv/other", ""));
+    CHECK(is_rejected("", "other:/srv/relay", ""));
+
+    // It has to run rsync for the remote systems behind it
+    CHECK(is_rejected(", \"transport\": \"agent\"", "relay:/srv/relay", ""));
+    CHECK(is_rejected("", "relay:/srv/relay", ", \"transport\": \"agent\""));
+
+    // Relays are not nested
+    CHECK(is_rejected(", \"relay-parent\": \"relay:/srv/relay\"", "relay:/srv/relay", ""));
+
+    char *error_msg = NULL;
+    WorkspaceInformation *ws_info = parse_workspace(
+            "/ws",
+            "{\"remote-workspace-root-path\": \"/mnt/relay\", \"connection-type\": \"LOCAL_PATH\"}, "
+            "{\"remote-workspace-root-path\": \"/mnt/behind\", \"connection-type\": \"LOCAL_PATH\", "
+            "\"relay-parent\": \"" LOCAL_PATH_HOST ":/mnt/relay\"}",
+            &error_msg
+    );
+    CHECK(ws_info == NULL && strstr(error_msg, "cannot relay") != NULL);
+    DO_FREE(error_msg);
+
+    // A mirror behind a relay is on the relay's host, so it may use any path
+    char *behind = format_string(BEHIND_JSON, "/ws/mirror", "relay:/srv/relay", "");
+    char *relay = format_string(RELAY_JSON, "");
+    char *remote_systems = format_string("%s, %s", relay, behind);
+    ws_info = parse_workspace("/ws", remote_systems, &error_msg);
+    CHECK(ws_info != NULL);
+    CHECK(get_relay_parent(ws_info, ws_info->remote_systems->next) == ws_info->remote_systems);
+    CHECK(get_relay_parent(ws_info, ws_info->remote_systems) == NULL);
+
+    destroy_workspaceInformation(&ws_info);
+    DO_FREE(remote_systems);
+    DO_FREE(relay);
+    DO_FREE(behind);
+}
+
+static void
+test_sync_through_relay(const char *workspace_path)
+{
+    char *relay = format_string(RELAY_JSON, "");
+    char *behind = format_string(BEHIND_JSON, "/mnt/behind", "relay:/srv/relay", "");
+    char *remote_systems = format_string("%s, %s", relay, behind);
+    char *error_msg = NULL;
+    WorkspaceInformation *ws_info = parse_workspace(workspace_path, remote_systems, &error_msg);
+    CHECK(ws_info != NULL);
+
+    // The directory crosses the link to the relay once, and is synced from there to the remote system behind it
+    synchronize_workspace(ws_info, "dir");
+
+    char *invocations_path = concat_paths(root, "invocations");
+    FILE *invocations_file = fopen(invocations_path, "r");
+    CHECK(invocations_file != NULL);
+
+    char rsync_line[4096], ssh_line[4096];
+    CHECK(fgets(rsync_line, sizeof(rsync_line), invocations_file) != NULL);
+    CHECK(fgets(ssh_line, sizeof(ssh_line), invocations_file) != NULL);
+    CHECK(fgetc(invocations_file) == EOF);
+    fclose(invocations_file);
+
+    CHECK(strstr(rsync_line, "/bin/rsync ") != NULL && strstr(rsync_line, " relay:/srv/relay/dir") != NULL);
+    CHECK(strstr(ssh_line, "/bin/ssh ") != NULL && strstr(ssh_line, " relay ") != NULL);
+    CHECK(strstr(ssh_line, "'rsync'") != NULL);
+    CHECK(strstr(ssh_line, "'/srv/relay/dir/' '/mnt/behind/dir") != NULL);
+
+    RemoteWorkspaceMetadata *remote_system;
+    LL_FOREACH(ws_info->remote_systems, remote_system) {
+        release_remote_system_transport(remote_system);
+    }
+    destroy_workspaceInformation(&ws_info);
+    DO_FREE(invocations_path);
+    DO_FREE(remote_systems);
+    DO_FREE(behind);
+    DO_FREE(relay);
+}
+
+static void
+clean_up(void)
+{
+    char *command = format_string("rm -rf '%s'", root);
+    system(command);
+    DO_FREE(command);
+}
+
+int
+main(void)
+{
+    CHECK(mkdtemp(root) != NULL);
+    CHECK(atexit(clean_up) == 0);
+
+    char *workspace_path = concat_paths(root, "workspace");
+    char *dir_path = concat_paths(workspace_path, "dir");
+    char *bin_path = concat_paths(root, "bin");
+    char *rsync_path = concat_paths(bin_path, "rsync");
+    char *ssh_path = concat_paths(bin_path, "ssh");
+    CHECK(mkdir(workspace_path, 0700) == 0 && mkdir(dir_path, 0700) == 0 && mkdir(bin_path, 0700) == 0);
+
+    char *script = format_string(FAKE_SCRIPT, root);
+    write_file(rsync_path, script);
+    write_file(ssh_path, script);
+    CHECK(chmod(rsync_path, 0700) == 0 && chmod(ssh_path, 0700) == 0);
+
+    char *path = format_string("%s:%s", bin_path, getenv("PATH"));
+    CHECK(setenv("PATH", path, 1) == 0);
+
+    test_validation();
+    test_sync_through_relay(workspace_path);
+
+    DO_FREE(path);
+    DO_FREE(script);
+    DO_FREE(ssh_path);
+    DO_FREE(rsync_path);
+    DO_FREE(bin_path);
+    DO_FREE(dir_path);
+    DO_FREE(workspace_path);
+    return EXIT_SUCCESS;
+}
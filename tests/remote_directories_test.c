@@ -0,0 +1,108 @@
+#include "../src/server/remote_directories.h"
+#include "test.h"
+
+static void
+check_sync_root(const RemoteWorkspaceMetadata *remote_system, const char *relative_path, const char *expected_sync_root)
+{
+    char *sync_root = get_remote_sync_root(remote_system, relative_path);
+    CHECK(is_equal(sync_root, expected_sync_root));
+    DO_FREE(sync_root);
+}
+
+static void
+test_nothing_is_known_before_a_complete_sync(void)
+{
+    RemoteWorkspaceMetadata remote_system = {.remote_workspace_root_path = "/remote"};
+
+    add_unconfirmed_remote_directory(&remote_system, "a");
+    CHECK(!is_remote_directory_unconfirmed(&remote_system, "a"));
+    check_sync_root(&remote_system, "a/b", "a/b");
+    check_sync_root(&remote_system, NULL, NULL);
+
+    release_remote_directories(&remote_system);
+}
+
+static void
+test_syncs_start_at_the_topmost_unconfirmed_directory(void)
+{
+    RemoteWorkspaceMetadata remote_system = {.remote_workspace_root_path = "/remote"};
+    confirm_remote_directory(&remote_system, NULL);
+
+    add_unconfirmed_remote_directory(&remote_system, "a");
+    add_unconfirmed_remote_directory(&remote_system, "a/b");
+    add_unconfirmed_remote_directory(&remote_system, "c/d");
+
+    CHECK(is_remote_directory_unconfirmed(&remote_system, "a"));
+    CHECK(is_remote_directory_unconfirmed(&remote_system, "a/b/e"));
+    CHECK(!is_remote_directory_unconfirmed(&remote_system, "ab"));
+    CHECK(!is_remote_directory_unconfirmed(&remote_system, "c"));
+    CHECK(!is_remote_directory_unconfirmed(&remote_system, NULL));
+
+    // rsync creates the directory it syncs, so an unconfirmed directory is synced as itself
+    check_sync_root(&remote_system, "a", "a");
+    check_sync_root(&remote_system, "a/b", "a");
+    check_sync_root(&remote_system, "a/b/e", "a");
+    check_sync_root(&remote_system, "c/d/e", "c/d");
+    check_sync_root(&remote_system, "c", "c");
+    check_sync_root(&remote_system, "ab/x", "ab/x");
+
+    release_remote_directories(&remote_system);
+}
+
+static void
+test_confirmation(void)
+{
+    RemoteWorkspaceMetadata remote_system = {.remote_workspace_root_path = "/remote"};
+    confirm_remote_directory(&remote_system, NULL);
+
+    add_unconfirmed_remote_directory(&remote_system, "a");
+    add_unconfirmed_remote_directory(&remote_system, "a/b");
+    add_unconfirmed_remote_directory(&remote_system, "a/b/c");
+    add_unconfirmed_remote_directory(&remote_system, "x");
+
+    // A sync of a descendant confirms its ancestors, and everything below the synced directory
+    confirm_remote_directory(&remote_system, "a/b");
+    CHECK(!is_remote_directory_unconfirmed(&remote_system, "a"));
+    CHECK(!is_remote_directory_unconfirmed(&remote_system, "a/b/c"));
+    CHECK(is_remote_directory_unconfirmed(&remote_system, "x"));
+
+    // A failed sync leaves the state of the remote system unknown
+    invalidate_remote_directories(&remote_system);
+    CHECK(!is_remote_directory_unconfirmed(&remote_system, "x"));
+    add_unconfirmed_remote_directory(&remote_system, "y");
+    CHECK(!is_remote_directory_unconfirmed(&remote_system, "y"));
+
+    release_remote_directories(&remote_system);
+}
+
+static void
+test_tracking_is_bounded(void)
+{
+    RemoteWorkspaceMetadata remote_system = {
+            .remote_workspace_root_path = "/remote",
+            .connection_type = SSH_HOST_ALIAS,
+            .connection_information.ssh_host_alias = "host"
+    };
+    confirm_remote_directory(&remote_system, NULL);
+
+    for (int i = 0; i <= REMOTE_DIRECTORIES_MAX_UNCONFIRMED; i++) {
+        char *path = format_string("dir%d", i);
+        add_unconfirmed_remote_directory(&remote_system, path);
+        DO_FREE(path);
+    }
+
+    CHECK(!is_remote_directory_unconfirmed(&remote_system, "dir0"));
+    check_sync_root(&remote_system, "dir0/sub", "dir0/sub");
+
+    release_remote_directories(&remote_system);
+}
+
+int
+main(void)
+{
+    test_nothing_is_known_before_a_complete_sync();
+    test_syncs_start_at_the_topmost_unconfirmed_directory();
+    test_confirmation();
+    test_tracking_is_bounded();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,235 @@
+#include "../src/server/ssh_pool.h"
+#include "../src/types/mappers.h"
+#include "../src/util/fs_util.h"
+#include "test.h"
+
+/*
+ * Registers workspaces with the ssh pool and checks which master connections it holds. The masters are run by a fake
+ *  'ssh' that records its arguments and either keeps running or fails if a file named 'fail' exists next to it.
+ */
+
+#define WAIT_TIMEOUT_SEC 10
+
+#define BUILD_JSON \
+    "{\"remote-workspace-root-path\": \"/srv/%s\", \"connection-type\": \"SSH\", " \
+    "\"connection-information\": {\"username\": \"user\", \"hostname\": \"build\", \"identity-file\": \"/id\"}}"
+#define RELAY_JSON \
+    "{\"remote-workspace-root-path\": \"/srv/%s\", \"connection-type\": \"SSH_HOST_ALIAS\", " \
+    "\"connection-information\": {\"ssh-host-alias\": \"relay\"}}"
+#define LOCAL_JSON "{\"remote-workspace-root-path\": \"/mnt/%s\", \"connection-type\": \"LOCAL_PATH\"}"
+
+#define BUILD_KEY "ssh:user@build#/id"
+#define RELAY_KEY "alias:relay"
+
+static char root[] = "/tmp/resync-ssh-pool-XXXXXX";
+
+static void
+register_workspace(SshPool *pool, const char *ws_path, const char *remote_systems_json)
+{
+    char *json = format_string(
+            "{\"local-workspace-root-path\": \"%s\", \"remote-systems\": [%s]}",
+            ws_path,
+            remote_systems_json
+    );
+    char *error_msg = NULL;
+    WorkspaceInformation *ws_info = stringified_json_to_workspaceInformation(json, &error_msg);
+    CHECK(ws_info != NULL);
+
+    register_ssh_pool_workspace(pool, ws_info);
+
+    destroy_workspaceInformation(&ws_info);
+    DO_FREE(json);
+}
+
+static SshMaster *
+find_master(SshPool *pool, const char *connection_key)
+{
+    SshMaster *master;
+    HASH_FIND_STR(pool->masters, connection_key, master);
+    return master;
+}
+
+/*
+ * Maintains the masters until the master's process terminated.
+ *
+ * @return the timeout returned once the master's termination was handled
+ */
+static int
+wait_for_master_exit(SshPool *pool, const SshMaster *master, const int consecutive_failures)
+{
+    const time_t deadline = time(NULL) + WAIT_TIMEOUT_SEC;
+
+    int timeout_ms;
+    while ((timeout_ms = maintain_ssh_masters(pool)) == -1 || master->consecutive_failures < consecutive_failures) {
+        CHECK(time(NULL) < deadline);
+        usleep(20 * 1000);
+    }
+
+    CHECK(master->pid == -1);
+    return timeout_ms;
+}
+
+/*
+ * Waits until the started masters recorded their arguments.
+ */
+static void
+wait_for_arguments(const int masters_count)
+{
+    char *args_path = concat_paths(root, "args");
+    const time_t deadline = time(NULL) + WAIT_TIMEOUT_SEC;
+
+    while (true) {
+        int lines_count = 0;
+        FILE *args_file = fopen(args_path, "r");
+        if (args_file != NULL) {
+            int c;
+            while ((c = fgetc(args_file)) != EOF) {
+                lines_count += (c == '\n');
+            }
+            fclose(args_file);
+        }
+
+        if (lines_count >= masters_count) {
+            break;
+        }
+        CHECK(time(NULL) < deadline);
+        usleep(20 * 1000);
+    }
+
+    DO_FREE(args_path);
+}
+
+static void
+test_references(void)
+{
+    SshPool *pool = create_ssh_pool();
+
+    // Remote systems on the same ssh destination share a master, other connection types do not need one
+    char *a_remote_systems = format_string(BUILD_JSON ", " BUILD_JSON ", " RELAY_JSON ", " LOCAL_JSON, "a", "a2", "a", "a");
+    register_workspace(pool, "/a", a_remote_systems);
+    char *b_remote_systems = format_string(BUILD_JSON, "b");
+    register_workspace(pool, "/b", b_remote_systems);
+    CHECK(HASH_COUNT(pool->masters) == 2);
+    CHECK(find_master(pool, BUILD_KEY)->references == 2);
+    CHECK(find_master(pool, RELAY_KEY)->references == 1);
+
+    // Masters are connected in the background, so there is nothing to reconnect
+    CHECK(maintain_ssh_masters(pool) == -1);
+    SshMaster *relay_master = find_master(pool, RELAY_KEY);
+    CHECK(relay_master->pid != -1 && relay_master->connects == 1);
+    CHECK(find_master(pool, BUILD_KEY)->pid != -1);
+    wait_for_arguments(2);
+
+    // A re-registered workspace releases the destinations it no longer uses, unused masters are terminated
+    char *local_remote_system = format_string(LOCAL_JSON, "a");
+    register_workspace(pool, "/a", local_remote_system);
+    CHECK(find_master(pool, RELAY_KEY) == NULL);
+    CHECK(find_master(pool, BUILD_KEY)->references == 1);
+
+    unregister_ssh_pool_workspace(pool, "/b");
+    CHECK(pool->masters == NULL);
+    unregister_ssh_pool_workspace(pool, "/unknown");
+
+    DO_FREE(local_remote_system);
+    DO_FREE(b_remote_systems);
+    DO_FREE(a_remote_systems);
+    destroy_ssh_pool(&pool);
+    CHECK(pool == NULL);
+}
+
+static void
+test_arguments(void)
+{
+    char *args_path = concat_paths(root, "args");
+    FILE *args_file = fopen(args_path, "r");
+    CHECK(args_file != NULL);
+
+    // Each master is a batch mode ssh connection that is multiplexed through its control socket
+    char line[1024];
+    bool found_build = false;
+    bool found_relay = false;
+    while (fgets(line, sizeof(line), args_file) != NULL) {
+        CHECK(strncmp(line, "-M -N -o ControlPath=" DEFAULT_RESYNC_SSH_CONTROL_DIRECTORY "/", 21) == 0);
+        CHECK(strstr(line, "-o BatchMode=yes") != NULL);
+        found_build |= (strstr(line, "-i /id -l user build\n") != NULL);
+        found_relay |= (strstr(line, " relay\n") != NULL);
+    }
+    CHECK(found_build && found_relay);
+
+    fclose(args_file);
+    DO_FREE(args_path);
+}
+
+static void
+test_reconnect(void)
+{
+    char *fail_path = concat_paths(root, "bin/fail");
+    FILE *fail_file = fopen(fail_path, "w");
+    CHECK(fail_file != NULL && fclose(fail_file) == 0);
+
+    SshPool *pool = create_ssh_pool();
+    char *relay_remote_system = format_string(RELAY_JSON, "a");
+    register_workspace(pool, "/a", relay_remote_system);
+    maintain_ssh_masters(pool);
+    SshMaster *master = find_master(pool, RELAY_KEY);
+
+    // A master that keeps failing is reconnected with an increasing delay
+    int timeout_ms = wait_for_master_exit(pool, master, 1);
+    CHECK(timeout_ms > 0 && timeout_ms <= SSH_MASTER_INITIAL_BACKOFF_MS);
+
+    master->reconnect_at_ms = 0;
+    CHECK(maintain_ssh_masters(pool) == -1 && master->connects == 2);
+    timeout_ms = wait_for_master_exit(pool, master, 2);
+    CHECK(timeout_ms > SSH_MASTER_INITIAL_BACKOFF_MS && timeout_ms <= 2 * SSH_MASTER_INITIAL_BACKOFF_MS);
+
+    // Once the remote host is reachable again, the master keeps running
+    CHECK(unlink(fail_path) == 0);
+    master->reconnect_at_ms = 0;
+    CHECK(maintain_ssh_masters(pool) == -1 && master->connects == 3);
+    usleep(100 * 1000);
+    CHECK(maintain_ssh_masters(pool) == -1 && master->pid != -1);
+
+    DO_FREE(relay_remote_system);
+    DO_FREE(fail_path);
+    destroy_ssh_pool(&pool);
+}
+
+static void
+clean_up(void)
+{
+    char *command = format_string("rm -rf '%s'", root);
+    system(command);
+    DO_FREE(command);
+}
+
+int
+main(void)
+{
+    CHECK(mkdtemp(root) != NULL);
+    CHECK(atexit(clean_up) == 0);
+
+    char *bin_path = concat_paths(root, "bin");
+    char *ssh_path = concat_paths(bin_path, "ssh");
+    CHECK(mkdir(bin_path, 0700) == 0);
+    char *ssh_script = format_string(
+            "#!/bin/sh\necho \"$@\" >> '%s/args'\n[ -e '%s/fail' ] && exit 1\nexec sleep 60\n",
+            root,
+            bin_path
+    );
+    FILE *ssh_file = fopen(ssh_path, "w");
+    CHECK(ssh_file != NULL && fputs(ssh_script, ssh_file) >= 0 && fclose(ssh_file) == 0);
+    CHECK(chmod(ssh_path, 0700) == 0);
+
+    char *path = format_string("%s:%s", bin_path, getenv("PATH"));
+    CHECK(setenv("PATH", path, 1) == 0);
+
+    test_references();
+    test_arguments();
+    test_reconnect();
+
+    DO_FREE(path);
+    DO_FREE(ssh_script);
+    DO_FREE(ssh_path);
+    DO_FREE(bin_path);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+#include "../src/server/supervisor.h"
+#include "test.h"
+
+/*
+ * Records crashes and starts of workspace monitors and checks the restart delays and the dispatched restarts.
+ */
+
+typedef struct DispatchedRestarts {
+    int count;
+    const char *last_ws_path;
+} DispatchedRestarts;
+
+static void
+restart(const char *ws_path, void *context)
+{
+    DispatchedRestarts *restarts = (DispatchedRestarts *) context;
+    restarts->count++;
+    restarts->last_ws_path = ws_path;
+}
+
+static void
+test_backoff(void)
+{
+    MonitorSupervisor *supervisor = create_monitor_supervisor(100, 700);
+
+    // The delay doubles with every crash in a row, up to the maximum
+    record_monitor_start(supervisor, "/ws");
+    CHECK(record_monitor_crash(supervisor, "/ws") == 100);
+    CHECK(record_monitor_crash(supervisor, "/ws") == 200);
+    CHECK(record_monitor_crash(supervisor, "/ws") == 400);
+    CHECK(record_monitor_crash(supervisor, "/ws") == 700);
+    CHECK(record_monitor_crash(supervisor, "/ws") == 700);
+
+    // Workspaces are supervised independently, and a start does not reset the crashes in a row
+    CHECK(record_monitor_crash(supervisor, "/other") == 100);
+    record_monitor_start(supervisor, "/ws");
+    CHECK(record_monitor_crash(supervisor, "/ws") == 700);
+
+    // A forgotten workspace starts over
+    forget_supervised_monitor(supervisor, "/ws");
+    CHECK(record_monitor_crash(supervisor, "/ws") == 100);
+
+    destroy_monitor_supervisor(&supervisor);
+    CHECK(supervisor == NULL);
+
+    // A maximum below the initial delay is raised to it
+    supervisor = create_monitor_supervisor(100, 10);
+    CHECK(record_monitor_crash(supervisor, "/ws") == 100);
+    CHECK(record_monitor_crash(supervisor, "/ws") == 100);
+    destroy_monitor_supervisor(&supervisor);
+}
+
+static void
+test_dispatch(void)
+{
+    MonitorSupervisor *supervisor = create_monitor_supervisor(0, 0);
+    DispatchedRestarts restarts = {.count = 0, .last_ws_path = NULL};
+
+    CHECK(dispatch_monitor_restarts(supervisor, restart, &restarts) == -1);
+
+    // A due restart is dispatched once
+    record_monitor_crash(supervisor, "/ws");
+    CHECK(dispatch_monitor_restarts(supervisor, restart, &restarts) == -1);
+    CHECK(restarts.count == 1 && is_equal(restarts.last_ws_path, "/ws"));
+    CHECK(dispatch_monitor_restarts(supervisor, restart, &restarts) == -1);
+    CHECK(restarts.count == 1);
+
+    // A start cancels the scheduled restart, e.g. because the workspace was restarted for another reason meanwhile
+    record_monitor_crash(supervisor, "/ws");
+    record_monitor_start(supervisor, "/ws");
+    CHECK(dispatch_monitor_restarts(supervisor, restart, &restarts) == -1);
+    CHECK(restarts.count == 1);
+
+    // So does forgetting the workspace
+    record_monitor_crash(supervisor, "/ws");
+    forget_supervised_monitor(supervisor, "/ws");
+    CHECK(dispatch_monitor_restarts(supervisor, restart, &restarts) == -1);
+    CHECK(restarts.count == 1);
+
+    destroy_monitor_supervisor(&supervisor);
+
+    // Restarts that are not due yet determine the timeout of the caller
+    supervisor = create_monitor_supervisor(60 * 1000, 60 * 1000);
+    record_monitor_crash(supervisor, "/ws");
+    const int timeout_ms = dispatch_monitor_restarts(supervisor, restart, &restarts);
+    CHECK(timeout_ms > 0 && timeout_ms <= 60 * 1000);
+    CHECK(restarts.count == 1);
+
+    destroy_monitor_supervisor(&supervisor);
+}
+
+int
+main(void)
+{
+    test_backoff();
+    test_dispatch();
+    return EXIT_SUCCESS;
+}
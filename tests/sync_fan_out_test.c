@@ -0,0 +1,186 @@
+#include "../src/server/sync.h"
+#include "../src/types/mappers.h"
+#include "../src/util/fs_util.h"
+#include "test.h"
+
+#include <sys/stat.h>
+
+/*
+ * Synchronizes changes with three remote systems that use the rsync transport and checks which of them share a batch.
+ *  rsync is replaced by a fake that records its arguments, writes the requested batch and fails to replay batches
+ *  while a file named 'diverged' exists next to it.
+ */
+
+#define RSYNC_SCRIPT \
+    "#!/bin/sh\n" \
+    "echo \"$@\" >> '%s/invocations'\n" \
+    "for arg; do\n" \
+    "    case \"$arg\" in\n" \
+    "        --write-batch=*) touch \"${arg#--write-batch=}\" ;;\n" \
+    "        --read-batch=*) [ -e '%s/diverged' ] && exit 1 ;;\n" \
+    "    esac\n" \
+    "done\n" \
+    "exit 0\n"
+
+#define REMOTE_SYSTEM_JSON(name) \
+    "{\"remote-workspace-root-path\": \"/srv/" name "\", \"connection-type\": \"SSH_HOST_ALIAS\", " \
+    "\"connection-information\": {\"ssh-host-alias\": \"host-" name "\"}}"
+
+static char root[] = "/tmp/resync-sync-fan-out-XXXXXX";
+
+static void
+write_file(const char *path, const char *content)
+{
+    FILE *file = fopen(path, "w");
+    CHECK(file != NULL);
+    CHECK(fputs(content, file) >= 0);
+    CHECK(fclose(file) == 0);
+}
+
+/*
+ * Summarizes the recorded rsync invocations as a kind per invocation ('W' writes a batch, 'R' replays one, 'S' syncs on
+ *  its own) followed by the remote system, and clears the record.
+ */
+static char *
+take_invocations(void)
+{
+    char *invocations_path = concat_paths(root, "invocations");
+    char *summary = resync_strdup("");
+
+    FILE *invocations_file = fopen(invocations_path, "r");
+    char line[4096];
+    while (invocations_file != NULL && fgets(line, sizeof(line), invocations_file) != NULL) {
+        const char kind = (strstr(line, "--write-batch=") != NULL) ? 'W' : (strstr(line, "--read-batch=") != NULL) ? 'R' : 'S';
+        const char *host = strstr(line, " host-");
+        CHECK(host != NULL);
+
+        char *extended = format_string("%s%s%c%c", summary, (*summary == '\0') ? "" : " ", kind, host[strlen(" host-")]);
+        DO_FREE(summary);
+        summary = extended;
+    }
+
+    if (invocations_file != NULL) {
+        fclose(invocations_file);
+        CHECK(unlink(invocations_path) == 0);
+    }
+    DO_FREE(invocations_path);
+    return summary;
+}
+
+static void
+check_invocations(const char *expected_summary)
+{
+    char *summary = take_invocations();
+    CHECK(is_equal(summary, expected_summary));
+    DO_FREE(summary);
+}
+
+static void
+test_fan_out(WorkspaceInformation *ws_info)
+{
+    // A sync of the workspace root would be a full sync, which brings a remote system back in line with the others
+    const WorkspaceChange change = {
+            .type = FILE_WRITTEN,
+            .relative_path = "dir/file",
+            .relative_directory_path = "dir"
+    };
+    char *diverged_path = concat_paths(root, "diverged");
+
+    // Remote systems in the same state receive a batch that is written while syncing the first of them
+    synchronize_change(ws_info, &change);
+    check_invocations("Wa Rb Rc");
+
+    // The batch does not outlive the change
+    char *batch_path = format_string(
+            "%s/%016llx.batch",
+            DEFAULT_RESYNC_SYNC_STATE_DIRECTORY,
+            (unsigned long long) hash_string(ws_info->local_workspace_root_path)
+    );
+    CHECK(access(batch_path, F_OK) == -1);
+
+    // Remote systems that reject a batch are synced on their own, and keep being synced on their own
+    write_file(diverged_path, "");
+    synchronize_change(ws_info, &change);
+    check_invocations("Wa Rb Sb Rc Sc");
+    CHECK(unlink(diverged_path) == 0);
+
+    synchronize_change(ws_info, &change);
+    check_invocations("Sa Sb Sc");
+
+    // Until they are fully synced again
+    RemoteWorkspaceMetadata *remote_system_b = ws_info->remote_systems->next;
+    synchronize_with_remote_system(ws_info, remote_system_b, NULL);
+    check_invocations("Sb");
+
+    synchronize_change(ws_info, &change);
+    check_invocations("Wa Rb Sc");
+
+    // Changes of modes are picked up by the next sync, so they are not synchronized on their own
+    const WorkspaceChange mode_change = {
+            .type = MODE_CHANGED,
+            .relative_path = "dir/file",
+            .relative_directory_path = "dir",
+            .mode = 0600
+    };
+    synchronize_change(ws_info, &mode_change);
+    check_invocations("");
+
+    DO_FREE(batch_path);
+    DO_FREE(diverged_path);
+}
+
+static void
+clean_up(void)
+{
+    char *command = format_string("rm -rf '%s'", root);
+    system(command);
+    DO_FREE(command);
+}
+
+int
+main(void)
+{
+    CHECK(mkdtemp(root) != NULL);
+    CHECK(atexit(clean_up) == 0);
+
+    char *workspace_path = concat_paths(root, "workspace");
+    char *dir_path = concat_paths(workspace_path, "dir");
+    char *file_path = concat_paths(dir_path, "file");
+    char *bin_path = concat_paths(root, "bin");
+    char *rsync_path = concat_paths(bin_path, "rsync");
+    CHECK(mkdir(workspace_path, 0700) == 0 && mkdir(dir_path, 0700) == 0 && mkdir(bin_path, 0700) == 0);
+    write_file(file_path, "content");
+
+    char *rsync_script = format_string(RSYNC_SCRIPT, root, root);
+    write_file(rsync_path, rsync_script);
+    CHECK(chmod(rsync_path, 0700) == 0);
+
+    char *path = format_string("%s:%s", bin_path, getenv("PATH"));
+    CHECK(setenv("PATH", path, 1) == 0);
+
+    char *json = format_string(
+            "{\"local-workspace-root-path\": \"%s\", \"remote-systems\": ["
+            REMOTE_SYSTEM_JSON("a") ", " REMOTE_SYSTEM_JSON("b") ", " REMOTE_SYSTEM_JSON("c") "]}",
+            workspace_path
+    );
+    char *error_msg = NULL;
+    WorkspaceInformation *ws_info = stringified_json_to_workspaceInformation(json, &error_msg);
+    CHECK(ws_info != NULL);
+
+    test_fan_out(ws_info);
+
+    RemoteWorkspaceMetadata *remote_system;
+    LL_FOREACH(ws_info->remote_systems, remote_system) {
+        release_remote_system_transport(remote_system);
+    }
+    destroy_workspaceInformation(&ws_info);
+    DO_FREE(json);
+    DO_FREE(path);
+    DO_FREE(rsync_script);
+    DO_FREE(rsync_path);
+    DO_FREE(bin_path);
+    DO_FREE(file_path);
+    DO_FREE(dir_path);
+    DO_FREE(workspace_path);
+    return EXIT_SUCCESS;
+}
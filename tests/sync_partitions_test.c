@@ -0,0 +1,96 @@
+#include "../src/server/sync_partitions.h"
+#include "test.h"
+
+/*
+ * Splits synthetic workspace trees into partitions and checks their selection and order.
+ */
+
+static SyncSubtree *
+add_subtree(SyncSubtree *parent, const char *path_relative_to_ws_root, const uint64_t entries_count)
+{
+    SyncSubtree *subtree = create_sync_subtree(path_relative_to_ws_root);
+    subtree->entries_count = entries_count;
+    LL_APPEND(parent->subtrees, subtree);
+    return subtree;
+}
+
+static bool
+is_partition(const SyncPartitionList *partition, const char *path_relative_to_ws_root, const uint64_t entries_count)
+{
+    return partition != NULL && is_equal(partition->path_relative_to_ws_root, path_relative_to_ws_root)
+        && partition->entries_count == entries_count;
+}
+
+static void
+test_small_workspaces_are_not_split(void)
+{
+    SyncSubtree *root = create_sync_subtree(NULL);
+    root->entries_count = SYNC_PARTITION_MIN_ENTRIES - 1;
+    add_subtree(root, "a", root->entries_count / 2);
+    add_subtree(root, "b", root->entries_count / 2);
+
+    CHECK(create_sync_partitions(NULL, 4) == NULL);
+    CHECK(create_sync_partitions(root, 4) == NULL);
+
+    // Neither is a workspace synced by a single stream
+    root->entries_count = 100000;
+    CHECK(create_sync_partitions(root, 1) == NULL);
+
+    destroy_sync_subtree(&root);
+    CHECK(root == NULL);
+}
+
+static void
+test_partitions(void)
+{
+    // With 2 streams, the target size of a partition is 100000 / 8 = 12500 entries, subtrees below 1562 are skipped
+    SyncSubtree *root = create_sync_subtree(NULL);
+    root->entries_count = 100000;
+    add_subtree(root, "small", 1000);
+    add_subtree(root, "medium", 5000);
+    add_subtree(root, "wild*card", 10000);
+    add_subtree(root, "files", 30000);
+    SyncSubtree *large = add_subtree(root, "large", 50000);
+    add_subtree(large, "large/x", 20000);
+    add_subtree(large, "large/y", 12000);
+    add_subtree(large, "large/z", 100);
+
+    SyncPartitionList *partitions = create_sync_partitions(root, 2);
+
+    // Large subtrees are split into their subdirectories, unless they have none, and all of them are ordered by size
+    const SyncPartitionList *partition = partitions;
+    CHECK(is_partition(partition, "files", 30000));
+    CHECK(is_partition(partition = partition->next, "large/x", 20000));
+    CHECK(is_partition(partition = partition->next, "large/y", 12000));
+    CHECK(is_partition(partition = partition->next, "medium", 5000));
+    CHECK(partition->next == NULL);
+
+    destroy_sync_partitions(&partitions);
+    CHECK(partitions == NULL);
+    destroy_sync_subtree(&root);
+}
+
+static void
+test_single_partition_is_dropped(void)
+{
+    SyncSubtree *root = create_sync_subtree(NULL);
+    root->entries_count = 100000;
+    add_subtree(root, "only", 90000);
+    add_subtree(root, "tiny", 10);
+
+    CHECK(create_sync_partitions(root, 2) == NULL);
+
+    destroy_sync_subtree(&root);
+}
+
+int
+main(void)
+{
+    const uint32_t streams_count = get_sync_streams_count();
+    CHECK(streams_count >= 2 && streams_count <= SYNC_PARTITION_MAX_STREAMS);
+
+    test_small_workspaces_are_not_split();
+    test_partitions();
+    test_single_partition_is_dropped();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,19 @@
+#ifndef RESYNC_TEST_H
+#define RESYNC_TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Minimal checks for the test executables, which are run by ctest. Unlike 'assert', they are not compiled out in
+ *  release builds. A failed check terminates the test with a non-zero exit status.
+ */
+#define CHECK(condition)                                                                          \
+    do {                                                                                          \
+        if (!(condition)) {                                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);         \
+            exit(EXIT_FAILURE);                                                                   \
+        }                                                                                         \
+    } while (0)
+
+#endif //RESYNC_TEST_H
@@ -0,0 +1,141 @@
+#include "../src/server/transfer_tuning.h"
+#include "../src/types/mappers.h"
+#include "test.h"
+
+/*
+ * Records the statistics of synthetic syncs and checks the profiles chosen for the measured links.
+ */
+
+#define MIB (1024.0 * 1024)
+#define LATENCY_SEC 0.1
+
+#define RSYNC_STATS_OUTPUT \
+    "Number of files: 1,203 (reg: 1,100, dir: 103)\n" \
+    "Number of created files: 0\n" \
+    "Number of regular files transferred: 12\n" \
+    "Total file size: 98,765,432 bytes\n" \
+    "Total transferred file size: 1,234,567 bytes\n" \
+    "Literal data: 234,567 bytes\n" \
+    "Matched data: 1,000,000 bytes\n" \
+    "Total bytes sent: 120,345\n" \
+    "Total bytes received: 2,345\n" \
+    "\n" \
+    "sent 120,345 bytes  received 2,345 bytes  245,380.00 bytes/sec\n"
+
+static void
+test_parse_stats(void)
+{
+    RsyncTransferStats stats;
+    CHECK(parse_rsync_transfer_stats(RSYNC_STATS_OUTPUT, 0.5, &stats));
+    CHECK(stats.elapsed_sec == 0.5);
+    CHECK(stats.bytes_sent == 120345 && stats.bytes_received == 2345);
+    CHECK(stats.literal_data_size == 234567);
+    CHECK(stats.transferred_files_count == 12 && stats.transferred_file_size == 1234567);
+
+    // Older rsync versions do not count regular files separately
+    CHECK(parse_rsync_transfer_stats(
+            "Number of files transferred: 7\nTotal bytes sent: 1\nTotal bytes received: 2\n",
+            0.5,
+            &stats
+    ));
+    CHECK(stats.transferred_files_count == 7);
+
+    // Output without the statistics, e.g. of a failed sync, is rejected
+    CHECK(!parse_rsync_transfer_stats("rsync: connection unexpectedly closed\n", 0.5, &stats));
+    CHECK(!parse_rsync_transfer_stats("Total bytes sent: 1\n", 0.5, &stats));
+    CHECK(!parse_rsync_transfer_stats("", 0.5, &stats));
+}
+
+static void
+record_sync(const RemoteWorkspaceMetadata *remote_system, const double throughput, const double file_size)
+{
+    // The latency of the link is subtracted from the duration of larger syncs
+    const RsyncTransferStats stats = {
+            .elapsed_sec = 1 + LATENCY_SEC,
+            .bytes_sent = (uint64_t) throughput,
+            .bytes_received = 0,
+            .literal_data_size = (uint64_t) throughput,
+            .transferred_files_count = 1,
+            .transferred_file_size = (uint64_t) file_size
+    };
+    record_rsync_transfer(remote_system, &stats);
+}
+
+/*
+ * Records syncs over a link of the throughput until its moving average settled.
+ */
+static const TransferProfile *
+record_link(const RemoteWorkspaceMetadata *remote_system, const double throughput, const double file_size)
+{
+    for (int i = 0; i < 30; i++) {
+        record_sync(remote_system, throughput, file_size);
+    }
+    return get_transfer_profile(remote_system);
+}
+
+static bool
+is_profile(const TransferProfile *profile, const bool is_compressed, const int compress_level, const bool is_whole_file,
+           const bool is_inplace)
+{
+    return profile->is_compressed == is_compressed && profile->compress_level == compress_level
+        && profile->is_whole_file == is_whole_file && profile->is_inplace == is_inplace;
+}
+
+static void
+test_profiles(const RemoteWorkspaceMetadata *remote_system)
+{
+    // Unmeasured links are compressed and delta transferred
+    CHECK(is_profile(get_transfer_profile(remote_system), true, 0, false, false));
+
+    const RsyncTransferStats latency_stats = {.elapsed_sec = LATENCY_SEC, .bytes_sent = 1000, .bytes_received = 1000};
+    record_rsync_transfer(remote_system, &latency_stats);
+
+    // The profile is adapted only after enough throughput measurements
+    for (int i = 1; i < TRANSFER_TUNING_MIN_SAMPLES; i++) {
+        record_sync(remote_system, 100 * MIB, MIB);
+        CHECK(is_profile(get_transfer_profile(remote_system), true, 0, false, false));
+    }
+    record_sync(remote_system, 100 * MIB, MIB);
+    CHECK(is_profile(get_transfer_profile(remote_system), false, 0, true, false));
+
+    // Profiles only change back once the throughput fell well below their threshold
+    CHECK(is_profile(record_link(remote_system, 40 * MIB, MIB), false, 0, true, false));
+    CHECK(is_profile(record_link(remote_system, 10 * MIB, MIB), true, 1, false, false));
+    CHECK(is_profile(record_link(remote_system, 5 * MIB, MIB), true, 1, false, false));
+    CHECK(is_profile(record_link(remote_system, 1 * MIB, MIB), true, 0, false, false));
+
+    // Large files are delta transferred in place
+    CHECK(is_profile(record_link(remote_system, 1 * MIB, 100 * MIB), true, 0, false, true));
+    CHECK(is_profile(record_link(remote_system, 100 * MIB, 100 * MIB), false, 0, true, false));
+
+    release_transfer_tuning(remote_system);
+    CHECK(is_profile(get_transfer_profile(remote_system), true, 0, false, false));
+}
+
+int
+main(void)
+{
+    char *error_msg = NULL;
+    WorkspaceInformation *ws_info = stringified_json_to_workspaceInformation(
+            "{\"local-workspace-root-path\": \"/ws\", \"remote-systems\": ["
+            "{\"remote-workspace-root-path\": \"/srv/ws\", \"connection-type\": \"SSH_HOST_ALIAS\", "
+            "\"connection-information\": {\"ssh-host-alias\": \"build\"}}, "
+            "{\"remote-workspace-root-path\": \"/mnt/ws\", \"connection-type\": \"LOCAL_PATH\"}]}",
+            &error_msg
+    );
+    CHECK(ws_info != NULL);
+    RemoteWorkspaceMetadata *remote_system = ws_info->remote_systems;
+    RemoteWorkspaceMetadata *local_mirror = remote_system->next;
+
+    test_parse_stats();
+    test_profiles(remote_system);
+
+    // Local mirrors are never compressed, however slow the disks are
+    CHECK(is_profile(get_transfer_profile(local_mirror), false, 0, true, false));
+    CHECK(is_profile(record_link(local_mirror, 1 * MIB, MIB), false, 0, true, false));
+
+    release_transfer_tuning(local_mirror);
+    release_transfer_tuning(remote_system);
+    destroy_workspaceInformation(&ws_info);
+    return EXIT_SUCCESS;
+}
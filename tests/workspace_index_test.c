@@ -0,0 +1,209 @@
+#include "../src/server/workspace_index.h"
+#include "../src/util/fs_util.h"
+#include "test.h"
+
+#include <sys/stat.h>
+
+/*
+ * Hashes a temporary workspace, changes it and checks that the index is up to date again once the changed directories
+ *  were invalidated, by comparing it with an index that is built from scratch.
+ */
+
+static char root[] = "/tmp/resync-workspace-index-XXXXXX";
+
+static void
+write_file(const char *relative_path, const char *content)
+{
+    char *path = concat_paths(root, relative_path);
+    FILE *file = fopen(path, "w");
+    CHECK(file != NULL);
+    CHECK(fputs(content, file) >= 0);
+    CHECK(fclose(file) == 0);
+    DO_FREE(path);
+}
+
+static void
+make_directory(const char *relative_path)
+{
+    char *path = concat_paths(root, relative_path);
+    CHECK(mkdir(path, 0700) == 0);
+    DO_FREE(path);
+}
+
+static bool
+are_digests_equal(const DirectoryDigest *digest, const DirectoryDigest *other_digest)
+{
+    if (digest->entries_hash != other_digest->entries_hash || digest->subdirs_count != other_digest->subdirs_count) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < digest->subdirs_count; i++) {
+        if (!is_equal(digest->subdir_names[i], other_digest->subdir_names[i])
+            || digest->subdir_hashes[i] != other_digest->subdir_hashes[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * @return whether the digest of the workspace root matches that of an index that is built from scratch
+ */
+static bool
+is_index_current(WorkspaceIndex *index)
+{
+    WorkspaceIndex *fresh_index = create_workspace_index(root, index->ignore_rules, index->flags);
+    DirectoryDigest *digest = get_directory_digest(index, NULL);
+    DirectoryDigest *fresh_digest = get_directory_digest(fresh_index, NULL);
+    CHECK(digest != NULL && fresh_digest != NULL);
+
+    const bool is_current = are_digests_equal(digest, fresh_digest);
+
+    destroy_directory_digest(&fresh_digest);
+    destroy_directory_digest(&digest);
+    destroy_workspace_index(&fresh_index);
+    return is_current;
+}
+
+static void
+test_digests(WorkspaceIndex *index)
+{
+    DirectoryDigest *digest = get_directory_digest(index, NULL);
+    CHECK(digest != NULL);
+
+    // Hidden and ignored directories are left out, the others are ordered by name
+    CHECK(digest->subdirs_count == 2);
+    CHECK(is_equal(digest->subdir_names[0], "x") && is_equal(digest->subdir_names[1], "y"));
+    CHECK(digest->subdir_hashes[0] != digest->subdir_hashes[1]);
+    destroy_directory_digest(&digest);
+
+    CHECK(get_directory_digest(index, "missing") == NULL);
+
+    // Changes in them do not change any hash
+    write_file(".hidden/new", "new");
+    write_file("build/new", "new");
+    invalidate_workspace_index(index, NULL);
+    CHECK(is_index_current(index));
+}
+
+static void
+test_invalidation(WorkspaceIndex *index)
+{
+    DirectoryDigest *digest = get_directory_digest(index, NULL);
+
+    // Hashes are reused until their directory is invalidated
+    write_file("x/a", "changed");
+    CHECK(!is_index_current(index));
+    invalidate_workspace_index(index, "x");
+    CHECK(is_index_current(index));
+
+    // The entries of the root did not change, only the tree hash of the changed subdirectory
+    DirectoryDigest *changed_digest = get_directory_digest(index, NULL);
+    CHECK(changed_digest->entries_hash == digest->entries_hash);
+    CHECK(changed_digest->subdir_hashes[0] != digest->subdir_hashes[0]);
+    CHECK(changed_digest->subdir_hashes[1] == digest->subdir_hashes[1]);
+    destroy_directory_digest(&changed_digest);
+
+    // Deeper changes invalidate all ancestors
+    write_file("y/z/b", "changed");
+    invalidate_workspace_index(index, "y/z");
+    CHECK(is_index_current(index));
+
+    // A replaced directory is hashed anew, including its subdirectories of the same name
+    char *command = format_string("rm -rf '%s/y'", root);
+    CHECK(system(command) == 0);
+    DO_FREE(command);
+    make_directory("y");
+    make_directory("y/z");
+    write_file("y/z/b", "replaced");
+    invalidate_workspace_index_resource(index, "y", true);
+    CHECK(is_index_current(index));
+
+    // Files are invalidated through their directory
+    write_file("f", "changed file");
+    invalidate_workspace_index_resource(index, "f", false);
+    CHECK(is_index_current(index));
+
+    destroy_directory_digest(&digest);
+}
+
+static void
+test_content_hashes(WorkspaceIndex *index)
+{
+    WorkspaceIndex *content_index = create_workspace_index(root, index->ignore_rules, WORKSPACE_INDEX_CONTENT_HASHED);
+    DirectoryDigest *digest = get_directory_digest(index, "x");
+    DirectoryDigest *content_digest = get_directory_digest(content_index, "x");
+
+    // Content of the same size is only told apart if the content is hashed
+    write_file("x/a", "CHANGED");
+    invalidate_workspace_index(index, "x");
+    invalidate_workspace_index(content_index, "x");
+    DirectoryDigest *changed_digest = get_directory_digest(index, "x");
+    DirectoryDigest *changed_content_digest = get_directory_digest(content_index, "x");
+    CHECK(are_digests_equal(digest, changed_digest));
+    CHECK(!are_digests_equal(content_digest, changed_content_digest));
+
+    destroy_directory_digest(&changed_content_digest);
+    destroy_directory_digest(&changed_digest);
+    destroy_directory_digest(&content_digest);
+    destroy_directory_digest(&digest);
+    destroy_workspace_index(&content_index);
+}
+
+static void
+test_reset(WorkspaceIndex *index)
+{
+    IgnoreRules *rules = create_ignore_rules();
+    char *error_msg = NULL;
+    CHECK(add_ignore_pattern(rules, "build/", &error_msg) && add_ignore_pattern(rules, "x/", &error_msg));
+
+    // Other ignore rules hash the workspace from scratch
+    reset_workspace_index(index, rules);
+    DirectoryDigest *digest = get_directory_digest(index, NULL);
+    CHECK(digest->subdirs_count == 1 && is_equal(digest->subdir_names[0], "y"));
+    destroy_directory_digest(&digest);
+
+    reset_workspace_index(index, NULL);
+    destroy_ignore_rules(&rules);
+}
+
+static void
+clean_up(void)
+{
+    char *command = format_string("rm -rf '%s'", root);
+    system(command);
+    DO_FREE(command);
+}
+
+int
+main(void)
+{
+    CHECK(mkdtemp(root) != NULL);
+    CHECK(atexit(clean_up) == 0);
+
+    make_directory("x");
+    make_directory("y");
+    make_directory("y/z");
+    make_directory(".hidden");
+    make_directory("build");
+    write_file("f", "file");
+    write_file("x/a", "a");
+    write_file("y/z/b", "b");
+    write_file(".hidden/h", "h");
+    write_file("build/o", "o");
+
+    IgnoreRules *rules = create_ignore_rules();
+    char *error_msg = NULL;
+    CHECK(add_ignore_pattern(rules, "build/", &error_msg));
+    WorkspaceIndex *index = create_workspace_index(root, rules, 0);
+
+    test_digests(index);
+    test_invalidation(index);
+    test_content_hashes(index);
+    test_reset(index);
+
+    destroy_workspace_index(&index);
+    CHECK(index == NULL);
+    destroy_ignore_rules(&rules);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+#include "../src/server/linux/write_settle.h"
+#include "test.h"
+
+#include <unistd.h>
+
+/*
+ * Writes files at different rates and sizes and checks which of their syncs are deferred until they settle.
+ */
+
+static uint32_t settled_files_count = 0;
+static char settled_path[PATH_MAX];
+static char settled_directory_path[PATH_MAX];
+
+static void
+handle_settled_file(const char *relative_path, const char *relative_directory_path)
+{
+    settled_files_count++;
+    snprintf(settled_path, sizeof(settled_path), "%s", relative_path);
+    snprintf(
+            settled_directory_path,
+            sizeof(settled_directory_path),
+            "%s",
+            (relative_directory_path == NULL) ? "" : relative_directory_path
+    );
+}
+
+static void
+test_hot_files(void)
+{
+    // A file becomes hot once it is written several times within a short period
+    for (int i = 1; i < WRITE_SETTLE_HOT_WRITES_COUNT; i++) {
+        CHECK(!defer_written_file("file", NULL, 10));
+    }
+    CHECK(get_write_settle_timeout_ms() == -1 && get_oldest_deferred_write_time() == 0);
+
+    CHECK(defer_written_file("file", NULL, 10));
+    const int timeout_ms = get_write_settle_timeout_ms();
+    CHECK(timeout_ms > 0 && timeout_ms <= WRITE_SETTLE_QUIET_MS);
+    CHECK(get_oldest_deferred_write_time() != 0);
+
+    // It has not settled yet, unless the sync is forced
+    CHECK(synchronize_settled_files(handle_settled_file, false) == 0);
+    CHECK(synchronize_settled_files(handle_settled_file, true) == 1);
+    CHECK(settled_files_count == 1 && is_equal(settled_path, "file") && is_equal(settled_directory_path, ""));
+    CHECK(get_write_settle_timeout_ms() == -1);
+    CHECK(synchronize_settled_files(handle_settled_file, true) == 0);
+
+    // Large files are hot on every write
+    CHECK(defer_written_file("dir/large", "dir", WRITE_SETTLE_LARGE_FILE_SIZE));
+
+    // Files that are written without being closed are deferred as well
+    note_file_modification("dir", "log");
+    note_file_modification("dir", "log");
+    note_file_modification(NULL, "other");
+
+    // Forgetting a directory drops the deferred syncs below it
+    CHECK(forget_file_writes("dir", true) == 2);
+    CHECK(forget_file_writes("dir/large", false) == 0);
+    CHECK(forget_file_writes("other", false) == 1);
+    CHECK(forget_file_writes("file", false) == 0);
+    CHECK(get_write_settle_timeout_ms() == -1);
+}
+
+static void
+test_settling(void)
+{
+    for (int i = 0; i < WRITE_SETTLE_HOT_WRITES_COUNT; i++) {
+        defer_written_file("dir/hot", "dir", 10);
+    }
+
+    // Files settle once they were not written to for a while
+    usleep((WRITE_SETTLE_QUIET_MS + 100) * 1000);
+    CHECK(get_write_settle_timeout_ms() == 0);
+    CHECK(synchronize_settled_files(handle_settled_file, false) == 1);
+    CHECK(is_equal(settled_path, "dir/hot") && is_equal(settled_directory_path, "dir"));
+
+    forget_file_writes("dir", true);
+}
+
+static void
+test_appended_files(void)
+{
+    CHECK(!defer_written_file("log", NULL, 100));
+
+    // Whether a file only grew is known once its synced size is
+    CHECK(!is_file_appended("log", 150));
+    record_synced_file_size("log", 100);
+    CHECK(is_file_appended("log", 150));
+    CHECK(!is_file_appended("log", 100));
+    CHECK(!is_file_appended("log", 50));
+    CHECK(!is_file_appended("unknown", 150));
+
+    record_synced_file_size("unknown", 100);
+    CHECK(!is_file_appended("unknown", 150));
+
+    forget_file_writes("log", false);
+    CHECK(!is_file_appended("log", 150));
+}
+
+int
+main(void)
+{
+    test_hot_files();
+    test_settling();
+    test_appended_files();
+    return EXIT_SUCCESS;
+}